@@ -67,6 +67,38 @@ struct CollisionSphereState
 
 std::ostream& operator<<(std::ostream& o, const CollisionSphereState& css);
 
+/// \brief Structure-of-arrays scratch storage for batched sphere queries
+struct SphereBatch
+{
+    std::vector<const CollisionSphereState*> spheres;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+    std::vector<double> rr; ///< squared effective radii
+    std::vector<double> d2; ///< squared distances returned by the query
+
+    size_t size() const { return x.size(); }
+
+    void clear()
+    {
+        spheres.clear();
+        x.clear();
+        y.clear();
+        z.clear();
+        rr.clear();
+    }
+
+    void push_back(const CollisionSphereState* s, double padding)
+    {
+        const double r = s->model->radius + padding;
+        spheres.push_back(s);
+        x.push_back(s->pos.x());
+        y.push_back(s->pos.y());
+        z.push_back(s->pos.z());
+        rr.push_back(r * r);
+    }
+};
+
 class CollisionSpheresState;
 
 class CollisionSphereStateTree
@@ -57,7 +57,9 @@
 namespace smpl {
 namespace collision {
 
-class CollisionSpace : public CollisionChecker
+class CollisionSpace :
+    public CollisionChecker,
+    public CollisionCheckerCloneExtension
 {
 public:
 
@@ -83,6 +85,9 @@ public:
         const std::string& group_name,
         const std::vector<std::string>& planning_joints);
 
+    auto clone(OccupancyGrid* grid = nullptr) const
+        -> std::unique_ptr<CollisionSpace>;
+
     auto getPlanningVariables() const -> const std::vector<std::string>& {
         return m_planning_variables;
     }
@@ -95,6 +100,12 @@ public:
 
     void setPadding(double padding);
 
+    /// \name Motion Interpolation
+    ///@{
+    double interpolationResolution() const { return m_interp_res; }
+    void setInterpolationResolution(double res);
+    ///@}
+
     /// \name Self Collisions
     ///@{
     auto allowedCollisionMatrix() const -> const AllowedCollisionMatrix&;
@@ -192,6 +203,11 @@ public:
     Extension* getExtension(size_t class_code) override;
     ///@}
 
+    /// \name Required Functions from CollisionCheckerCloneExtension
+    ///@{
+    auto cloneCollisionChecker() -> std::unique_ptr<CollisionChecker> override;
+    ///@}
+
     /// \name Required Functions from CollisionChecker
     ///@{
     bool isStateValid(
@@ -229,6 +245,16 @@ public:
     AttachedBodiesCollisionStatePtr m_abcs;
     std::vector<double>             m_joint_vars;
 
+    // attached objects, as given to attachObject(), for copying to clones
+    struct AttachedObject
+    {
+        std::string id;
+        std::vector<shapes::ShapeConstPtr> shapes;
+        Affine3dVector transforms;
+        std::string link_name;
+    };
+    std::vector<AttachedObject>     m_attached_objects;
+
     WorldCollisionModelPtr          m_wcm;
     SelfCollisionModelPtr           m_scm;
 
@@ -239,6 +265,26 @@ public:
     // Planning Joint Information
     std::vector<int>                m_planning_joint_to_collision_model_indices;
 
+    // maximum distance any sphere may travel between interpolated waypoints
+    double                          m_interp_res = 0.05;
+
+    // whether sphere motion bounds are valid for all planning variables, so
+    // that waypoints may be certified clear of the occupied voxels by the
+    // clearance of nearby waypoints
+    bool                            m_certify_motions = false;
+
+    struct WaypointInterval
+    {
+        int first;
+        int last;
+        double first_clearance;
+        double last_clearance;
+    };
+
+    // scratch space for motion validation
+    std::vector<WaypointInterval>   m_waypoint_intervals;
+    RobotState                      m_waypoint;
+
     size_t planningVariableCount() const {
         return m_planning_joint_to_collision_model_indices.size();
     }
@@ -257,6 +303,9 @@ public:
     void copyState();
 
     bool withinJointPositionLimits(const std::vector<double>& positions) const;
+
+    bool checkSpheresCollision(const RobotState& state);
+    double waypointClearance(const RobotState& state, bool verbose);
 };
 
 typedef std::shared_ptr<CollisionSpace> CollisionSpacePtr;
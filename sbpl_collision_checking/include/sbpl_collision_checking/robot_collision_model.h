@@ -34,6 +34,7 @@
 #define sbpl_collision_robot_collision_model_h
 
 // standard includes
+#include <cstdint>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -75,6 +76,41 @@ enum JointType
     FLOATING
 };
 
+/// \brief One instruction of the forward kinematics program compiled from the
+///     kinematic tree when the model is loaded
+///
+/// Each op computes the transform of one link, in the model frame, from the
+/// transform of its parent link and the variables of the joint between them.
+/// The op for the root link evaluates the world joint, whose parent frame is
+/// the model frame.
+/// Joint origins are stored as column-major 3x4 matrices and each op is
+/// specialized to the type and axis of its joint, so that evaluating an op
+/// is a sin/cos pair and a single 3x4 product.
+struct FKOp
+{
+    enum Code : std::uint8_t
+    {
+        Fixed,
+        RevoluteX,
+        RevoluteY,
+        RevoluteZ,
+        Revolute,   // revolute or continuous joint about an arbitrary axis
+        Prismatic,
+        General,    // planar and floating joints, evaluated through fn
+    };
+
+    Code code;
+    int parent;     // parent link index, or -1 for the root link
+    int var;        // index of the joint's first variable
+    double origin[12];
+
+    // revolute: the joint axis; prismatic: the joint axis rotated into the
+    // parent link frame
+    double axis[3];
+
+    JointTransformFunction fn;
+};
+
 /// \brief Represents the collision model of the robot used for planning.
 class RobotCollisionModel
 {
@@ -154,6 +190,17 @@ public:
     auto   linkChildJointIndices(int lidx) const -> const std::vector<int>&;
     ///@}
 
+    /// \name Robot Model - Forward Kinematics
+    ///@{
+
+    /// \brief Return the compiled forward kinematics program, with one op per
+    ///     link, indexed by link. Links are numbered such that every link
+    ///     follows its parent, so executing the ops in order updates the whole
+    ///     kinematic tree.
+    auto   fkProgram() const -> const std::vector<FKOp>&;
+    auto   linkFKOp(int lidx) const -> const FKOp&;
+    ///@}
+
     /// \name Collision Model
     ///@{
     size_t sphereModelCount() const;
@@ -217,6 +264,8 @@ private:
     std::vector<int>                        m_link_parent_joints;
     std::vector<std::vector<int>>           m_link_children_joints;
     hash_map<std::string, int>              m_link_name_to_index;
+
+    std::vector<FKOp>                       m_fk_program;
     ///@}
 
     /// \name Collision Model
@@ -275,6 +324,8 @@ private:
         const ::urdf::ModelInterface& urdf,
         const WorldJointConfig& config);
 
+    bool compileFKProgram();
+
     bool initCollisionModel(
         const ::urdf::ModelInterface& urdf,
         const CollisionModelConfig& config);
@@ -560,6 +611,19 @@ const std::vector<int>& RobotCollisionModel::linkChildJointIndices(
     return m_link_children_joints[lidx];
 }
 
+inline
+auto RobotCollisionModel::fkProgram() const -> const std::vector<FKOp>&
+{
+    return m_fk_program;
+}
+
+inline
+auto RobotCollisionModel::linkFKOp(int lidx) const -> const FKOp&
+{
+    ASSERT_VECTOR_RANGE(m_fk_program, lidx);
+    return m_fk_program[lidx];
+}
+
 inline
 size_t RobotCollisionModel::sphereModelCount() const
 {
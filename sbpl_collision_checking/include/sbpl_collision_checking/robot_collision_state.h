@@ -138,9 +138,13 @@ private:
     /// \name Robot State
     ///@{
     std::vector<double>                     m_jvar_positions;
-    std::vector<bool>                       m_dirty_joint_transforms;
-    Affine3dVector                          m_joint_transforms;
-    std::vector<bool>                       m_dirty_link_transforms;
+
+    // per-link transforms relative to the parent link, as column-major 3x4
+    // matrices, recomputed only when the parent joint's variables change
+    std::vector<char>                       m_dirty_joint_transforms;
+    std::vector<double>                     m_joint_transforms;
+
+    std::vector<char>                       m_dirty_link_transforms;
     Affine3dVector                          m_link_transforms;
     std::vector<int>                        m_link_transform_versions;
     ///@}
@@ -289,6 +293,8 @@ inline bool RobotCollisionState::setWorldToModelTransform(
 
     if (updated) {
         m_link_transforms[0] = M;
+        // the world joint's cached transform no longer matches its variables
+        m_dirty_joint_transforms[0] = true;
         std::fill(m_dirty_link_transforms.begin(), m_dirty_link_transforms.end(), true);
         m_dirty_link_transforms[0] = false;
         ++m_link_transform_versions[0];
@@ -364,59 +370,6 @@ inline bool RobotCollisionState::linkTransformDirty(int lidx) const
     return m_dirty_link_transforms[lidx];
 }
 
-inline bool RobotCollisionState::updateLinkTransforms()
-{
-    ROS_DEBUG_NAMED(RCS_LOGGER, "Updating all link transforms");
-    bool updated = false;
-    for (size_t lidx = 0; lidx < m_model->linkCount(); ++lidx) {
-        updated |= updateLinkTransform(lidx);
-    }
-    return updated;
-}
-
-inline bool RobotCollisionState::updateLinkTransform(int lidx)
-{
-    ASSERT_VECTOR_RANGE(m_dirty_link_transforms, lidx);
-    if (!m_dirty_link_transforms[lidx]) {
-        return false;
-    }
-
-    int pjidx = m_model->linkParentJointIndex(lidx);
-    int plidx = m_model->jointParentLinkIndex(pjidx);
-
-    ROS_DEBUG_NAMED(RCS_LOGGER, "Updating transform for link '%s'. parent joint = %d, parent link = %d", m_model->linkName(lidx).c_str(), pjidx, plidx);
-
-    // do NOT optimize out this recursion...i don't know why, but attempts at
-    // the equivalent iteration were not faster than the recursive version by a
-    // noticeable margin
-    if (plidx >= 0) {
-        updateLinkTransform(plidx);
-    }
-
-    if (m_dirty_joint_transforms[pjidx]) {
-        JointTransformFunction fn = m_model->jointTransformFn(pjidx);
-        const Eigen::Affine3d& joint_origin = m_model->jointOrigin(pjidx);
-        const Eigen::Vector3d& joint_axis = m_model->jointAxis(pjidx);
-        int fvidx = m_model->jointVarIndexFirst(pjidx);
-        double* variables = m_jvar_positions.data() + fvidx;
-        m_joint_transforms[pjidx] = fn(joint_origin, joint_axis, variables);
-        m_dirty_joint_transforms[pjidx] = false;
-    }
-    const Eigen::Affine3d& T_parent_link = m_joint_transforms[pjidx];
-    if (plidx >= 0) {
-        const Eigen::Affine3d& T_world_parent = m_link_transforms[plidx];
-        m_link_transforms[lidx] = T_world_parent * T_parent_link;
-    } else {
-        m_link_transforms[lidx] = T_parent_link;
-    }
-
-    ROS_DEBUG_NAMED(RCS_LOGGER, " -> %s", AffineToString(m_link_transforms[lidx]).c_str());
-
-    m_dirty_link_transforms[lidx] = false;
-    ++m_link_transform_versions[lidx];
-    return true;
-}
-
 inline int RobotCollisionState::linkTransformVersion(int lidx) const
 {
     ASSERT_VECTOR_RANGE(m_link_transform_versions, lidx);
@@ -526,10 +479,21 @@ inline bool RobotCollisionState::updateSphereStates()
 
 inline bool RobotCollisionState::updateSphereStates(int ssidx)
 {
+    ASSERT_VECTOR_RANGE(m_spheres_states, ssidx);
+    CollisionSpheresState& spheres_state = m_spheres_states[ssidx];
+    const int lidx = spheres_state.model->link_index;
+    updateLinkTransform(lidx);
+
+    const int link_version = m_link_transform_versions[lidx];
+    const Eigen::Affine3d& T_model_link = m_link_transforms[lidx];
+
     bool updated = false;
-    const CollisionSpheresState& spheres_state = m_spheres_states[ssidx];
-    for (size_t sidx = 0; sidx < spheres_state.spheres.size(); ++sidx) {
-        updated |= updateSphereState(SphereIndex(ssidx, sidx));
+    for (CollisionSphereState& sphere_state : spheres_state.spheres) {
+        if (sphere_state.version != link_version) {
+            sphere_state.pos = T_model_link * sphere_state.model->center;
+            sphere_state.version = link_version;
+            updated = true;
+        }
     }
     return updated;
 }
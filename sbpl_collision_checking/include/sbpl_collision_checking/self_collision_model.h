@@ -33,6 +33,7 @@
 #define sbpl_collision_self_collision_model_h
 
 // standard includes
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -123,6 +124,17 @@ public:
         const int gidx,
         CollisionDetails& details);
 
+    double voxelsCollisionDistance(
+        const RobotCollisionState& state,
+        const AttachedBodiesCollisionState& ab_state,
+        const int gidx);
+
+    bool checkSpheresCollision(
+        const RobotCollisionState& state,
+        const AttachedBodiesCollisionState& ab_state,
+        const int gidx,
+        double& dist);
+
     bool collisionDetails(
         const RobotCollisionState& state,
         const AttachedBodiesCollisionState& ab_state,
@@ -157,6 +169,21 @@ private:
     AllowedCollisionMatrix                  m_acm;
     double                                  m_padding;
 
+    // m_acm compiled into dense bit matrices over its entry names. Every node
+    // of every spheres model maps to the index of its name in the matrix (-1
+    // if the name has no entries) so that leaf-leaf checks need no string
+    // lookups. Attached body indices are recompiled when the version of the
+    // attached bodies model changes.
+    hash_map<std::string, int>              m_acm_entry_indices;
+    int                                     m_acm_words;
+    std::vector<std::uint64_t>              m_acm_entry_bits;
+    std::vector<std::uint64_t>              m_acm_allowed_bits;
+    std::vector<int>                        m_robot_sphere_acm_offsets;
+    std::vector<int>                        m_robot_sphere_acm_indices;
+    std::vector<int>                        m_ab_sphere_acm_offsets;
+    std::vector<int>                        m_ab_sphere_acm_indices;
+    int                                     m_ab_version;
+
     // queue storage for sphere hierarchy traversal
     using SpherePair =
             std::pair<const CollisionSphereState*, const CollisionSphereState*>;
@@ -177,6 +204,21 @@ private:
 #endif
 
     void initAllowedCollisionMatrix();
+    void compileAllowedCollisionMatrix();
+    void compileRobotSphereIndices();
+    void compileAttachedBodySphereIndices();
+    void updateAttachedBodies();
+
+    bool acmEntry(int i, int j) const;
+    bool acmAllowed(int i, int j) const;
+    int sphereAcmIndex(
+        const RobotCollisionState& state,
+        int ssidx,
+        const CollisionSphereModel* s) const;
+    int sphereAcmIndex(
+        const AttachedBodiesCollisionState& state,
+        int ssidx,
+        const CollisionSphereModel* s) const;
 
     bool checkCommonInputs(
         const RobotCollisionState& state,
@@ -91,6 +91,7 @@ private:
     const WorldCollisionModel* m_wcm;
 
     mutable std::vector<const CollisionSphereState*> m_vq;
+    mutable SphereBatch m_batch;
 
     bool checkRobotSpheresStateCollisions(
         RobotCollisionState& state,
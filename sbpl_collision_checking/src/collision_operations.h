@@ -32,6 +32,9 @@
 #ifndef sbpl_collision_collision_operations_h
 #define sbpl_collision_collision_operations_h
 
+// standard includes
+#include <algorithm>
+
 // system includes
 #include <ros/console.h>
 #include <smpl/occupancy_grid.h>
@@ -61,8 +64,21 @@ bool CheckVoxelsCollisions(
     double padding,
     double& dist);
 
+template <typename StateType>
+bool CheckVoxelsCollisionsBatched(
+    StateType& state,
+    std::vector<const CollisionSphereState*>& q,
+    const OccupancyGrid& grid,
+    double padding,
+    SphereBatch& batch,
+    double& dist);
+
 static const char* COP_LOGGER = "collision_operations";
 
+/// Number of spheres whose distances are looked up before testing them for
+/// collision, bounding the work wasted past the first colliding sphere.
+static const int SPHERE_BATCH_BLOCK_SIZE = 16;
+
 /// Check a single sphere against an occupancy grid
 inline
 bool CheckSphereCollision(
@@ -164,6 +180,74 @@ bool CheckVoxelsCollisions(
     return true;
 }
 
+/// Check sphere hierarchies for collisions against an occupancy grid, one
+/// level of the hierarchies at a time
+///
+/// Equivalent to CheckVoxelsCollisions(), but gathers each level into
+/// structure-of-arrays storage so that distances are looked up in batches
+/// rather than with a virtual call per sphere.
+///
+/// \param q The roots of all collision sphere trees to check; used as storage
+///     for the next level of the traversal
+/// \param batch Scratch storage for the current level of the traversal
+template <typename StateType>
+bool CheckVoxelsCollisionsBatched(
+    StateType& state,
+    std::vector<const CollisionSphereState*>& q,
+    const OccupancyGrid& grid,
+    double padding,
+    SphereBatch& batch,
+    double& dist)
+{
+    while (!q.empty()) {
+        batch.clear();
+        for (const CollisionSphereState* s : q) {
+            if (s->parent_state->index != -1) {
+                state.updateSphereState(SphereIndex(s->parent_state->index, s->index()));
+            }
+            batch.push_back(s, padding);
+        }
+        q.clear();
+
+        const int count = (int)batch.size();
+        batch.d2.resize(count);
+        for (int b = 0; b < count; b += SPHERE_BATCH_BLOCK_SIZE) {
+            const int n = std::min(SPHERE_BATCH_BLOCK_SIZE, count - b);
+            grid.getSquaredDists(
+                    &batch.x[b], &batch.y[b], &batch.z[b], n, &batch.d2[b]);
+            for (int i = b; i < b + n; ++i) {
+                if (batch.d2[i] >= batch.rr[i]) {
+                    continue; // no collision -> ok!
+                }
+
+                const CollisionSphereState* s = batch.spheres[i];
+                if (s->isLeaf()) {
+                    if (s->parent_state->index == -1) { // meta-leaf
+                        const CollisionSphereState* sl = s->left->left;
+                        const CollisionSphereState* sr = s->right->right;
+                        if (sl) {
+                            q.push_back(sl);
+                        }
+                        if (sr) {
+                            q.push_back(sr);
+                        }
+                    } else { // normal leaf
+                        dist = batch.d2[i];
+                        ROS_DEBUG_NAMED(COP_LOGGER, "    *collision* name: %s, pos: (%0.3f, %0.3f, %0.3f), radius: %0.3fm, dist: %0.3fm", s->model->name.c_str(), s->pos.x(), s->pos.y(), s->pos.z(), s->model->radius, dist);
+                        return false;
+                    }
+                } else {
+                    q.push_back(s->left);
+                    q.push_back(s->right);
+                }
+            }
+        }
+    }
+
+    ROS_DEBUG_NAMED(COP_LOGGER, "No voxels collisions");
+    return true;
+}
+
 } // namespace collision
 } // namespace smpl
 
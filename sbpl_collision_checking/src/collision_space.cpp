@@ -34,6 +34,8 @@
 
 // standard includes
 #include <assert.h>
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <utility>
 #include <queue>
@@ -116,6 +118,15 @@ void CollisionSpace::setPadding(double padding)
     m_scm->setPadding(padding);
 }
 
+/// \brief Set the resolution at which motions are interpolated for validation
+///
+/// The resolution is the maximum distance any sphere on the robot may travel
+/// between two consecutive waypoints along a motion.
+void CollisionSpace::setInterpolationResolution(double res)
+{
+    m_interp_res = res;
+}
+
 /// \brief Return the allowed collision matrix
 /// \return The allowed collision matrix
 const AllowedCollisionMatrix& CollisionSpace::allowedCollisionMatrix() const
@@ -203,7 +214,17 @@ bool CollisionSpace::attachObject(
     const Affine3dVector& transforms,
     const std::string& link_name)
 {
-    return m_abcm->attachBody(id, shapes, transforms, link_name);
+    if (!m_abcm->attachBody(id, shapes, transforms, link_name)) {
+        return false;
+    }
+
+    AttachedObject object;
+    object.id = id;
+    object.shapes = shapes;
+    object.transforms = transforms;
+    object.link_name = link_name;
+    m_attached_objects.push_back(std::move(object));
+    return true;
 }
 
 /// \brief Detach a collision object from the robot
@@ -211,7 +232,15 @@ bool CollisionSpace::attachObject(
 /// \return true if the object was detached; false otherwise
 bool CollisionSpace::detachObject(const std::string& id)
 {
-    return m_abcm->detachBody(id);
+    if (!m_abcm->detachBody(id)) {
+        return false;
+    }
+
+    m_attached_objects.erase(std::remove_if(
+            begin(m_attached_objects), end(m_attached_objects),
+            [&](const AttachedObject& object) { return object.id == id; }),
+            end(m_attached_objects));
+    return true;
 }
 
 /// \brief Return a visualization of the current world
@@ -394,7 +423,9 @@ bool CollisionSpace::collisionDetails(
 
 Extension* CollisionSpace::getExtension(size_t class_code)
 {
-    if (class_code == GetClassCode<CollisionChecker>()) {
+    if (class_code == GetClassCode<CollisionChecker>() ||
+        class_code == GetClassCode<CollisionCheckerCloneExtension>())
+    {
         return this;
     }
     return nullptr;
@@ -406,48 +437,143 @@ bool CollisionSpace::isStateValid(const RobotState& state, bool verbose)
     return checkCollision(state, dist);
 }
 
+/// Return the number of waypoints, beyond a waypoint with the given clearance,
+/// that are guaranteed to be collision-free, given an upper bound on the loss
+/// of separation between waypoints.
+static
+int CertifiedWaypointCount(double clearance, double step_motion, int count)
+{
+    if (clearance <= 0.0) {
+        return 0;
+    }
+    if (step_motion <= 0.0) {
+        return count;
+    }
+    auto n = std::ceil(clearance / step_motion) - 1.0;
+    return (int)std::min(n, (double)count);
+}
+
+/// Check a waypoint for collisions between the robot's spheres, ignoring the
+/// occupied voxels.
+bool CollisionSpace::checkSpheresCollision(const RobotState& state)
+{
+    double dist = std::numeric_limits<double>::max();
+    updateState(state);
+    return m_scm->checkSpheresCollision(*m_rcs, *m_abcs, m_gidx, dist);
+}
+
+/// Check the validity of a waypoint. Return a negative value if the waypoint is
+/// in collision. Otherwise, return a lower bound on the separation distance
+/// between the robot and the occupied voxels, or 0 if no bound is known.
+///
+/// Only the separation from the occupied voxels is bounded. Self collisions
+/// must still be checked at every waypoint certified by this clearance.
+double CollisionSpace::waypointClearance(const RobotState& state, bool verbose)
+{
+    // separation distances are not computed for attached bodies
+    if (m_certify_motions && m_abcm->attachedBodyCount() == 0) {
+        // obstacle distances are looked up at the center of the cell containing
+        // each sphere, so the distance measured here and the one tested at a
+        // certified waypoint may each be off by half a cell diagonal. The
+        // padding is removed as well, as slack.
+        auto margin = std::sqrt(3.0) * m_grid->resolution() + m_wcm->padding();
+        updateState(state);
+        auto d = m_scm->voxelsCollisionDistance(*m_rcs, *m_abcs, m_gidx) - margin;
+        if (d > 0.0) {
+            return checkSpheresCollision(state) ? d : -1.0;
+        }
+    }
+
+    return isStateValid(state, verbose) ? 0.0 : -1.0;
+}
+
+/// Check the motion between two states for validity.
+///
+/// The motion is interpolated such that no sphere travels further than the
+/// interpolation resolution between consecutive waypoints. Waypoints are
+/// checked coarse-to-fine, beginning with the endpoints and then recursively
+/// bisecting the path, so that collisions anywhere along the motion are found
+/// early. When possible, the separation distance from the occupied voxels at
+/// each checked waypoint is used, along with the maximum sphere motion between
+/// waypoints, to skip checking nearby waypoints against the voxels. Every
+/// waypoint is checked for self collisions.
 bool CollisionSpace::isStateToStateValid(
     const RobotState& start,
     const RobotState& finish,
     bool verbose)
 {
-    const double res = 0.05;
+    auto& variables = m_planning_joint_to_collision_model_indices;
 
     MotionInterpolation interp(m_rcm.get());
 
     m_rmcm->fillMotionInterpolation(
             start,
             finish,
-            m_planning_joint_to_collision_model_indices,
-            res,
+            variables,
+            m_interp_res,
             interp);
 
-    const int inc_cc = 5;
-
-    RobotState interm;
-
-    // TODO: Looks like the idea here is to collision check the path starting at
-    // the most coarse resolution (just the endpoints) and increasing the
-    // granularity until all points are checked. This could probably be made
-    // irrespective of the number of waypoints by bisecting the path and
-    // checking the endpoints recursively.
-    if (interp.waypointCount() > inc_cc) {
-        // try to find collisions that might come later in the path earlier
-        for (int i = 0; i < inc_cc; i++) {
-            for (size_t j = i; j < interp.waypointCount(); j = j + inc_cc) {
-                interp.interpolate(j, interm, m_planning_joint_to_collision_model_indices);
-                if (!isStateValid(interm, verbose)) {
+    auto count = interp.waypointCount();
+    if (count == 0) {
+        return true;
+    }
+
+    // upper bound on the separation lost between adjacent waypoints, with
+    // slack for the voxels of links outside the group, which may move with
+    // the state as well
+    auto step_motion = 2.0 *
+            m_rmcm->getMaxSphereMotion(start, finish, variables) /
+            (double)(count - 1);
+
+    auto& waypoint = m_waypoint;
+
+    interp.interpolate(0, waypoint, variables);
+    auto first_clearance = waypointClearance(waypoint, verbose);
+    if (first_clearance < 0.0) {
+        return false;
+    }
+
+    interp.interpolate(count - 1, waypoint, variables);
+    auto last_clearance = waypointClearance(waypoint, verbose);
+    if (last_clearance < 0.0) {
+        return false;
+    }
+
+    // breadth-first bisection of intervals whose endpoints have been checked
+    auto& q = m_waypoint_intervals;
+    q.clear();
+    q.push_back(WaypointInterval{
+            0, count - 1, first_clearance, last_clearance });
+    for (size_t q_head = 0; q_head < q.size(); ++q_head) {
+        auto interval = q[q_head];
+
+        // waypoints (first, lo] and [hi, last) are certified collision-free
+        auto lo = interval.first + CertifiedWaypointCount(
+                interval.first_clearance, step_motion, count);
+        auto hi = interval.last - CertifiedWaypointCount(
+                interval.last_clearance, step_motion, count);
+        if (lo + 1 >= hi) {
+            // the certified waypoints are only known to be clear of the voxels
+            for (auto i = interval.first + 1; i < interval.last; ++i) {
+                interp.interpolate(i, waypoint, variables);
+                if (!checkSpheresCollision(waypoint)) {
                     return false;
                 }
             }
+            continue;
         }
-    } else {
-        for (size_t i = 0; i < interp.waypointCount(); i++) {
-            interp.interpolate(i, interm, m_planning_joint_to_collision_model_indices);
-            if (!isStateValid(interm, verbose)) {
-                return false;
-            }
+
+        auto mid = (lo + hi) / 2;
+        interp.interpolate(mid, waypoint, variables);
+        auto mid_clearance = waypointClearance(waypoint, verbose);
+        if (mid_clearance < 0.0) {
+            return false;
         }
+
+        q.push_back(WaypointInterval{
+                interval.first, mid, interval.first_clearance, mid_clearance });
+        q.push_back(WaypointInterval{
+                mid, interval.last, mid_clearance, interval.last_clearance });
     }
 
     return true;
@@ -469,14 +595,12 @@ bool CollisionSpace::interpolatePath(
         return false;
     }
 
-    const double res = 0.05;
-
     MotionInterpolation interp(m_rcm.get());
     m_rmcm->fillMotionInterpolation(
             start,
             finish,
             m_planning_joint_to_collision_model_indices,
-            res,
+            m_interp_res,
             interp);
     opath.resize(interp.waypointCount());
     for (int i = 0; i < interp.waypointCount(); ++i) {
@@ -586,6 +710,21 @@ bool CollisionSpace::init(
     m_group_name = group_name;
     m_gidx = m_rcm->groupIndex(m_group_name);
 
+    // motion bounds are not computed for planar and floating joints
+    m_certify_motions = true;
+    for (auto vidx : m_planning_joint_to_collision_model_indices) {
+        switch (m_rcm->jointType(m_rcm->jointVarJointIndex(vidx))) {
+        case JointType::FIXED:
+        case JointType::REVOLUTE:
+        case JointType::CONTINUOUS:
+        case JointType::PRISMATIC:
+            break;
+        default:
+            m_certify_motions = false;
+            break;
+        }
+    }
+
     m_rmcm = std::make_shared<RobotMotionCollisionModel>(m_rcm.get());
     m_abcm = std::make_shared<AttachedBodiesCollisionModel>(m_rcm.get()),
     m_rcs = std::make_shared<RobotCollisionState>(m_rcm.get());
@@ -600,6 +739,54 @@ bool CollisionSpace::init(
     return true;
 }
 
+/// \brief Create an independent collision space for the same robot and group
+///
+/// The clone shares this collision space's (immutable) robot collision model
+/// and copies its joint positions, world-to-model transform, padding,
+/// interpolation resolution, allowed collision matrix, and attached objects,
+/// so that it may be used to check states concurrently with this collision
+/// space, e.g. by an edge validation worker.
+///
+/// \param grid The occupancy grid used by the clone. Collision checks update
+///     the grid with the voxels models of links outside the planning group,
+///     so clones used concurrently should be given their own copy of the grid
+///     if the robot has voxels models. Defaults to this collision space's grid.
+auto CollisionSpace::clone(OccupancyGrid* grid) const
+    -> std::unique_ptr<CollisionSpace>
+{
+    std::unique_ptr<CollisionSpace> cspace(new CollisionSpace);
+    if (!cspace->init(
+            grid ? grid : m_grid,
+            m_rcm,
+            m_group_name,
+            m_planning_variables))
+    {
+        return nullptr;
+    }
+
+    cspace->m_joint_vars = m_joint_vars;
+    cspace->copyState();
+    cspace->setWorldToModelTransform(m_rcs->worldToModelTransform());
+    cspace->setPadding(m_wcm->padding());
+    cspace->setInterpolationResolution(m_interp_res);
+    cspace->setAllowedCollisionMatrix(m_scm->allowedCollisionMatrix());
+    for (auto& object : m_attached_objects) {
+        if (!cspace->attachObject(
+                object.id, object.shapes, object.transforms, object.link_name))
+        {
+            return nullptr;
+        }
+    }
+    return cspace;
+}
+
+/// Clone the collision space, sharing this collision space's occupancy grid.
+/// See clone().
+auto CollisionSpace::cloneCollisionChecker() -> std::unique_ptr<CollisionChecker>
+{
+    return clone();
+}
+
 void CollisionSpace::updateState(const std::vector<double>& vals)
 {
     updateState(m_joint_vars, vals);
@@ -224,6 +224,10 @@ bool RobotCollisionModel::initRobotModel(
         }
     }
 
+    if (!compileFKProgram()) {
+        return false;
+    }
+
     ROS_DEBUG_NAMED(LOG, "ComputeFixedJointTransform: %p", ComputeFixedJointTransform);
     ROS_DEBUG_NAMED(LOG, "ComputeRevoluteJointTransform: %p", ComputeRevoluteJointTransform);
     ROS_DEBUG_NAMED(LOG, "ComputeContinuousJointTransform: %p", ComputeContinuousJointTransform);
@@ -268,6 +272,69 @@ bool RobotCollisionModel::initRobotModel(
     return true;
 }
 
+// Compile the kinematic tree into a sequence of ops, one per link, indexed by
+// link. Links are numbered in the order of a depth-first traversal, so the op
+// for a link always follows the op for its parent.
+bool RobotCollisionModel::compileFKProgram()
+{
+    m_fk_program.resize(m_link_names.size());
+    for (size_t lidx = 0; lidx < m_link_names.size(); ++lidx) {
+        FKOp& op = m_fk_program[lidx];
+
+        const int jidx = m_link_parent_joints[lidx];
+        op.parent = m_joint_parent_links[jidx];
+        op.var = m_joint_var_indices[jidx].first;
+        op.fn = m_joint_transforms[jidx];
+
+        if (op.parent >= (int)lidx) {
+            ROS_ERROR_NAMED(LOG, "Link '%s' precedes its parent link", m_link_names[lidx].c_str());
+            return false;
+        }
+
+        const Eigen::Affine3d& origin = m_joint_origins[jidx];
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 3; ++r) {
+                op.origin[3 * c + r] = origin(r, c);
+            }
+        }
+
+        const Eigen::Vector3d& axis = m_joint_axes[jidx];
+        op.axis[0] = axis.x();
+        op.axis[1] = axis.y();
+        op.axis[2] = axis.z();
+
+        switch (m_joint_types[jidx]) {
+        case FIXED:
+            op.code = FKOp::Fixed;
+            break;
+        case REVOLUTE:
+        case CONTINUOUS:
+            if (axis == Eigen::Vector3d::UnitX()) {
+                op.code = FKOp::RevoluteX;
+            } else if (axis == Eigen::Vector3d::UnitY()) {
+                op.code = FKOp::RevoluteY;
+            } else if (axis == Eigen::Vector3d::UnitZ()) {
+                op.code = FKOp::RevoluteZ;
+            } else {
+                op.code = FKOp::Revolute;
+            }
+            break;
+        case PRISMATIC: {
+            op.code = FKOp::Prismatic;
+            const Eigen::Vector3d axis_parent = origin.linear() * axis;
+            op.axis[0] = axis_parent.x();
+            op.axis[1] = axis_parent.y();
+            op.axis[2] = axis_parent.z();
+        }   break;
+        default:
+            op.code = FKOp::General;
+            break;
+        }
+    }
+
+    return true;
+}
+
 void RobotCollisionModel::addJoint(const ::urdf::Joint& joint)
 {
     m_joint_names.push_back(joint.name);
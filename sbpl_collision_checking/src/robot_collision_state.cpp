@@ -66,7 +66,7 @@ bool RobotCollisionState::setJointVarPosition(int vidx, double position)
 
         const int jidx = m_model->jointVarJointIndex(vidx);
 
-        m_dirty_joint_transforms[jidx] = true;
+        m_dirty_joint_transforms[m_model->jointChildLinkIndex(jidx)] = true;
 
         // TODO: cache affected link transforms in a per-joint array?
 
@@ -110,7 +110,7 @@ bool RobotCollisionState::setJointVarPositions(const double* positions)
         if (m_jvar_positions[vidx] != positions[vidx]) {
             m_jvar_positions[vidx] = positions[vidx];
             const int jidx = m_model->jointVarJointIndex(vidx);
-            m_dirty_joint_transforms[jidx] = true;
+            m_dirty_joint_transforms[m_model->jointChildLinkIndex(jidx)] = true;
             bool add = true;
             for (int& ancestor : ancestors) {
                 if (m_model->isDescendantJoint(jidx, ancestor)) {
@@ -165,6 +165,75 @@ bool RobotCollisionState::setJointVarPositions(const double* positions)
     return true;
 }
 
+// The parent frame of the world joint is the model frame.
+static
+auto ParentLinkTransform(const Affine3dVector& link_transforms, const FKOp& op)
+    -> const Eigen::Affine3d&
+{
+    static const Eigen::Affine3d identity(Eigen::Affine3d::Identity());
+    return op.parent >= 0 ? link_transforms[op.parent] : identity;
+}
+
+bool RobotCollisionState::updateLinkTransforms()
+{
+    ROS_DEBUG_NAMED(RCS_LOGGER, "Updating all link transforms");
+
+    // the program is ordered so that parent links are updated before their
+    // children
+    const std::vector<FKOp>& program = m_model->fkProgram();
+    const double* jvals = m_jvar_positions.data();
+    bool updated = false;
+    for (size_t lidx = 0; lidx < program.size(); ++lidx) {
+        if (!m_dirty_link_transforms[lidx]) {
+            continue;
+        }
+        const FKOp& op = program[lidx];
+        double* J = &m_joint_transforms[12 * lidx];
+        if (m_dirty_joint_transforms[lidx]) {
+            ComputeJointTransform(op, jvals, J);
+            m_dirty_joint_transforms[lidx] = false;
+        }
+        ComputeLinkTransform(
+                ParentLinkTransform(m_link_transforms, op),
+                J,
+                m_link_transforms[lidx]);
+        m_dirty_link_transforms[lidx] = false;
+        ++m_link_transform_versions[lidx];
+        updated = true;
+    }
+    return updated;
+}
+
+bool RobotCollisionState::updateLinkTransform(int lidx)
+{
+    ASSERT_VECTOR_RANGE(m_dirty_link_transforms, lidx);
+    if (!m_dirty_link_transforms[lidx]) {
+        return false;
+    }
+
+    const FKOp& op = m_model->linkFKOp(lidx);
+
+    ROS_DEBUG_NAMED(RCS_LOGGER, "Updating transform for link '%s'. parent link = %d", m_model->linkName(lidx).c_str(), op.parent);
+
+    if (op.parent >= 0) {
+        updateLinkTransform(op.parent);
+    }
+
+    double* J = &m_joint_transforms[12 * lidx];
+    if (m_dirty_joint_transforms[lidx]) {
+        ComputeJointTransform(op, m_jvar_positions.data(), J);
+        m_dirty_joint_transforms[lidx] = false;
+    }
+    ComputeLinkTransform(
+            ParentLinkTransform(m_link_transforms, op), J, m_link_transforms[lidx]);
+
+    ROS_DEBUG_NAMED(RCS_LOGGER, " -> %s", AffineToString(m_link_transforms[lidx]).c_str());
+
+    m_dirty_link_transforms[lidx] = false;
+    ++m_link_transform_versions[lidx];
+    return true;
+}
+
 auto RobotCollisionState::getVisualization() const
     -> visualization_msgs::MarkerArray
 {
@@ -245,8 +314,8 @@ void RobotCollisionState::initRobotState()
         }
     }
 
-    m_dirty_joint_transforms.assign(m_model->jointCount(), true);
-    m_joint_transforms.assign(m_model->jointCount(), Eigen::Affine3d::Identity());
+    m_dirty_joint_transforms.assign(m_model->linkCount(), true);
+    m_joint_transforms.assign(12 * m_model->linkCount(), 0.0);
 
     m_dirty_link_transforms.assign(m_model->linkCount(), true);
     m_link_transforms.assign(m_model->linkCount(), Eigen::Affine3d::Identity());
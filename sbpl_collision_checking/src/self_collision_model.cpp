@@ -31,6 +31,9 @@
 
 #include <sbpl_collision_checking/self_collision_model.h>
 
+// standard includes
+#include <algorithm>
+
 // system includes
 #include <leatherman/print.h>
 #include <smpl/geometry/triangle.h>
@@ -62,6 +65,15 @@ SelfCollisionModel::SelfCollisionModel(
     m_checked_attached_body_robot_spheres_states(),
     m_acm(),
     m_padding(0.0),
+    m_acm_entry_indices(),
+    m_acm_words(0),
+    m_acm_entry_bits(),
+    m_acm_allowed_bits(),
+    m_robot_sphere_acm_offsets(),
+    m_robot_sphere_acm_indices(),
+    m_ab_sphere_acm_offsets(),
+    m_ab_sphere_acm_indices(),
+    m_ab_version(-1),
 #if SCDL_USE_META_TREE
     m_model_state_map(),
     m_root_models(),
@@ -106,10 +118,124 @@ void SelfCollisionModel::initAllowedCollisionMatrix()
             m_acm.setEntry(link_name, child_link_name, true);
         }
     }
+    compileAllowedCollisionMatrix();
     // NOTE: no need to update checked sphere indices here, they will be updated
     // when the first request with a valid group index is received
 }
 
+/// Compile the allowed collision matrix into bit matrices indexed by entry
+/// and map all robot and attached body spheres onto them.
+void SelfCollisionModel::compileAllowedCollisionMatrix()
+{
+    ROS_DEBUG_NAMED(SCM_LOGGER, "Compile allowed collision matrix");
+    std::vector<std::string> names;
+    m_acm.getAllEntryNames(names);
+
+    m_acm_entry_indices.clear();
+    for (size_t i = 0; i < names.size(); ++i) {
+        m_acm_entry_indices[names[i]] = (int)i;
+    }
+
+    m_acm_words = (int)((names.size() + 63) / 64);
+    m_acm_entry_bits.assign(names.size() * m_acm_words, 0);
+    m_acm_allowed_bits.assign(names.size() * m_acm_words, 0);
+
+    collision_detection::AllowedCollision::Type type;
+    for (size_t i = 0; i < names.size(); ++i) {
+        for (size_t j = 0; j < names.size(); ++j) {
+            if (!m_acm.getEntry(names[i], names[j], type)) {
+                continue;
+            }
+            const size_t w = i * m_acm_words + (j >> 6);
+            const std::uint64_t b = std::uint64_t(1) << (j & 63);
+            m_acm_entry_bits[w] |= b;
+            if (type == collision_detection::AllowedCollision::ALWAYS) {
+                m_acm_allowed_bits[w] |= b;
+            }
+        }
+    }
+
+    compileRobotSphereIndices();
+    compileAttachedBodySphereIndices();
+}
+
+void SelfCollisionModel::compileRobotSphereIndices()
+{
+    m_robot_sphere_acm_offsets.clear();
+    m_robot_sphere_acm_indices.clear();
+    for (size_t smidx = 0; smidx < m_rcm->spheresModelCount(); ++smidx) {
+        m_robot_sphere_acm_offsets.push_back(
+                (int)m_robot_sphere_acm_indices.size());
+        for (auto& sphere : m_rcm->spheresModel(smidx).spheres) {
+            auto it = m_acm_entry_indices.find(sphere.name);
+            m_robot_sphere_acm_indices.push_back(
+                    it != end(m_acm_entry_indices) ? it->second : -1);
+        }
+    }
+}
+
+void SelfCollisionModel::compileAttachedBodySphereIndices()
+{
+    m_ab_sphere_acm_offsets.clear();
+    m_ab_sphere_acm_indices.clear();
+    for (size_t smidx = 0; smidx < m_abcm->spheresModelCount(); ++smidx) {
+        m_ab_sphere_acm_offsets.push_back((int)m_ab_sphere_acm_indices.size());
+        for (auto& sphere : m_abcm->spheresModel(smidx).spheres) {
+            auto it = m_acm_entry_indices.find(sphere.name);
+            m_ab_sphere_acm_indices.push_back(
+                    it != end(m_acm_entry_indices) ? it->second : -1);
+        }
+    }
+    m_ab_version = m_abcm->version();
+}
+
+/// Recompile the attached body portion of the allowed collision matrix and
+/// the set of checked spheres states when bodies have been attached or
+/// detached since the last check.
+void SelfCollisionModel::updateAttachedBodies()
+{
+    if (m_ab_version == m_abcm->version()) {
+        return;
+    }
+
+    ROS_DEBUG_NAMED(SCM_LOGGER, "Update attached bodies to version %d", m_abcm->version());
+    compileAttachedBodySphereIndices();
+    updateCheckedSpheresIndices();
+}
+
+inline
+bool SelfCollisionModel::acmEntry(int i, int j) const
+{
+    return m_acm_entry_bits[i * m_acm_words + (j >> 6)] &
+            (std::uint64_t(1) << (j & 63));
+}
+
+inline
+bool SelfCollisionModel::acmAllowed(int i, int j) const
+{
+    return m_acm_allowed_bits[i * m_acm_words + (j >> 6)] &
+            (std::uint64_t(1) << (j & 63));
+}
+
+inline
+int SelfCollisionModel::sphereAcmIndex(
+    const RobotCollisionState& state,
+    int ssidx,
+    const CollisionSphereModel* s) const
+{
+    return m_robot_sphere_acm_indices[
+            m_robot_sphere_acm_offsets[ssidx] + s->index()];
+}
+
+inline
+int SelfCollisionModel::sphereAcmIndex(
+    const AttachedBodiesCollisionState& state,
+    int ssidx,
+    const CollisionSphereModel* s) const
+{
+    return m_ab_sphere_acm_indices[m_ab_sphere_acm_offsets[ssidx] + s->index()];
+}
+
 /// Check that the input states are related to the collision models passed to
 /// the constructor.
 bool SelfCollisionModel::checkCommonInputs(
@@ -139,6 +265,7 @@ void SelfCollisionModel::prepareState(
     int gidx,
     const double* state)
 {
+    updateAttachedBodies();
     updateGroup(gidx);
     copyState(state);
     updateVoxelsStates();
@@ -179,6 +306,7 @@ void SelfCollisionModel::updateAllowedCollisionMatrix(
             }
         }
     }
+    compileAllowedCollisionMatrix();
     updateCheckedSpheresIndices();
 }
 
@@ -187,6 +315,7 @@ void SelfCollisionModel::setAllowedCollisionMatrix(
 {
     ROS_DEBUG_NAMED(SCM_LOGGER, "Overwrite allowed collision matrix");
     m_acm = acm;
+    compileAllowedCollisionMatrix();
     updateCheckedSpheresIndices();
 }
 
@@ -360,6 +489,44 @@ double SelfCollisionModel::collisionDistance(
     return d;
 }
 
+/// Return a lower bound on the distance between the group's spheres and the
+/// occupied voxels of the world and of the links outside the group. Collisions
+/// between spheres are not considered; see checkSpheresCollision().
+double SelfCollisionModel::voxelsCollisionDistance(
+    const RobotCollisionState& state,
+    const AttachedBodiesCollisionState& ab_state,
+    const int gidx)
+{
+    if (!checkCommonInputs(state, ab_state, gidx)) {
+        return 0.0;
+    }
+
+    prepareState(gidx, state.getJointVarPositions());
+
+    return std::min(
+            robotVoxelsCollisionDistance(),
+            attachedBodyVoxelsCollisionDistance());
+}
+
+/// Check the group's spheres, and those of attached bodies, for collisions
+/// with other spheres of the robot, subject to the allowed collision matrix.
+/// Collisions with occupied voxels are not considered.
+bool SelfCollisionModel::checkSpheresCollision(
+    const RobotCollisionState& state,
+    const AttachedBodiesCollisionState& ab_state,
+    const int gidx,
+    double& dist)
+{
+    if (!checkCommonInputs(state, ab_state, gidx)) {
+        return false;
+    }
+
+    prepareState(gidx, state.getJointVarPositions());
+
+    return checkRobotSpheresStateCollisions(dist) &&
+            checkAttachedBodySpheresStateCollisions(dist);
+}
+
 bool SelfCollisionModel::collisionDetails(
     const RobotCollisionState& state,
     const AttachedBodiesCollisionState& ab_state,
@@ -992,14 +1159,9 @@ bool SelfCollisionModel::checkSpheresStateCollision(
 
         if (s1s->isLeaf() && s2s->isLeaf()) {
             // collision found! check acm
-            collision_detection::AllowedCollision::Type type;
-            if (m_acm.getEntry(s1m->name, s2m->name, type)) {
-                if (type != collision_detection::AllowedCollision::ALWAYS) {
-                    ROS_DEBUG_NAMED(SCM_LOGGER, "  *collision* '%s' x '%s'", s1m->name.c_str(), s2m->name.c_str());
-                    dist = cd2;
-                    return false;
-                }
-            } else {
+            const int a1 = sphereAcmIndex(stateA, ss1i, s1m);
+            const int a2 = sphereAcmIndex(stateB, ss2i, s2m);
+            if (a1 < 0 || a2 < 0 || !acmAllowed(a1, a2)) {
                 ROS_DEBUG_NAMED(SCM_LOGGER, "  *collision* '%s' x '%s'", s1m->name.c_str(), s2m->name.c_str());
                 dist = cd2;
                 return false;
@@ -1118,9 +1280,10 @@ bool SelfCollisionModel::checkSpheresStateCollision(
 
         if (s1s->isLeaf() && s2s->isLeaf()) {
             // collision found! check acm
-            collision_detection::AllowedCollision::Type type;
-            if (m_acm.getEntry(s1m->name, s2m->name, type)) {
-                if (type != collision_detection::AllowedCollision::ALWAYS) {
+            const int a1 = sphereAcmIndex(stateA, ss1i, s1m);
+            const int a2 = sphereAcmIndex(stateB, ss2i, s2m);
+            if (a1 >= 0 && a2 >= 0 && acmEntry(a1, a2)) {
+                if (!acmAllowed(a1, a2)) {
                     ROS_DEBUG_NAMED(SCM_LOGGER, "  *collision* '%s' x '%s'", s1m->name.c_str(), s2m->name.c_str());
                     dist = cd2;
                     return false;
@@ -1279,7 +1442,6 @@ void SelfCollisionModel::updateRobotCheckedSphereIndices()
 
 void SelfCollisionModel::updateRobotAttachedBodyCheckedSphereIndices()
 {
-    // TODO: see note in updateAttachedBodyCheckedSphereIndices()
     m_checked_attached_body_robot_spheres_states.clear();
 
     const auto& group_body_indices = m_abcm->groupLinkIndices(m_gidx);
@@ -1318,8 +1480,6 @@ void SelfCollisionModel::updateRobotAttachedBodyCheckedSphereIndices()
 
 void SelfCollisionModel::updateAttachedBodyCheckedSphereIndices()
 {
-    // TODO: need to call this function whenever the attached bodies model has
-    // a body added or removed from it
     m_checked_attached_body_spheres_states.clear();
     const auto& group_body_indices = m_abcm->groupLinkIndices(m_gidx);
     for (int b1 = 0; b1 < group_body_indices.size(); ++b1) {
@@ -32,8 +32,12 @@
 #ifndef sbpl_collision_transform_functions_h
 #define sbpl_collision_transform_functions_h
 
+#include <cmath>
+
 #include <Eigen/Dense>
 
+#include <sbpl_collision_checking/robot_collision_model.h>
+
 #define SBPL_COLLISION_SPECIALIZED_JOINT_TRANSFORMS 1
 
 namespace smpl {
@@ -283,6 +287,142 @@ Eigen::Affine3d ComputeFixedJointTransform(
     return o;
 }
 
+/////////////////////////////////////
+// Compiled Forward Kinematics Ops //
+/////////////////////////////////////
+
+/// Compute the transform of a link relative to its parent link, the joint
+/// origin composed with the joint motion, from one op of a compiled forward
+/// kinematics program. \p jvals points to the positions of all joint
+/// variables and the result is written to \p J as a column-major 3x4 matrix.
+inline
+void ComputeJointTransform(const FKOp& op, const double* jvals, double* J)
+{
+    const double* o = op.origin;
+
+    switch (op.code) {
+    case FKOp::Fixed: {
+        for (int i = 0; i < 12; ++i) {
+            J[i] = o[i];
+        }
+        break;
+    }
+    case FKOp::RevoluteX: {
+        const double q = jvals[op.var];
+        const double c = std::cos(q);
+        const double s = std::sin(q);
+        for (int r = 0; r < 3; ++r) {
+            J[r] = o[r];
+            J[3 + r] = c * o[3 + r] + s * o[6 + r];
+            J[6 + r] = c * o[6 + r] - s * o[3 + r];
+            J[9 + r] = o[9 + r];
+        }
+        break;
+    }
+    case FKOp::RevoluteY: {
+        const double q = jvals[op.var];
+        const double c = std::cos(q);
+        const double s = std::sin(q);
+        for (int r = 0; r < 3; ++r) {
+            J[r] = c * o[r] - s * o[6 + r];
+            J[3 + r] = o[3 + r];
+            J[6 + r] = s * o[r] + c * o[6 + r];
+            J[9 + r] = o[9 + r];
+        }
+        break;
+    }
+    case FKOp::RevoluteZ: {
+        const double q = jvals[op.var];
+        const double c = std::cos(q);
+        const double s = std::sin(q);
+        for (int r = 0; r < 3; ++r) {
+            J[r] = c * o[r] + s * o[3 + r];
+            J[3 + r] = c * o[3 + r] - s * o[r];
+            J[6 + r] = o[6 + r];
+            J[9 + r] = o[9 + r];
+        }
+        break;
+    }
+    case FKOp::Revolute: {
+        // rotation about the axis by Rodrigues' formula, premultiplied by the
+        // origin rotation
+        const double q = jvals[op.var];
+        const double c = std::cos(q);
+        const double s = std::sin(q);
+        const double t = 1.0 - c;
+        const double x = op.axis[0], y = op.axis[1], z = op.axis[2];
+        const double R[9] = {
+            t * x * x + c,     t * x * y + s * z, t * x * z - s * y,
+            t * x * y - s * z, t * y * y + c,     t * y * z + s * x,
+            t * x * z + s * y, t * y * z - s * x, t * z * z + c,
+        };
+        for (int k = 0; k < 3; ++k) {
+            for (int r = 0; r < 3; ++r) {
+                J[3 * k + r] =
+                        o[r] * R[3 * k] +
+                        o[3 + r] * R[3 * k + 1] +
+                        o[6 + r] * R[3 * k + 2];
+            }
+        }
+        J[9] = o[9];
+        J[10] = o[10];
+        J[11] = o[11];
+        break;
+    }
+    case FKOp::Prismatic: {
+        const double q = jvals[op.var];
+        for (int i = 0; i < 9; ++i) {
+            J[i] = o[i];
+        }
+        J[9] = o[9] + q * op.axis[0];
+        J[10] = o[10] + q * op.axis[1];
+        J[11] = o[11] + q * op.axis[2];
+        break;
+    }
+    case FKOp::General: {
+        Eigen::Affine3d origin(Eigen::Affine3d::Identity());
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 3; ++r) {
+                origin(r, c) = o[3 * c + r];
+            }
+        }
+        const Eigen::Vector3d axis(op.axis[0], op.axis[1], op.axis[2]);
+        const Eigen::Affine3d T =
+                op.fn(origin, axis, const_cast<double*>(jvals + op.var));
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 3; ++r) {
+                J[3 * c + r] = T(r, c);
+            }
+        }
+        break;
+    }
+    }
+}
+
+/// Compute the transform of a link from the transform of its parent link and
+/// the joint transform computed by ComputeJointTransform(). Only the upper
+/// 3x4 block of \p T_model_link is written.
+inline
+void ComputeLinkTransform(
+    const Eigen::Affine3d& T_model_parent,
+    const double* J,
+    Eigen::Affine3d& T_model_link)
+{
+    const double* P = T_model_parent.data();
+    double* T = T_model_link.data();
+    for (int c = 0; c < 4; ++c) {
+        const double j0 = J[3 * c + 0];
+        const double j1 = J[3 * c + 1];
+        const double j2 = J[3 * c + 2];
+        for (int r = 0; r < 3; ++r) {
+            T[4 * c + r] = P[r] * j0 + P[4 + r] * j1 + P[8 + r] * j2;
+        }
+    }
+    T[12] += P[12];
+    T[13] += P[13];
+    T[14] += P[14];
+}
+
 } // namespace collision
 } // namespace smpl
 
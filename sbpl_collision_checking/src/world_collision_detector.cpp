@@ -47,7 +47,8 @@ WorldCollisionDetector::WorldCollisionDetector(
 :
     m_rcm(rcm),
     m_wcm(wcm),
-    m_vq()
+    m_vq(),
+    m_batch()
 {
 }
 
@@ -145,7 +146,8 @@ bool WorldCollisionDetector::checkRobotSpheresStateCollisions(
         q.push_back(s);
     }
 
-    return CheckVoxelsCollisions(state, q, *m_wcm->grid(), m_wcm->padding(), dist);
+    return CheckVoxelsCollisionsBatched(
+            state, q, *m_wcm->grid(), m_wcm->padding(), m_batch, dist);
 }
 
 bool WorldCollisionDetector::checkAttachedBodySpheresStateCollisions(
@@ -163,7 +165,8 @@ bool WorldCollisionDetector::checkAttachedBodySpheresStateCollisions(
         q.push_back(s);
     }
 
-    return CheckVoxelsCollisions(state, q, *m_wcm->grid(), m_wcm->padding(), dist);
+    return CheckVoxelsCollisionsBatched(
+            state, q, *m_wcm->grid(), m_wcm->padding(), m_batch, dist);
 }
 
 } // namespace collision
@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+// standard includes
+#include <stdio.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+// system includes
+#include <Eigen/Dense>
+#include <smpl/occupancy_grid.h>
+
+// project includes
+#include <sbpl_collision_checking/base_collision_models.h>
+#include <sbpl_collision_checking/base_collision_states.h>
+#include <sbpl_collision_checking/collision_model_config.h>
+#include "../src/collision_operations.h"
+
+using namespace smpl::collision;
+
+// Sphere trees for a set of rigid links, placed by a pose per link
+struct LinkSpheres
+{
+    std::vector<std::unique_ptr<CollisionSpheresModel>> models;
+    std::vector<std::unique_ptr<CollisionSpheresState>> states;
+    std::vector<Eigen::Affine3d, Eigen::aligned_allocator<Eigen::Affine3d>> poses;
+
+    void updateSphereState(const SphereIndex& i)
+    {
+        auto& s = states[i.ss]->spheres[i.s];
+        s.pos = poses[i.ss] * s.model->center;
+    }
+};
+
+// A tree over the root spheres of the links, as built by SelfCollisionModel
+// when SCDL_USE_META_TREE is enabled, whose leaves refer to the link trees
+struct MetaSpheres
+{
+    std::vector<CollisionSphereModel> root_models;
+    std::vector<const CollisionSphereModel*> root_model_pointers;
+    CollisionSpheresModel model;
+    CollisionSpheresState state;
+
+    void build(LinkSpheres& links)
+    {
+        root_models.resize(links.states.size());
+        root_model_pointers.resize(links.states.size());
+        for (size_t i = 0; i < links.states.size(); ++i) {
+            auto* root = links.states[i]->spheres.root();
+            links.updateSphereState(SphereIndex((int)i, root->index()));
+            root_models[i].name = root->model->name;
+            root_models[i].center = root->pos;
+            root_models[i].radius = root->model->radius;
+            root_model_pointers[i] = &root_models[i];
+        }
+
+        model.link_index = -1;
+        model.spheres.buildFrom(root_model_pointers);
+        for (auto& sphere : model.spheres.m_tree) {
+            sphere.parent = &model;
+        }
+
+        state.model = &model;
+        state.index = -1;
+        state.spheres.buildFrom(&state);
+        for (auto& s : state.spheres) {
+            if (s.isLeaf()) {
+                auto i = std::distance(
+                        (const CollisionSphereModel*)root_models.data(),
+                        s.model->left);
+                s.left = links.states[i]->spheres.root();
+                s.right = s.left;
+            }
+        }
+    }
+};
+
+static
+void MakeLinkSpheres(
+    std::default_random_engine& rng,
+    int link_count,
+    int sphere_count,
+    LinkSpheres& links)
+{
+    std::uniform_real_distribution<double> pos_dist(-0.15, 0.15);
+    std::uniform_real_distribution<double> radius_dist(0.01, 0.05);
+    for (int l = 0; l < link_count; ++l) {
+        std::vector<CollisionSphereConfig> spheres(sphere_count);
+        for (int i = 0; i < sphere_count; ++i) {
+            auto& sphere = spheres[i];
+            sphere.name = "sphere" + std::to_string(i);
+            sphere.x = pos_dist(rng);
+            sphere.y = pos_dist(rng);
+            sphere.z = pos_dist(rng);
+            sphere.radius = radius_dist(rng);
+            sphere.priority = 1;
+        }
+
+        std::unique_ptr<CollisionSpheresModel> model(new CollisionSpheresModel);
+        model->link_index = l;
+        model->spheres.buildFrom(spheres);
+        for (auto& sphere : model->spheres.m_tree) {
+            sphere.parent = model.get();
+        }
+
+        std::unique_ptr<CollisionSpheresState> state(new CollisionSpheresState);
+        state->model = model.get();
+        state->index = l;
+        state->spheres.buildFrom(state.get());
+
+        links.models.push_back(std::move(model));
+        links.states.push_back(std::move(state));
+    }
+    links.poses.resize(link_count, Eigen::Affine3d::Identity());
+}
+
+// Check random placements of a set of links among random obstacles, with and
+// without a meta tree, and return the number of placements for which the
+// batched check disagrees with the scalar check
+static
+int CountDisagreements(int trials, int& collisions)
+{
+    std::default_random_engine rng;
+
+    const double res = 0.02;
+    smpl::OccupancyGrid grid(1.0, 1.0, 1.0, res, 0.0, 0.0, 0.0, 0.2);
+
+    std::uniform_real_distribution<double> unit_dist;
+    std::vector<Eigen::Vector3d> obstacles;
+    for (int i = 0; i < 20; ++i) {
+        obstacles.emplace_back(unit_dist(rng), unit_dist(rng), unit_dist(rng));
+    }
+    grid.addPointsToField(obstacles);
+
+    LinkSpheres links;
+    MakeLinkSpheres(rng, 6, 20, links);
+
+    std::vector<const CollisionSphereState*> q;
+    SphereBatch batch;
+
+    collisions = 0;
+    int disagreements = 0;
+    for (int t = 0; t < trials; ++t) {
+        for (auto& pose : links.poses) {
+            Eigen::Vector3d axis(
+                    unit_dist(rng) - 0.5, unit_dist(rng) - 0.5, unit_dist(rng) - 0.5);
+            pose = Eigen::Translation3d(
+                    0.2 + 0.6 * unit_dist(rng),
+                    0.2 + 0.6 * unit_dist(rng),
+                    0.2 + 0.6 * unit_dist(rng)) *
+                    Eigen::AngleAxisd(M_PI * unit_dist(rng), axis.normalized());
+        }
+
+        for (int padding_i = 0; padding_i < 2; ++padding_i) {
+            const double padding = 0.01 * padding_i;
+
+            double dist;
+
+            q.clear();
+            for (auto& state : links.states) {
+                q.push_back(state->spheres.root());
+            }
+            auto scalar = CheckVoxelsCollisions(links, q, grid, padding, dist);
+
+            q.clear();
+            for (auto& state : links.states) {
+                q.push_back(state->spheres.root());
+            }
+            auto batched = CheckVoxelsCollisionsBatched(
+                    links, q, grid, padding, batch, dist);
+
+            MetaSpheres meta;
+            meta.build(links);
+            q.clear();
+            q.push_back(meta.state.spheres.root());
+            auto meta_batched = CheckVoxelsCollisionsBatched(
+                    links, q, grid, padding, batch, dist);
+
+            if (!scalar) {
+                ++collisions;
+            }
+            if (batched != scalar || meta_batched != scalar) {
+                fprintf(stderr, "trial %d: scalar check %s, batched check %s, batched meta tree check %s\n",
+                        t,
+                        scalar ? "valid" : "invalid",
+                        batched ? "valid" : "invalid",
+                        meta_batched ? "valid" : "invalid");
+                ++disagreements;
+            }
+        }
+    }
+
+    return disagreements;
+}
+
+int main(int argc, char* argv[])
+{
+    const int trials = 1000;
+    int collisions;
+    auto disagreements = CountDisagreements(trials, collisions);
+    printf("%d of %d checks in collision, %d disagreements\n",
+            collisions, 2 * trials, disagreements);
+    if (collisions == 0 || collisions == 2 * trials) {
+        fprintf(stderr, "Checks do not cover both outcomes\n");
+        return 1;
+    }
+    return disagreements != 0;
+}
@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// \author Andrew Dornbush
+
+// standard includes
+#include <math.h>
+#include <stdio.h>
+#include <random>
+#include <vector>
+
+// system includes
+#include <Eigen/Dense>
+
+// project includes
+#include <sbpl_collision_checking/robot_collision_model.h>
+#include "../src/transform_functions.h"
+
+using namespace smpl::collision;
+
+typedef std::vector<Eigen::Affine3d, Eigen::aligned_allocator<Eigen::Affine3d>>
+        Affine3dVector;
+
+// A joint of a serial chain, with the number of variables it consumes
+struct ChainJoint
+{
+    FKOp::Code code;
+    Eigen::Affine3d origin;
+    Eigen::Vector3d axis;
+    JointTransformFunction fn;
+    int var_count;
+};
+
+static
+auto RandomTransform(std::default_random_engine& rng) -> Eigen::Affine3d
+{
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    return Eigen::Translation3d(dist(rng), dist(rng), dist(rng)) *
+            Eigen::Quaterniond(
+                    dist(rng), dist(rng), dist(rng), dist(rng)).normalized();
+}
+
+// The motion of a joint relative to its origin, computed directly from the
+// joint type, independently of the compiled ops and the Compute*Transform
+// functions
+static
+auto ReferenceJointMotion(const ChainJoint& joint, const double* q)
+    -> Eigen::Affine3d
+{
+    switch (joint.code) {
+    case FKOp::Fixed:
+        return Eigen::Affine3d::Identity();
+    case FKOp::RevoluteX:
+    case FKOp::RevoluteY:
+    case FKOp::RevoluteZ:
+    case FKOp::Revolute:
+        return Eigen::Affine3d(Eigen::AngleAxisd(q[0], joint.axis));
+    case FKOp::Prismatic:
+        return Eigen::Affine3d(Eigen::Translation3d(q[0] * joint.axis));
+    case FKOp::General:
+    default:
+        if (joint.var_count == 3) {
+            return Eigen::Translation3d(q[0], q[1], 0.0) *
+                    Eigen::AngleAxisd(q[2], Eigen::Vector3d::UnitZ());
+        } else {
+            return Eigen::Translation3d(q[0], q[1], q[2]) *
+                    Eigen::Quaterniond(q[6], q[3], q[4], q[5]);
+        }
+    }
+}
+
+// Build a serial chain whose first joint is a planar or floating world joint,
+// followed by one joint of every other op code, and return the largest
+// difference between the link transforms computed by the ops and the
+// reference transforms over random joint positions
+static
+double MaxLinkTransformError(bool floating_world_joint, int trials)
+{
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    const Eigen::Vector3d axis =
+            Eigen::Vector3d(dist(rng), dist(rng), dist(rng)).normalized();
+
+    std::vector<ChainJoint> joints;
+    if (floating_world_joint) {
+        joints.push_back({ FKOp::General, RandomTransform(rng), Eigen::Vector3d::Zero(), ComputeFloatingJointTransform, 7 });
+    } else {
+        joints.push_back({ FKOp::General, RandomTransform(rng), Eigen::Vector3d::Zero(), ComputePlanarJointTransform, 3 });
+    }
+    joints.push_back({ FKOp::RevoluteX, RandomTransform(rng), Eigen::Vector3d::UnitX(), ComputeRevoluteJointTransformX, 1 });
+    joints.push_back({ FKOp::RevoluteY, RandomTransform(rng), Eigen::Vector3d::UnitY(), ComputeRevoluteJointTransformY, 1 });
+    joints.push_back({ FKOp::RevoluteZ, RandomTransform(rng), Eigen::Vector3d::UnitZ(), ComputeRevoluteJointTransformZ, 1 });
+    joints.push_back({ FKOp::Revolute, RandomTransform(rng), axis, ComputeRevoluteJointTransform, 1 });
+    joints.push_back({ FKOp::Fixed, RandomTransform(rng), Eigen::Vector3d::Zero(), ComputeFixedJointTransform, 0 });
+    joints.push_back({ FKOp::Prismatic, RandomTransform(rng), axis, ComputePrismaticJointTransform, 1 });
+    joints.push_back({ FKOp::Revolute, RandomTransform(rng), axis, ComputeContinuousJointTransform, 1 });
+
+    // compile the chain as RobotCollisionModel does, one op per link with the
+    // prismatic axis rotated into the parent link frame
+    std::vector<FKOp> program(joints.size());
+    int var_count = 0;
+    for (size_t i = 0; i < joints.size(); ++i) {
+        auto& joint = joints[i];
+        auto& op = program[i];
+        op.code = joint.code;
+        op.parent = (int)i - 1;
+        op.var = var_count;
+        op.fn = joint.fn;
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 3; ++r) {
+                op.origin[3 * c + r] = joint.origin(r, c);
+            }
+        }
+        Eigen::Vector3d op_axis = joint.axis;
+        if (joint.code == FKOp::Prismatic) {
+            op_axis = joint.origin.linear() * joint.axis;
+        }
+        op.axis[0] = op_axis.x();
+        op.axis[1] = op_axis.y();
+        op.axis[2] = op_axis.z();
+        var_count += joint.var_count;
+    }
+
+    static const Eigen::Affine3d identity(Eigen::Affine3d::Identity());
+
+    std::vector<double> jvals(var_count);
+    Affine3dVector expected(joints.size(), identity);
+    Affine3dVector actual(joints.size(), identity);
+    double max_error = 0.0;
+    for (int t = 0; t < trials; ++t) {
+        for (auto& v : jvals) {
+            v = M_PI * dist(rng);
+        }
+        if (floating_world_joint) {
+            Eigen::Quaterniond q(jvals[6], jvals[3], jvals[4], jvals[5]);
+            q.normalize();
+            jvals[3] = q.x();
+            jvals[4] = q.y();
+            jvals[5] = q.z();
+            jvals[6] = q.w();
+        }
+
+        for (size_t i = 0; i < joints.size(); ++i) {
+            auto& op = program[i];
+            const Eigen::Affine3d& parent =
+                    op.parent >= 0 ? expected[op.parent] : identity;
+            expected[i] = parent * joints[i].origin *
+                    ReferenceJointMotion(joints[i], &jvals[op.var]);
+        }
+
+        for (size_t i = 0; i < program.size(); ++i) {
+            auto& op = program[i];
+            double J[12];
+            ComputeJointTransform(op, jvals.data(), J);
+            ComputeLinkTransform(
+                    op.parent >= 0 ? actual[op.parent] : identity,
+                    J,
+                    actual[i]);
+        }
+
+        for (size_t i = 0; i < joints.size(); ++i) {
+            auto error = (expected[i].matrix() - actual[i].matrix())
+                    .cwiseAbs().maxCoeff();
+            max_error = std::max(max_error, error);
+        }
+    }
+
+    return max_error;
+}
+
+int main(int argc, char* argv[])
+{
+    const double tolerance = 1e-9;
+    bool ok = true;
+    for (int floating = 0; floating < 2; ++floating) {
+        auto error = MaxLinkTransformError(floating != 0, 1000);
+        printf("%s world joint: max link transform error %g\n",
+                floating ? "floating" : "planar", error);
+        if (!(error < tolerance)) {
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
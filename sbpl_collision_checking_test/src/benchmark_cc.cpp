@@ -30,6 +30,7 @@
 /// \author Andrew Dornbush
 
 // standard includes
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <chrono>
@@ -44,6 +45,7 @@
 #include <smpl/distance_map/euclid_distance_map.h>
 #include <smpl/occupancy_grid.h>
 #include <sbpl_collision_checking/collision_space.h>
+#include <sbpl_collision_checking/robot_collision_state.h>
 #include <urdf/model.h>
 
 #include "pr2_allowed_collision_pairs.h"
@@ -152,6 +154,18 @@ public:
         int check_count;
     };
 
+    struct FKProfileResults
+    {
+        int reference_count;
+        int compiled_count;
+        double max_error;
+
+        // difference after moving the world joint through individual
+        // variable updates
+        double max_world_joint_error;
+    };
+
+    FKProfileResults profileForwardKinematics(double time_limit);
     ProfileResults profileCollisionChecks(double time_limit);
     ProfileResults profileDistanceChecks(double time_limit);
     int exportCheckedStates(const char* filename, int count);
@@ -232,6 +246,132 @@ bool CollisionSpaceProfiler::init()
     return true;
 }
 
+// Time full updates of the kinematic tree and all collision sphere positions,
+// first through the per-joint transform functions, then through the compiled
+// forward kinematics program used by RobotCollisionState.
+CollisionSpaceProfiler::FKProfileResults
+CollisionSpaceProfiler::profileForwardKinematics(double time_limit)
+{
+    ROS_INFO("Evaluating %0.3f seconds of forward kinematics updates per method", time_limit);
+
+    smpl::collision::RobotCollisionState state(m_rcm.get());
+
+    std::vector<int> var_indices;
+    for (const std::string& var_name : m_planning_joints) {
+        var_indices.push_back(m_rcm->jointVarIndex(var_name));
+    }
+    std::vector<double> positions(state.jointVarPositions());
+
+    smpl::collision::Affine3dVector link_transforms(
+            m_rcm->linkCount(), Eigen::Affine3d::Identity());
+    std::vector<Eigen::Vector3d> sphere_positions(m_rcm->sphereModelCount());
+
+    auto update_reference = [&]()
+    {
+        for (size_t lidx = 0; lidx < m_rcm->linkCount(); ++lidx) {
+            const int jidx = m_rcm->linkParentJointIndex(lidx);
+            const int plidx = m_rcm->jointParentLinkIndex(jidx);
+            auto fn = m_rcm->jointTransformFn(jidx);
+            double* jvals = positions.data() + m_rcm->jointVarIndexFirst(jidx);
+            const Eigen::Affine3d T_parent_link =
+                    fn(m_rcm->jointOrigin(jidx), m_rcm->jointAxis(jidx), jvals);
+            if (plidx >= 0) {
+                link_transforms[lidx] = link_transforms[plidx] * T_parent_link;
+            } else {
+                link_transforms[lidx] = T_parent_link;
+            }
+        }
+        size_t i = 0;
+        for (size_t smidx = 0; smidx < m_rcm->spheresModelCount(); ++smidx) {
+            const auto& spheres_model = m_rcm->spheresModel(smidx);
+            const Eigen::Affine3d& T = link_transforms[spheres_model.link_index];
+            for (const auto& sphere : spheres_model.spheres) {
+                sphere_positions[i++] = T * sphere.center;
+            }
+        }
+    };
+
+    auto update_compiled = [&]()
+    {
+        state.setJointVarPositions(positions.data());
+        state.updateLinkTransforms();
+        state.updateSphereStates();
+    };
+
+    auto set_random_positions = [&]()
+    {
+        auto variables = createRandomState();
+        for (size_t i = 0; i < var_indices.size(); ++i) {
+            positions[var_indices[i]] = variables[i];
+        }
+    };
+
+    FKProfileResults res;
+
+    res.reference_count = 0;
+    double elapsed = 0.0;
+    while (ros::ok() && elapsed < time_limit) {
+        set_random_positions();
+        auto start = std::chrono::high_resolution_clock::now();
+        update_reference();
+        auto finish = std::chrono::high_resolution_clock::now();
+        elapsed += std::chrono::duration<double>(finish - start).count();
+        ++res.reference_count;
+    }
+
+    res.compiled_count = 0;
+    elapsed = 0.0;
+    while (ros::ok() && elapsed < time_limit) {
+        set_random_positions();
+        auto start = std::chrono::high_resolution_clock::now();
+        update_compiled();
+        auto finish = std::chrono::high_resolution_clock::now();
+        elapsed += std::chrono::duration<double>(finish - start).count();
+        ++res.compiled_count;
+    }
+
+    auto max_link_error = [&]()
+    {
+        double max_error = 0.0;
+        for (size_t lidx = 0; lidx < m_rcm->linkCount(); ++lidx) {
+            const Eigen::Matrix4d diff =
+                    state.linkTransform(lidx).matrix() -
+                    link_transforms[lidx].matrix();
+            max_error = std::max(max_error, diff.cwiseAbs().maxCoeff());
+        }
+        return max_error;
+    };
+
+    // compare the link transforms computed by both methods
+    set_random_positions();
+    update_reference();
+    update_compiled();
+    res.max_error = max_link_error();
+
+    // move the world joint one variable at a time and update the links
+    // through the spheres that reference them
+    const int wvfirst = m_rcm->jointVarIndexFirst(0);
+    const int wvlast = m_rcm->jointVarIndexLast(0);
+    std::uniform_real_distribution<double> world_dist(-1.0, 1.0);
+    for (int vidx = wvfirst; vidx < wvlast; ++vidx) {
+        positions[vidx] = world_dist(m_rng);
+    }
+    if (m_rcm->jointType(0) == smpl::collision::FLOATING) {
+        // normalize the orientation quaternion
+        Eigen::Map<Eigen::Vector4d> q(&positions[wvfirst + 3]);
+        q.normalize();
+    }
+    update_reference();
+    for (int vidx = wvfirst; vidx < wvlast; ++vidx) {
+        state.setJointVarPosition(vidx, positions[vidx]);
+    }
+    state.updateSphereStates();
+    state.updateLinkTransforms();
+    res.max_world_joint_error = max_link_error();
+
+    return res;
+}
+
 CollisionSpaceProfiler::ProfileResults
 CollisionSpaceProfiler::profileCollisionChecks(double time_limit)
 {
@@ -404,6 +544,17 @@ int main(int argc, char *argv[])
             ROS_WARN("Did you make a mistake?");
         }
 
+        {
+            auto res = prof.profileForwardKinematics(time_limit);
+            ROS_INFO("per-joint transform functions:");
+            ROS_INFO("  updates / second: %g", res.reference_count / time_limit);
+            ROS_INFO("  seconds / update: %g", time_limit / res.reference_count);
+            ROS_INFO("compiled forward kinematics:");
+            ROS_INFO("  updates / second: %g", res.compiled_count / time_limit);
+            ROS_INFO("  seconds / update: %g", time_limit / res.compiled_count);
+            ROS_INFO("max transform difference: %g", res.max_error);
+            ROS_INFO("max transform difference after moving the world joint: %g", res.max_world_joint_error);
+        }
         {
             auto res = prof.profileCollisionChecks(time_limit);
             ROS_INFO("check count: %d", res.check_count);
@@ -30,6 +30,8 @@
 /// \author Benjamin Cohen
 
 // standard includes
+#include <cmath>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -44,6 +46,143 @@
 #include <smpl/debug/visualize.h>
 #include <smpl/debug/visualizer_ros.h>
 
+// Compare the coarse-to-fine motion check against checking every interpolated
+// waypoint. Each trial places a single obstacle voxel near the surface of a
+// random sphere at a random waypoint, so that it lies just inside the distance
+// over which other waypoints might be certified collision-free. Return the
+// number of trials where the motion was accepted although some waypoint is in
+// collision.
+static
+int CountUncheckedCollisions(
+    smpl::collision::CollisionSpace& cspace,
+    smpl::OccupancyGrid& grid,
+    const std::vector<double>& start,
+    const std::vector<double>& finish,
+    int trials)
+{
+    std::vector<std::vector<double>> path;
+    if (!cspace.interpolatePath(start, finish, path) || path.empty()) {
+        return 0;
+    }
+
+    std::default_random_engine rng;
+    std::uniform_int_distribution<size_t> waypoint_dist(0, path.size() - 1);
+    std::normal_distribution<double> dir_dist;
+    std::uniform_real_distribution<double> offset_dist(
+            -grid.resolution(), 2.0 * grid.resolution());
+
+    auto& rcs = *cspace.m_rcs;
+
+    int unchecked = 0;
+    for (int t = 0; t < trials; ++t) {
+        // pose the robot at a random waypoint and pick one of its spheres
+        cspace.isStateValid(path[waypoint_dist(rng)]);
+        rcs.updateSphereStates();
+        std::vector<const smpl::collision::CollisionSphereState*> spheres;
+        for (int ssidx : rcs.groupSpheresStateIndices(cspace.m_gidx)) {
+            for (auto& sphere : rcs.spheresState(ssidx).spheres) {
+                if (sphere.isLeaf()) {
+                    spheres.push_back(&sphere);
+                }
+            }
+        }
+        if (spheres.empty()) {
+            return 0;
+        }
+        std::uniform_int_distribution<size_t> sphere_dist(0, spheres.size() - 1);
+        auto* sphere = spheres[sphere_dist(rng)];
+
+        Eigen::Vector3d dir(dir_dist(rng), dir_dist(rng), dir_dist(rng));
+        dir.normalize();
+        Eigen::Vector3d p = sphere->pos +
+                (sphere->model->radius + offset_dist(rng)) * dir;
+        std::vector<Eigen::Vector3d> points(1, p);
+
+        grid.addPointsToField(points);
+
+        bool waypoints_valid = true;
+        for (auto& waypoint : path) {
+            if (!cspace.isStateValid(waypoint)) {
+                waypoints_valid = false;
+                break;
+            }
+        }
+        if (cspace.isStateToStateValid(start, finish) && !waypoints_valid) {
+            ROS_ERROR("Motion accepted with an obstacle at (%0.3f, %0.3f, %0.3f) in collision with some waypoint", p.x(), p.y(), p.z());
+            ++unchecked;
+        }
+
+        grid.removePointsFromField(points);
+    }
+
+    return unchecked;
+}
+
+// Compare the coarse-to-fine motion check against checking every interpolated
+// waypoint, for random motions between collision-free states in the current
+// world, so that the colliding waypoints found are mostly self collisions,
+// which clearance from the occupied voxels does not bound. Return the number
+// of motions that were accepted although some waypoint is in collision, and
+// store the number of motions with a colliding waypoint in found.
+static
+int CountUncheckedSelfCollisions(
+    smpl::collision::CollisionSpace& cspace,
+    int trials,
+    int& found)
+{
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> unit_dist;
+
+    auto sample_state = [&](std::vector<double>& state) {
+        state.resize(cspace.planningVariableCount());
+        for (size_t vidx = 0; vidx < state.size(); ++vidx) {
+            double lo = -M_PI;
+            double hi = M_PI;
+            if (cspace.hasLimit(vidx)) {
+                lo = cspace.minLimit(vidx);
+                hi = cspace.maxLimit(vidx);
+            }
+            state[vidx] = lo + unit_dist(rng) * (hi - lo);
+        }
+    };
+
+    found = 0;
+    int unchecked = 0;
+    std::vector<double> start;
+    std::vector<double> finish;
+    std::vector<std::vector<double>> path;
+    for (int t = 0; t < trials; ++t) {
+        sample_state(start);
+        sample_state(finish);
+        if (!cspace.isStateValid(start) || !cspace.isStateValid(finish)) {
+            continue;
+        }
+
+        if (!cspace.interpolatePath(start, finish, path)) {
+            continue;
+        }
+
+        bool waypoints_valid = true;
+        for (auto& waypoint : path) {
+            if (!cspace.isStateValid(waypoint)) {
+                waypoints_valid = false;
+                break;
+            }
+        }
+        if (waypoints_valid) {
+            continue;
+        }
+
+        ++found;
+        if (cspace.isStateToStateValid(start, finish)) {
+            ROS_ERROR("Motion accepted with a waypoint in collision");
+            ++unchecked;
+        }
+    }
+
+    return unchecked;
+}
+
 int main(int argc, char **argv)
 {
     ros::init(argc, argv, "sbpl_collision_space_test");
@@ -143,6 +282,31 @@ int main(int argc, char **argv)
     ros::spinOnce();
     sleep(1);
 
+    std::vector<double> finish_angles(angles);
+    finish_angles[0] += 0.6;
+    finish_angles[1] -= 0.3;
+    finish_angles[3] -= 0.4;
+    if (!cspace.isStateToStateValid(angles, finish_angles)) {
+        ROS_WARN("Motion is invalid in the empty world. Skip the motion check test");
+    } else {
+        auto unchecked = CountUncheckedCollisions(
+                cspace, grid, angles, finish_angles, 500);
+        if (unchecked != 0) {
+            ROS_ERROR("%d motions with colliding waypoints were accepted", unchecked);
+            return 1;
+        }
+    }
+
+    int found;
+    auto unchecked = CountUncheckedSelfCollisions(cspace, 500, found);
+    if (found == 0) {
+        ROS_WARN("No motions with colliding waypoints were sampled");
+    }
+    if (unchecked != 0) {
+        ROS_ERROR("%d of %d motions with self-colliding waypoints were accepted", unchecked, found);
+        return 1;
+    }
+
     ROS_INFO("Done");
     return 0;
 }
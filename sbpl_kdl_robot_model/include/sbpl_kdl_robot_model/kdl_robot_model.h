@@ -36,6 +36,7 @@
 // standard includes
 #include <memory>
 #include <string>
+#include <vector>
 
 // system includes
 #include <kdl/chain.hpp>
@@ -50,6 +51,27 @@
 
 namespace smpl {
 
+/// \brief Closed-form inverse kinematics for the kinematic chain of a
+///     KDLRobotModel
+///
+/// Poses are expressed in the frame of the chain root and joint positions are
+/// ordered as the joints of the chain.
+class AnalyticIKSolver
+{
+public:
+
+    virtual ~AnalyticIKSolver();
+
+    /// \brief Compute every solution branch for a pose of the chain tip, with
+    ///     the redundant joints held at their positions in \p seed.
+    ///
+    /// \return true if any solution was found; false otherwise
+    virtual bool solve(
+        const KDL::Frame& pose,
+        const KDL::JntArray& seed,
+        std::vector<KDL::JntArray>& solutions) = 0;
+};
+
 class KDLRobotModel :
     public virtual urdf::URDFRobotModel,
     public virtual InverseKinematicsInterface,
@@ -68,6 +90,12 @@ public:
     auto getBaseLink() const -> const std::string&;
     auto getPlanningLink() const -> const std::string&;
 
+    /// \brief Use a closed-form solver in place of the numeric KDL solver.
+    ///
+    /// The free angle is swept over its range with the closed-form solver by
+    /// computeIK() and held at the seed by computeFastIK().
+    void setAnalyticIKSolver(std::unique_ptr<AnalyticIKSolver> solver);
+
     bool computeIKSearch(
         const Eigen::Affine3d& pose,
         const RobotState& start,
@@ -83,6 +111,13 @@ public:
         const Eigen::Affine3d& pose,
         const RobotState& start,
         RobotState& solution) override;
+
+    bool computeFastIKBatch(
+        const Eigen::Affine3d& pose,
+        const RobotState* seeds,
+        int count,
+        std::vector<RobotState>& solutions,
+        std::vector<int>* seed_indices = nullptr) override;
     /// @}
 
     /// \name InverseKinematicsInterface Interface
@@ -122,6 +157,7 @@ public:
     std::unique_ptr<KDL::ChainFkSolverPos_recursive>    m_fk_solver;
     std::unique_ptr<KDL::ChainIkSolverVel_pinv>         m_ik_vel_solver;
     std::unique_ptr<KDL::ChainIkSolverPos_NR_JL>        m_ik_solver;
+    std::unique_ptr<AnalyticIKSolver>                   m_analytic_ik_solver;
 
     // ik solver settings
     int m_max_iterations;
@@ -130,6 +166,9 @@ public:
     // temporary storage
     KDL::JntArray m_jnt_pos_in;
     KDL::JntArray m_jnt_pos_out;
+    std::vector<KDL::JntArray> m_ik_branches;
+    std::vector<double> m_ik_branch_dists;
+    std::vector<int> m_ik_branch_order;
 
     // ik search configuration
     int m_free_angle;
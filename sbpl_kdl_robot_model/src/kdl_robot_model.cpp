@@ -32,6 +32,10 @@
 
 #include <sbpl_kdl_robot_model/kdl_robot_model.h>
 
+// standard includes
+#include <algorithm>
+#include <cmath>
+
 // system includes
 #include <eigen_conversions/eigen_kdl.h>
 #include <kdl/frames.hpp>
@@ -45,6 +49,10 @@
 
 namespace smpl {
 
+AnalyticIKSolver::~AnalyticIKSolver()
+{
+}
+
 static
 bool getCount(int& count, int max_count, int min_count)
 {
@@ -201,6 +209,11 @@ auto KDLRobotModel::getPlanningLink() const -> const std::string&
     return m_tip_link;
 }
 
+void KDLRobotModel::setAnalyticIKSolver(std::unique_ptr<AnalyticIKSolver> solver)
+{
+    m_analytic_ik_solver = std::move(solver);
+}
+
 static
 void NormalizeAngles(KDLRobotModel* model, KDL::JntArray* q)
 {
@@ -221,6 +234,63 @@ double GetSolverMinPosition(KDLRobotModel* model, int vidx)
     }
 }
 
+static
+double GetSolverMaxPosition(KDLRobotModel* model, int vidx)
+{
+    if (model->vprops[vidx].continuous) {
+        return M_PI;
+    } else {
+        return model->vprops[vidx].max_position;
+    }
+}
+
+static
+void CopyJntArray(KDLRobotModel* model, const KDL::JntArray* q, RobotState* state)
+{
+    state->resize(model->jointVariableCount());
+    for (auto i = 0; i < model->jointVariableCount(); ++i) {
+        (*state)[i] = (*q)(i);
+    }
+}
+
+// Compute every solution branch of the analytic solver for a pose in the
+// kinematics frame. The branches are stored, normalized, in m_ik_branches,
+// and m_ik_branch_order lists them nearest to the seed first.
+static
+int SolveAnalyticIK(
+    KDLRobotModel* model,
+    const KDL::Frame* pose,
+    const KDL::JntArray* seed)
+{
+    auto& branches = model->m_ik_branches;
+    branches.clear();
+    if (!model->m_analytic_ik_solver->solve(*pose, *seed, branches)) {
+        return 0;
+    }
+
+    auto& dists = model->m_ik_branch_dists;
+    auto& order = model->m_ik_branch_order;
+    dists.resize(branches.size());
+    order.resize(branches.size());
+    for (size_t b = 0; b < branches.size(); ++b) {
+        NormalizeAngles(model, &branches[b]);
+        auto dist = 0.0;
+        for (auto i = 0; i < model->jointVariableCount(); ++i) {
+            if (model->vprops[i].continuous) {
+                dist += angles::shortest_angle_dist(branches[b](i), (*seed)(i));
+            } else {
+                dist += std::fabs(branches[b](i) - (*seed)(i));
+            }
+        }
+        dists[b] = dist;
+        order[b] = (int)b;
+    }
+    std::sort(begin(order), end(order), [&](int a, int b) {
+        return dists[a] < dists[b];
+    });
+    return (int)branches.size();
+}
+
 bool KDLRobotModel::computeIKSearch(
     const Eigen::Affine3d& pose,
     const RobotState& start,
@@ -246,14 +316,19 @@ bool KDLRobotModel::computeIKSearch(
     auto count = 0;
 
     auto num_positive_increments =
-            (int)((GetSolverMinPosition(this, m_free_angle) - initial_guess) /
+            (int)((GetSolverMaxPosition(this, m_free_angle) - initial_guess) /
                     this->m_search_discretization);
     auto num_negative_increments =
             (int)((initial_guess - GetSolverMinPosition(this, m_free_angle)) /
                     this->m_search_discretization);
 
     while (loop_time < this->m_timeout) {
-        if (m_ik_solver->CartToJnt(m_jnt_pos_in, frame_des, m_jnt_pos_out) >= 0) {
+        if (m_analytic_ik_solver) {
+            if (SolveAnalyticIK(this, &frame_des, &m_jnt_pos_in) > 0) {
+                CopyJntArray(this, &m_ik_branches[m_ik_branch_order[0]], &solution);
+                return true;
+            }
+        } else if (m_ik_solver->CartToJnt(m_jnt_pos_in, frame_des, m_jnt_pos_out) >= 0) {
             NormalizeAngles(this, &m_jnt_pos_out);
             solution.resize(start.size());
             for (size_t i = 0; i < solution.size(); ++i) {
@@ -298,6 +373,13 @@ bool KDLRobotModel::computeIK(
     std::vector<RobotState>& solutions,
     ik_option::IkOption option)
 {
+    if (m_analytic_ik_solver && option == ik_option::UNRESTRICTED) {
+        // every branch at the seed's free angle
+        if (computeFastIKBatch(pose, &start, 1, solutions)) {
+            return true;
+        }
+    }
+
     // NOTE: only returns one solution
     RobotState solution;
     if (computeIK(pose, start, solution)) {
@@ -324,6 +406,14 @@ bool KDLRobotModel::computeFastIK(
     // must be normalized for CartToJntSearch
     NormalizeAngles(this, &m_jnt_pos_in);
 
+    if (m_analytic_ik_solver) {
+        if (SolveAnalyticIK(this, &frame_des, &m_jnt_pos_in) == 0) {
+            return false;
+        }
+        CopyJntArray(this, &m_ik_branches[m_ik_branch_order[0]], &solution);
+        return true;
+    }
+
     if (m_ik_solver->CartToJnt(m_jnt_pos_in, frame_des, m_jnt_pos_out) < 0) {
         return false;
     }
@@ -338,6 +428,43 @@ bool KDLRobotModel::computeFastIK(
     return true;
 }
 
+bool KDLRobotModel::computeFastIKBatch(
+    const Eigen::Affine3d& pose,
+    const RobotState* seeds,
+    int count,
+    std::vector<RobotState>& solutions,
+    std::vector<int>* seed_indices)
+{
+    if (!m_analytic_ik_solver) {
+        return RedundantManipulatorInterface::computeFastIKBatch(
+                pose, seeds, count, solutions, seed_indices);
+    }
+
+    // the pose is transformed into the kinematics frame once for all seeds
+    auto* T_map_kinematics = GetLinkTransform(&this->robot_state, m_kinematics_link);
+    KDL::Frame frame_des;
+    tf::transformEigenToKDL(T_map_kinematics->inverse() * pose, frame_des);
+
+    auto found = false;
+    for (int s = 0; s < count; ++s) {
+        for (size_t i = 0; i < seeds[s].size(); ++i) {
+            m_jnt_pos_in(i) = seeds[s][i];
+        }
+        NormalizeAngles(this, &m_jnt_pos_in);
+
+        auto branch_count = SolveAnalyticIK(this, &frame_des, &m_jnt_pos_in);
+        for (auto b = 0; b < branch_count; ++b) {
+            solutions.emplace_back();
+            CopyJntArray(this, &m_ik_branches[m_ik_branch_order[b]], &solutions.back());
+            if (seed_indices != nullptr) {
+                seed_indices->push_back(s);
+            }
+        }
+        found |= branch_count > 0;
+    }
+    return found;
+}
+
 void KDLRobotModel::printRobotModelInformation()
 {
     leatherman::printKDLChain(m_chain, "robot_model");
@@ -37,7 +37,6 @@
 #include <string>
 
 // system includes
-#include <pr2_arm_kinematics/pr2_arm_ik_solver.h>
 #include <sbpl_kdl_robot_model/kdl_robot_model.h>
 
 // project includes
@@ -66,17 +65,10 @@ public:
         const RobotState& start,
         RobotState& solution,
         ik_option::IkOption option = ik_option::UNRESTRICTED) override;
-
-    bool computeFastIK(
-        const Eigen::Affine3d& pose,
-        const RobotState& start,
-        RobotState& solution) override;
     ///@}
 
 private:
 
-    std::unique_ptr<pr2_arm_kinematics::PR2ArmIKSolver> pr2_ik_solver_;
-
     std::unique_ptr<RPYSolver> m_rpy_solver;
 
     std::string m_forearm_roll_link_name;
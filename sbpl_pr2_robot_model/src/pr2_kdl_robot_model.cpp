@@ -36,11 +36,29 @@
 #include <kdl/tree.hpp>
 #include <leatherman/print.h>
 #include <leatherman/utils.h>
+#include <pr2_arm_kinematics/pr2_arm_ik_solver.h>
 #include <ros/console.h>
 #include <smpl/angles.h>
 
 namespace smpl {
 
+// Closed-form PR2 arm solver, enumerating the elbow and wrist branches at the
+// seed's upper arm roll angle
+class PR2ArmAnalyticIKSolver : public AnalyticIKSolver
+{
+public:
+
+    std::unique_ptr<pr2_arm_kinematics::PR2ArmIKSolver> solver;
+
+    bool solve(
+        const KDL::Frame& pose,
+        const KDL::JntArray& seed,
+        std::vector<KDL::JntArray>& solutions) override
+    {
+        return solver->CartToJnt(seed, pose, solutions) >= 0;
+    }
+};
+
 bool PR2KDLRobotModel::init(
     const std::string& robot_description,
     const std::string& base_link,
@@ -54,11 +72,13 @@ bool PR2KDLRobotModel::init(
     }
 
     // PR2 Specific IK Solver
-    pr2_ik_solver_.reset(new pr2_arm_kinematics::PR2ArmIKSolver(m_urdf, base_link, tip_link, 0.02, 2));
-    if (!pr2_ik_solver_->active_) {
+    std::unique_ptr<PR2ArmAnalyticIKSolver> ik_solver(new PR2ArmAnalyticIKSolver);
+    ik_solver->solver.reset(new pr2_arm_kinematics::PR2ArmIKSolver(m_urdf, base_link, tip_link, 0.02, 2));
+    if (!ik_solver->solver->active_) {
         ROS_ERROR("The PR2 IK solver is NOT active.");
         return false;
     }
+    setAnalyticIKSolver(std::move(ik_solver));
 
     // initialize rpy solver
     if (tip_link == "r_gripper_palm_link" || tip_link == "l_gripper_palm_link") {
@@ -152,54 +172,8 @@ bool PR2KDLRobotModel::computeIK(
         return m_rpy_solver->computeRPYOnly(rpy, start, vfpose, vepose, 1, solution);
     }
 
-    if (pr2_ik_solver_) {
-        auto timeout = 0.2;
-        auto consistency_limit = 2.0 * M_PI;
-        if (pr2_ik_solver_->CartToJntSearch(
-                m_jnt_pos_in,
-                frame_des,
-                m_jnt_pos_out,
-                timeout,
-                consistency_limit) < 0)
-        {
-            return false;
-        }
-
-        solution.resize(start.size());
-        for (size_t i = 0; i < solution.size(); ++i) {
-            solution[i] = m_jnt_pos_out(i);
-        }
-    }
-
+    // the free angle is swept with the analytic solver
     return KDLRobotModel::computeIK(pose, start, solution, option);
 }
 
-bool PR2KDLRobotModel::computeFastIK(
-    const Eigen::Affine3d& pose,
-    const RobotState& start,
-    RobotState& solution)
-{
-    auto* T_map_kinematics = GetLinkTransform(&this->robot_state, this->m_kinematics_link);
-    KDL::Frame frame_des;
-    tf::transformEigenToKDL(T_map_kinematics->inverse() * pose, frame_des);
-
-    // seed configuration
-    for (size_t i = 0; i < start.size(); i++) {
-        m_jnt_pos_in(i) = start[i];
-    }
-
-    NormalizeAngles(this, &m_jnt_pos_in);
-
-    if (pr2_ik_solver_->CartToJnt(m_jnt_pos_in, frame_des, m_jnt_pos_out) < 0) {
-        return false;
-    }
-
-    solution.resize(start.size());
-    for (size_t i = 0; i < solution.size(); ++i) {
-        solution[i] = m_jnt_pos_out(i);
-    }
-
-    return true;
-}
-
 } // namespace smpl
@@ -34,13 +34,38 @@
 #define SMPL_BFS3D_H
 
 #include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <thread>
 #include <tuple>
+#include <vector>
 #include <iostream>
 
+// project includes
+#include <smpl/planning_stats.h>
+
 namespace smpl {
 
+class ThreadPool;
+
+/// Breadth-first search over a 3D grid with 26-connectivity.
+///
+/// run() returns immediately and computes distances on a background thread.
+/// Queries for cells that have not been reached yet block, without spinning,
+/// until the search finishes the level containing the cell. With more than one
+/// thread, each level is expanded in parallel from a bitmap of the frontier
+/// cells, with cells claimed atomically by the worker that discovers them.
+///
+/// The time from run() until the search finishes is recorded as a heuristic
+/// update in the planning statistics active on the thread that called run().
+///
+/// In lazy mode, no background search is started. Instead, queries for cells
+/// that have not been reached resume a best-first search from the start cells
+/// in the calling thread, and only as far as needed to settle the queried cell.
 class BFS_3D
 {
 public:
@@ -53,7 +78,53 @@ public:
 
     void getDimensions(int* length, int* width, int* height);
 
+    /// \brief Set the number of worker threads used by run().
+    ///
+    /// A single thread uses a sequential FIFO search; more threads expand each
+    /// level of the search in parallel. Has no effect while a search is
+    /// running.
+    void setThreadCount(int num_threads);
+    int threadCount() const { return m_num_threads; }
+
+    /// \brief Compute distances on demand rather than on a background thread.
+    ///
+    /// In lazy mode, run() only seeds the search from the start cells. A query
+    /// for a cell that has not been settled resumes the search until the cell
+    /// has been expanded. The search is ordered by distance plus the Chebyshev
+    /// distance to the focus cell (see setFocus()), which is consistent, so
+    /// the distances of expanded cells are exact and queries near the focus
+    /// settle after expanding little more than the corridor between the start
+    /// cells and the focus. Takes effect at the next run(); has no effect
+    /// while a search is running.
+    void setLazy(bool lazy);
+    bool lazy() const { return m_lazy; }
+
+    /// \brief Set the cell toward which a lazy search is directed.
+    ///
+    /// Distances already computed remain valid and the open cells of a lazy
+    /// search in progress are reordered for the new focus. A cell out of
+    /// bounds clears the focus, which reduces the lazy search to a
+    /// breadth-first search.
+    void setFocus(int x, int y, int z);
+
     void setWall(int x, int y, int z);
+    void unsetWall(int x, int y, int z);
+
+    /// \brief Clear all walls, preserving the allocated grid.
+    void clearWalls();
+
+    /// \brief Set and clear walls and repair the distances of the last search.
+    ///
+    /// The cells in \p walls and \p frees are given as consecutive (x, y, z)
+    /// triples. Rather than searching the whole grid again, only the distances
+    /// of cells whose shortest path to a start cell passed through a new wall
+    /// are invalidated, and the search is resumed from the boundary of the
+    /// invalidated region and from the newly freed cells. Start cells of the
+    /// last search are never made into walls, to match the behavior of run().
+    /// If no search has been run, this only updates the walls. A lazy search
+    /// is instead restarted from its start cells, since it has only computed
+    /// the distances that have been queried.
+    void updateWalls(const std::vector<int>& walls, const std::vector<int>& frees);
 
     // \brief Clear cells around a given cell until freespace is encountered.
     //
@@ -77,7 +148,8 @@ public:
     /// \brief Return the distance, in cells, to the nearest occupied cell.
     ///
     /// This function is blocking if the BFS is running in parallel and a value
-    /// has not yet been computed for this cell.
+    /// has not yet been computed for this cell. In lazy mode, the value is
+    /// computed by the calling thread.
     int getDistance(int x, int y, int z) const;
 
     /// \brief Return whether this cell has been discovered.
@@ -92,6 +164,9 @@ public:
 
     bool isRunning() const { return m_running; }
 
+    /// \brief Block until the running search, if any, has finished.
+    void wait();
+
     int countWalls() const;
     int countUndiscovered() const;
     int countDiscovered() const;
@@ -103,17 +178,73 @@ private:
     int m_dim_x, m_dim_y, m_dim_z;
     int m_dim_xy, m_dim_xyz;
 
-    int volatile* m_distance_grid;
+    std::atomic<int>* m_distance_grid;
 
     int* m_queue;
     int m_queue_head, m_queue_tail;
 
-    volatile bool m_running;
+    std::atomic<bool> m_running;
+    bool m_searched;
+
+    // Completed levels of the search and the end of the search are published
+    // by locking m_mutex and notifying m_level_cv, on which queries for
+    // undiscovered cells wait.
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_level_cv;
+
+    // statistics active when the running search was started, and its start
+    PlanningStats* m_stats;
+    clock::time_point m_build_start;
+
+    int m_num_threads;
+    std::unique_ptr<ThreadPool> m_pool;
+
+    // one bit per cell for the current and next levels of a parallel search
+    std::vector<std::atomic<std::uint64_t>> m_frontier[2];
 
     int m_neighbor_offsets[26];
     std::vector<bool> m_closed;
     std::vector<int> m_distances;
 
+    // per-distance buckets of cells used to repair distances in updateWalls()
+    std::vector<std::vector<int>> m_repair_buckets;
+    std::vector<int> m_repair_cells;
+
+    bool m_lazy;
+    bool m_has_focus;
+    int m_focus_x, m_focus_y, m_focus_z;
+    std::vector<int> m_lazy_starts;
+
+    // Open list of the lazy search, which is advanced by const queries while
+    // holding m_mutex. Open cells remain UNDISCOVERED in the distance grid
+    // until they are expanded; their tentative distances are kept in
+    // m_lazy_g and they are bucketed by distance plus heuristic, with stale
+    // entries skipped when popped.
+    mutable std::vector<int> m_lazy_g;
+    mutable std::vector<std::vector<int>> m_lazy_buckets;
+    mutable size_t m_lazy_f;
+
+    void waitForSearch();
+    void pushRepairCell(int node, int dist);
+
+    int cell(int node) const;
+    void setCell(int node, int value);
+    int waitForCell(int node) const;
+
+    void beginSearch();
+    void startSearch();
+    void publishLevel();
+    void finishSearch();
+    void searchParallel();
+
+    void startLazySearch();
+    void restartLazySearch();
+    void clearLazySearch();
+    int lazyHeuristic(int node) const;
+    void pushLazyCell(int node, int g) const;
+    void expandLazyCell(int node) const;
+    int resolveCell(int node) const;
+
     int getNode(int x, int y, int z) const;
     bool getCoord(int node, int& x, int& y, int& z) const;
     void setWall(int node);
@@ -125,7 +256,7 @@ private:
     void search(
         int width,
         int planeSize,
-        int volatile* distance_grid,
+        std::atomic<int>* distance_grid,
         int* queue,
         int& queue_head,
         int& queue_tail);
@@ -133,11 +264,11 @@ private:
     void search(
         int width,
         int planeSize,
-        int volatile* distance_grid,
+        std::atomic<int>* distance_grid,
         int* queue,
         int& queue_head,
         int& queue_tail,
-        int volatile* frontier_grid,
+        std::atomic<int>* frontier_grid,
         int* frontier_queue,
         int& frontier_queue_head,
         int& frontier_queue_tail);
@@ -159,9 +290,13 @@ void BFS_3D::run(InputIt cells_begin, InputIt cells_end)
         return;
     }
 
+    waitForSearch();
+
+    beginSearch();
+
     for (int i = 0; i < m_dim_xyz; i++) {
-        if (m_distance_grid[i] != WALL) {
-            m_distance_grid[i] = UNDISCOVERED;
+        if (cell(i) != WALL) {
+            setCell(i, UNDISCOVERED);
         }
     }
 
@@ -171,26 +306,21 @@ void BFS_3D::run(InputIt cells_begin, InputIt cells_end)
     int xyz[3];
     int ind = 0;
     int start_count = 0;
-    for (auto it = cells_begin; it != cells_end;) {
+    for (auto it = cells_begin; it != cells_end; ++it) {
+        xyz[ind++] = *it;
         if (ind == 3) {
             auto origin = getNode(xyz[0], xyz[1], xyz[2]);
-            m_queue[start_count++] = origin;
-            m_distance_grid[origin] = 0;
+            if (cell(origin) != 0) {
+                m_queue[start_count++] = origin;
+                setCell(origin, 0);
+            }
             ind = 0;
-        } else {
-            xyz[ind++] = *it++;
         }
     }
 
     m_queue_tail = start_count;
 
-    // fire off background thread to compute bfs
-    m_search_thread = std::thread([&]()
-    {
-        this->search(m_dim_x, m_dim_xy, m_distance_grid, m_queue, m_queue_head, m_queue_tail);
-    });
-
-    m_running = true;
+    startSearch();
 }
 
 inline int BFS_3D::getNode(int x, int y, int z) const
@@ -217,24 +347,34 @@ inline bool BFS_3D::getCoord(int node, int& x, int& y, int& z) const
     return true;
 }
 
+inline int BFS_3D::cell(int node) const
+{
+    return m_distance_grid[node].load(std::memory_order_relaxed);
+}
+
+inline void BFS_3D::setCell(int node, int value)
+{
+    m_distance_grid[node].store(value, std::memory_order_relaxed);
+}
+
 inline void BFS_3D::setWall(int node)
 {
-    m_distance_grid[node] = WALL;
+    setCell(node, WALL);
 }
 
 inline void BFS_3D::unsetWall(int node)
 {
-    m_distance_grid[node] = UNDISCOVERED;
+    setCell(node, UNDISCOVERED);
 }
 
 inline bool BFS_3D::isWall(int node) const
 {
-    return m_distance_grid[node] == WALL;
+    return cell(node) == WALL;
 }
 
 inline int BFS_3D::isUndiscovered(int node) const
 {
-    return m_distance_grid[node] < 0;
+    return cell(node) < 0;
 }
 
 inline int BFS_3D::neighbor(int node, int neighbor) const
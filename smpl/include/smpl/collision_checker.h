@@ -34,6 +34,7 @@
 #define SMPL_COLLISION_CHECKER_H
 
 // standard includes
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -111,6 +112,17 @@ public:
         const RobotState& finish) = 0;
 };
 
+/// Creates independent copies of a collision checker, e.g. for edge validation
+/// workers that check states concurrently with the original.
+class CollisionCheckerCloneExtension : public virtual Extension
+{
+public:
+
+    /// Return a collision checker for the same robot and world, in the same
+    /// state as this one, or nullptr if one could not be created.
+    virtual auto cloneCollisionChecker() -> std::unique_ptr<CollisionChecker> = 0;
+};
+
 } // namespace smpl
 
 #endif
@@ -34,6 +34,8 @@
 
 // standard includes
 #include <array>
+#include <cstdint>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -45,7 +47,9 @@
 #include <smpl/forward.h>
 #include <smpl/distance_map/distance_map_interface.h>
 #include <smpl/grid/grid.h>
+#include <smpl/snapshot.h>
 #include <smpl/spatial.h>
+#include <smpl/thread_pool.h>
 
 #include "detail/distance_map_common.h"
 
@@ -92,6 +96,11 @@ public:
     double getMetricDistance(double x, double y, double z) const override;
     double getCellDistance(int x, int y, int z) const override;
 
+    void getMetricSquaredDistances(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* d2) const override;
+
     void gridToWorld(
         int x, int y, int z,
         double& world_x, double& world_y, double& world_z) const override;
@@ -101,34 +110,70 @@ public:
         int& x, int& y, int& z) const override;
 
     bool isCellValid(int x, int y, int z) const override;
+
+    bool saveSnapshot(SnapshotWriter& writer) const override;
+    bool loadSnapshot(const SnapshotReader& reader) override;
     ///@}
 
+    void releasePropagationData();
+    void setRetainPropagationData(bool retain);
+    bool retainPropagationData() const;
+    bool hasPropagationData() const;
+
+    void setThreadCount(int num_threads);
+    int threadCount() const;
+
+    void setBulkBuildThreshold(int num_points);
+    int bulkBuildThreshold() const;
+
     friend Derived;
 
 private:
 
+    // Bookkeeping for incremental distance propagation. Coordinates are
+    // stored as 16-bit values and the nearest obstacle is referenced by its
+    // index into m_cells, which keeps the struct at 28 bytes and allows copies
+    // of the map without rewiring pointers.
     struct Cell
     {
-        int x;
-        int y;
-        int z;
-
         int dist;
         int dist_new;
 #if SMPL_DMAP_RETURN_CHANGED_CELLS
         int dist_old;
 #endif
-        Cell* obs;
+        int obs;
         int bucket;
-        int dir;
-
         int pos;
+
+        std::int16_t x;
+        std::int16_t y;
+        std::int16_t z;
+        std::int8_t dir;
     };
 
     static constexpr int NO_UPDATE_DIR = dirnum(0, 0, 0);
 
+    // Derived classes whose distance function is the squared euclidean
+    // distance between cell centers hide this with a true value to enable bulk
+    // builds via a separable exact distance transform
+    static constexpr bool SQUARED_EUCLIDEAN_DISTANCE = false;
+
+    // Derived classes hide this with a unique nonzero tag to identify their
+    // snapshots and enable saving and loading them
+    static constexpr std::uint32_t SNAPSHOT_TYPE = 0;
+
+    // Metric distance values, including the border cells, kept apart from the
+    // propagation bookkeeping so that distance queries only touch this array
+    Grid3<float> m_dist;
+
+    // Propagation bookkeeping, with the same dimensions as m_dist. Empty after
+    // a call to releasePropagationData().
     Grid3<Cell> m_cells;
 
+    // Obstacle cells, recorded while the propagation bookkeeping is released,
+    // from which the bookkeeping is rebuilt before the next update
+    std::vector<bool> m_obstacles;
+
     double m_max_dist;
     double m_inv_res;
 
@@ -166,13 +211,36 @@ private:
 
     std::vector<double> m_sqrt_table;
 
-    typedef std::vector<Cell*> bucket_type;
+    typedef std::vector<int> bucket_type;
     typedef std::vector<bucket_type> bucket_list;
     bucket_list m_open;
 
-    std::vector<Cell*> m_rem_stack;
+    std::vector<int> m_rem_stack;
+
+    // workers for bulk builds; null when running single-threaded
+    int m_num_threads;
+    std::unique_ptr<ThreadPool> m_pool;
+
+    int m_bulk_build_threshold;
+
+    // whether no obstacles have been added since construction or reset()
+    bool m_cleared;
+
+    // whether to keep the propagation bookkeeping after an update
+    bool m_retain_propagation_data;
+
+    int cellIndex(const Cell* c) const;
+    bool isObstacle(int i) const;
+    void setDistance(Cell* c, int d);
+
+    void initCells();
+    void restorePropagationData();
+    void freePropagationData();
+    void finishUpdate();
 
-    void rewire(const DistanceMap& o);
+    bool useBulkBuild(size_t num_points) const;
+    void gatherObstacles();
+    void bulkBuild();
 
     void initBorderCells();
 
@@ -189,7 +257,7 @@ private:
     void propagateRemovals();
     void propagateBorder();
 
-    void resetCell(Cell& c) const;
+    void resetCell(Cell& c);
 };
 
 } // namespace smpl
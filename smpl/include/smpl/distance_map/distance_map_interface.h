@@ -44,6 +44,9 @@
 
 namespace smpl {
 
+class SnapshotReader;
+class SnapshotWriter;
+
 /// Abstract base class for Distance Map implementations. This class specifies
 /// methods for returning distances to the nearest occupied cells, both in
 /// cell units and metric units.
@@ -114,6 +117,19 @@ public:
 
     virtual double getCellSquaredDistance(int x, int y, int z) const
     { double d = getCellDistance(x, y, z); return d * d; }
+
+    /// Compute the squared metric distances for a batch of points given in
+    /// structure-of-arrays layout. Implementations may override this to avoid
+    /// a virtual call per point.
+    virtual void getMetricSquaredDistances(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* d2) const
+    {
+        for (int i = 0; i < count; ++i) {
+            d2[i] = getMetricSquaredDistance(x[i], y[i], z[i]);
+        }
+    }
     ///@}
 
     /// \name Conversions Between Cell and Metric Coordinates
@@ -129,6 +145,20 @@ public:
     virtual bool isCellValid(int x, int y, int z) const = 0;
     ///@}
 
+    /// \name Snapshots
+    ///@{
+
+    /// Add the sections describing the contents of the map to a snapshot.
+    /// Return false if the implementation does not support snapshots.
+    virtual bool saveSnapshot(SnapshotWriter& writer) const { return false; }
+
+    /// Replace the contents of the map with those from a snapshot. Return false,
+    /// leaving the map unmodified, if the snapshot was saved from a map of a
+    /// different type or layout, or if the implementation does not support
+    /// snapshots.
+    virtual bool loadSnapshot(const SnapshotReader& reader) { return false; }
+    ///@}
+
 protected:
 
     double m_origin_x;
@@ -50,6 +50,8 @@ public:
 
 private:
 
+    static constexpr std::uint32_t SNAPSHOT_TYPE = SnapshotTag('E', 'D', 'G', 'E');
+
     int distance(const Cell& n, const Cell& s);
 };
 
@@ -50,6 +50,9 @@ public:
 
 private:
 
+    static constexpr bool SQUARED_EUCLIDEAN_DISTANCE = true;
+    static constexpr std::uint32_t SNAPSHOT_TYPE = SnapshotTag('E', 'U', 'C', 'L');
+
     int distance(const Cell& n, const Cell& s);
 };
 
@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_OVERLAY_DISTANCE_MAP_H
+#define SMPL_OVERLAY_DISTANCE_MAP_H
+
+// standard includes
+#include <memory>
+#include <vector>
+
+// project includes
+#include <smpl/distance_map/distance_map_interface.h>
+#include <smpl/distance_map/sparse_distance_map.h>
+
+namespace smpl {
+
+/// A distance map layered over an immutable base map that may be shared with
+/// other maps, e.g. the static environment shared by several planners running
+/// concurrently.
+///
+/// Obstacles added to the map are stored in a sparse overlay, which only
+/// allocates storage for the regions within the maximum distance of the added
+/// obstacles, and distance lookups return the smaller of the distances from
+/// the base map and the overlay. Obstacles may be removed from the overlay
+/// freely. The first removal of an obstacle from the base map instead replaces
+/// the base map with a private copy, to which all further updates are applied.
+/// Copies of an overlay distance map share its base map.
+///
+/// The base map must not be modified while it is shared.
+class OverlayDistanceMap : public DistanceMapInterface
+{
+public:
+
+    explicit OverlayDistanceMap(
+        const std::shared_ptr<const DistanceMapInterface>& base);
+
+    OverlayDistanceMap(const OverlayDistanceMap& o);
+
+    auto operator=(const OverlayDistanceMap& rhs) -> OverlayDistanceMap&;
+
+    /// Return the shared base map, or nullptr if it has been replaced by a
+    /// private copy.
+    auto base() const -> const std::shared_ptr<const DistanceMapInterface>&
+    { return m_base; }
+
+    bool isShared() const { return m_base != nullptr; }
+
+    /// \name Required Functions from DistanceMapInterface
+    ///@{
+    DistanceMapInterface* clone() const override;
+
+    void addPointsToMap(const std::vector<Vector3>& points) override;
+    void removePointsFromMap(const std::vector<Vector3>& points) override;
+    void updatePointsInMap(
+        const std::vector<Vector3>& old_points,
+        const std::vector<Vector3>& new_points) override;
+    void reset() override;
+
+    int numCellsX() const override;
+    int numCellsY() const override;
+    int numCellsZ() const override;
+
+    double getUninitializedDistance() const override;
+
+    double getMetricDistance(double x, double y, double z) const override;
+    double getCellDistance(int x, int y, int z) const override;
+
+    double getMetricSquaredDistance(double x, double y, double z) const override;
+    double getCellSquaredDistance(int x, int y, int z) const override;
+
+    void getMetricSquaredDistances(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* d2) const override;
+
+    void gridToWorld(
+        int x, int y, int z,
+        double& world_x, double& world_y, double& world_z) const override;
+
+    void worldToGrid(
+        double world_x, double world_y, double world_z,
+        int& x, int& y, int& z) const override;
+
+    bool isCellValid(int x, int y, int z) const override;
+    ///@}
+
+private:
+
+    // shared base map, null once replaced by m_own
+    std::shared_ptr<const DistanceMapInterface> m_base;
+
+    // obstacles added on top of the base map
+    std::unique_ptr<SparseDistanceMap> m_overlay;
+
+    // whether any obstacles have been added to m_overlay since it was cleared
+    bool m_has_overlay;
+
+    // private copy of the base map, including the overlay obstacles
+    std::unique_ptr<DistanceMapInterface> m_own;
+
+    auto map() const -> const DistanceMapInterface&;
+
+    bool isBaseObstacle(int x, int y, int z) const;
+    bool isOverlayObstacle(int x, int y, int z) const;
+
+    void makeOwn();
+};
+
+} // namespace smpl
+
+#endif
@@ -84,6 +84,12 @@ public:
         double resolution,
         double max_dist);
 
+    SparseDistanceMap(const SparseDistanceMap& o);
+    SparseDistanceMap(SparseDistanceMap&& o) = default;
+
+    auto operator=(const SparseDistanceMap& rhs) -> SparseDistanceMap&;
+    auto operator=(SparseDistanceMap&& rhs) -> SparseDistanceMap& = default;
+
     double maxDistance() const;
 
     double getDistance(double x, double y, double z) const;
@@ -115,6 +121,11 @@ public:
     double getMetricSquaredDistance(double x, double y, double z) const override;
     double getCellSquaredDistance(int x, int y, int z) const override;
 
+    void getMetricSquaredDistances(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* d2) const override;
+
     void gridToWorld(
         int x, int y, int z,
         double& world_x, double& world_y, double& world_z) const override;
@@ -124,10 +135,14 @@ public:
         int& x, int& y, int& z) const override;
 
     bool isCellValid(int x, int y, int z) const override;
+
+    bool saveSnapshot(SnapshotWriter& writer) const override;
+    bool loadSnapshot(const SnapshotReader& reader) override;
     ///@}
 
     double resolution() const { return 1.0 / m_inv_res; }
     auto cells() -> SparseGrid<Cell>& { return m_cells; }
+    auto cells() const -> const SparseGrid<Cell>& { return m_cells; }
 
 public:
 
@@ -218,6 +233,8 @@ public:
     void propagateBorder();
     ///@}
 
+    void relinkObstacles();
+
     double getTrueMetricSquaredDistance(double x, double y, double z) const;
     double getInterpMetricSquaredDistance(double x, double y, double z) const;
 };
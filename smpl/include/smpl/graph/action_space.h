@@ -32,6 +32,11 @@
 #ifndef SMPL_ACTION_SPACE_H
 #define SMPL_ACTION_SPACE_H
 
+// standard includes
+#include <assert.h>
+#include <stddef.h>
+#include <vector>
+
 // project includes
 #include <smpl/types.h>
 
@@ -40,6 +45,75 @@ namespace smpl {
 class RobotPlanningSpace;
 struct GoalConstraint;
 
+/// \brief A read-only view of the waypoints of an action in an ActionBuffer
+class ActionView
+{
+public:
+
+    using const_iterator = const RobotState*;
+
+    ActionView(const RobotState* first, const RobotState* last) :
+        m_first(first), m_last(last)
+    { }
+
+    auto size() const -> size_t { return m_last - m_first; }
+    bool empty() const { return m_first == m_last; }
+
+    auto operator[](size_t i) const -> const RobotState& { return m_first[i]; }
+    auto front() const -> const RobotState& { return *m_first; }
+    auto back() const -> const RobotState& { return *(m_last - 1); }
+
+    auto begin() const -> const_iterator { return m_first; }
+    auto end() const -> const_iterator { return m_last; }
+
+private:
+
+    const RobotState* m_first;
+    const RobotState* m_last;
+};
+
+/// \brief A reusable container of actions
+///
+/// The waypoints of all actions are stored in a single sequence, delimited by
+/// per-action offsets. Clearing the buffer retains previously constructed
+/// waypoints, and their storage, so that refilling the buffer with actions of
+/// the same shape performs no heap allocations.
+///
+/// An action is constructed by appending waypoints with appendWaypoint() and
+/// then calling either commitAction() or discardAction(). References and views
+/// into the buffer are invalidated by appendWaypoint().
+class ActionBuffer
+{
+public:
+
+    ActionBuffer() : m_offsets(1, 0), m_waypoint_count(0) { }
+
+    auto size() const -> size_t { return m_offsets.size() - 1; }
+    bool empty() const { return size() == 0; }
+
+    auto operator[](size_t i) const -> ActionView
+    {
+        assert(i < size());
+        auto* data = m_waypoints.data();
+        return ActionView(data + m_offsets[i], data + m_offsets[i + 1]);
+    }
+
+    void clear();
+
+    auto appendWaypoint() -> RobotState&;
+    void commitAction();
+    void discardAction();
+
+    void push_back(const Action& action);
+    void push_back(const ActionView& action);
+
+private:
+
+    std::vector<RobotState> m_waypoints;
+    std::vector<size_t> m_offsets;
+    size_t m_waypoint_count;
+};
+
 class ActionSpace
 {
 public:
@@ -60,6 +134,13 @@ public:
     /// CollisionChecker's isStateToStateValid function during a search.
     virtual bool apply(const RobotState& parent, std::vector<Action>& actions) = 0;
 
+    /// \brief Append the set of actions available from a state to a buffer.
+    ///
+    /// The default implementation forwards to apply() and copies the resulting
+    /// actions into the buffer. Action spaces should reimplement this to
+    /// construct actions in place.
+    virtual bool apply(const RobotState& parent, ActionBuffer& actions);
+
     virtual void updateStart(const RobotState& state) { }
     virtual void updateGoal(const GoalConstraint& goal) { }
 
@@ -50,9 +50,11 @@
 #include <smpl/occupancy_grid.h>
 #include <smpl/planning_params.h>
 #include <smpl/robot_model.h>
+#include <smpl/thread_pool.h>
 #include <smpl/types.h>
 #include <smpl/graph/robot_planning_space.h>
 #include <smpl/graph/action_space.h>
+#include <smpl/graph/manip_lattice_state_table.h>
 
 namespace smpl {
 
@@ -60,34 +62,6 @@ class RobotHeuristic;
 
 typedef std::vector<int> RobotCoord;
 
-struct ManipLatticeState
-{
-    RobotCoord coord;   // discrete coordinate
-    RobotState state;   // corresponding continuous coordinate
-};
-
-inline
-bool operator==(const ManipLatticeState& a, const ManipLatticeState& b)
-{
-    return a.coord == b.coord;
-}
-
-} // namespace smpl
-
-namespace std {
-
-template <>
-struct hash<smpl::ManipLatticeState>
-{
-    typedef smpl::ManipLatticeState argument_type;
-    typedef std::size_t result_type;
-    result_type operator()(const argument_type& s) const;
-};
-
-} // namespace std
-
-namespace smpl {
-
 /// \class Discrete space constructed by expliciting discretizing each joint
 class ManipLattice :
     public RobotPlanningSpace,
@@ -117,6 +91,13 @@ public:
 
     void clearStates();
 
+    /// \name Parallel Edge Validation
+    ///@{
+    bool setEdgeValidationCheckers(const std::vector<CollisionChecker*>& checkers);
+    bool setEdgeValidationThreadCount(int num_threads);
+    int edgeValidationThreadCount() const;
+    ///@}
+
     /// \name Reimplemented Public Functions from RobotPlanningSpace
     ///@{
     void GetLazySuccs(
@@ -125,6 +106,11 @@ public:
         std::vector<int>* costs,
         std::vector<bool>* true_costs) override;
     int GetTrueCost(int parent_id, int child_id) override;
+    void GetTrueCosts(
+        const int* parent_ids,
+        const int* child_ids,
+        int count,
+        int* costs) override;
     ///@}
 
     /// \name Required Public Functions from ExtractRobotStateExtension
@@ -181,6 +167,8 @@ protected:
     int getOrCreateState(const RobotCoord& coord, const RobotState& state);
     int reserveHashEntry();
 
+    auto getCoord(const ManipLatticeState* entry) const -> RobotCoord;
+
     Affine3 computePlanningFrameFK(const RobotState& state) const;
 
     int cost(
@@ -188,9 +176,18 @@ protected:
         ManipLatticeState* HashEntry2,
         bool bState2IsGoal) const;
 
-    bool checkAction(const RobotState& state, const Action& action);
+    bool checkAction(const RobotState& state, const ActionView& action);
+    bool checkActionJointLimits(const ActionView& action);
+    bool checkActionCollisions(
+        CollisionChecker* checker,
+        const RobotState& state,
+        const ActionView& action) const;
+    void checkActions(
+        const RobotState& state,
+        const ActionBuffer& actions,
+        std::vector<char>& valid);
 
-    bool isGoal(const RobotState& state);
+    bool isGoal(const RobotState& state, const Affine3* pose = nullptr);
 
     auto getStateVisualization(const RobotState& vars, const std::string& ns)
         -> std::vector<visual::Marker>;
@@ -212,17 +209,52 @@ private:
     int m_goal_state_id = -1;
     int m_start_state_id = -1;
 
-    // maps from coords to stateID
-    typedef ManipLatticeState StateKey;
-    typedef PointerValueHash<StateKey> StateHash;
-    typedef PointerValueEqual<StateKey> StateEqual;
-    hash_map<StateKey*, int, StateHash, StateEqual> m_state_to_id;
-
-    // maps from stateID to coords
-    std::vector<ManipLatticeState*> m_states;
+    // maps from stateID to coords and from coords to stateID
+    ManipLatticeStateTable m_states;
 
     std::string m_viz_frame_id;
 
+    // scratch space for successor generation
+    ActionBuffer m_action_buffer;
+    RobotCoord m_succ_coord;
+    std::vector<char> m_action_valid;
+
+    // successors of the latest expansion and the planning frame poses of
+    // their stored states, computed together on first use by projectToPose()
+    std::vector<int> m_succ_ids;
+    std::vector<double> m_succ_positions;
+    std::vector<Affine3, Eigen::aligned_allocator<Affine3>> m_succ_poses;
+    bool m_succ_poses_valid = false;
+
+    // planning frame poses of the action endpoints of the latest expansion,
+    // computed together for the goal test
+    std::vector<const RobotState*> m_action_endpoints;
+    std::vector<Affine3, Eigen::aligned_allocator<Affine3>> m_action_poses;
+
+    // parallel edge validation; worker i checks edges with m_edge_checkers[i].
+    // Candidate edges are gathered on the search thread as (source state,
+    // action) pairs, checked by the workers, and reduced on the search thread.
+    std::vector<CollisionChecker*> m_edge_checkers;
+    std::unique_ptr<ThreadPool> m_edge_pool;
+
+    // clones of the lattice's collision checker made for the workers by
+    // setEdgeValidationThreadCount(), remade for each start state
+    std::vector<std::unique_ptr<CollisionChecker>> m_edge_checker_clones;
+    ActionBuffer m_edge_actions;
+    std::vector<const RobotState*> m_edge_sources;
+    std::vector<int> m_edge_indices;
+    std::vector<int> m_edge_costs;
+    std::vector<char> m_edge_valid;
+
+    void validateEdgeActions();
+    bool cloneEdgeValidationCheckers(int num_threads);
+
+    void beginSuccessors();
+    void computeSuccessorPoses();
+    void computeActionPoses(
+        const ActionBuffer& actions,
+        const std::vector<char>* valid);
+
     bool setGoalPose(const GoalConstraint& goal);
     bool setGoalPoses(const GoalConstraint& goal);
     bool setGoalConfiguration(const GoalConstraint& goal);
@@ -91,6 +91,7 @@ public:
     /// \name Required Public Functions from ActionSpace
     ///@{
     bool apply(const RobotState& parent, std::vector<Action>& actions) override;
+    bool apply(const RobotState& parent, ActionBuffer& actions) override;
     ///@}
 
 protected:
@@ -106,24 +107,27 @@ protected:
     bool m_use_multiple_ik_solutions        = false;
     bool m_use_long_and_short_dist_mprims   = false;
 
+    // scratch space for multiple ik solutions
+    std::vector<RobotState> m_ik_solutions;
+
     bool applyMotionPrimitive(
         const RobotState& state,
         const MotionPrimitive& mp,
-        Action& action);
+        ActionBuffer& actions);
 
     bool computeIkAction(
         const RobotState& state,
         const Affine3& goal,
         double dist_to_goal,
         ik_option::IkOption option,
-        std::vector<Action>& actions);
+        ActionBuffer& actions);
 
     virtual bool getAction(
         const RobotState& parent,
         double goal_dist,
         double start_dist,
         const MotionPrimitive& mp,
-        std::vector<Action>& actions);
+        ActionBuffer& actions);
 
     bool mprimActive(
         double start_dist,
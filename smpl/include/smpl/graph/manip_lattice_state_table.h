@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_MANIP_LATTICE_STATE_TABLE_H
+#define SMPL_MANIP_LATTICE_STATE_TABLE_H
+
+// standard includes
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// project includes
+#include <smpl/types.h>
+
+namespace smpl {
+
+struct ManipLatticeState
+{
+    int* coord;         // discrete coordinate
+    RobotState state;   // corresponding continuous coordinate
+};
+
+/// \brief Storage for the states discovered by a ManipLattice
+///
+/// Entries are stored in fixed-size chunks so that pointers to entries remain
+/// valid as the table grows. Discrete coordinates and per-state planner
+/// indices live in flat, fixed-stride arenas, and continuous states are
+/// sized once per entry and reused. Entries may optionally be indexed by
+/// their discrete coordinate using an open-addressing hash table.
+///
+/// clear() is O(1) and does not release memory, so that filling the table to
+/// a previously reached size performs no heap allocations.
+class ManipLatticeStateTable
+{
+public:
+
+    ManipLatticeStateTable() = default;
+    ManipLatticeStateTable(const ManipLatticeStateTable&) = delete;
+    ManipLatticeStateTable& operator=(const ManipLatticeStateTable&) = delete;
+
+    void init(int coord_size, int index_size);
+
+    int coordSize() const { return m_coord_size; }
+    int size() const { return m_size; }
+
+    void clear();
+
+    int reserve();
+
+    auto get(int id) const -> ManipLatticeState*;
+
+    auto indices(int id) -> int*;
+
+    int find(const int* coord) const;
+    void insert(int id);
+
+private:
+
+    static const int ChunkShift = 12;
+    static const int ChunkSize = 1 << ChunkShift;
+    static const int ChunkMask = ChunkSize - 1;
+
+    struct Slot
+    {
+        int id;
+        std::uint32_t hash;
+        std::uint32_t generation;
+    };
+
+    int m_coord_size = 0;
+    int m_index_size = 0;
+    int m_size = 0;
+
+    std::vector<std::unique_ptr<ManipLatticeState[]>> m_state_chunks;
+    std::vector<std::unique_ptr<int[]>> m_coord_chunks;
+    std::vector<std::unique_ptr<int[]>> m_index_chunks;
+
+    // open-addressing index from coordinate to id; a slot is occupied iff its
+    // generation matches the table's current generation
+    std::vector<Slot> m_slots;
+    std::uint32_t m_generation = 1;
+    int m_indexed = 0;
+
+    auto hash(const int* coord) const -> std::uint32_t;
+    bool equal(const int* a, const int* b) const;
+
+    void addChunk();
+    void growIndex();
+};
+
+} // namespace smpl
+
+#endif
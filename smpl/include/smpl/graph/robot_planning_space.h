@@ -107,6 +107,15 @@ public:
     virtual int GetTrueCost(int parentID, int childID) override;
     ///@}
 
+    /// Compute the true costs of a batch of edges, as by GetTrueCost(), with
+    /// -1 for invalid edges. Planning spaces may override this to evaluate
+    /// the edges concurrently.
+    virtual void GetTrueCosts(
+        const int* parent_ids,
+        const int* child_ids,
+        int count,
+        int* costs);
+
     /// \name Restate DiscreteSpaceInformation Interface
     ///@{
     virtual void GetSuccs(
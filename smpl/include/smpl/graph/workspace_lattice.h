@@ -83,6 +83,9 @@ struct WorkspaceLattice :
 
     std::string m_viz_frame_id;
 
+    // ik solution branches for the waypoint being checked
+    std::vector<RobotState> m_ik_solutions;
+
     ~WorkspaceLattice();
 
     void setVisualizationFrameId(const std::string& frame_id);
@@ -176,6 +179,11 @@ struct WorkspaceLattice :
         const WorkspaceAction& action,
         RobotState* final_rstate = nullptr);
 
+    bool waypointToRobot(
+        const RobotState& prev,
+        const WorkspaceState& waypoint,
+        RobotState& ostate);
+
     bool isGoal(const WorkspaceState& state, const RobotState& robot_state) const;
 
     auto getStateVisualization(const RobotState& state, const std::string& ns)
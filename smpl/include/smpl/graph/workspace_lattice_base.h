@@ -32,6 +32,11 @@
 #ifndef SMPL_WORKSPACE_LATTICE_BASE_H
 #define SMPL_WORKSPACE_LATTICE_BASE_H
 
+// standard includes
+#include <cstddef>
+#include <list>
+#include <vector>
+
 // project includes
 #include <smpl/graph/robot_planning_space.h>
 #include <smpl/graph/workspace_lattice_types.h>
@@ -71,8 +76,59 @@ public:
         int Y_count;
 
         std::vector<double> free_angle_res;
+
+        /// Maximum number of ik results remembered; 0 disables the cache
+        int ik_cache_size = 32768;
+
+        /// Width of the buckets that the non-redundant variables of an ik seed
+        /// are grouped into; nonpositive to ignore the seed
+        double ik_cache_seed_res = 0.1;
+
+        /// Largest change of any non-redundant joint variable between
+        /// consecutive waypoints of an action. Larger changes mean that the ik
+        /// solution jumped to another branch.
+        double ik_branch_step = 0.5;
+    };
+
+    struct IKCacheStats
+    {
+        std::size_t hits = 0;
+        std::size_t failure_hits = 0;
+        std::size_t misses = 0;
+        std::size_t bypasses = 0; // queries off a cell center or its free angles
+        std::size_t evictions = 0;
+
+        double hitRate() const;
+    };
+
+    // ik results for states at the center of a lattice cell, keyed by the
+    // workspace coordinate followed by the seed bucket, most recently used
+    // first. Failed queries are remembered with no solutions.
+    struct IKCacheEntry
+    {
+        std::vector<int> key;
+        std::vector<RobotState> solutions;
+        bool all_branches;
     };
 
+    using IKCacheList = std::list<IKCacheEntry>;
+
+    mutable IKCacheList m_ik_cache;
+    mutable hash_map<std::vector<int>, IKCacheList::iterator, VectorHash<int>> m_ik_cache_index;
+    mutable IKCacheStats m_ik_cache_stats;
+    mutable std::vector<int> m_ik_cache_key;
+    mutable WorkspaceCoord m_ik_cache_coord;
+    mutable WorkspaceState m_ik_cache_center;
+    std::size_t m_ik_cache_size = 0;
+    double m_ik_cache_seed_res = 0.0;
+
+    double m_ik_branch_step = 0.0;
+
+    // the pose of a fixed robot state when the cache was filled, used to
+    // detect changes to the kinematic frame between planning requests
+    RobotState m_ik_cache_ref_state;
+    Affine3 m_ik_cache_ref_pose;
+
     virtual bool init(
         RobotModel* robot,
         CollisionChecker* checker,
@@ -96,9 +152,39 @@ public:
     bool stateWorkspaceToRobot(
         const WorkspaceState& state, const RobotState& seed, RobotState& ostate) const;
 
+    /// Append every ik solution branch for the workspace state with the
+    /// redundant angles held at the seed, nearest the seed first.
+    bool stateWorkspaceToRobotSolutions(
+        const WorkspaceState& state,
+        const RobotState& seed,
+        std::vector<RobotState>& osolutions) const;
+
     // TODO: variants of workspace -> robot that don't restrict redundant angles
     // TODO: variants of workspace -> robot that take in a full seed state
 
+    auto ikCacheStats() const -> const IKCacheStats& { return m_ik_cache_stats; }
+
+    void clearIKCache();
+
+    /// Clear the ik cache if the kinematic frame of the robot model has moved
+    /// since the cache was filled. Called when the start state is set.
+    void validateIKCache(const RobotState& state);
+
+    /// Find the cached ik result for a query. A query for all solution
+    /// branches is only answered by an entry that holds all branches.
+    ///
+    /// \return true if the result was found; false otherwise, in which case
+    ///     the key for a subsequent insertIK() is prepared if the query is for
+    ///     a state at the center of its cell
+    bool lookupIK(
+        const WorkspaceState& state,
+        const RobotState& seed,
+        bool all_branches,
+        const IKCacheEntry** entry) const;
+
+    /// Remember the result of the query last passed to a missed lookupIK().
+    void insertIK(const RobotState* solutions, int count, bool all_branches) const;
+
     // conversions from discrete coordinates to continuous states
     void posWorkspaceToCoord(const double* wp, int* gp) const;
     void posCoordToWorkspace(const int* gp, double* wp) const;
@@ -36,6 +36,8 @@
 
 // standard includes
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 #include <limits>
 
 namespace smpl {
@@ -43,7 +45,9 @@ namespace smpl {
 template <class T, class Allocator>
 SparseGrid<T, Allocator>::SparseGrid() :
     m_tree(),
-    m_max_depth(16)
+    m_max_depth(16),
+    m_id(next_id()),
+    m_version(0)
 {
     m_size[0] = m_size[1] = m_size[2] = 1u << 16;
 }
@@ -51,7 +55,9 @@ SparseGrid<T, Allocator>::SparseGrid() :
 template <class T, class Allocator>
 SparseGrid<T, Allocator>::SparseGrid(const T& value) :
     m_tree(value),
-    m_max_depth(16)
+    m_max_depth(16),
+    m_id(next_id()),
+    m_version(0)
 {
     m_size[0] = m_size[1] = m_size[2] = 1u << 16;
 }
@@ -63,7 +69,9 @@ SparseGrid<T, Allocator>::SparseGrid(
     size_type size_z)
 :
     m_tree(),
-    m_max_depth(compute_max_depth(size_x, size_y, size_z))
+    m_max_depth(compute_max_depth(size_x, size_y, size_z)),
+    m_id(next_id()),
+    m_version(0)
 {
     m_size[0] = size_x;
     m_size[1] = size_y;
@@ -78,7 +86,9 @@ SparseGrid<T, Allocator>::SparseGrid(
     const T& value)
 :
     m_tree(value),
-    m_max_depth(compute_max_depth(size_x, size_y, size_z))
+    m_max_depth(compute_max_depth(size_x, size_y, size_z)),
+    m_id(next_id()),
+    m_version(0)
 {
     m_size[0] = size_x;
     m_size[1] = size_y;
@@ -88,7 +98,9 @@ SparseGrid<T, Allocator>::SparseGrid(
 template <class T, class Allocator>
 SparseGrid<T, Allocator>::SparseGrid(const Allocator& alloc) :
     m_tree(alloc),
-    m_max_depth(16)
+    m_max_depth(16),
+    m_id(next_id()),
+    m_version(0)
 {
     m_size[0] = m_size[1] = m_size[2] = 1u << 16;
 }
@@ -96,7 +108,9 @@ SparseGrid<T, Allocator>::SparseGrid(const Allocator& alloc) :
 template <class T, class Allocator>
 SparseGrid<T, Allocator>::SparseGrid(const T& value, const Allocator& alloc) :
     m_tree(value, alloc),
-    m_max_depth(16)
+    m_max_depth(16),
+    m_id(next_id()),
+    m_version(0)
 {
     m_size[0] = m_size[1] = m_size[2] = 1u << 16;
 }
@@ -107,7 +121,9 @@ SparseGrid<T, Allocator>::SparseGrid(
     const Allocator& alloc)
 :
     m_tree(alloc),
-    m_max_depth(compute_max_depth(size_x, size_y, size_z))
+    m_max_depth(compute_max_depth(size_x, size_y, size_z)),
+    m_id(next_id()),
+    m_version(0)
 {
     m_size[0] = size_x;
     m_size[1] = size_y;
@@ -120,13 +136,73 @@ SparseGrid<T, Allocator>::SparseGrid(
     const T& value, const Allocator& alloc)
 :
     m_tree(value, alloc),
-    m_max_depth(compute_max_depth(size_x, size_y, size_z))
+    m_max_depth(compute_max_depth(size_x, size_y, size_z)),
+    m_id(next_id()),
+    m_version(0)
 {
     m_size[0] = size_x;
     m_size[1] = size_y;
     m_size[2] = size_z;
 }
 
+/// Copy constructor. The copy is given a new id, so that lookups cached for
+/// the original are not used for the copy.
+template <class T, class Allocator>
+SparseGrid<T, Allocator>::SparseGrid(const SparseGrid& o) :
+    m_tree(o.m_tree),
+    m_max_depth(o.m_max_depth),
+    m_id(next_id()),
+    m_version(0)
+{
+    m_size[0] = o.m_size[0];
+    m_size[1] = o.m_size[1];
+    m_size[2] = o.m_size[2];
+}
+
+template <class T, class Allocator>
+SparseGrid<T, Allocator>::SparseGrid(SparseGrid&& o) :
+    m_tree(std::move(o.m_tree)),
+    m_max_depth(o.m_max_depth),
+    m_id(next_id()),
+    m_version(0)
+{
+    m_size[0] = o.m_size[0];
+    m_size[1] = o.m_size[1];
+    m_size[2] = o.m_size[2];
+    o.modified();
+}
+
+template <class T, class Allocator>
+SparseGrid<T, Allocator>&
+SparseGrid<T, Allocator>::operator=(const SparseGrid& rhs)
+{
+    if (this != &rhs) {
+        m_tree = rhs.m_tree;
+        m_max_depth = rhs.m_max_depth;
+        m_size[0] = rhs.m_size[0];
+        m_size[1] = rhs.m_size[1];
+        m_size[2] = rhs.m_size[2];
+        modified();
+    }
+    return *this;
+}
+
+template <class T, class Allocator>
+SparseGrid<T, Allocator>&
+SparseGrid<T, Allocator>::operator=(SparseGrid&& rhs)
+{
+    if (this != &rhs) {
+        m_tree = std::move(rhs.m_tree);
+        m_max_depth = rhs.m_max_depth;
+        m_size[0] = rhs.m_size[0];
+        m_size[1] = rhs.m_size[1];
+        m_size[2] = rhs.m_size[2];
+        modified();
+        rhs.modified();
+    }
+    return *this;
+}
+
 /// Return the size of the three-dimensional grid. This corresponds to the
 /// maximum possible number of leaf nodes for the octree's size. OcTree::size_type OcTree::size() const
 template <class T, class Allocator>
@@ -177,24 +253,26 @@ SparseGrid<T, Allocator>::max_depth() const
     return m_max_depth;
 }
 
+/// Return the approximate number of bytes used by the grid. When the allocator
+/// is a PoolAllocator, this is the storage reserved by its pool.
 template <class T, class Allocator>
 auto SparseGrid<T, Allocator>::mem_usage() const -> size_type
 {
     return m_tree.mem_usage();
 }
 
-// TODO: test efficiency of recursion using (x, y, z) vs index arguments
 template <class T, class Allocator>
 typename SparseGrid<T, Allocator>::const_reference
 SparseGrid<T, Allocator>::operator()(index_type x, index_type y, index_type z) const
 {
-    return get_node(m_max_depth, m_tree.root(), x, y, z)->value;
+    return get(x, y, z);
 }
 
 template <class T, class Allocator>
 typename SparseGrid<T, Allocator>::reference
 SparseGrid<T, Allocator>::operator()(index_type x, index_type y, index_type z)
 {
+    modified();
     return get_node_unique(m_max_depth, m_tree.root(), x, y, z)->value;
 }
 
@@ -203,6 +281,7 @@ template <class T, class Allocator>
 void
 SparseGrid<T, Allocator>::reset(const T& value)
 {
+    modified();
     m_tree.clear();
     m_tree.root()->value = value;
 }
@@ -219,6 +298,7 @@ void
 SparseGrid<T, Allocator>::set(
     index_type x, index_type y, index_type z, const T& data)
 {
+    modified();
     set_node(m_max_depth, m_tree.root(), x, y, z, data);
 }
 
@@ -227,12 +307,14 @@ void
 SparseGrid<T, Allocator>::set_lazy(
     index_type x, index_type y, index_type z, const T& data)
 {
+    modified();
     set_node_lazy(m_max_depth, m_tree.root(), x, y, z, data);
 }
 
 template <class T, class Allocator>
 void SparseGrid<T, Allocator>::prune()
 {
+    modified();
     prune(m_tree.root());
 }
 
@@ -240,6 +322,7 @@ template <class T, class Allocator>
 template <class UnaryPredicate>
 void SparseGrid<T, Allocator>::prune(UnaryPredicate p)
 {
+    modified();
     prune(m_tree.root(), p);
 }
 
@@ -250,6 +333,7 @@ SparseGrid<T, Allocator>::resize(
     size_type size_y,
     size_type size_z)
 {
+    modified();
     m_tree.clear(); // TODO: non-destructive resize
     m_size[0] = size_x;
     m_size[1] = size_y;
@@ -273,7 +357,75 @@ template <class T, class Allocator>
 typename SparseGrid<T, Allocator>::const_reference
 SparseGrid<T, Allocator>::get(index_type x, index_type y, index_type z) const
 {
-    return get_node(m_max_depth, m_tree.root(), x, y, z)->value;
+    assert(m_max_depth <= MAX_MORTON_DEPTH);
+    const std::uint64_t code = morton_code(x, y, z);
+
+    LeafCache& cache = leaf_cache();
+    if (cache.id == m_id && cache.version == m_version &&
+        (code >> cache.shift) == cache.prefix)
+    {
+        return cache.leaf->value;
+    }
+
+    int rdepth;
+    const node_type* n = find_leaf(m_tree.root(), m_max_depth, code, rdepth);
+
+    cache.id = m_id;
+    cache.version = m_version;
+    cache.shift = 3 * rdepth;
+    cache.prefix = code >> cache.shift;
+    cache.leaf = n;
+    return n->value;
+}
+
+/// Look up the values of a sequence of cells, given as consecutive (x, y, z)
+/// triples in coords, and store pointers to them in values. The pointers are
+/// valid until the grid is next modified. Each descent begins from the deepest
+/// ancestor shared with the previous cell in the sequence.
+template <class T, class Allocator>
+void SparseGrid<T, Allocator>::get(
+    const index_type* coords,
+    size_type count,
+    const value_type** values) const
+{
+    assert(m_max_depth <= MAX_MORTON_DEPTH);
+
+    // path[k] is the node k levels below the root on the path to the leaf
+    // containing the previous cell, which is path[depth]
+    const node_type* path[MAX_MORTON_DEPTH + 1];
+    path[0] = m_tree.root();
+    int depth = 0;
+    std::uint64_t prev = 0;
+
+    for (size_type i = 0; i < count; ++i) {
+        const std::uint64_t code = morton_code(
+                coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+
+        // the first differing digit selects a child below path[k], if the
+        // previous descent went that far
+        int k = 0;
+        if (i != 0) {
+            const std::uint64_t diff = code ^ prev;
+            if (diff == 0) {
+                k = depth;
+            } else {
+                const int r = (63 - __builtin_clzll(diff)) / 3;
+                k = std::max(0, std::min(depth, m_max_depth - 1 - r));
+            }
+        }
+
+        const node_type* n = path[k];
+        int rdepth = m_max_depth - k;
+        while (rdepth && n->children) {
+            --rdepth;
+            n = &n->children[(code >> (3 * rdepth)) & 7];
+            path[++k] = n;
+        }
+
+        depth = k;
+        prev = code;
+        values[i] = &n->value;
+    }
 }
 
 /// Return the approximate number of bytes used by an equivalent dense grid.
@@ -322,6 +474,14 @@ void SparseGrid<T, Allocator>::accept_coords(Callable c)
     accept_coords(c, m_tree.root(), 0, 0, 0, max_coord, max_coord, max_coord);
 }
 
+template <class T, class Allocator>
+template <typename Callable>
+void SparseGrid<T, Allocator>::accept_coords(Callable c) const
+{
+    int max_coord = 1 << m_max_depth;
+    accept_coords(c, m_tree.root(), 0, 0, 0, max_coord, max_coord, max_coord);
+}
+
 template <class T, class Allocator>
 int SparseGrid<T, Allocator>::compute_max_depth(
     size_type size_x,
@@ -350,34 +510,54 @@ int SparseGrid<T, Allocator>::compute_max_depth(
 }
 
 template <class T, class Allocator>
-const typename SparseGrid<T, Allocator>::node_type*
-SparseGrid<T, Allocator>::get_node(
-    int rdepth,
-    const node_type* n,
-    index_type x,
-    index_type y,
-    index_type z) const
+std::uint64_t SparseGrid<T, Allocator>::next_id()
 {
-    if (!rdepth) {
-        return n;
-    }
-
-    if (!n->children) {
-        return n;
-    }
+    static std::atomic<std::uint64_t> id(1);
+    return id++;
+}
 
-    --rdepth;
+template <class T, class Allocator>
+auto SparseGrid<T, Allocator>::leaf_cache() -> LeafCache&
+{
+    static thread_local LeafCache cache;
+    return cache;
+}
 
-    index_type x_loc = x >> rdepth;
-    index_type y_loc = y >> rdepth;
-    index_type z_loc = z >> rdepth;
-    index_type cidx = x_loc << 2 | y_loc << 1 | z_loc;
+/// Interleave the bits of the coordinates of a cell, so that each group of
+/// three bits, from least to most significant, is the index of the child
+/// containing the cell at the corresponding level above the leaves.
+template <class T, class Allocator>
+std::uint64_t SparseGrid<T, Allocator>::morton_code(
+    index_type x, index_type y, index_type z)
+{
+    auto spread = [](std::uint64_t v) {
+        v &= 0x1FFFFF;
+        v = (v | v << 32) & 0x1F00000000FFFF;
+        v = (v | v << 16) & 0x1F0000FF0000FF;
+        v = (v | v << 8) & 0x100F00F00F00F00F;
+        v = (v | v << 4) & 0x10C30C30C30C30C3;
+        v = (v | v << 2) & 0x1249249249249249;
+        return v;
+    };
+    return spread(x) << 2 | spread(y) << 1 | spread(z);
+}
 
-    return get_node(
-            rdepth, &n->children[cidx],
-            x - (x_loc << rdepth),
-            y - (y_loc << rdepth),
-            z - (z_loc << rdepth));
+/// Descend from a node, rdepth levels above the leaves, to the leaf containing
+/// the cell with the given Morton code, and return the number of levels the
+/// leaf lies above the deepest level in leaf_rdepth.
+template <class T, class Allocator>
+auto SparseGrid<T, Allocator>::find_leaf(
+    const node_type* n,
+    int rdepth,
+    std::uint64_t code,
+    int& leaf_rdepth) const -> const node_type*
+{
+    while (rdepth && n->children) {
+        --rdepth;
+        n = &n->children[(code >> (3 * rdepth)) & 7];
+    }
+    leaf_rdepth = rdepth;
+    return n;
 }
 
 template <class T, class Allocator>
@@ -536,12 +716,17 @@ SparseGrid<T, Allocator>::create_node(
             z - (z_loc << rdepth));
 }
 
+/// Test whether all children of a node are leaves with equal values. The
+/// values of internal nodes are stale, so they do not count.
 template <class T, class Allocator>
 bool SparseGrid<T, Allocator>::collapsible(node_type* n) const
 {
     assert(n->children);
+    if (n->children[0].children) {
+        return false;
+    }
     for (node_type* c = n->children + 1; c != n->children + 8; ++c) {
-        if (!std::equal_to<T>()(c->value, n->children[0].value)) {
+        if (c->children || !std::equal_to<T>()(c->value, n->children[0].value)) {
             return false;
         }
     }
@@ -588,9 +773,9 @@ bool SparseGrid<T, Allocator>::prune(node_type* n, UnaryPredicate p)
 }
 
 template <class T, class Allocator>
-template <typename Callable>
+template <typename Callable, typename NodePtr>
 void SparseGrid<T, Allocator>::accept_coords(
-    Callable c, node_type* n,
+    Callable c, NodePtr n,
     size_type first_x, size_type first_y, size_type first_z,
     size_type last_x, size_type last_y, size_type last_z)
 {
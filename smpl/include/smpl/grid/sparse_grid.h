@@ -33,6 +33,7 @@
 #define SMPL_SPARSE_GRID_H
 
 // standard includes
+#include <cstdint>
 #include <memory>
 
 // project includes
@@ -68,6 +69,14 @@ namespace smpl {
 /// set() to skip automatic pruning of nodes. The underlying octree may then be
 /// explicitly pruned by calling the prune() function, which will prune all
 /// nodes where applicable for maximum compression.
+///
+/// Lookups descend the octree iteratively, selecting each child by the
+/// corresponding digit of the cell's Morton code. Each thread remembers the
+/// leaf found by its most recent get() on each grid type, which answers
+/// repeated queries within the same leaf without a descent until the grid is
+/// next modified. Batches of nearby cells are best looked up with the batch
+/// overload of get(), which resumes each descent from the deepest ancestor
+/// shared with the previous cell.
 template <class T, class Allocator = std::allocator<T>>
 class SparseGrid
 {
@@ -98,6 +107,12 @@ public:
         size_type size_x, size_type size_y, size_type size_z,
         const T& value, const Allocator& alloc);
 
+    SparseGrid(const SparseGrid& o);
+    SparseGrid(SparseGrid&& o);
+
+    SparseGrid& operator=(const SparseGrid& rhs);
+    SparseGrid& operator=(SparseGrid&& rhs);
+
     /// \name Size Properties
     ///@{
     size_type size() const;
@@ -118,6 +133,11 @@ public:
     reference operator()(index_type x, index_type y, index_type z);
 
     const_reference get(index_type x, index_type y, index_type z) const;
+
+    void get(
+        const index_type* coords,
+        size_type count,
+        const value_type** values) const;
     ///@}
 
     /// \name Modifiers
@@ -146,27 +166,57 @@ public:
     template <typename Callable>
     void accept_coords(Callable c);
 
+    template <typename Callable>
+    void accept_coords(Callable c) const;
+
     const TreeType &tree() const { return m_tree; }
 
 private:
 
+    // the deepest tree that can be addressed by a 64-bit Morton code
+    static const int MAX_MORTON_DEPTH = 21;
+
+    // The leaf most recently returned by get(), on this thread, for the grid
+    // identified by (id, version), and the prefix of the Morton codes of the
+    // cells it contains
+    struct LeafCache
+    {
+        std::uint64_t id = 0;
+        std::uint64_t version = 0;
+        std::uint64_t prefix = 0;
+        int shift = 0;
+        const node_type* leaf = nullptr;
+    };
+
     OcTree<T, Allocator> m_tree;
 
     int m_max_depth;
     size_type m_size[3];
 
+    // A globally unique id for this grid, and the number of modifications
+    // made to it, which together identify the structure of its tree. Ids are
+    // never reused, so cached nodes can not be confused between grids.
+    std::uint64_t m_id;
+    std::uint64_t m_version;
+
+    static std::uint64_t next_id();
+    static LeafCache& leaf_cache();
+
+    static std::uint64_t morton_code(index_type x, index_type y, index_type z);
+
+    void modified() { ++m_version; }
+
+    const node_type* find_leaf(
+        const node_type* n,
+        int rdepth,
+        std::uint64_t code,
+        int& leaf_rdepth) const;
+
     int compute_max_depth(
         size_type size_x,
         size_type size_y,
         size_type size_z) const;
 
-    const node_type* get_node(
-        int rdepth,
-        const node_type* n,
-        index_type x,
-        index_type y,
-        index_type z) const;
-
     node_type* get_node_unique(
         int rdepth,
         node_type* n,
@@ -204,9 +254,9 @@ private:
     template <class UnaryPredicate>
     bool prune(node_type* n, UnaryPredicate p);
 
-    template <typename Callable>
-    void accept_coords(
-        Callable c, node_type* n,
+    template <typename Callable, typename NodePtr>
+    static void accept_coords(
+        Callable c, NodePtr n,
         size_type first_x, size_type first_y, size_type first_z,
         size_type last_x, size_type last_y, size_type last_z);
 };
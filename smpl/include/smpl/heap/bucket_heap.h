@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_BUCKET_HEAP_H
+#define SMPL_BUCKET_HEAP_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+
+#include <smpl/heap/intrusive_heap.h>
+
+namespace smpl {
+
+/// Provides an intrusive bucket queue with the interface of intrusive_heap.
+/// Objects inserted into the queue must derive from the \p heap_element class,
+/// and an object may be stored in at most one intrusive_heap or bucket_heap at
+/// a time. The implementation stores pointers to inserted objects, which must
+/// remain valid throughout the lifetime of the queue.
+///
+/// Rather than comparing elements, the queue keeps one bucket per integer key,
+/// determined by calling the \p Key function object on an element. Insertion,
+/// erasure, and updates of element priorities take constant time, and the
+/// minimum element is found by scanning a bitmap of nonempty buckets from the
+/// last minimum key. Keys do not need to be monotone, but the memory used by
+/// the queue is proportional to the range of keys inserted since the queue
+/// was last empty, so it is intended for small integer keys, such as the
+/// f-values of a search over integer edge costs. Elements with equal keys are
+/// popped in last-in-first-out order.
+///
+/// If the keys of multiple elements are implicitly changed, the queue may be
+/// rebuilt in linear time by calling the make() member function.
+template <class T, class Key>
+class bucket_heap
+{
+public:
+
+    static_assert(std::is_base_of<heap_element, T>::value, "T must extend heap_element");
+
+    typedef Key key_function;
+    typedef std::int64_t key_type;
+
+    typedef std::vector<T*> container_type;
+    typedef typename container_type::size_type size_type;
+
+    typedef typename container_type::iterator iterator;
+    typedef typename container_type::const_iterator const_iterator;
+
+    bucket_heap(const key_function& key = key_function());
+
+    template <class InputIt>
+    bucket_heap(InputIt first, InputIt last);
+
+    template <class InputIt>
+    bucket_heap(const key_function& key, InputIt first, InputIt last);
+
+    bucket_heap(const bucket_heap&) = delete;
+
+    bucket_heap(bucket_heap&& o);
+
+    bucket_heap& operator=(const bucket_heap&) = delete;
+    bucket_heap& operator=(bucket_heap&& rhs);
+
+    T* min() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    bool empty() const;
+    size_type size() const;
+    size_type max_size() const;
+    void reserve(size_type new_cap);
+
+    void clear();
+    void push(T* e);
+    void pop();
+    bool contains(T* e);
+    void update(T* e);
+    void increase(T* e);
+    void decrease(T* e);
+    void erase(T* e);
+
+    void make();
+
+    void swap(bucket_heap& o);
+
+private:
+
+    // links of an element within the list of its bucket, parallel to m_data
+    struct node
+    {
+        key_type key;
+        size_type prev;
+        size_type next;
+    };
+
+    // elements, with a null element at index 0 so that a zero heap index or
+    // link means none, as in intrusive_heap
+    container_type m_data;
+    std::vector<node> m_nodes;
+
+    // head of the list of elements in each bucket, for keys starting at
+    // m_base, and a bit for each nonempty bucket
+    std::vector<size_type> m_heads;
+    std::vector<std::uint64_t> m_bits;
+    key_type m_base;
+
+    // lowest nonempty bucket, when the queue is not empty
+    size_type m_min;
+
+    key_function m_key;
+
+    size_type bucket(key_type key);
+    void link(size_type pos, size_type b);
+    void unlink(size_type pos);
+    size_type next_bucket(size_type b) const;
+};
+
+template <class T, class Key>
+void swap(bucket_heap<T, Key>& lhs, bucket_heap<T, Key>& rhs);
+
+} // namespace smpl
+
+#include "detail/bucket_heap.hpp"
+
+#endif
@@ -0,0 +1,349 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_BUCKET_HEAP_HPP
+#define SMPL_BUCKET_HEAP_HPP
+
+#include "../bucket_heap.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <utility>
+
+namespace smpl {
+
+template <class T, class Key>
+bucket_heap<T, Key>::bucket_heap(const key_function& key) :
+    m_data(1, nullptr),
+    m_nodes(1),
+    m_heads(),
+    m_bits(),
+    m_base(0),
+    m_min(0),
+    m_key(key)
+{
+}
+
+template <class T, class Key>
+template <class InputIt>
+bucket_heap<T, Key>::bucket_heap(
+    const key_function& key,
+    InputIt first,
+    InputIt last)
+:
+    bucket_heap(key)
+{
+    for (auto it = first; it != last; ++it) {
+        push(*it);
+    }
+}
+
+template <class T, class Key>
+template <class InputIt>
+bucket_heap<T, Key>::bucket_heap(InputIt first, InputIt last) :
+    bucket_heap(key_function(), first, last)
+{
+}
+
+template <class T, class Key>
+bucket_heap<T, Key>::bucket_heap(bucket_heap&& o) :
+    bucket_heap(o.m_key)
+{
+    swap(o);
+}
+
+template <class T, class Key>
+bucket_heap<T, Key>&
+bucket_heap<T, Key>::operator=(bucket_heap&& rhs)
+{
+    if (this != &rhs) {
+        clear();
+        swap(rhs);
+    }
+    return *this;
+}
+
+template <class T, class Key>
+T* bucket_heap<T, Key>::min() const
+{
+    assert(m_data.size() > 1);
+    return m_data[m_heads[m_min]];
+}
+
+template <class T, class Key>
+typename bucket_heap<T, Key>::const_iterator
+bucket_heap<T, Key>::begin() const
+{
+    return m_data.begin() + 1;
+}
+
+template <class T, class Key>
+typename bucket_heap<T, Key>::const_iterator
+bucket_heap<T, Key>::end() const
+{
+    return m_data.end();
+}
+
+template <class T, class Key>
+bool bucket_heap<T, Key>::empty() const
+{
+    return m_data.size() == 1;
+}
+
+template <class T, class Key>
+typename bucket_heap<T, Key>::size_type
+bucket_heap<T, Key>::size() const
+{
+    return m_data.size() - 1;
+}
+
+template <class T, class Key>
+typename bucket_heap<T, Key>::size_type
+bucket_heap<T, Key>::max_size() const
+{
+    return m_data.max_size() - 1;
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::reserve(size_type new_cap)
+{
+    m_data.reserve(new_cap + 1);
+    m_nodes.reserve(new_cap + 1);
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::clear()
+{
+    for (size_t i = 1; i < m_data.size(); ++i) {
+        m_data[i]->m_heap_index = 0;
+    }
+    m_data.resize(1);
+    m_nodes.resize(1);
+    m_heads.clear();
+    m_bits.clear();
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::push(T* e)
+{
+    assert(e);
+    const key_type key = m_key(*e);
+    const size_type b = bucket(key);
+
+    const size_type pos = m_data.size();
+    e->m_heap_index = pos;
+    m_data.push_back(e);
+    m_nodes.push_back(node{ key, 0, 0 });
+    link(pos, b);
+
+    if (pos == 1 || b < m_min) {
+        m_min = b;
+    }
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::pop()
+{
+    assert(!empty());
+    erase(min());
+}
+
+template <class T, class Key>
+bool bucket_heap<T, Key>::contains(T* e)
+{
+    assert(e);
+    return e->m_heap_index != 0;
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::update(T* e)
+{
+    assert(e && contains(e));
+    erase(e);
+    push(e);
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::increase(T* e)
+{
+    update(e);
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::decrease(T* e)
+{
+    update(e);
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::erase(T* e)
+{
+    assert(e && contains(e));
+    const size_type pos = e->m_heap_index;
+    const size_type b = m_nodes[pos].key - m_base;
+    unlink(pos);
+
+    // move the last element into the vacated position
+    const size_type last = m_data.size() - 1;
+    if (pos != last) {
+        m_data[pos] = m_data[last];
+        m_nodes[pos] = m_nodes[last];
+        m_data[pos]->m_heap_index = pos;
+        const node& n = m_nodes[pos];
+        if (n.prev) {
+            m_nodes[n.prev].next = pos;
+        } else {
+            m_heads[n.key - m_base] = pos;
+        }
+        if (n.next) {
+            m_nodes[n.next].prev = pos;
+        }
+    }
+    m_data.pop_back();
+    m_nodes.pop_back();
+    e->m_heap_index = 0;
+
+    if (empty()) {
+        // recenter the buckets around the next key pushed
+        m_heads.clear();
+        m_bits.clear();
+    } else if (b == m_min && !m_heads[b]) {
+        m_min = next_bucket(b);
+    }
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::make()
+{
+    container_type elements(m_data.begin() + 1, m_data.end());
+    clear();
+    for (T* e : elements) {
+        push(e);
+    }
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::swap(bucket_heap& o)
+{
+    if (this != &o) {
+        using std::swap;
+        swap(m_data, o.m_data);
+        swap(m_nodes, o.m_nodes);
+        swap(m_heads, o.m_heads);
+        swap(m_bits, o.m_bits);
+        swap(m_base, o.m_base);
+        swap(m_min, o.m_min);
+        swap(m_key, o.m_key);
+    }
+}
+
+// Return the bucket for a key, growing the range of buckets to include it.
+// The number of buckets is kept a multiple of 64, and the range is at least
+// doubled when it grows, so that growth takes amortized constant time.
+template <class T, class Key>
+typename bucket_heap<T, Key>::size_type
+bucket_heap<T, Key>::bucket(key_type key)
+{
+    if (m_heads.empty()) {
+        m_base = key;
+        m_heads.assign(64, 0);
+        m_bits.assign(1, 0);
+        return 0;
+    }
+
+    if (key < m_base) {
+        size_type shift = std::max((size_type)(m_base - key), m_heads.size());
+        shift = (shift + 63) & ~size_type(63);
+        m_heads.insert(m_heads.begin(), shift, 0);
+        m_bits.insert(m_bits.begin(), shift >> 6, 0);
+        m_base -= (key_type)shift;
+        m_min += shift;
+    } else if ((size_type)(key - m_base) >= m_heads.size()) {
+        size_type count = std::max((size_type)(key - m_base) + 1, 2 * m_heads.size());
+        count = (count + 63) & ~size_type(63);
+        m_heads.resize(count, 0);
+        m_bits.resize(count >> 6, 0);
+    }
+    return key - m_base;
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::link(size_type pos, size_type b)
+{
+    const size_type head = m_heads[b];
+    m_nodes[pos].prev = 0;
+    m_nodes[pos].next = head;
+    if (head) {
+        m_nodes[head].prev = pos;
+    } else {
+        m_bits[b >> 6] |= std::uint64_t(1) << (b & 63);
+    }
+    m_heads[b] = pos;
+}
+
+template <class T, class Key>
+void bucket_heap<T, Key>::unlink(size_type pos)
+{
+    const node& n = m_nodes[pos];
+    const size_type b = n.key - m_base;
+    if (n.prev) {
+        m_nodes[n.prev].next = n.next;
+    } else {
+        m_heads[b] = n.next;
+        if (!n.next) {
+            m_bits[b >> 6] &= ~(std::uint64_t(1) << (b & 63));
+        }
+    }
+    if (n.next) {
+        m_nodes[n.next].prev = n.prev;
+    }
+}
+
+// Return the first nonempty bucket after b. The queue must not be empty.
+template <class T, class Key>
+typename bucket_heap<T, Key>::size_type
+bucket_heap<T, Key>::next_bucket(size_type b) const
+{
+    size_type w = b >> 6;
+    std::uint64_t bits = m_bits[w] & (~std::uint64_t(0) << (b & 63));
+    while (!bits) {
+        bits = m_bits[++w];
+    }
+    return (w << 6) + __builtin_ctzll(bits);
+}
+
+template <class T, class Key>
+void swap(bucket_heap<T, Key>& lhs, bucket_heap<T, Key>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,369 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_INTRUSIVE_DARY_HEAP_HPP
+#define SMPL_INTRUSIVE_DARY_HEAP_HPP
+
+#include "../intrusive_dary_heap.h"
+
+#include <assert.h>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace smpl {
+
+// alignment of the entry array
+static const std::size_t DARY_HEAP_ALIGNMENT = 64;
+
+template <class T, class Key, int D>
+intrusive_dary_heap<T, Key, D>::intrusive_dary_heap(const key_function& key) :
+    m_buffer(nullptr),
+    m_data(nullptr),
+    m_size(0),
+    m_capacity(0),
+    m_key(key)
+{
+}
+
+template <class T, class Key, int D>
+template <class InputIt>
+intrusive_dary_heap<T, Key, D>::intrusive_dary_heap(
+    const key_function& key,
+    InputIt first,
+    InputIt last)
+:
+    intrusive_dary_heap(key)
+{
+    for (auto it = first; it != last; ++it) {
+        if (m_size == m_capacity) {
+            grow(2 * m_capacity);
+        }
+        T* e = *it;
+        const size_type pos = ROOT + m_size++;
+        m_data[pos].key = m_key(*e);
+        m_data[pos].elem = e;
+        e->m_heap_index = pos;
+    }
+    make();
+}
+
+template <class T, class Key, int D>
+template <class InputIt>
+intrusive_dary_heap<T, Key, D>::intrusive_dary_heap(InputIt first, InputIt last) :
+    intrusive_dary_heap(key_function(), first, last)
+{
+}
+
+template <class T, class Key, int D>
+intrusive_dary_heap<T, Key, D>::intrusive_dary_heap(intrusive_dary_heap&& o) :
+    intrusive_dary_heap(o.m_key)
+{
+    swap(o);
+}
+
+template <class T, class Key, int D>
+intrusive_dary_heap<T, Key, D>::~intrusive_dary_heap()
+{
+    ::operator delete(m_buffer);
+}
+
+template <class T, class Key, int D>
+intrusive_dary_heap<T, Key, D>&
+intrusive_dary_heap<T, Key, D>::operator=(intrusive_dary_heap&& rhs)
+{
+    if (this != &rhs) {
+        clear();
+        swap(rhs);
+    }
+    return *this;
+}
+
+template <class T, class Key, int D>
+T* intrusive_dary_heap<T, Key, D>::min() const
+{
+    assert(m_size > 0);
+    return m_data[ROOT].elem;
+}
+
+template <class T, class Key, int D>
+typename intrusive_dary_heap<T, Key, D>::const_iterator
+intrusive_dary_heap<T, Key, D>::begin() const
+{
+    return const_iterator(m_data ? m_data + ROOT : nullptr);
+}
+
+template <class T, class Key, int D>
+typename intrusive_dary_heap<T, Key, D>::const_iterator
+intrusive_dary_heap<T, Key, D>::end() const
+{
+    return const_iterator(m_data ? m_data + ROOT + m_size : nullptr);
+}
+
+template <class T, class Key, int D>
+bool intrusive_dary_heap<T, Key, D>::empty() const
+{
+    return m_size == 0;
+}
+
+template <class T, class Key, int D>
+typename intrusive_dary_heap<T, Key, D>::size_type
+intrusive_dary_heap<T, Key, D>::size() const
+{
+    return m_size;
+}
+
+template <class T, class Key, int D>
+typename intrusive_dary_heap<T, Key, D>::size_type
+intrusive_dary_heap<T, Key, D>::max_size() const
+{
+    return (std::numeric_limits<size_type>::max() - DARY_HEAP_ALIGNMENT) /
+            sizeof(entry) - ROOT;
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::reserve(size_type new_cap)
+{
+    if (new_cap > m_capacity) {
+        grow(new_cap);
+    }
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::clear()
+{
+    for (size_type i = 0; i < m_size; ++i) {
+        m_data[ROOT + i].elem->m_heap_index = 0;
+    }
+    m_size = 0;
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::push(T* e)
+{
+    assert(e);
+    if (m_size == m_capacity) {
+        grow(2 * m_capacity);
+    }
+    const size_type pos = ROOT + m_size++;
+    m_data[pos].key = m_key(*e);
+    m_data[pos].elem = e;
+    sift_up(pos);
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::pop()
+{
+    assert(!empty());
+    m_data[ROOT].elem->m_heap_index = 0;
+    --m_size;
+    if (m_size > 0) {
+        m_data[ROOT] = m_data[ROOT + m_size];
+        sift_down(ROOT);
+    }
+}
+
+template <class T, class Key, int D>
+bool intrusive_dary_heap<T, Key, D>::contains(T* e)
+{
+    assert(e);
+    return e->m_heap_index != 0;
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::update(T* e)
+{
+    assert(e && contains(e));
+    m_data[e->m_heap_index].key = m_key(*e);
+    sift(e->m_heap_index);
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::increase(T* e)
+{
+    assert(e && contains(e));
+    m_data[e->m_heap_index].key = m_key(*e);
+    sift_down(e->m_heap_index);
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::decrease(T* e)
+{
+    assert(e && contains(e));
+    m_data[e->m_heap_index].key = m_key(*e);
+    sift_up(e->m_heap_index);
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::erase(T* e)
+{
+    assert(e && contains(e));
+    const size_type pos = e->m_heap_index;
+    e->m_heap_index = 0;
+    --m_size;
+    if (pos != ROOT + m_size) {
+        m_data[pos] = m_data[ROOT + m_size];
+        sift(pos);
+    }
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::make()
+{
+    for (size_type i = 0; i < m_size; ++i) {
+        m_data[ROOT + i].key = m_key(*m_data[ROOT + i].elem);
+    }
+    if (m_size < 2) {
+        return; // the root has no parent to start from
+    }
+    for (size_type pos = parent(ROOT + m_size - 1) + 1; pos-- > ROOT; ) {
+        sift_down(pos);
+    }
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::swap(intrusive_dary_heap& o)
+{
+    if (this != &o) {
+        using std::swap;
+        swap(m_buffer, o.m_buffer);
+        swap(m_data, o.m_data);
+        swap(m_size, o.m_size);
+        swap(m_capacity, o.m_capacity);
+        swap(m_key, o.m_key);
+    }
+}
+
+template <class T, class Key, int D>
+void intrusive_dary_heap<T, Key, D>::grow(size_type new_cap)
+{
+    static_assert(std::is_trivially_copyable<entry>::value,
+            "keys must be trivially copyable");
+
+    new_cap = std::max(new_cap, size_type(16));
+    void* buffer = ::operator new(
+            (ROOT + new_cap) * sizeof(entry) + DARY_HEAP_ALIGNMENT);
+    auto addr = reinterpret_cast<std::uintptr_t>(buffer);
+    addr = (addr + DARY_HEAP_ALIGNMENT - 1) & ~(DARY_HEAP_ALIGNMENT - 1);
+    entry* data = reinterpret_cast<entry*>(addr);
+    if (m_size > 0) {
+        std::memcpy(data + ROOT, m_data + ROOT, m_size * sizeof(entry));
+    }
+    ::operator delete(m_buffer);
+    m_buffer = buffer;
+    m_data = data;
+    m_capacity = new_cap;
+}
+
+template <class T, class Key, int D>
+inline
+typename intrusive_dary_heap<T, Key, D>::size_type
+intrusive_dary_heap<T, Key, D>::parent(size_type pos) const
+{
+    return (pos - D) / D + ROOT;
+}
+
+template <class T, class Key, int D>
+inline
+typename intrusive_dary_heap<T, Key, D>::size_type
+intrusive_dary_heap<T, Key, D>::first_child(size_type pos) const
+{
+    return D * (pos - ROOT + 1);
+}
+
+template <class T, class Key, int D>
+inline
+void intrusive_dary_heap<T, Key, D>::sift_up(size_type pos)
+{
+    const entry tmp = m_data[pos];
+    while (pos != ROOT) {
+        const size_type p = parent(pos);
+        if (!(tmp.key < m_data[p].key)) {
+            break;
+        }
+        m_data[pos] = m_data[p];
+        m_data[pos].elem->m_heap_index = pos;
+        pos = p;
+    }
+    m_data[pos] = tmp;
+    tmp.elem->m_heap_index = pos;
+}
+
+template <class T, class Key, int D>
+inline
+void intrusive_dary_heap<T, Key, D>::sift_down(size_type pos)
+{
+    const entry tmp = m_data[pos];
+    const size_type end = ROOT + m_size;
+    for (;;) {
+        const size_type first = first_child(pos);
+        if (first >= end) {
+            break;
+        }
+        const size_type last = std::min(first + D, end);
+        size_type best = first;
+        for (size_type c = first + 1; c < last; ++c) {
+            if (m_data[c].key < m_data[best].key) {
+                best = c;
+            }
+        }
+        if (!(m_data[best].key < tmp.key)) {
+            break;
+        }
+        m_data[pos] = m_data[best];
+        m_data[pos].elem->m_heap_index = pos;
+        pos = best;
+    }
+    m_data[pos] = tmp;
+    tmp.elem->m_heap_index = pos;
+}
+
+// Move an element whose key may have increased or decreased into place
+template <class T, class Key, int D>
+inline
+void intrusive_dary_heap<T, Key, D>::sift(size_type pos)
+{
+    if (pos != ROOT && m_data[pos].key < m_data[parent(pos)].key) {
+        sift_up(pos);
+    } else {
+        sift_down(pos);
+    }
+}
+
+template <class T, class Key, int D>
+void swap(intrusive_dary_heap<T, Key, D>& lhs, intrusive_dary_heap<T, Key, D>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+} // namespace smpl
+
+#endif
@@ -203,7 +203,15 @@ void intrusive_heap<T, Compare>::erase(T* e)
     m_data[pos]->m_heap_index = pos;
     e->m_heap_index = 0;
     m_data.pop_back();
-    percolate_down(pos);
+    if (pos == m_data.size()) {
+        return;
+    }
+    // the element moved into the vacated position may belong above it
+    if (pos != 1 && m_comp(*m_data[pos], *m_data[parent(pos)])) {
+        percolate_up(pos);
+    } else {
+        percolate_down(pos);
+    }
 }
 
 template <class T, class Compare>
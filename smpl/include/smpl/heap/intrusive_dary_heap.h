@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_INTRUSIVE_DARY_HEAP_H
+#define SMPL_INTRUSIVE_DARY_HEAP_H
+
+#include <cstdlib>
+#include <iterator>
+#include <type_traits>
+
+#include <smpl/heap/intrusive_heap.h>
+
+namespace smpl {
+
+/// Provides an intrusive d-ary heap with the interface of intrusive_heap.
+/// Objects inserted into the heap must derive from the \p heap_element class,
+/// and an object may be stored in at most one heap at a time. The
+/// implementation stores pointers to inserted objects, which must remain valid
+/// throughout the lifetime of the heap.
+///
+/// Rather than comparing elements, the heap orders elements by the keys
+/// returned by the \p Key function object, compared with operator<. The key of
+/// each element is cached next to its pointer when the element is inserted or
+/// updated, so that sifting an element through the heap never dereferences
+/// the other elements. Each node has \p D children, which are stored
+/// contiguously and, for 16-byte entries and D >= 4, aligned to a cache line,
+/// so that selecting the minimum child touches a single line for D = 4. The
+/// heap is shallower than a binary heap by a factor of log2(D), so pushes and
+/// decreases are cheaper, while pops compare against more children per level.
+///
+/// If the keys of multiple elements are implicitly changed, the heap may be
+/// reordered in-place in linear time by calling the make() member function,
+/// which recomputes the cached keys.
+template <class T, class Key, int D = 4>
+class intrusive_dary_heap
+{
+public:
+
+    static_assert(std::is_base_of<heap_element, T>::value, "T must extend heap_element");
+    static_assert(D >= 2, "D must be at least 2");
+
+    typedef Key key_function;
+    typedef typename std::decay<
+            typename std::result_of<const Key(const T&)>::type>::type key_type;
+
+    typedef std::size_t size_type;
+
+    class const_iterator;
+
+    intrusive_dary_heap(const key_function& key = key_function());
+
+    template <class InputIt>
+    intrusive_dary_heap(InputIt first, InputIt last);
+
+    template <class InputIt>
+    intrusive_dary_heap(const key_function& key, InputIt first, InputIt last);
+
+    intrusive_dary_heap(const intrusive_dary_heap&) = delete;
+
+    intrusive_dary_heap(intrusive_dary_heap&& o);
+
+    ~intrusive_dary_heap();
+
+    intrusive_dary_heap& operator=(const intrusive_dary_heap&) = delete;
+    intrusive_dary_heap& operator=(intrusive_dary_heap&& rhs);
+
+    T* min() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    bool empty() const;
+    size_type size() const;
+    size_type max_size() const;
+    void reserve(size_type new_cap);
+
+    void clear();
+    void push(T* e);
+    void pop();
+    bool contains(T* e);
+    void update(T* e);
+    void increase(T* e);
+    void decrease(T* e);
+    void erase(T* e);
+
+    void make();
+
+    void swap(intrusive_dary_heap& o);
+
+private:
+
+    struct entry
+    {
+        key_type key;
+        T* elem;
+    };
+
+    // The root is stored at position D - 1, after D - 1 unused entries, so
+    // that the children of every node begin at a multiple of D and a zero
+    // heap index means that an element is not in the heap.
+    static const size_type ROOT = D - 1;
+
+    void* m_buffer;
+    entry* m_data;
+    size_type m_size;
+    size_type m_capacity;
+
+    key_function m_key;
+
+    void grow(size_type new_cap);
+
+    size_type parent(size_type pos) const;
+    size_type first_child(size_type pos) const;
+
+    void sift_up(size_type pos);
+    void sift_down(size_type pos);
+    void sift(size_type pos);
+};
+
+template <class T, class Key, int D>
+class intrusive_dary_heap<T, Key, D>::const_iterator
+{
+public:
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T* value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* const* pointer;
+    typedef T* const& reference;
+
+    const_iterator() : m_it(nullptr) { }
+
+    reference operator*() const { return m_it->elem; }
+
+    const_iterator operator++(int) { const_iterator it(m_it); ++m_it; return it; }
+    const_iterator& operator++() { ++m_it; return *this; }
+
+    bool operator==(const_iterator it) const { return it.m_it == m_it; }
+    bool operator!=(const_iterator it) const { return it.m_it != m_it; }
+
+private:
+
+    const entry* m_it;
+
+    explicit const_iterator(const entry* it) : m_it(it) { }
+
+    friend class intrusive_dary_heap;
+};
+
+template <class T, class Key, int D>
+void swap(intrusive_dary_heap<T, Key, D>& lhs, intrusive_dary_heap<T, Key, D>& rhs);
+
+} // namespace smpl
+
+#include "detail/intrusive_dary_heap.hpp"
+
+#endif
@@ -40,6 +40,12 @@ namespace smpl {
 template <class T, class Compare>
 class intrusive_heap;
 
+template <class T, class Key>
+class bucket_heap;
+
+template <class T, class Key, int D>
+class intrusive_dary_heap;
+
 struct heap_element
 {
 
@@ -51,6 +57,12 @@ private:
 
     template <class T, class Compare>
     friend class intrusive_heap;
+
+    template <class T, class Key>
+    friend class bucket_heap;
+
+    template <class T, class Key, int D>
+    friend class intrusive_dary_heap;
 };
 
 /// Provides an intrusive binary heap implementation. Objects inserted into the
@@ -43,7 +43,7 @@
 
 namespace smpl {
 
-class BfsHeuristic : public RobotHeuristic
+class BfsHeuristic : public RobotHeuristic, public OccupancyGridObserver
 {
 public:
 
@@ -55,6 +55,10 @@ public:
     void setInflationRadius(double radius);
     int costPerCell() const { return m_cost_per_cell; }
     void setCostPerCell(int cost);
+    int threadCount() const { return m_thread_count; }
+    void setThreadCount(int num_threads);
+    bool lazy() const { return m_lazy; }
+    void setLazy(bool lazy);
 
     auto grid() const -> const OccupancyGrid* { return m_grid; }
 
@@ -74,6 +78,7 @@ public:
 
     /// \name Reimplemented Public Functions from RobotPlanningSpaceObserver
     ///@{
+    void updateStart(const RobotState& state) override;
     void updateGoal(const GoalConstraint& goal) override;
     ///@}
 
@@ -84,6 +89,15 @@ public:
     int GetFromToHeuristic(int from_id, int to_id) override;
     ///@}
 
+    /// \name Required Public Functions from OccupancyGridObserver
+    ///@{
+    void updateOccupancy(
+        const OccupancyGrid& grid,
+        const std::vector<Vector3>& added,
+        const std::vector<Vector3>& removed) override;
+    void resetOccupancy(const OccupancyGrid& grid) override;
+    ///@}
+
 private:
 
     const OccupancyGrid* m_grid = nullptr;
@@ -93,6 +107,8 @@ private:
 
     double m_inflation_radius = 0.0;
     int m_cost_per_cell = 1;
+    int m_thread_count = 1;
+    bool m_lazy = false;
 
     struct CellCoord
     {
@@ -103,6 +119,8 @@ private:
     std::vector<CellCoord> m_goal_cells;
 
     void syncGridAndBfs();
+    void runBfs();
+    void updateBfsFocus();
     int getBfsCostToGoal(const BFS_3D& bfs, int x, int y, int z) const;
 };
 
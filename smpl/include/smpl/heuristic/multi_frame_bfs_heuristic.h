@@ -43,7 +43,9 @@
 
 namespace smpl {
 
-class MultiFrameBfsHeuristic : public RobotHeuristic
+class MultiFrameBfsHeuristic :
+    public RobotHeuristic,
+    public OccupancyGridObserver
 {
 public:
 
@@ -57,6 +59,8 @@ public:
     void setInflationRadius(double radius);
     int costPerCell() const { return m_cost_per_cell; }
     void setCostPerCell(int cost);
+    int threadCount() const { return m_thread_count; }
+    void setThreadCount(int num_threads);
 
     auto grid() const -> const OccupancyGrid* { return m_grid; }
 
@@ -86,6 +90,15 @@ public:
     int GetFromToHeuristic(int from_id, int to_id) override;
     ///@}
 
+    /// \name Required Public Functions from OccupancyGridObserver
+    ///@{
+    void updateOccupancy(
+        const OccupancyGrid& grid,
+        const std::vector<Vector3>& added,
+        const std::vector<Vector3>& removed) override;
+    void resetOccupancy(const OccupancyGrid& grid) override;
+    ///@}
+
 private:
 
     const OccupancyGrid* m_grid = nullptr;
@@ -99,8 +112,14 @@ private:
 
     double m_pos_offset[3];
 
+    // goal cells of the last goal update, to rerun the searches after a reset
+    bool m_has_goal = false;
+    int m_goal_cell[3];
+    int m_ee_goal_cell[3];
+
     double m_inflation_radius = 0.0;
     int m_cost_per_cell = 1;
+    int m_thread_count = 1;
 
     int getGoalHeuristic(int state_id, bool use_ee) const;
 
@@ -49,6 +49,28 @@
 
 namespace smpl {
 
+class OccupancyGrid;
+
+/// Interface for objects that maintain state derived from the obstacles in an
+/// OccupancyGrid and want to update it incrementally as obstacles change.
+class OccupancyGridObserver
+{
+public:
+
+    virtual ~OccupancyGridObserver();
+
+    /// Called after obstacle points have been added to or removed from the
+    /// grid. For reference-counted grids, only the points that changed the
+    /// occupancy of their cell are reported.
+    virtual void updateOccupancy(
+        const OccupancyGrid& grid,
+        const std::vector<Vector3>& added,
+        const std::vector<Vector3>& removed) = 0;
+
+    /// Called after the contents of the grid have been replaced wholesale.
+    virtual void resetOccupancy(const OccupancyGrid& grid) = 0;
+};
+
 class OccupancyGrid
 {
 public:
@@ -84,6 +106,23 @@ public:
         const std::vector<Vector3>& new_points);
 
     void reset();
+
+    /// Return a counter that is incremented whenever the obstacles in the grid
+    /// are modified through this interface.
+    int version() const { return m_version; }
+    ///@}
+
+    /// \name Snapshots
+    ///@{
+    bool saveSnapshot(SnapshotWriter& writer) const;
+    bool loadSnapshot(const SnapshotReader& reader);
+    ///@}
+
+    /// \name Observers
+    ///@{
+    bool insertObserver(OccupancyGridObserver* o) const;
+    bool eraseObserver(const OccupancyGridObserver* o) const;
+    bool hasObserver(const OccupancyGridObserver* o) const;
     ///@}
 
     /// \name Properties
@@ -129,6 +168,10 @@ public:
 
     double getDistanceFromPoint(double x, double y, double z) const;
     double getSquaredDist(double x, double y, double z) const;
+    void getSquaredDists(
+        const double* x, const double* y, const double* z,
+        int count,
+        double* d2) const;
 
     double getDistanceToBorder(int x, int y, int z) const;
 
@@ -164,9 +207,23 @@ private:
     bool m_ref_counted;
     int m_x_stride;
     int m_y_stride;
-    std::vector<int> m_counts;
+
+    // per-cell reference counts, shared between copies of the grid until one
+    // of them is modified
+    std::shared_ptr<std::vector<int>> m_counts;
+
+    int m_version = 0;
+
+    // registering an observer does not modify the grid contents
+    mutable std::vector<OccupancyGridObserver*> m_observers;
 
     void initRefCounts();
+    auto mutableCounts() -> std::vector<int>&;
+
+    void notifyOccupancyUpdate(
+        const std::vector<Vector3>& added,
+        const std::vector<Vector3>& removed);
+    void notifyOccupancyReset();
 
     int coordToIndex(int x, int y, int z) const;
 
@@ -230,6 +287,17 @@ double OccupancyGrid::getSquaredDist(double x, double y, double z) const
     return m_grid->getMetricSquaredDistance(x, y, z);
 }
 
+/// Get the squared distances, in meters, for a batch of points given in
+/// structure-of-arrays layout.
+inline
+void OccupancyGrid::getSquaredDists(
+    const double* x, const double* y, const double* z,
+    int count,
+    double* d2) const
+{
+    m_grid->getMetricSquaredDistances(x, y, z, count, d2);
+}
+
 /// Get the distance to the, in meters, to the border.
 inline
 double OccupancyGrid::getDistanceToBorder(int x, int y, int z) const
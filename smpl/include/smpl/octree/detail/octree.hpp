@@ -220,11 +220,18 @@ OcTree<T, Allocator>::num_leaves() const
 
 /// Return the approximate number of bytes used by the octree. Note the size is
 /// obtained from sizeof which will not account for dynamic memory allocated by
-/// an element
+/// an element. If the allocator reports the storage it has reserved, as
+/// PoolAllocator does, that is returned instead, which includes internal nodes
+/// and blocks that are reserved but not in use.
 template <class T, class Allocator>
 typename OcTree<T, Allocator>::size_type
 OcTree<T, Allocator>::mem_usage() const
 {
+    using detail::reserved_bytes;
+    const size_type reserved = reserved_bytes(get_node_allocator());
+    if (reserved != 0) {
+        return sizeof(node_type) + reserved;
+    }
     return mem_usage(root());
 }
 
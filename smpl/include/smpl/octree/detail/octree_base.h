@@ -34,12 +34,31 @@
 
 // standard includes
 #include <assert.h>
+#include <cstddef>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace smpl {
 namespace detail {
 
+/// \name Allocator Hooks
+/// Allocators that manage their own storage, such as PoolAllocator, provide
+/// overloads of these functions that are found by argument-dependent lookup.
+///@{
+
+/// Release all storage handed out by an allocator at once. Return false if the
+/// allocator does not support this, in which case each allocation must be
+/// deallocated individually.
+template <class Allocator>
+bool release_all(Allocator&) { return false; }
+
+/// Return the number of bytes reserved by an allocator, or 0 if unknown.
+template <class Allocator>
+std::size_t reserved_bytes(const Allocator&) { return 0; }
+
+///@}
+
 template <typename T>
 struct OcTreeNode
 {
@@ -111,7 +130,7 @@ public:
     allocator_type get_allocator() const noexcept
     { return allocator_type(get_node_allocator()); }
 
-    void clear() { clear_node(&m_impl.m_node); m_impl.m_node.children = nullptr; }
+    void clear();
 
 protected:
 
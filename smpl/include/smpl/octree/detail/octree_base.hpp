@@ -37,6 +37,20 @@
 namespace smpl {
 namespace detail {
 
+/// Destroy and deallocate all nodes below the root. When nodes do not need to
+/// be destroyed, and the allocator supports it, the storage for all nodes is
+/// released in bulk rather than traversing the tree.
+template <class T, class Allocator>
+void OcTreeBase<T, Allocator>::clear()
+{
+    if (!std::is_trivially_destructible<node_type>::value ||
+        !release_all(get_node_allocator()))
+    {
+        clear_node(&m_impl.m_node);
+    }
+    m_impl.m_node.children = nullptr;
+}
+
 template <class T, class Allocator>
 const typename OcTreeBase<T, Allocator>::node_allocator_type&
 OcTreeBase<T, Allocator>::get_node_allocator() const noexcept
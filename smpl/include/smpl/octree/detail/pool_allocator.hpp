@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_POOL_ALLOCATOR_HPP
+#define SMPL_POOL_ALLOCATOR_HPP
+
+#include "../pool_allocator.h"
+
+// standard includes
+#include <assert.h>
+#include <algorithm>
+#include <new>
+
+namespace smpl {
+namespace detail {
+
+inline
+BlockPool::BlockPool(std::size_t blocks_per_slab) :
+    m_blocks_per_slab(std::max<std::size_t>(blocks_per_slab, 1)),
+    m_size(0),
+    m_block_size(0),
+    m_alignment(0),
+    m_slabs(),
+    m_free(nullptr),
+    m_next(nullptr),
+    m_end(nullptr),
+    m_blocks_used(0),
+    m_blocks_free(0)
+{
+}
+
+inline
+BlockPool::~BlockPool()
+{
+    release();
+}
+
+inline
+void* BlockPool::allocate(std::size_t size, std::size_t alignment)
+{
+    if (m_size == 0) {
+        // round the block size up so that consecutive blocks in a slab are
+        // aligned and large enough to hold a free list link
+        m_size = size;
+        m_alignment = std::max(alignment, alignof(FreeBlock));
+        m_block_size = std::max(size, sizeof(FreeBlock));
+        m_block_size = (m_block_size + m_alignment - 1) / m_alignment * m_alignment;
+    }
+
+    if (size != m_size) {
+        return ::operator new(size);
+    }
+
+    assert(alignment <= m_alignment);
+
+    ++m_blocks_used;
+    if (m_free) {
+        FreeBlock* b = m_free;
+        m_free = b->next;
+        --m_blocks_free;
+        return b;
+    }
+
+    if (m_next == m_end) {
+        allocateSlab();
+    }
+    void* p = m_next;
+    m_next += m_block_size;
+    --m_blocks_free;
+    return p;
+}
+
+inline
+void BlockPool::deallocate(void* p, std::size_t size)
+{
+    if (size != m_size) {
+        ::operator delete(p);
+        return;
+    }
+
+    FreeBlock* b = static_cast<FreeBlock*>(p);
+    b->next = m_free;
+    m_free = b;
+    --m_blocks_used;
+    ++m_blocks_free;
+}
+
+/// Return all slabs to the system, invalidating every block handed out by the
+/// pool.
+inline
+void BlockPool::release()
+{
+    for (void* slab : m_slabs) {
+        ::operator delete(slab);
+    }
+    m_slabs.clear();
+    m_free = nullptr;
+    m_next = nullptr;
+    m_end = nullptr;
+    m_blocks_used = 0;
+    m_blocks_free = 0;
+}
+
+inline
+auto BlockPool::stats() const -> PoolAllocatorStats
+{
+    PoolAllocatorStats stats;
+    stats.block_size = m_block_size;
+    stats.slab_count = m_slabs.size();
+    stats.blocks_used = m_blocks_used;
+    stats.blocks_free = m_blocks_free;
+    stats.bytes_reserved =
+            m_slabs.size() * (m_blocks_per_slab * m_block_size + m_alignment);
+    return stats;
+}
+
+inline
+void BlockPool::allocateSlab()
+{
+    // over-allocate by the alignment, as operator new only guarantees
+    // alignment for fundamental types
+    const std::size_t bytes = m_blocks_per_slab * m_block_size + m_alignment;
+    void* slab = ::operator new(bytes);
+    m_slabs.push_back(slab);
+
+    std::size_t space = bytes;
+    void* first = slab;
+    std::align(m_alignment, m_blocks_per_slab * m_block_size, first, space);
+    m_next = static_cast<char*>(first);
+    m_end = m_next + m_blocks_per_slab * m_block_size;
+    m_blocks_free += m_blocks_per_slab;
+}
+
+} // namespace detail
+
+template <class T>
+PoolAllocator<T>::PoolAllocator() :
+    PoolAllocator(DEFAULT_BLOCKS_PER_SLAB)
+{
+}
+
+/// Construct an allocator with a new pool that allocates storage from the
+/// system in slabs of blocks_per_slab blocks.
+template <class T>
+PoolAllocator<T>::PoolAllocator(std::size_t blocks_per_slab) :
+    m_pool(std::make_shared<detail::BlockPool>(blocks_per_slab))
+{
+}
+
+template <class T>
+T* PoolAllocator<T>::allocate(std::size_t n)
+{
+    return static_cast<T*>(m_pool->allocate(n * sizeof(T), alignof(T)));
+}
+
+template <class T>
+void PoolAllocator<T>::deallocate(T* p, std::size_t n)
+{
+    m_pool->deallocate(p, n * sizeof(T));
+}
+
+/// Return an allocator with a new, empty pool, so that copies of a container
+/// do not share storage with the original.
+template <class T>
+auto PoolAllocator<T>::select_on_container_copy_construction() const
+    -> PoolAllocator
+{
+    return PoolAllocator(m_pool->blocksPerSlab());
+}
+
+template <class T>
+auto PoolAllocator<T>::stats() const -> PoolAllocatorStats
+{
+    return m_pool->stats();
+}
+
+} // namespace smpl
+
+#endif
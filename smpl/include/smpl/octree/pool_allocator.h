@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_POOL_ALLOCATOR_H
+#define SMPL_POOL_ALLOCATOR_H
+
+// standard includes
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace smpl {
+
+struct PoolAllocatorStats
+{
+    std::size_t block_size;     // bytes per pooled block
+    std::size_t slab_count;     // number of slabs allocated from the system
+    std::size_t blocks_used;    // blocks currently handed out
+    std::size_t blocks_free;    // blocks reserved but not in use
+    std::size_t bytes_reserved; // total bytes allocated from the system
+};
+
+namespace detail {
+
+/// Storage for fixed-size blocks carved out of larger slabs. Freed blocks are
+/// kept on a free list for reuse and slabs are only returned to the system
+/// when the pool is released or destroyed. The block size and alignment are
+/// fixed by the first allocation; allocations of any other size are passed
+/// through to the global operator new. Not thread-safe.
+class BlockPool
+{
+public:
+
+    explicit BlockPool(std::size_t blocks_per_slab);
+    ~BlockPool();
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    std::size_t blocksPerSlab() const { return m_blocks_per_slab; }
+
+    void* allocate(std::size_t size, std::size_t alignment);
+    void deallocate(void* p, std::size_t size);
+
+    void release();
+
+    auto stats() const -> PoolAllocatorStats;
+
+private:
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::size_t m_blocks_per_slab;
+    std::size_t m_size;         // requested size of pooled allocations
+    std::size_t m_block_size;   // m_size, rounded up to the alignment
+    std::size_t m_alignment;
+
+    std::vector<void*> m_slabs;
+
+    FreeBlock* m_free;
+
+    // unused remainder of the most recent slab
+    char* m_next;
+    char* m_end;
+
+    std::size_t m_blocks_used;
+    std::size_t m_blocks_free;
+
+    void allocateSlab();
+};
+
+} // namespace detail
+
+/// An allocator that recycles fixed-size blocks from a pool of slabs, suitable
+/// as the Allocator argument to OcTree, SparseGrid, and SparseBinaryGrid.
+///
+/// OcTree allocates the children of a node in blocks of 8, which makes node
+/// expansion and collapse a stream of identically-sized allocations. The pool
+/// serves these from a free list without calls into the system allocator, and
+/// a cleared OcTree of a trivially-destructible type hands all of its blocks
+/// back to the pool at once instead of visiting each node. Node statistics for
+/// such trees are reported by OcTree::mem_usage() and SparseGrid::mem_usage()
+/// from the pool.
+///
+/// Copies of a PoolAllocator, including rebound copies, share a pool. Copies
+/// of a container are given a new pool, so the pool of a tree is normally only
+/// shared with allocators handed to it by the caller.
+template <class T>
+class PoolAllocator
+{
+public:
+
+    using value_type = T;
+
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    static const std::size_t DEFAULT_BLOCKS_PER_SLAB = 256;
+
+    PoolAllocator();
+    explicit PoolAllocator(std::size_t blocks_per_slab);
+
+    PoolAllocator(const PoolAllocator& o) = default;
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>& o) : m_pool(o.m_pool) { }
+
+    auto operator=(const PoolAllocator& rhs) -> PoolAllocator& = default;
+
+    T* allocate(std::size_t n);
+    void deallocate(T* p, std::size_t n);
+
+    auto select_on_container_copy_construction() const -> PoolAllocator;
+
+    auto stats() const -> PoolAllocatorStats;
+
+    friend bool operator==(const PoolAllocator& a, const PoolAllocator& b)
+    { return a.m_pool == b.m_pool; }
+
+    friend bool operator!=(const PoolAllocator& a, const PoolAllocator& b)
+    { return a.m_pool != b.m_pool; }
+
+    /// Return every block to the pool, and the pool's slabs to the system, if
+    /// this is the only allocator using the pool. Blocks handed out by the
+    /// pool must not be used afterwards.
+    friend bool release_all(PoolAllocator& a)
+    {
+        if (a.m_pool.use_count() != 1) {
+            return false;
+        }
+        a.m_pool->release();
+        return true;
+    }
+
+    /// Return the number of bytes reserved from the system by the pool.
+    friend std::size_t reserved_bytes(const PoolAllocator& a)
+    { return a.m_pool->stats().bytes_reserved; }
+
+private:
+
+    template <class U> friend class PoolAllocator;
+
+    std::shared_ptr<detail::BlockPool> m_pool;
+};
+
+} // namespace smpl
+
+#include "detail/pool_allocator.hpp"
+
+#endif
@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_PLANNING_STATS_H
+#define SMPL_PLANNING_STATS_H
+
+// standard includes
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+// project includes
+#include <smpl/time.h>
+
+namespace smpl {
+
+/// Phases of a planning request whose latencies are recorded.
+enum class PlanningPhase
+{
+    SetGoal = 0,
+    SetStart,
+    HeuristicUpdate,
+    Search,
+    Expansion,
+    SuccessorGeneration,
+    CollisionCheck,
+    InverseKinematics,
+    PostProcessing,
+    Shortcut,
+    Count
+};
+
+auto to_string(PlanningPhase phase) -> std::string;
+
+/// Call count, total, extremes, and a log-scale histogram of the latencies of
+/// one planning phase. Samples may be added concurrently from multiple threads.
+class PhaseStats
+{
+public:
+
+    /// Bucket i of the histogram counts samples in [2^i, 2^(i+1)) nanoseconds.
+    static const int BucketCount = 48;
+
+    PhaseStats();
+
+    void add(clock::duration d);
+    void reset();
+
+    auto count() const -> std::int64_t;
+    double totalTime() const;
+    double meanTime() const;
+    double minTime() const;
+    double maxTime() const;
+
+    /// Return an estimate, in seconds, of the latency at percentile \p p in
+    /// [0, 1], interpolated within the histogram bucket containing it.
+    double percentile(double p) const;
+
+private:
+
+    std::atomic<std::int64_t> m_count;
+    std::atomic<std::int64_t> m_total_ns;
+    std::atomic<std::int64_t> m_min_ns;
+    std::atomic<std::int64_t> m_max_ns;
+    std::atomic<std::int64_t> m_buckets[BucketCount];
+};
+
+/// Latency statistics for every phase of a planning request.
+class PlanningStats
+{
+public:
+
+    void reset();
+
+    auto phase(PlanningPhase p) -> PhaseStats& { return m_phases[(int)p]; }
+    auto phase(PlanningPhase p) const -> const PhaseStats& { return m_phases[(int)p]; }
+
+    /// Add "<phase> count", "<phase> total time", "<phase> mean time",
+    /// "<phase> p50 time", "<phase> p99 time", and "<phase> max time" entries,
+    /// in seconds, for every phase that recorded a sample.
+    void getStats(std::map<std::string, double>& stats) const;
+
+private:
+
+    PhaseStats m_phases[(int)PlanningPhase::Count];
+};
+
+/// Set the statistics that PhaseTimers on the calling thread record into, or
+/// nullptr to disable recording. Typically set for the duration of a planning
+/// request. ThreadPool workers record into the statistics that were active on
+/// the thread that submitted the work.
+void SetActivePlanningStats(PlanningStats* stats);
+auto GetActivePlanningStats() -> PlanningStats*;
+
+/// Records the time from its construction to its destruction into a phase of
+/// the planning statistics active on the calling thread. When no statistics
+/// are active, this costs one thread-local load.
+class PhaseTimer
+{
+public:
+
+    explicit PhaseTimer(PlanningPhase phase) :
+        m_stats(GetActivePlanningStats()),
+        m_phase(phase)
+    {
+        if (m_stats) {
+            m_start = clock::now();
+        }
+    }
+
+    ~PhaseTimer()
+    {
+        if (m_stats) {
+            m_stats->phase(m_phase).add(clock::now() - m_start);
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+
+    PlanningStats* m_stats;
+    PlanningPhase m_phase;
+    clock::time_point m_start;
+};
+
+/// Makes a set of planning statistics active on the calling thread for the
+/// lifetime of the object, restoring the previously active statistics
+/// afterwards.
+class ScopedActivePlanningStats
+{
+public:
+
+    explicit ScopedActivePlanningStats(PlanningStats* stats) :
+        m_prev(GetActivePlanningStats())
+    {
+        SetActivePlanningStats(stats);
+    }
+
+    ~ScopedActivePlanningStats() { SetActivePlanningStats(m_prev); }
+
+    ScopedActivePlanningStats(const ScopedActivePlanningStats&) = delete;
+    ScopedActivePlanningStats& operator=(const ScopedActivePlanningStats&) = delete;
+
+private:
+
+    PlanningStats* m_prev;
+};
+
+} // namespace smpl
+
+#endif
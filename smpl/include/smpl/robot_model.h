@@ -100,6 +100,21 @@ public:
     ///
     /// \return true if forward kinematics were computed; false otherwise
     virtual Affine3 computeFK(const RobotState& state) = 0;
+
+    /// \brief Compute forward kinematics of the planning link for a batch of
+    ///     states.
+    ///
+    /// The states are given in structure-of-arrays form: the position of
+    /// planning variable v in state i is positions[v * stride + i], for
+    /// \p count states and \p stride >= \p count. The pose of the planning
+    /// link in state i is written to poses[i].
+    ///
+    /// The default implementation calls computeFK() once per state.
+    virtual void computeFKBatch(
+        const double* positions,
+        int count,
+        int stride,
+        Affine3* poses);
 };
 
 namespace ik_option {
@@ -155,6 +170,25 @@ public:
         const Affine3& pose,
         const RobotState& start,
         RobotState& solution) = 0;
+
+    /// \brief Compute every inverse kinematics solution for a batch of seed
+    ///     states, restricting the redundant joint variables to each seed.
+    ///
+    /// The solutions for seeds[i] are appended to \p solutions, nearest to
+    /// the seed first, and i is appended to \p seed_indices for each of them.
+    /// Seeds that differ only in their redundant variables sample the
+    /// solution manifold of a redundant manipulator.
+    ///
+    /// The default implementation calls computeFastIK() once per seed, and
+    /// so finds at most one solution for each.
+    ///
+    /// \return true if any solution was found; false otherwise
+    virtual bool computeFastIKBatch(
+        const Affine3& pose,
+        const RobotState* seeds,
+        int count,
+        std::vector<RobotState>& solutions,
+        std::vector<int>* seed_indices = nullptr);
 };
 
 /// \brief Convenience class allowing a component to implement all root
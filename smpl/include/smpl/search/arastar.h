@@ -35,6 +35,7 @@
 // standard includes
 #include <assert.h>
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 
 // system includes
@@ -42,7 +43,9 @@
 #include <sbpl/planners/planner.h>
 
 // project includes
+#include <smpl/heap/intrusive_dary_heap.h>
 #include <smpl/heap/intrusive_heap.h>
+#include <smpl/search/search_state_pool.h>
 #include <smpl/time.h>
 
 namespace smpl {
@@ -176,7 +179,7 @@ private:
         unsigned int f;     // (g + eps * h) at time of insertion into OPEN
         unsigned int eg;    // g-value at time of expansion
         unsigned short iteration_closed;
-        unsigned short call_number;
+        std::uint32_t generation;   // for lazy reinitialization, see m_states
         SearchState* bp;
         bool incons;
     };
@@ -188,6 +191,15 @@ private:
         }
     };
 
+    struct SearchStateKey
+    {
+        std::int64_t operator()(const SearchState& s) const {
+            return s.f;
+        }
+    };
+
+    using OpenList = intrusive_dary_heap<SearchState, SearchStateKey, 4>;
+
     DiscreteSpaceInformation* m_space;
     Heuristic* m_heur;
 
@@ -199,14 +211,14 @@ private:
 
     bool m_allow_partial_solutions;
 
-    std::vector<SearchState*> m_states;
+    SearchStatePool<SearchState> m_states;
 
     int m_start_state_id;   // graph state id for the start state
     int m_goal_state_id;    // graph state id for the goal state
 
     // search state (not including the values of g, f, back pointers, and
     // closed list from m_stats)
-    intrusive_heap<SearchState, SearchStateCompare> m_open;
+    OpenList m_open;
     std::vector<SearchState*> m_incons;
     double m_curr_eps;
     int m_iteration;
@@ -214,7 +226,6 @@ private:
     std::vector<int> m_succs;
     std::vector<int> m_costs;
 
-    int m_call_number;          // for lazy reinitialization of search states
     int m_last_start_state_id;  // for lazy reinitialization of the search tree
     int m_last_goal_state_id;   // for updating the search tree when the goal changes
     double m_last_eps;          // for updating the search tree when heuristics change
@@ -250,7 +261,6 @@ private:
     int computeKey(SearchState* s) const;
 
     SearchState* getSearchState(int state_id);
-    SearchState* createState(int state_id);
     void reinitSearchState(SearchState* state);
 
     void extractPath(
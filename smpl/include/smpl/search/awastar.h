@@ -32,12 +32,16 @@
 #ifndef SMPL_AWASTAR_H
 #define SMPL_AWASTAR_H
 
+// standard includes
+#include <cstdint>
+
 // system includes
 #include <sbpl/heuristics/heuristic.h>
 #include <sbpl/planners/planner.h>
 
 // project includes
 #include <smpl/heap/intrusive_heap.h>
+#include <smpl/search/search_state_pool.h>
 #include <smpl/time.h>
 
 namespace smpl {
@@ -121,7 +125,7 @@ struct AWAStar : public SBPLPlanner
         int h;     // estimated cost-to-go
         int f;     // (g + eps * h) at time of insertion into OPEN
         int level;
-        short call_number;
+        std::uint32_t generation;
         std::uint8_t flags;
     };
 
@@ -137,7 +141,7 @@ struct AWAStar : public SBPLPlanner
     DiscreteSpaceInformation*   m_space = nullptr;
     Heuristic*                  m_heur = nullptr;
 
-    std::vector<SearchState*>   m_states;
+    SearchStatePool<SearchState> m_states;
     OpenList                    m_open;
     std::vector<SearchState*>   m_suspended;
 
@@ -146,7 +150,6 @@ struct AWAStar : public SBPLPlanner
     int                         m_start_state_id = -1;
     int                         m_goal_state_id = -1;
 
-    int                         m_call_number = 0;
     int                         m_last_start_id = -1;
     int                         m_last_goal_id = -1;
 
@@ -162,7 +165,6 @@ struct AWAStar : public SBPLPlanner
     int computeKey(SearchState* s) const;
 
     SearchState* getSearchState(int state_id);
-    SearchState* createState(int state_id);
     void reinitSearchState(SearchState* state);
 
     void extractPath(
@@ -43,6 +43,7 @@
 // project includes
 #include <smpl/time.h>
 #include <smpl/console/console.h>
+#include <smpl/planning_stats.h>
 
 namespace smpl {
 
@@ -557,6 +558,8 @@ int MHAStarBase<Derived>::compute_key(MHASearchState* state, int hidx)
 template <typename Derived>
 void MHAStarBase<Derived>::expand(MHASearchState* state, int hidx)
 {
+    PhaseTimer timer(PlanningPhase::Expansion);
+
     SMPL_INFO("Expanding state %d in search %d", state->state_id, hidx);
 
     assert(!closed_in_add_search(state) || !closed_in_anc_search(state));
@@ -44,6 +44,7 @@
 #include <smpl/heap/intrusive_heap.h>
 #include <smpl/heuristic/robot_heuristic.h>
 #include <smpl/heuristic/egraph_heuristic.h>
+#include <smpl/search/search_state_pool.h>
 
 namespace smpl {
 
@@ -92,7 +93,7 @@ private:
         int32_t h;
         int64_t f;
         uint16_t iteration_closed;
-        uint16_t call_number;
+        uint32_t generation;
         SearchState* bp;
     };
 
@@ -109,21 +110,17 @@ private:
     RobotHeuristic* m_heur;
     ExperienceGraphHeuristicExtension* m_egh;
 
-    std::vector<SearchState*> m_states;
+    SearchStatePool<SearchState> m_states;
     SearchState* m_start_state;
     SearchState* m_goal_state;
 
-    std::vector<int> m_graph_to_search_map;
-
     intrusive_heap<SearchState, SearchStateCompare> m_open;
 
-    int m_call_number;
     double m_eps;
 
     int m_expand_count;
 
     SearchState* getSearchState(int state_id);
-    SearchState* createState(int state_id);
     void reinitSearchState(SearchState* state);
 
     void extractPath(std::vector<int>& solution, int& cost) const;
@@ -53,6 +53,8 @@ int Replan(
     std::vector<int>& solution,
     int& cost);
 
+void SetEvalBatchSize(LazyARAStar& search, int batch_size);
+
 struct LazyARAStar
 {
     struct State;
@@ -101,10 +103,22 @@ struct LazyARAStar
     int32_t                 call_number_    = 0;
     double                  eps_            = 1.0;
 
+    // number of states expanded by the latest call to Replan
+    int                     expand_count_   = 0;
+
+    // maximum number of lazy edges at the top of OPEN evaluated together
+    // through ILazySuccFun::GetSuccTrueCosts
+    int                     eval_batch_size_ = 1;
+
     std::vector<int> succs_;
     std::vector<int> costs_;
     std::vector<bool> true_costs_;
 
+    std::vector<State*> eval_states_;
+    std::vector<int> eval_preds_;
+    std::vector<int> eval_succs_;
+    std::vector<int> eval_costs_;
+
     LazyARAStar() : open_(StateCompare{this}) { }
 };
 
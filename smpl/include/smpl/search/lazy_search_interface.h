@@ -61,6 +61,19 @@ struct ILazySuccFun {
         std::vector<bool>& true_costs) = 0;
 
     virtual int GetSuccTrueCost(int state_id, int succ_id) = 0;
+
+    /// Evaluate the true costs of a batch of edges. Implementations may
+    /// override this to evaluate the edges concurrently.
+    virtual void GetSuccTrueCosts(
+        const int* state_ids,
+        const int* succ_ids,
+        int count,
+        int* costs)
+    {
+        for (int i = 0; i < count; ++i) {
+            costs[i] = GetSuccTrueCost(state_ids[i], succ_ids[i]);
+        }
+    }
 };
 
 struct ILazyPredFun {
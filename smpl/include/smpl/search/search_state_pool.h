@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_SEARCH_STATE_POOL_H
+#define SMPL_SEARCH_STATE_POOL_H
+
+// standard includes
+#include <assert.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace smpl {
+
+/// Storage for the per-state data of a search, indexed by graph state id.
+///
+/// States are allocated in chunks of CHUNK_SIZE consecutive ids and are kept
+/// until clear() is called, so a planner that is reused for many requests over
+/// the same graph only allocates when it first reaches a new range of state
+/// ids. Pointers to states remain valid until clear() is called.
+///
+/// Instead of resetting every state between searches, the pool maintains a
+/// generation number. A state whose \p generation member differs from the
+/// pool's generation was last touched by an earlier search and should be
+/// reinitialized before use. Beginning a new search is then a single call to
+/// nextGeneration().
+///
+/// The \p State type must be default-constructible and have an \p int member
+/// \p state_id and a \p std::uint32_t member \p generation. Both are assigned
+/// when the state's chunk is allocated.
+template <class State>
+class SearchStatePool
+{
+public:
+
+    static const int CHUNK_BITS = 12;
+    static const int CHUNK_SIZE = 1 << CHUNK_BITS;
+
+    /// Return the state for a graph state id, allocating its chunk if needed.
+    auto get(int state_id) -> State*
+    {
+        assert(state_id >= 0);
+        auto c = (std::size_t)state_id >> CHUNK_BITS;
+        if (c >= m_chunks.size()) {
+            m_chunks.resize(c + 1);
+        }
+        if (!m_chunks[c]) {
+            allocateChunk(c);
+        }
+        return &m_chunks[c][state_id & (CHUNK_SIZE - 1)];
+    }
+
+    /// Return the state for a graph state id, or nullptr if its chunk has not
+    /// been allocated.
+    auto find(int state_id) const -> State*
+    {
+        auto c = (std::size_t)state_id >> CHUNK_BITS;
+        if (state_id < 0 || c >= m_chunks.size() || !m_chunks[c]) {
+            return nullptr;
+        }
+        return &m_chunks[c][state_id & (CHUNK_SIZE - 1)];
+    }
+
+    auto generation() const -> std::uint32_t { return m_generation; }
+
+    /// Return whether a state has been initialized during the current
+    /// generation.
+    bool current(const State* state) const
+    {
+        return state->generation == m_generation;
+    }
+
+    /// Mark all states as stale. If the generation counter wraps around, the
+    /// generation of every allocated state is reset.
+    void nextGeneration()
+    {
+        if (++m_generation == 0) {
+            forEach([](State& s) { s.generation = 0; });
+            m_generation = 1;
+        }
+    }
+
+    /// Call a function with every allocated state, in order of state id.
+    /// States in allocated chunks that have not been reached by any search
+    /// are included and may be identified by a generation of 0.
+    template <class Function>
+    void forEach(Function f)
+    {
+        for (auto& chunk : m_chunks) {
+            if (!chunk) continue;
+            for (int i = 0; i < CHUNK_SIZE; ++i) {
+                f(chunk[i]);
+            }
+        }
+    }
+
+    /// Free all states. The generation is preserved.
+    void clear()
+    {
+        m_chunks.clear();
+        m_chunks.shrink_to_fit();
+    }
+
+private:
+
+    std::vector<std::unique_ptr<State[]>> m_chunks;
+
+    // Freshly allocated states have generation 0, which is never current.
+    std::uint32_t m_generation = 1;
+
+    void allocateChunk(std::size_t c)
+    {
+        m_chunks[c].reset(new State[CHUNK_SIZE]());
+        auto base = (int)(c << CHUNK_BITS);
+        for (int i = 0; i < CHUNK_SIZE; ++i) {
+            m_chunks[c][i].state_id = base + i;
+            m_chunks[c][i].generation = 0;
+        }
+    }
+};
+
+template <class State> const int SearchStatePool<State>::CHUNK_BITS;
+template <class State> const int SearchStatePool<State>::CHUNK_SIZE;
+
+} // namespace smpl
+
+#endif
@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SMPL_SNAPSHOT_H
+#define SMPL_SNAPSHOT_H
+
+// standard includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace smpl {
+
+class DistanceMapInterface;
+class OccupancyGrid;
+
+/// Return the identifier of a snapshot section or distance map type, built from
+/// four characters, e.g. SnapshotTag('D', 'I', 'S', 'T').
+constexpr auto SnapshotTag(char a, char b, char c, char d) -> std::uint32_t
+{
+    return  (std::uint32_t)(unsigned char)a |
+            (std::uint32_t)(unsigned char)b << 8 |
+            (std::uint32_t)(unsigned char)c << 16 |
+            (std::uint32_t)(unsigned char)d << 24;
+}
+
+/// Version of the snapshot file layout, incremented whenever the layout of the
+/// file, or of any section written by the library, changes.
+constexpr std::uint32_t SNAPSHOT_VERSION = 1;
+
+/// Collects the sections of a snapshot and writes them to a binary file.
+///
+/// A snapshot file begins with a header, identifying the file and its version,
+/// followed by a table of sections, each identified by a tag, and the contents
+/// of the sections. The contents of each section are aligned to a 64-byte
+/// boundary in the file, so that arrays can be read in place from a read-only
+/// memory mapping of the file by a SnapshotReader. Values are written in the
+/// byte order of the host, and snapshots are rejected when loaded on a host
+/// with a different byte order.
+class SnapshotWriter
+{
+public:
+
+    /// Append a section referring to existing data. The data is not copied and
+    /// must remain valid until the snapshot is written.
+    void addSection(std::uint32_t tag, const void* data, std::size_t size);
+
+    /// Append a section of the given size, owned by the writer, and return a
+    /// pointer to its contents, to be filled in by the caller.
+    auto allocateSection(std::uint32_t tag, std::size_t size) -> void*;
+
+    bool hasSection(std::uint32_t tag) const;
+
+    bool write(const std::string& path) const;
+
+private:
+
+    struct Section
+    {
+        std::uint32_t tag;
+        const void* data;
+        std::size_t size;
+    };
+
+    std::vector<Section> m_sections;
+    std::vector<std::unique_ptr<char[]>> m_buffers;
+};
+
+/// Provides read-only access to the sections of a snapshot file written by a
+/// SnapshotWriter. The file is memory-mapped, so that the contents of a
+/// section are only paged in from disk as they are accessed.
+class SnapshotReader
+{
+public:
+
+    SnapshotReader();
+    ~SnapshotReader();
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const;
+
+    /// Return a pointer to the contents of the section with the given tag, or
+    /// nullptr if the snapshot has no such section. The size of the section,
+    /// in bytes, is stored in \p size if it is non-null. The contents remain
+    /// valid until the reader is closed.
+    auto section(std::uint32_t tag, std::size_t* size = nullptr) const
+        -> const void*;
+
+private:
+
+    struct Section
+    {
+        std::uint32_t tag;
+        const char* data;
+        std::size_t size;
+    };
+
+    void* m_map;
+    std::size_t m_map_size;
+    std::vector<Section> m_sections;
+};
+
+/// \name Distance Map Snapshots
+///@{
+
+/// Record the type, layout, and maximum distance of a distance map, from which
+/// LoadDistanceMapInfo() decides whether a snapshot can be loaded into a map.
+void SaveDistanceMapInfo(
+    SnapshotWriter& writer,
+    const DistanceMapInterface& dmap,
+    std::uint32_t type,
+    double max_dist);
+
+bool LoadDistanceMapInfo(
+    const SnapshotReader& reader,
+    const DistanceMapInterface& dmap,
+    std::uint32_t type,
+    double max_dist);
+
+bool SaveSnapshot(const DistanceMapInterface& dmap, const std::string& path);
+bool LoadSnapshot(DistanceMapInterface& dmap, const std::string& path);
+
+bool SaveSnapshot(const OccupancyGrid& grid, const std::string& path);
+bool LoadSnapshot(OccupancyGrid& grid, const std::string& path);
+
+///@}
+
+} // namespace smpl
+
+#endif
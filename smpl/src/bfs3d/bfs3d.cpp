@@ -32,10 +32,19 @@
 
 #include <smpl/bfs3d/bfs3d.h>
 
+// standard includes
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
 #include <smpl/console/console.h>
+#include <smpl/thread_pool.h>
 
 namespace smpl {
 
+// number of 64-cell frontier words claimed by a worker at a time
+static const int FRONTIER_CHUNK_SIZE = 64;
+
 BFS_3D::BFS_3D(int width, int height, int length) :
     m_search_thread(),
     m_dim_x(),
@@ -46,9 +55,22 @@ BFS_3D::BFS_3D(int width, int height, int length) :
     m_queue_head(),
     m_queue_tail(),
     m_running(false),
+    m_searched(false),
+    m_mutex(),
+    m_level_cv(),
+    m_stats(nullptr),
+    m_build_start(),
+    m_num_threads(1),
+    m_pool(),
     m_neighbor_offsets(),
     m_closed(),
-    m_distances()
+    m_distances(),
+    m_lazy(false),
+    m_has_focus(false),
+    m_focus_x(),
+    m_focus_y(),
+    m_focus_z(),
+    m_lazy_f(0)
 {
     if (width <= 0 || height <= 0 || length <= 0) {
         return;
@@ -88,7 +110,7 @@ BFS_3D::BFS_3D(int width, int height, int length) :
     m_neighbor_offsets[24] = m_dim_x+1-m_dim_xy;
     m_neighbor_offsets[25] = m_dim_x-1-m_dim_xy;
 
-    m_distance_grid = new int[m_dim_xyz];
+    m_distance_grid = new std::atomic<int>[m_dim_xyz];
     m_queue = new int[width * height * length];
 
     for (int node = 0; node < m_dim_xyz; node++) {
@@ -99,21 +121,17 @@ BFS_3D::BFS_3D(int width, int height, int length) :
             y == 0 || y == m_dim_y - 1 ||
             z == 0 || z == m_dim_z - 1)
         {
-            m_distance_grid[node] = WALL;
+            setCell(node, WALL);
         }
         else {
-            m_distance_grid[node] = UNDISCOVERED;
+            setCell(node, UNDISCOVERED);
         }
     }
-
-    m_running = false;
 }
 
 BFS_3D::~BFS_3D()
 {
-    if (m_search_thread.joinable()) {
-        m_search_thread.join();
-    }
+    waitForSearch();
 
     if (m_distance_grid) {
         delete[] m_distance_grid;
@@ -130,6 +148,76 @@ void BFS_3D::getDimensions(int* width, int* height, int* length)
     *length = m_dim_z - 2;
 }
 
+void BFS_3D::setThreadCount(int num_threads)
+{
+    if (m_running) {
+        return;
+    }
+
+    waitForSearch();
+
+    num_threads = std::max(num_threads, 1);
+    if (num_threads == m_num_threads) {
+        return;
+    }
+
+    m_num_threads = num_threads;
+    if (m_num_threads > 1) {
+        m_pool.reset(new ThreadPool(m_num_threads));
+        if (m_frontier[0].empty()) {
+            const size_t words = (m_dim_xyz + 63) / 64;
+            m_frontier[0] = std::vector<std::atomic<std::uint64_t>>(words);
+            m_frontier[1] = std::vector<std::atomic<std::uint64_t>>(words);
+        }
+    } else {
+        m_pool.reset();
+        m_frontier[0].clear();
+        m_frontier[1].clear();
+    }
+}
+
+void BFS_3D::setLazy(bool lazy)
+{
+    if (m_running) {
+        return;
+    }
+
+    waitForSearch();
+
+    m_lazy = lazy;
+    if (!m_lazy) {
+        clearLazySearch();
+    }
+}
+
+void BFS_3D::setFocus(int x, int y, int z)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // gather the open cells, keyed by the old heuristic, before refocusing
+    std::vector<int> open;
+    for (size_t f = m_lazy_f; f < m_lazy_buckets.size(); ++f) {
+        for (int node : m_lazy_buckets[f]) {
+            if (cell(node) == UNDISCOVERED &&
+                m_lazy_g[node] + lazyHeuristic(node) == (int)f)
+            {
+                open.push_back(node);
+            }
+        }
+        m_lazy_buckets[f].clear();
+    }
+
+    m_has_focus = inBounds(x, y, z);
+    m_focus_x = x + 1;
+    m_focus_y = y + 1;
+    m_focus_z = z + 1;
+
+    m_lazy_f = 0;
+    for (int node : open) {
+        pushLazyCell(node, m_lazy_g[node]);
+    }
+}
+
 void BFS_3D::setWall(int x, int y, int z)
 {
     if (m_running) {
@@ -138,20 +226,195 @@ void BFS_3D::setWall(int x, int y, int z)
     }
 
     int node = getNode(x, y, z);
-    m_distance_grid[node] = WALL;
+    setCell(node, WALL);
+}
+
+void BFS_3D::unsetWall(int x, int y, int z)
+{
+    if (m_running) {
+        //error "Cannot modify grid while search is running"
+        return;
+    }
+
+    int node = getNode(x, y, z);
+    if (cell(node) == WALL) {
+        setCell(node, UNDISCOVERED);
+    }
+}
+
+void BFS_3D::clearWalls()
+{
+    waitForSearch();
+
+    for (int node = 0; node < m_dim_xyz; node++) {
+        int x = node % m_dim_x;
+        int y = node / m_dim_x % m_dim_y;
+        int z = node / m_dim_xy;
+        if (x == 0 || x == m_dim_x - 1 ||
+            y == 0 || y == m_dim_y - 1 ||
+            z == 0 || z == m_dim_z - 1)
+        {
+            continue;
+        }
+        setCell(node, UNDISCOVERED);
+    }
+
+    clearLazySearch();
+    m_searched = false;
+}
+
+void BFS_3D::updateWalls(
+    const std::vector<int>& walls,
+    const std::vector<int>& frees)
+{
+    waitForSearch();
+
+    if (!m_searched) {
+        for (size_t i = 0; i + 2 < walls.size(); i += 3) {
+            setWall(walls[i], walls[i + 1], walls[i + 2]);
+        }
+        for (size_t i = 0; i + 2 < frees.size(); i += 3) {
+            unsetWall(frees[i], frees[i + 1], frees[i + 2]);
+        }
+        return;
+    }
+
+    if (m_lazy) {
+        for (size_t i = 0; i + 2 < walls.size(); i += 3) {
+            int node = getNode(walls[i], walls[i + 1], walls[i + 2]);
+            if (node >= 0 && cell(node) != 0) {
+                setCell(node, WALL);
+            }
+        }
+        for (size_t i = 0; i + 2 < frees.size(); i += 3) {
+            int node = getNode(frees[i], frees[i + 1], frees[i + 2]);
+            if (node >= 0 && cell(node) == WALL) {
+                setCell(node, UNDISCOVERED);
+            }
+        }
+        restartLazySearch();
+        return;
+    }
+
+    auto is_discovered = [&](int node) {
+        int d = cell(node);
+        return d >= 0 && d != WALL;
+    };
+
+    // Raise: turn cells into walls and queue up the cells that were reached
+    // through them. Start cells (distance 0) are left as-is.
+    for (size_t i = 0; i + 2 < walls.size(); i += 3) {
+        int node = getNode(walls[i], walls[i + 1], walls[i + 2]);
+        if (node < 0) {
+            continue;
+        }
+        int d = cell(node);
+        if (d == WALL || d == 0) {
+            continue;
+        }
+        setCell(node, WALL);
+        if (d != UNDISCOVERED) {
+            for (int n = 0; n < 26; ++n) {
+                int nn = neighbor(node, n);
+                if (cell(nn) == d + 1) {
+                    pushRepairCell(nn, d + 1);
+                }
+            }
+        }
+    }
+
+    // Invalidate, in order of increasing distance, every queued cell that no
+    // longer has a neighbor one step closer to a start cell. Processing cells
+    // by distance guarantees that a cell's candidate parents have already been
+    // invalidated, if they are going to be, by the time the cell is examined.
+    m_repair_cells.clear();
+    for (size_t d = 0; d < m_repair_buckets.size(); ++d) {
+        // buckets may be appended to while iterating
+        for (size_t i = 0; i < m_repair_buckets[d].size(); ++i) {
+            int node = m_repair_buckets[d][i];
+            if (cell(node) != (int)d) {
+                continue; // already invalidated
+            }
+
+            bool supported = false;
+            for (int n = 0; n < 26; ++n) {
+                if (cell(neighbor(node, n)) == (int)d - 1) {
+                    supported = true;
+                    break;
+                }
+            }
+            if (supported) {
+                continue;
+            }
+
+            setCell(node, UNDISCOVERED);
+            m_repair_cells.push_back(node);
+            for (int n = 0; n < 26; ++n) {
+                int nn = neighbor(node, n);
+                if (cell(nn) == (int)d + 1) {
+                    pushRepairCell(nn, (int)d + 1);
+                }
+            }
+        }
+        m_repair_buckets[d].clear();
+    }
+
+    for (size_t i = 0; i + 2 < frees.size(); i += 3) {
+        int node = getNode(frees[i], frees[i + 1], frees[i + 2]);
+        if (node < 0 || cell(node) != WALL) {
+            continue;
+        }
+        setCell(node, UNDISCOVERED);
+        m_repair_cells.push_back(node);
+    }
+
+    // Lower: seed each invalidated or freed cell from its best discovered
+    // neighbor and resume the search in order of increasing distance.
+    for (int node : m_repair_cells) {
+        int best = UNDISCOVERED;
+        for (int n = 0; n < 26; ++n) {
+            int nn = neighbor(node, n);
+            if (is_discovered(nn) &&
+                (best == UNDISCOVERED || cell(nn) + 1 < best))
+            {
+                best = cell(nn) + 1;
+            }
+        }
+        if (best != UNDISCOVERED) {
+            setCell(node, best);
+            pushRepairCell(node, best);
+        }
+    }
+
+    for (size_t d = 0; d < m_repair_buckets.size(); ++d) {
+        for (size_t i = 0; i < m_repair_buckets[d].size(); ++i) {
+            int node = m_repair_buckets[d][i];
+            if (cell(node) != (int)d) {
+                continue; // stale entry
+            }
+            for (int n = 0; n < 26; ++n) {
+                int nn = neighbor(node, n);
+                int dn = cell(nn);
+                if (dn == UNDISCOVERED || (dn != WALL && dn > (int)d + 1)) {
+                    setCell(nn, (int)d + 1);
+                    pushRepairCell(nn, (int)d + 1);
+                }
+            }
+        }
+        m_repair_buckets[d].clear();
+    }
 }
 
 bool BFS_3D::isWall(int x, int y, int z) const
 {
     int node = getNode(x, y, z);
-    return m_distance_grid[node] == WALL;
+    return cell(node) == WALL;
 }
 
 bool BFS_3D::isUndiscovered(int x, int y, int z) const
 {
     int node = getNode(x, y, z);
-    while (m_running && m_distance_grid[node] < 0);
-    return m_distance_grid[node] == UNDISCOVERED;
+    return waitForCell(node) == UNDISCOVERED;
 }
 
 void BFS_3D::run(int x, int y, int z)
@@ -160,9 +423,13 @@ void BFS_3D::run(int x, int y, int z)
         return;
     }
 
+    waitForSearch();
+
+    beginSearch();
+
     for (int i = 0; i < m_dim_xyz; i++) {
-        if (m_distance_grid[i] != WALL) {
-            m_distance_grid[i] = UNDISCOVERED;
+        if (cell(i) != WALL) {
+            setCell(i, UNDISCOVERED);
         }
     }
 
@@ -175,22 +442,27 @@ void BFS_3D::run(int x, int y, int z)
     m_queue[0] = origin;
 
     // initialize starting distance
-    m_distance_grid[origin] = 0;
+    setCell(origin, 0);
 
-    m_running = true;
+    startSearch();
+}
 
-    // fire off background thread to compute bfs
-    m_search_thread = std::thread([&]()
-    {
-        this->search(m_dim_x, m_dim_xy, m_distance_grid, m_queue, m_queue_head, m_queue_tail);
-    });
+void BFS_3D::wait()
+{
+    waitForSearch();
 }
 
 void BFS_3D::run_components(int gx, int gy, int gz)
 {
+    waitForSearch();
+
+    // distances through walls can't be repaired by updateWalls()
+    m_searched = false;
+    clearLazySearch();
+
     for (int i = 0; i < m_dim_xyz; i++) {
-        if (m_distance_grid[i] != WALL) {
-            m_distance_grid[i] = UNDISCOVERED;
+        if (cell(i) != WALL) {
+            setCell(i, UNDISCOVERED);
         }
     }
 
@@ -210,8 +482,8 @@ void BFS_3D::run_components(int gx, int gy, int gz)
 
     // initialize the distance grid of the wall bfs
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (wall_bfs.m_distance_grid[i] != WALL) {
-            wall_bfs.m_distance_grid[i] = UNDISCOVERED;
+        if (wall_bfs.cell(i) != WALL) {
+            wall_bfs.setCell(i, UNDISCOVERED);
         }
     }
 
@@ -219,12 +491,12 @@ void BFS_3D::run_components(int gx, int gy, int gz)
     wall_bfs.m_queue_head = 0;
     wall_bfs.m_queue_tail = 1;
 
-    int volatile* curr_distance_grid = m_distance_grid;
+    std::atomic<int>* curr_distance_grid = m_distance_grid;
     int* curr_queue = m_queue;
     int* curr_queue_head = &m_queue_head;
     int* curr_queue_tail = &m_queue_tail;
 
-    int volatile* next_distance_grid = wall_bfs.m_distance_grid;
+    std::atomic<int>* next_distance_grid = wall_bfs.m_distance_grid;
     int* next_queue = wall_bfs.m_queue;
     int* next_queue_head = &wall_bfs.m_queue_head;
     int* next_queue_tail = &wall_bfs.m_queue_tail;
@@ -235,7 +507,7 @@ void BFS_3D::run_components(int gx, int gy, int gz)
     *curr_queue_head = 0;
     *curr_queue_tail = 1;
     curr_queue[0] = gnode;
-    curr_distance_grid[gnode] = 0;
+    curr_distance_grid[gnode].store(0, std::memory_order_relaxed);
 
     *next_queue_head = 0;
     *next_queue_tail = 0;
@@ -268,8 +540,8 @@ void BFS_3D::run_components(int gx, int gy, int gz)
 
     // combine distance fields
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (wall_bfs.m_distance_grid[i] != WALL) {
-            m_distance_grid[i] = wall_bfs.m_distance_grid[i];
+        if (wall_bfs.cell(i) != WALL) {
+            setCell(i, wall_bfs.cell(i));
         }
     }
 }
@@ -359,8 +631,7 @@ void BFS_3D::visit_free_cells(int node, const Visitor& visitor)
 int BFS_3D::getDistance(int x, int y, int z) const
 {
     int node = getNode(x, y, z);
-    while (m_running && m_distance_grid[node] < 0);
-    return m_distance_grid[node];
+    return waitForCell(node);
 }
 
 int BFS_3D::getNearestFreeNodeDist(int x, int y, int z)
@@ -451,11 +722,293 @@ if (inBounds(xn, yn, zn)) {\
     return -1;
 }
 
+void BFS_3D::waitForSearch()
+{
+    if (m_search_thread.joinable()) {
+        m_search_thread.join();
+    }
+}
+
+// Return the value of a cell, blocking until the cell has been discovered or
+// the search has finished.
+int BFS_3D::waitForCell(int node) const
+{
+    int d = cell(node);
+    if (d >= 0) {
+        return d;
+    }
+
+    if (m_lazy) {
+        return resolveCell(node);
+    }
+
+    if (!m_running) {
+        return d;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_level_cv.wait(lock, [&]() { return !m_running || cell(node) >= 0; });
+    return cell(node);
+}
+
+// Remember where and from when to record the time taken by the search about
+// to be started. The background thread has no active planning statistics of
+// its own.
+void BFS_3D::beginSearch()
+{
+    m_stats = GetActivePlanningStats();
+    if (m_stats) {
+        m_build_start = clock::now();
+    }
+}
+
+// Start the search from the start cells in m_queue[m_queue_head, m_queue_tail)
+// on the background thread.
+void BFS_3D::startSearch()
+{
+    if (m_lazy) {
+        // the remainder of a lazy search is paid for by the queries
+        startLazySearch();
+        if (m_stats) {
+            m_stats->phase(PlanningPhase::HeuristicUpdate).add(clock::now() - m_build_start);
+        }
+        return;
+    }
+
+    m_running = true;
+    m_searched = true;
+
+    m_search_thread = std::thread([&]()
+    {
+        if (m_pool) {
+            this->searchParallel();
+        } else {
+            this->search(m_dim_x, m_dim_xy, m_distance_grid, m_queue, m_queue_head, m_queue_tail);
+        }
+        this->finishSearch();
+    });
+}
+
+// Wake up queries waiting on cells discovered in the last level. Locking the
+// mutex orders the notification after any waiter's check of its cell.
+void BFS_3D::publishLevel()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_level_cv.notify_all();
+}
+
+void BFS_3D::finishSearch()
+{
+    if (m_stats) {
+        m_stats->phase(PlanningPhase::HeuristicUpdate).add(clock::now() - m_build_start);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_level_cv.notify_all();
+}
+
+// Level-synchronous search. Each level is split into chunks of frontier words
+// that are expanded in parallel. Every worker that discovers a cell in the
+// same level claims it with the same distance, so claims are plain atomic
+// stores rather than compare-and-swaps, and only setting the cell's bit in the
+// next frontier needs an atomic read-modify-write.
+void BFS_3D::searchParallel()
+{
+    auto* curr = m_frontier[0].data();
+    auto* next = m_frontier[1].data();
+
+    int lo = std::numeric_limits<int>::max();
+    int hi = -1;
+    for (int i = m_queue_head; i < m_queue_tail; ++i) {
+        int node = m_queue[i];
+        int w = node >> 6;
+        curr[w].fetch_or(std::uint64_t(1) << (node & 63), std::memory_order_relaxed);
+        lo = std::min(lo, w);
+        hi = std::max(hi, w);
+    }
+    m_queue_head = m_queue_tail;
+
+    int cost = 1;
+    while (lo <= hi) {
+        std::atomic<int> next_lo(std::numeric_limits<int>::max());
+        std::atomic<int> next_hi(-1);
+
+        const int chunk_count =
+                (hi - lo + FRONTIER_CHUNK_SIZE) / FRONTIER_CHUNK_SIZE;
+        m_pool->parallelFor(chunk_count, [&](int thread, int index)
+        {
+            const int wbegin = lo + index * FRONTIER_CHUNK_SIZE;
+            const int wend = std::min(hi + 1, wbegin + FRONTIER_CHUNK_SIZE);
+            int chunk_lo = std::numeric_limits<int>::max();
+            int chunk_hi = -1;
+            for (int w = wbegin; w < wend; ++w) {
+                std::uint64_t bits = curr[w].load(std::memory_order_relaxed);
+                if (!bits) {
+                    continue;
+                }
+                curr[w].store(0, std::memory_order_relaxed);
+
+                while (bits) {
+                    const int node = (w << 6) + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    for (int n = 0; n < 26; ++n) {
+                        const int nn = node + m_neighbor_offsets[n];
+                        if (cell(nn) == UNDISCOVERED) {
+                            setCell(nn, cost);
+                            const int nw = nn >> 6;
+                            next[nw].fetch_or(
+                                    std::uint64_t(1) << (nn & 63),
+                                    std::memory_order_relaxed);
+                            chunk_lo = std::min(chunk_lo, nw);
+                            chunk_hi = std::max(chunk_hi, nw);
+                        }
+                    }
+                }
+            }
+
+            int v = next_lo.load(std::memory_order_relaxed);
+            while (chunk_lo < v && !next_lo.compare_exchange_weak(v, chunk_lo));
+            v = next_hi.load(std::memory_order_relaxed);
+            while (chunk_hi > v && !next_hi.compare_exchange_weak(v, chunk_hi));
+        });
+
+        publishLevel();
+
+        std::swap(curr, next);
+        lo = next_lo;
+        hi = next_hi;
+        ++cost;
+    }
+}
+
+// Seed the lazy search with the start cells in m_queue[m_queue_head,
+// m_queue_tail), which have already been assigned distance 0, and open their
+// neighbors. No other cells are expanded until they are queried.
+void BFS_3D::startLazySearch()
+{
+    m_searched = true;
+
+    m_lazy_starts.assign(m_queue + m_queue_head, m_queue + m_queue_tail);
+    m_queue_head = m_queue_tail;
+
+    clearLazySearch();
+    m_lazy_g.assign(m_dim_xyz, -1);
+    for (int node : m_lazy_starts) {
+        m_lazy_g[node] = 0;
+    }
+    for (int node : m_lazy_starts) {
+        expandLazyCell(node);
+    }
+}
+
+// Discard the distances computed by the lazy search and reseed it from the
+// start cells of the last run().
+void BFS_3D::restartLazySearch()
+{
+    for (int i = 0; i < m_dim_xyz; ++i) {
+        if (cell(i) != WALL) {
+            setCell(i, UNDISCOVERED);
+        }
+    }
+
+    m_queue_head = 0;
+    m_queue_tail = 0;
+    for (int node : m_lazy_starts) {
+        m_queue[m_queue_tail++] = node;
+        setCell(node, 0);
+    }
+
+    startLazySearch();
+}
+
+void BFS_3D::clearLazySearch()
+{
+    for (auto& bucket : m_lazy_buckets) {
+        bucket.clear();
+    }
+    m_lazy_f = 0;
+}
+
+// Chebyshev distance to the focus cell, a lower bound on the number of
+// 26-connected steps to it
+int BFS_3D::lazyHeuristic(int node) const
+{
+    if (!m_has_focus) {
+        return 0;
+    }
+    int x = node % m_dim_x;
+    int y = node / m_dim_x % m_dim_y;
+    int z = node / m_dim_xy;
+    return std::max(std::abs(x - m_focus_x),
+            std::max(std::abs(y - m_focus_y), std::abs(z - m_focus_z)));
+}
+
+void BFS_3D::pushLazyCell(int node, int g) const
+{
+    const size_t f = g + lazyHeuristic(node);
+    if (m_lazy_buckets.size() <= f) {
+        m_lazy_buckets.resize(f + 1);
+    }
+    m_lazy_buckets[f].push_back(node);
+    m_lazy_f = std::min(m_lazy_f, f);
+}
+
+void BFS_3D::expandLazyCell(int node) const
+{
+    const int g = m_lazy_g[node] + 1;
+    for (int n = 0; n < 26; ++n) {
+        int nn = neighbor(node, n);
+        if (cell(nn) == UNDISCOVERED && (m_lazy_g[nn] < 0 || g < m_lazy_g[nn])) {
+            m_lazy_g[nn] = g;
+            pushLazyCell(nn, g);
+        }
+    }
+}
+
+// Resume the lazy search until a cell has been expanded or no open cells
+// remain. Every expanded cell is assigned its exact distance, which may be
+// read afterwards without locking.
+int BFS_3D::resolveCell(int node) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (cell(node) == UNDISCOVERED && m_lazy_f < m_lazy_buckets.size()) {
+        auto& bucket = m_lazy_buckets[m_lazy_f];
+        if (bucket.empty()) {
+            ++m_lazy_f;
+            continue;
+        }
+
+        int n = bucket.back();
+        bucket.pop_back();
+        if (cell(n) != UNDISCOVERED ||
+            m_lazy_g[n] + lazyHeuristic(n) != (int)m_lazy_f)
+        {
+            continue; // stale entry
+        }
+
+        m_distance_grid[n].store(m_lazy_g[n], std::memory_order_relaxed);
+        expandLazyCell(n);
+    }
+    return cell(node);
+}
+
+void BFS_3D::pushRepairCell(int node, int dist)
+{
+    if (m_repair_buckets.size() <= (size_t)dist) {
+        m_repair_buckets.resize(dist + 1);
+    }
+    m_repair_buckets[dist].push_back(node);
+}
+
 int BFS_3D::countWalls() const
 {
     int count = 0;
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (m_distance_grid[i] == WALL) {
+        if (cell(i) == WALL) {
             ++count;
         }
     }
@@ -466,7 +1019,7 @@ int BFS_3D::countUndiscovered() const
 {
     int count = 0;
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (m_distance_grid[i] == UNDISCOVERED) {
+        if (cell(i) == UNDISCOVERED) {
             ++count;
         }
     }
@@ -477,30 +1030,31 @@ int BFS_3D::countDiscovered() const
 {
     int count = 0;
     for (int i = 0; i < m_dim_xyz; ++i) {
-        if (m_distance_grid[i] != WALL && m_distance_grid[i] >= 0) {
+        if (cell(i) != WALL && cell(i) >= 0) {
             ++count;
         }
     }
     return count;
 }
 
-#define EXPAND_NEIGHBOR(offset)                            \
-    if (distance_grid[currentNode + offset] < 0) {         \
-        queue[queue_tail++] = currentNode + offset;        \
-        distance_grid[currentNode + offset] = currentCost; \
+#define EXPAND_NEIGHBOR(offset)                                                 \
+    if (distance_grid[currentNode + offset].load(std::memory_order_relaxed) < 0) { \
+        queue[queue_tail++] = currentNode + offset;                             \
+        distance_grid[currentNode + offset].store(currentCost, std::memory_order_relaxed); \
     }
 
 void BFS_3D::search(
     int width,
     int planeSize,
-    int volatile* distance_grid,
+    std::atomic<int>* distance_grid,
     int* queue,
     int& queue_head,
     int& queue_tail)
 {
+    int level_end = queue_tail;
     while (queue_head < queue_tail) {
         int currentNode = queue[queue_head++];
-        int currentCost = distance_grid[currentNode] + 1;
+        int currentCost = distance_grid[currentNode].load(std::memory_order_relaxed) + 1;
 
         EXPAND_NEIGHBOR(-width);
         EXPAND_NEIGHBOR(1);
@@ -528,22 +1082,27 @@ void BFS_3D::search(
         EXPAND_NEIGHBOR(-width+1-planeSize);
         EXPAND_NEIGHBOR(width+1-planeSize);
         EXPAND_NEIGHBOR(width-1-planeSize);
+
+        if (queue_head == level_end) {
+            publishLevel();
+            level_end = queue_tail;
+        }
     }
-    m_running = false;
 }
 
 #undef EXPAND_NEIGHBOR
 
 #define EXPAND_NEIGHBOR_FRONTIER(offset) \
 {\
-    if (distance_grid[currentNode + offset] < 0) {\
+    int d = distance_grid[currentNode + offset].load(std::memory_order_relaxed);\
+    if (d < 0) {\
         queue[queue_tail++] = currentNode + offset;\
-        distance_grid[currentNode + offset] = currentCost;\
+        distance_grid[currentNode + offset].store(currentCost, std::memory_order_relaxed);\
     }\
-    else if (distance_grid[currentNode + offset] == WALL) {\
-        if (frontier_grid[currentNode + offset] < 0) {\
+    else if (d == WALL) {\
+        if (frontier_grid[currentNode + offset].load(std::memory_order_relaxed) < 0) {\
             frontier_queue[frontier_queue_tail++] = currentNode + offset;\
-            frontier_grid[currentNode + offset] = currentCost;\
+            frontier_grid[currentNode + offset].store(currentCost, std::memory_order_relaxed);\
         }\
     }\
 }
@@ -551,18 +1110,18 @@ void BFS_3D::search(
 void BFS_3D::search(
     int width,
     int planeSize,
-    int volatile* distance_grid,
+    std::atomic<int>* distance_grid,
     int* queue,
     int& queue_head,
     int& queue_tail,
-    int volatile* frontier_grid,
+    std::atomic<int>* frontier_grid,
     int* frontier_queue,
     int& frontier_queue_head,
     int& frontier_queue_tail)
 {
     while (queue_head < queue_tail) {
         int currentNode = queue[queue_head++];
-        int currentCost = distance_grid[currentNode] + 1;
+        int currentCost = distance_grid[currentNode].load(std::memory_order_relaxed) + 1;
 
         EXPAND_NEIGHBOR_FRONTIER(-width);
         EXPAND_NEIGHBOR_FRONTIER(1);
@@ -591,7 +1150,6 @@ void BFS_3D::search(
         EXPAND_NEIGHBOR_FRONTIER(width+1-planeSize);
         EXPAND_NEIGHBOR_FRONTIER(width-1-planeSize);
     }
-    m_running = false;
 }
 
 #undef EXPAND_NEIGHBOR_FRONTIER
@@ -48,9 +48,10 @@ EuclidDistanceMap::EuclidDistanceMap(
 
 int EuclidDistanceMap::distance(const Cell& n, const Cell& s)
 {
-    int dx = n.x - s.obs->x;
-    int dy = n.y - s.obs->y;
-    int dz = n.z - s.obs->z;
+    const Cell& o = m_cells[s.obs];
+    int dx = n.x - o.x;
+    int dy = n.y - o.y;
+    int dz = n.z - o.z;
 
     return dx * dx + dy * dy + dz * dz;
 }
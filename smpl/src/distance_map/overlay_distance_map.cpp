@@ -0,0 +1,340 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <smpl/distance_map/overlay_distance_map.h>
+
+// standard includes
+#include <algorithm>
+#include <set>
+
+namespace smpl {
+
+/// Construct an overlay, without any obstacles of its own, over a base map.
+OverlayDistanceMap::OverlayDistanceMap(
+    const std::shared_ptr<const DistanceMapInterface>& base)
+:
+    DistanceMapInterface(
+            base->originX(), base->originY(), base->originZ(),
+            base->sizeX(), base->sizeY(), base->sizeZ(),
+            base->resolution()),
+    m_base(base),
+    m_overlay(new SparseDistanceMap(
+            base->originX(), base->originY(), base->originZ(),
+            base->sizeX(), base->sizeY(), base->sizeZ(),
+            base->resolution(),
+            base->getUninitializedDistance())),
+    m_has_overlay(false),
+    m_own()
+{
+}
+
+/// Copy constructor. The copy shares the base map of \p o, if \p o has not
+/// replaced it with a private copy, and copies the overlay.
+OverlayDistanceMap::OverlayDistanceMap(const OverlayDistanceMap& o) :
+    DistanceMapInterface(o),
+    m_base(o.m_base),
+    m_overlay(o.m_overlay ? new SparseDistanceMap(*o.m_overlay) : nullptr),
+    m_has_overlay(o.m_has_overlay),
+    m_own(o.m_own ? o.m_own->clone() : nullptr)
+{
+}
+
+auto OverlayDistanceMap::operator=(const OverlayDistanceMap& rhs)
+    -> OverlayDistanceMap&
+{
+    if (this != &rhs) {
+        DistanceMapInterface::operator=(rhs);
+        m_base = rhs.m_base;
+        m_overlay.reset(rhs.m_overlay ? new SparseDistanceMap(*rhs.m_overlay) : nullptr);
+        m_has_overlay = rhs.m_has_overlay;
+        m_own.reset(rhs.m_own ? rhs.m_own->clone() : nullptr);
+    }
+    return *this;
+}
+
+DistanceMapInterface* OverlayDistanceMap::clone() const
+{
+    return new OverlayDistanceMap(*this);
+}
+
+/// Add obstacles to the overlay. Points in obstacle cells of the base map are
+/// ignored.
+void OverlayDistanceMap::addPointsToMap(const std::vector<Vector3>& points)
+{
+    if (m_own) {
+        m_own->addPointsToMap(points);
+        return;
+    }
+
+    std::vector<Vector3> overlay_points;
+    overlay_points.reserve(points.size());
+    for (const Vector3& p : points) {
+        int gx, gy, gz;
+        worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+        if (isCellValid(gx, gy, gz) && !isBaseObstacle(gx, gy, gz)) {
+            overlay_points.push_back(p);
+        }
+    }
+
+    if (!overlay_points.empty()) {
+        m_overlay->addPointsToMap(overlay_points);
+        m_has_overlay = true;
+    }
+}
+
+/// Remove obstacles from the overlay. If any of the points lie in obstacle
+/// cells of the base map, the base map is first replaced by a private copy.
+void OverlayDistanceMap::removePointsFromMap(const std::vector<Vector3>& points)
+{
+    if (m_own) {
+        m_own->removePointsFromMap(points);
+        return;
+    }
+
+    std::vector<Vector3> overlay_points;
+    for (const Vector3& p : points) {
+        int gx, gy, gz;
+        worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+        if (!isCellValid(gx, gy, gz)) {
+            continue;
+        }
+
+        if (isOverlayObstacle(gx, gy, gz)) {
+            overlay_points.push_back(p);
+        } else if (isBaseObstacle(gx, gy, gz)) {
+            makeOwn();
+            m_own->removePointsFromMap(points);
+            return;
+        }
+    }
+
+    if (!overlay_points.empty()) {
+        m_overlay->removePointsFromMap(overlay_points);
+    }
+}
+
+/// Add the set (new_points - old_points) of obstacle cells and remove the set
+/// (old_points - new_points) of obstacle cells. Cells in both sets are left
+/// untouched, and do not require a private copy of the base map.
+void OverlayDistanceMap::updatePointsInMap(
+    const std::vector<Vector3>& old_points,
+    const std::vector<Vector3>& new_points)
+{
+    if (m_own) {
+        m_own->updatePointsInMap(old_points, new_points);
+        return;
+    }
+
+    auto to_cells = [&](const std::vector<Vector3>& points) {
+        std::set<Eigen::Vector3i, Eigen_Vector3i_compare> cells;
+        for (const Vector3& p : points) {
+            Eigen::Vector3i gp;
+            worldToGrid(p.x(), p.y(), p.z(), gp.x(), gp.y(), gp.z());
+            cells.insert(gp);
+        }
+        return cells;
+    };
+
+    auto difference = [&](
+        const std::vector<Vector3>& points,
+        const std::set<Eigen::Vector3i, Eigen_Vector3i_compare>& cells)
+    {
+        std::vector<Vector3> diff;
+        for (const Vector3& p : points) {
+            Eigen::Vector3i gp;
+            worldToGrid(p.x(), p.y(), p.z(), gp.x(), gp.y(), gp.z());
+            if (cells.find(gp) == cells.end()) {
+                diff.push_back(p);
+            }
+        }
+        return diff;
+    };
+
+    removePointsFromMap(difference(old_points, to_cells(new_points)));
+    addPointsToMap(difference(new_points, to_cells(old_points)));
+}
+
+/// Remove all obstacles, including those of the base map, which is replaced by
+/// an empty private copy.
+void OverlayDistanceMap::reset()
+{
+    if (!m_own) {
+        m_own.reset(m_base->clone());
+        m_base.reset();
+        m_overlay.reset();
+        m_has_overlay = false;
+    }
+    m_own->reset();
+}
+
+int OverlayDistanceMap::numCellsX() const
+{
+    return map().numCellsX();
+}
+
+int OverlayDistanceMap::numCellsY() const
+{
+    return map().numCellsY();
+}
+
+int OverlayDistanceMap::numCellsZ() const
+{
+    return map().numCellsZ();
+}
+
+double OverlayDistanceMap::getUninitializedDistance() const
+{
+    return map().getUninitializedDistance();
+}
+
+double OverlayDistanceMap::getMetricDistance(double x, double y, double z) const
+{
+    double d = map().getMetricDistance(x, y, z);
+    if (!m_own && m_has_overlay) {
+        d = std::min(d, m_overlay->getMetricDistance(x, y, z));
+    }
+    return d;
+}
+
+double OverlayDistanceMap::getCellDistance(int x, int y, int z) const
+{
+    double d = map().getCellDistance(x, y, z);
+    if (!m_own && m_has_overlay) {
+        d = std::min(d, m_overlay->getCellDistance(x, y, z));
+    }
+    return d;
+}
+
+double OverlayDistanceMap::getMetricSquaredDistance(
+    double x, double y, double z) const
+{
+    double d2 = map().getMetricSquaredDistance(x, y, z);
+    if (!m_own && m_has_overlay) {
+        d2 = std::min(d2, m_overlay->getMetricSquaredDistance(x, y, z));
+    }
+    return d2;
+}
+
+double OverlayDistanceMap::getCellSquaredDistance(int x, int y, int z) const
+{
+    double d2 = map().getCellSquaredDistance(x, y, z);
+    if (!m_own && m_has_overlay) {
+        d2 = std::min(d2, m_overlay->getCellSquaredDistance(x, y, z));
+    }
+    return d2;
+}
+
+void OverlayDistanceMap::getMetricSquaredDistances(
+    const double* x, const double* y, const double* z,
+    int count,
+    double* d2) const
+{
+    map().getMetricSquaredDistances(x, y, z, count, d2);
+    if (m_own || !m_has_overlay) {
+        return;
+    }
+
+    const int chunk_size = 64;
+    double overlay_d2[chunk_size];
+    for (int i = 0; i < count; i += chunk_size) {
+        const int n = std::min(chunk_size, count - i);
+        m_overlay->getMetricSquaredDistances(x + i, y + i, z + i, n, overlay_d2);
+        for (int j = 0; j < n; ++j) {
+            d2[i + j] = std::min(d2[i + j], overlay_d2[j]);
+        }
+    }
+}
+
+void OverlayDistanceMap::gridToWorld(
+    int x, int y, int z,
+    double& world_x, double& world_y, double& world_z) const
+{
+    map().gridToWorld(x, y, z, world_x, world_y, world_z);
+}
+
+void OverlayDistanceMap::worldToGrid(
+    double world_x, double world_y, double world_z,
+    int& x, int& y, int& z) const
+{
+    map().worldToGrid(world_x, world_y, world_z, x, y, z);
+}
+
+bool OverlayDistanceMap::isCellValid(int x, int y, int z) const
+{
+    return map().isCellValid(x, y, z);
+}
+
+auto OverlayDistanceMap::map() const -> const DistanceMapInterface&
+{
+    if (m_own) {
+        return *m_own;
+    } else {
+        return *m_base;
+    }
+}
+
+bool OverlayDistanceMap::isBaseObstacle(int x, int y, int z) const
+{
+    return m_base->getCellDistance(x, y, z) <= 0.0;
+}
+
+bool OverlayDistanceMap::isOverlayObstacle(int x, int y, int z) const
+{
+    return m_has_overlay && m_overlay->getCellDistance(x, y, z) <= 0.0;
+}
+
+/// Replace the shared base map with a private copy and move the obstacles from
+/// the overlay into it.
+void OverlayDistanceMap::makeOwn()
+{
+    m_own.reset(m_base->clone());
+
+    if (m_has_overlay) {
+        std::vector<Vector3> points;
+        const SparseDistanceMap& overlay = *m_overlay;
+        overlay.cells().accept_coords([&](
+            const SparseDistanceMap::Cell& c,
+            size_t fx, size_t fy, size_t fz,
+            size_t lx, size_t ly, size_t lz)
+        {
+            if (c.obs == &c) {
+                double wx, wy, wz;
+                overlay.gridToWorld((int)fx, (int)fy, (int)fz, wx, wy, wz);
+                points.emplace_back(wx, wy, wz);
+            }
+        });
+        m_own->addPointsToMap(points);
+    }
+
+    m_base.reset();
+    m_overlay.reset();
+    m_has_overlay = false;
+}
+
+} // namespace smpl
@@ -34,8 +34,28 @@
 // standard includes
 #include <set>
 
+// project includes
+#include <smpl/snapshot.h>
+
 namespace smpl {
 
+static const std::uint32_t SNAPSHOT_TYPE = SnapshotTag('S', 'P', 'R', 'S');
+static const std::uint32_t CELLS_TAG = SnapshotTag('C', 'E', 'L', 'L');
+
+// Snapshot record of a cell with a known nearest obstacle. All other cells
+// have their uninitialized values.
+struct SnapshotCell
+{
+    std::int32_t x;
+    std::int32_t y;
+    std::int32_t z;
+    std::int32_t ox;
+    std::int32_t oy;
+    std::int32_t oz;
+    std::int32_t dist;
+    std::int32_t dir;
+};
+
 SparseDistanceMap::SparseDistanceMap(
     double origin_x, double origin_y, double origin_z,
     double size_x, double size_y, double size_z,
@@ -89,6 +109,41 @@ SparseDistanceMap::SparseDistanceMap(
     reset();
 }
 
+/// Copy constructor. The nearest obstacle of each cell in the copy refers to
+/// the obstacle cell in the copy.
+SparseDistanceMap::SparseDistanceMap(const SparseDistanceMap& o) :
+    DistanceMapInterface(o),
+    m_cells(o.m_cells),
+    m_cell_count_x(o.m_cell_count_x),
+    m_cell_count_y(o.m_cell_count_y),
+    m_cell_count_z(o.m_cell_count_z),
+    m_max_dist(o.m_max_dist),
+    m_inv_res(o.m_inv_res),
+    m_dmax_int(o.m_dmax_int),
+    m_dmax_sqrd_int(o.m_dmax_sqrd_int),
+    m_bucket((int)o.m_open.size()),
+    m_neighbors(o.m_neighbors),
+    m_indices(o.m_indices),
+    m_neighbor_ranges(o.m_neighbor_ranges),
+    m_neighbor_dirs(o.m_neighbor_dirs),
+    m_sqrt_table(o.m_sqrt_table),
+    m_open(o.m_open.size()),
+    m_rem_stack(),
+    m_error(o.m_error)
+{
+    relinkObstacles();
+}
+
+auto SparseDistanceMap::operator=(const SparseDistanceMap& rhs)
+    -> SparseDistanceMap&
+{
+    if (this != &rhs) {
+        SparseDistanceMap tmp(rhs);
+        *this = std::move(tmp);
+    }
+    return *this;
+}
+
 /// Return the distance value for an invalid cell.
 double SparseDistanceMap::maxDistance() const
 {
@@ -323,6 +378,16 @@ double SparseDistanceMap::getMetricSquaredDistance(
 //    return getInterpMetricSquaredDistance(x, y, z);
 }
 
+void SparseDistanceMap::getMetricSquaredDistances(
+    const double* x, const double* y, const double* z,
+    int count,
+    double* d2) const
+{
+    for (int i = 0; i < count; ++i) {
+        d2[i] = getTrueMetricSquaredDistance(x[i], y[i], z[i]);
+    }
+}
+
 double SparseDistanceMap::getCellSquaredDistance(int x, int y, int z) const
 {
     double wx, wy, wz;
@@ -594,6 +659,116 @@ void SparseDistanceMap::propagateBorder()
 /// distances between the world point and the nearest point on (or within) the
 /// nearest obstacle cells for all of its 27-nearest cell neighbors and taking
 /// the minimum distance.
+// Point the nearest obstacle of each cell at the obstacle cell stored in this
+// map, after the cells have been copied from another map.
+void SparseDistanceMap::relinkObstacles()
+{
+    m_cells.accept_coords([&](
+        Cell& c,
+        size_t fx, size_t fy, size_t fz,
+        size_t lx, size_t ly, size_t lz)
+    {
+        if (c.obs) {
+            c.obs = &m_cells(c.ox, c.oy, c.oz); // force stable
+        }
+    });
+}
+
+/// Add the cells with known nearest obstacles to a snapshot.
+bool SparseDistanceMap::saveSnapshot(SnapshotWriter& writer) const
+{
+    SaveDistanceMapInfo(writer, *this, SNAPSHOT_TYPE, m_max_dist);
+
+    // cells with known nearest obstacles are never pruned, so each is stored
+    // in its own leaf
+    size_t count = 0;
+    m_cells.accept_coords([&](
+        const Cell& c,
+        size_t fx, size_t fy, size_t fz,
+        size_t lx, size_t ly, size_t lz)
+    {
+        if (c.obs) {
+            ++count;
+        }
+    });
+
+    auto* cells = (SnapshotCell*)writer.allocateSection(
+            CELLS_TAG, count * sizeof(SnapshotCell));
+    m_cells.accept_coords([&](
+        const Cell& c,
+        size_t fx, size_t fy, size_t fz,
+        size_t lx, size_t ly, size_t lz)
+    {
+        if (c.obs) {
+            SnapshotCell& sc = *cells++;
+            sc.x = (std::int32_t)fx;
+            sc.y = (std::int32_t)fy;
+            sc.z = (std::int32_t)fz;
+            sc.ox = c.ox;
+            sc.oy = c.oy;
+            sc.oz = c.oz;
+            sc.dist = c.dist;
+            sc.dir = c.dir;
+        }
+    });
+
+    return true;
+}
+
+/// Replace the contents of the map with the cells from a snapshot. The cells
+/// are inserted directly, without propagating distances.
+bool SparseDistanceMap::loadSnapshot(const SnapshotReader& reader)
+{
+    if (!LoadDistanceMapInfo(reader, *this, SNAPSHOT_TYPE, m_max_dist)) {
+        return false;
+    }
+
+    size_t size;
+    auto* cells = (const SnapshotCell*)reader.section(CELLS_TAG, &size);
+    if (!cells || size % sizeof(SnapshotCell) != 0) {
+        return false;
+    }
+
+    const size_t count = size / sizeof(SnapshotCell);
+    for (size_t i = 0; i < count; ++i) {
+        const SnapshotCell& sc = cells[i];
+        if (!isCellValid(sc.x, sc.y, sc.z) ||
+            !isCellValid(sc.ox, sc.oy, sc.oz) ||
+            sc.dist < 0 || sc.dist > m_dmax_sqrd_int ||
+            sc.dir < 0 || sc.dir >= NUM_DIRECTIONS)
+        {
+            return false;
+        }
+    }
+
+    reset();
+    for (auto& bucket : m_open) {
+        bucket.clear();
+    }
+    m_bucket = (int)m_open.size();
+    m_rem_stack.clear();
+
+    for (size_t i = 0; i < count; ++i) {
+        const SnapshotCell& sc = cells[i];
+        Cell& c = m_cells(sc.x, sc.y, sc.z); // force stable
+        c.obs = &c; // relinked below
+        c.ox = sc.ox;
+        c.oy = sc.oy;
+        c.oz = sc.oz;
+        c.dist = sc.dist;
+        c.dist_new = sc.dist;
+#if SMPL_DMAP_RETURN_CHANGED_CELLS
+        c.dist_old = sc.dist;
+#endif
+        c.dir = sc.dir;
+    }
+
+    // link each cell to its nearest obstacle once all leaves are in place
+    relinkObstacles();
+
+    return true;
+}
+
 double SparseDistanceMap::getTrueMetricSquaredDistance(
     double x, double y, double z) const
 {
@@ -663,39 +838,34 @@ double SparseDistanceMap::getTrueMetricSquaredDistance(
     bool conservative = false;
 
     // check the 27 nearest cells and take the minimum of the distances from
-    // (x, y, z) to their nearest obstacles
-    if (border) {
-        for (int gppx = gpx - 1; gppx != gpx + 2; ++gppx) {
-        for (int gppy = gpy - 1; gppy != gpy + 2; ++gppy) {
-        for (int gppz = gpz - 1; gppz != gpz + 2; ++gppz) {
-            if (SparseDistanceMap::isCellValid(gppx, gppy, gppz)) {
-                const Cell& c = m_cells.get(gppx, gppy, gppz);
-
-                if (c.obs) { // known nearest obstacle -> nearest distance to it
-                    const double d2 = nearestEdgeDist(c.ox, c.oy, c.oz);
-                    if (d2 < min_d2) {
-                        min_d2 = d2;
-                    }
-                } else { // unknown nearest obstacle -> conservative nearest distance
-                    conservative = true;
-                }
-            }
-        } } }
-    } else {
-        for (int gppx = gpx - 1; gppx != gpx + 2; ++gppx) {
-        for (int gppy = gpy - 1; gppy != gpy + 2; ++gppy) {
-        for (int gppz = gpz - 1; gppz != gpz + 2; ++gppz) {
-            const Cell& c = m_cells.get(gppx, gppy, gppz);
-
-            if (c.obs) { // known nearest obstacle -> nearest distance to it
-                const double d2 = nearestEdgeDist(c.ox, c.oy, c.oz);
-                if (d2 < min_d2) {
-                    min_d2 = d2;
-                }
-            } else { // unknown nearest obstacle -> conservative nearest distance
-                conservative = true;
+    // (x, y, z) to their nearest obstacles. The cells are looked up together,
+    // as they share most of their ancestors in the octree.
+    int coords[3 * 27];
+    int count = 0;
+    for (int gppx = gpx - 1; gppx != gpx + 2; ++gppx) {
+    for (int gppy = gpy - 1; gppy != gpy + 2; ++gppy) {
+    for (int gppz = gpz - 1; gppz != gpz + 2; ++gppz) {
+        if (!border || SparseDistanceMap::isCellValid(gppx, gppy, gppz)) {
+            coords[3 * count + 0] = gppx;
+            coords[3 * count + 1] = gppy;
+            coords[3 * count + 2] = gppz;
+            ++count;
+        }
+    } } }
+
+    const Cell* cells[27];
+    m_cells.get(coords, count, cells);
+
+    for (int i = 0; i < count; ++i) {
+        const Cell& c = *cells[i];
+        if (c.obs) { // known nearest obstacle -> nearest distance to it
+            const double d2 = nearestEdgeDist(c.ox, c.oy, c.oz);
+            if (d2 < min_d2) {
+                min_d2 = d2;
             }
-        } } }
+        } else { // unknown nearest obstacle -> conservative nearest distance
+            conservative = true;
+        }
     }
 
     if (conservative) {
@@ -36,6 +36,53 @@
 
 namespace smpl {
 
+void ActionBuffer::clear()
+{
+    m_offsets.resize(1);
+    m_waypoint_count = 0;
+}
+
+/// Append a waypoint to the action under construction and return a reference to
+/// it. The waypoint may hold the value of a previously cleared waypoint.
+auto ActionBuffer::appendWaypoint() -> RobotState&
+{
+    if (m_waypoint_count == m_waypoints.size()) {
+        m_waypoints.emplace_back();
+    }
+    return m_waypoints[m_waypoint_count++];
+}
+
+/// Finish the action under construction, consisting of all waypoints appended
+/// since the last call to commitAction() or discardAction().
+void ActionBuffer::commitAction()
+{
+    m_offsets.push_back(m_waypoint_count);
+}
+
+/// Remove all waypoints appended since the last call to commitAction() or
+/// discardAction().
+void ActionBuffer::discardAction()
+{
+    m_waypoint_count = m_offsets.back();
+}
+
+void ActionBuffer::push_back(const Action& action)
+{
+    for (auto& waypoint : action) {
+        appendWaypoint() = waypoint;
+    }
+    commitAction();
+}
+
+/// Append a copy of an action. The action must not be a view into this buffer.
+void ActionBuffer::push_back(const ActionView& action)
+{
+    for (auto& waypoint : action) {
+        appendWaypoint() = waypoint;
+    }
+    commitAction();
+}
+
 ActionSpace::~ActionSpace()
 {
 }
@@ -50,4 +97,16 @@ bool ActionSpace::init(RobotPlanningSpace* space)
     return true;
 }
 
+bool ActionSpace::apply(const RobotState& parent, ActionBuffer& actions)
+{
+    std::vector<Action> tmp;
+    if (!apply(parent, tmp)) {
+        return false;
+    }
+    for (auto& action : tmp) {
+        actions.push_back(action);
+    }
+    return true;
+}
+
 } // namespace smpl
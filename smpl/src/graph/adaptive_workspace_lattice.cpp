@@ -431,6 +431,8 @@ bool AdaptiveWorkspaceLattice::setStart(const RobotState& state)
     WorkspaceCoord start_coord;
     stateRobotToCoord(state, start_coord);
 
+    validateIKCache(state);
+
     m_start_state_id = getHiHashEntry(start_coord);
     if (m_start_state_id < 0) {
         m_start_state_id = createHiState(start_coord, state);
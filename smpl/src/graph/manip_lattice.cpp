@@ -33,6 +33,7 @@
 #include <smpl/graph/manip_lattice.h>
 
 // standard includes
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 
@@ -43,29 +44,28 @@
 #include <smpl/console/console.h>
 #include <smpl/console/nonstd.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/planning_stats.h>
 #include <smpl/debug/visualize.h>
 #include <smpl/debug/marker_utils.h>
 #include <smpl/spatial.h>
 #include "../profiling.h"
 
-auto std::hash<smpl::ManipLatticeState>::operator()(
-    const argument_type& s) const -> result_type
+namespace smpl {
+
+// goal types whose goal test requires the pose of the planning frame
+static
+bool IsPoseGoal(GoalType type)
 {
-    size_t seed = 0;
-    boost::hash_combine(seed, boost::hash_range(s.coord.begin(), s.coord.end()));
-    return seed;
+    return type == GoalType::XYZ_RPY_GOAL ||
+            type == GoalType::MULTIPLE_POSE_GOAL ||
+            type == GoalType::XYZ_GOAL;
 }
 
-namespace smpl {
-
 ManipLattice::~ManipLattice()
 {
-    for (size_t i = 0; i < m_states.size(); i++) {
-        delete m_states[i];
-        m_states[i] = nullptr;
-    }
-    m_states.clear();
-    m_state_to_id.clear();
+    // planner indices are owned by the state table, and must not be freed by
+    // DiscreteSpaceInformation
+    StateID2IndexMapping.clear();
 }
 
 bool ManipLattice::init(
@@ -111,6 +111,9 @@ bool ManipLattice::init(
             m_bounded[jidx] ? "true" : "false");
     }
 
+    StateID2IndexMapping.clear();
+    m_states.init(_robot->jointVariableCount(), NUMOFINDICES_STATEID2IND);
+
     m_goal_state_id = reserveHashEntry();
     SMPL_DEBUG_NAMED(G_LOG, "  goal state has state ID %d", m_goal_state_id);
 
@@ -138,18 +141,20 @@ bool ManipLattice::init(
 
     m_actions = actions;
 
+    m_succ_coord.resize(_robot->jointVariableCount());
+
     return true;
 }
 
 void ManipLattice::PrintState(int stateID, bool verbose, FILE* fout)
 {
-    assert(stateID >= 0 && stateID < (int)m_states.size());
+    assert(stateID >= 0 && stateID < m_states.size());
 
     if (!fout) {
         fout = stdout;
     }
 
-    ManipLatticeState* entry = m_states[stateID];
+    ManipLatticeState* entry = m_states.get(stateID);
 
     std::stringstream ss;
 
@@ -203,6 +208,8 @@ void ManipLattice::GetSuccs(
     assert(succs && costs && "successor buffer is null");
     assert(m_actions && "action space is uninitialized");
 
+    PhaseTimer timer(PlanningPhase::SuccessorGeneration);
+
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "expanding state %d", state_id);
 
     // goal state should be absorbing
@@ -210,13 +217,12 @@ void ManipLattice::GetSuccs(
         return;
     }
 
-    ManipLatticeState* parent_entry = m_states[state_id];
+    ManipLatticeState* parent_entry = m_states.get(state_id);
 
     assert(parent_entry);
-    assert(parent_entry->coord.size() >= robot()->jointVariableCount());
 
     // log expanded state details
-    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << parent_entry->coord);
+    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << getCoord(parent_entry));
     SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  angles: " << parent_entry->state);
 
     auto* vis_name = "expansion";
@@ -224,7 +230,8 @@ void ManipLattice::GetSuccs(
 
     int goal_succ_count = 0;
 
-    std::vector<Action> actions;
+    auto& actions = m_action_buffer;
+    actions.clear();
     if (!m_actions->apply(parent_entry->state, actions)) {
         SMPL_WARN("Failed to get actions");
         return;
@@ -233,28 +240,42 @@ void ManipLattice::GetSuccs(
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", actions.size());
 
     // check actions for validity
-    RobotCoord succ_coord(robot()->jointVariableCount(), 0);
+    auto& valid = m_action_valid;
+    checkActions(parent_entry->state, actions, valid);
+
+    // get or create the successor states
+    auto& succ_coord = m_succ_coord;
+    beginSuccessors();
     for (size_t i = 0; i < actions.size(); ++i) {
-        auto& action = actions[i];
+        if (valid[i]) {
+            stateToCoord(actions[i].back(), succ_coord);
+            m_succ_ids.push_back(getOrCreateState(succ_coord, actions[i].back()));
+        }
+    }
+
+    auto pose_goal = IsPoseGoal(goal().type);
+    if (pose_goal) {
+        computeActionPoses(actions, &valid);
+    }
+
+    size_t succ_index = 0;
+    for (size_t i = 0; i < actions.size(); ++i) {
+        auto action = actions[i];
 
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "    action %zu:", i);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      waypoints: %zu", action.size());
 
-        if (!checkAction(parent_entry->state, action)) {
+        if (!valid[i]) {
             continue;
         }
 
-        // compute destination coords
-        stateToCoord(action.back(), succ_coord);
-
-        // get the successor
-
-        // check if hash entry already exists, if not then create one
-        int succ_state_id = getOrCreateState(succ_coord, action.back());
+        auto k = succ_index++;
+        int succ_state_id = m_succ_ids[k];
         ManipLatticeState* succ_entry = getHashEntry(succ_state_id);
 
         // check if this state meets the goal criteria
-        auto is_goal_succ = isGoal(action.back());
+        auto is_goal_succ = isGoal(
+                action.back(), pose_goal ? &m_action_poses[k] : nullptr);
         if (is_goal_succ) {
             // update goal state
             ++goal_succ_count;
@@ -271,7 +292,7 @@ void ManipLattice::GetSuccs(
         // log successor details
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      succ: %zu", i);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        id: %5i", succ_state_id);
-        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << succ_coord);
+        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << getCoord(succ_entry));
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        state: " << succ_entry->state);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", cost(parent_entry, succ_entry, is_goal_succ));
     }
@@ -292,6 +313,8 @@ void ManipLattice::GetLazySuccs(
     GetLazySuccsStopwatch.start();
     PROFAUTOSTOP(GetLazySuccsStopwatch);
 
+    PhaseTimer timer(PlanningPhase::SuccessorGeneration);
+
     assert(state_id >= 0 && state_id < m_states.size());
 
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "expand state %d", state_id);
@@ -301,20 +324,20 @@ void ManipLattice::GetLazySuccs(
         return;
     }
 
-    ManipLatticeState* state_entry = m_states[state_id];
+    ManipLatticeState* state_entry = m_states.get(state_id);
 
     assert(state_entry);
-    assert(state_entry->coord.size() >= robot()->jointVariableCount());
 
     // log expanded state details
-    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << state_entry->coord);
+    SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  coord: " << getCoord(state_entry));
     SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "  angles: " << state_entry->state);
 
     auto& source_angles = state_entry->state;
     auto* vis_name = "expansion";
     SV_SHOW_DEBUG_NAMED(vis_name, getStateVisualization(source_angles, vis_name));
 
-    std::vector<Action> actions;
+    auto& actions = m_action_buffer;
+    actions.clear();
     if (!m_actions->apply(source_angles, actions)) {
         SMPL_WARN("Failed to get successors");
         return;
@@ -322,22 +345,32 @@ void ManipLattice::GetLazySuccs(
 
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "  actions: %zu", actions.size());
 
+    auto& succ_coord = m_succ_coord;
+    beginSuccessors();
+    for (size_t i = 0; i < actions.size(); ++i) {
+        stateToCoord(actions[i].back(), succ_coord);
+        m_succ_ids.push_back(getOrCreateState(succ_coord, actions[i].back()));
+    }
+
+    auto pose_goal = IsPoseGoal(goal().type);
+    if (pose_goal) {
+        computeActionPoses(actions, nullptr);
+    }
+
     int goal_succ_count = 0;
-    RobotCoord succ_coord(robot()->jointVariableCount());
     for (size_t i = 0; i < actions.size(); ++i) {
-        auto& action = actions[i];
+        auto action = actions[i];
 
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "    action %zu:", i);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      waypoints: %zu", action.size());
 
-        stateToCoord(action.back(), succ_coord);
-
-        auto succ_is_goal_state = isGoal(action.back());
+        auto succ_is_goal_state = isGoal(
+                action.back(), pose_goal ? &m_action_poses[i] : nullptr);
         if (succ_is_goal_state) {
             ++goal_succ_count;
         }
 
-        int succ_state_id = getOrCreateState(succ_coord, action.back());
+        int succ_state_id = m_succ_ids[i];
         ManipLatticeState* succ_entry = getHashEntry(succ_state_id);
 
         if (succ_is_goal_state) {
@@ -351,7 +384,7 @@ void ManipLattice::GetLazySuccs(
         // log successor details
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "      succ: %zu", i);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        id: %5i", succ_state_id);
-        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << succ_coord);
+        SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        coord: " << getCoord(succ_entry));
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        state: " << succ_entry->state);
         SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        cost: %5d", cost(state_entry, succ_entry, succ_is_goal_state));
     }
@@ -370,19 +403,20 @@ int ManipLattice::GetTrueCost(int parentID, int childID)
 
     SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "evaluating cost of transition %d -> %d", parentID, childID);
 
-    assert(parentID >= 0 && parentID < (int)m_states.size());
-    assert(childID >= 0 && childID < (int)m_states.size());
+    assert(parentID >= 0 && parentID < m_states.size());
+    assert(childID >= 0 && childID < m_states.size());
 
-    ManipLatticeState* parent_entry = m_states[parentID];
-    ManipLatticeState* child_entry = m_states[childID];
-    assert(parent_entry && parent_entry->coord.size() >= robot()->jointVariableCount());
-    assert(child_entry && child_entry->coord.size() >= robot()->jointVariableCount());
+    ManipLatticeState* parent_entry = m_states.get(parentID);
+    ManipLatticeState* child_entry = m_states.get(childID);
+    assert(parent_entry);
+    assert(child_entry);
 
     auto& parent_angles = parent_entry->state;
     auto* vis_name = "expansion";
     SV_SHOW_DEBUG_NAMED(vis_name, getStateVisualization(parent_angles, vis_name));
 
-    std::vector<Action> actions;
+    auto& actions = m_action_buffer;
+    actions.clear();
     if (!m_actions->apply(parent_angles, actions)) {
         SMPL_WARN("Failed to get actions");
         return -1;
@@ -393,10 +427,10 @@ int ManipLattice::GetTrueCost(int parentID, int childID)
     size_t num_actions = 0;
 
     // check actions for validity and find the valid action with the least cost
-    RobotCoord succ_coord(robot()->jointVariableCount());
+    auto& succ_coord = m_succ_coord;
     int best_cost = std::numeric_limits<int>::max();
     for (size_t aidx = 0; aidx < actions.size(); ++aidx) {
-        auto& action = actions[aidx];
+        auto action = actions[aidx];
 
         stateToCoord(action.back(), succ_coord);
 
@@ -408,7 +442,7 @@ int ManipLattice::GetTrueCost(int parentID, int childID)
             }
         } else {
             // skip actions which don't end up at the child state
-            if (succ_coord != child_entry->coord) {
+            if (!std::equal(succ_coord.begin(), succ_coord.end(), child_entry->coord)) {
                 continue;
             }
         }
@@ -438,9 +472,139 @@ int ManipLattice::GetTrueCost(int parentID, int childID)
     }
 }
 
+/// Compute the true costs of a batch of edges, as by GetTrueCost(). Candidate
+/// actions for all edges are gathered first, so that with edge validation
+/// workers enabled their collision checks run concurrently.
+///
+/// \param[out] costs The cost of each edge, or -1 if it is invalid
+void ManipLattice::GetTrueCosts(
+    const int* parent_ids,
+    const int* child_ids,
+    int count,
+    int* costs)
+{
+    GetTrueCostStopwatch.start();
+    PROFAUTOSTOP(GetTrueCostStopwatch);
+
+    m_edge_actions.clear();
+    m_edge_sources.clear();
+    m_edge_indices.clear();
+    m_edge_costs.clear();
+
+    auto& actions = m_action_buffer;
+    auto& succ_coord = m_succ_coord;
+    for (int e = 0; e < count; ++e) {
+        costs[e] = -1;
+
+        SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "evaluating cost of transition %d -> %d", parent_ids[e], child_ids[e]);
+
+        ManipLatticeState* parent_entry = m_states.get(parent_ids[e]);
+        ManipLatticeState* child_entry = m_states.get(child_ids[e]);
+        assert(parent_entry);
+        assert(child_entry);
+
+        actions.clear();
+        if (!m_actions->apply(parent_entry->state, actions)) {
+            SMPL_WARN("Failed to get actions");
+            continue;
+        }
+
+        auto goal_edge = (child_ids[e] == m_goal_state_id);
+
+        for (size_t aidx = 0; aidx < actions.size(); ++aidx) {
+            auto action = actions[aidx];
+
+            stateToCoord(action.back(), succ_coord);
+
+            if (goal_edge) {
+                if (!isGoal(action.back())) {
+                    continue;
+                }
+            } else {
+                if (!std::equal(succ_coord.begin(), succ_coord.end(), child_entry->coord)) {
+                    continue;
+                }
+            }
+
+            if (!checkActionJointLimits(action)) {
+                continue;
+            }
+
+            int succ_state_id = goal_edge ? getHashEntry(succ_coord) : child_ids[e];
+            ManipLatticeState* succ_entry = getHashEntry(succ_state_id);
+            assert(succ_entry);
+
+            m_edge_actions.push_back(action);
+            m_edge_sources.push_back(&parent_entry->state);
+            m_edge_indices.push_back(e);
+            m_edge_costs.push_back(cost(parent_entry, succ_entry, goal_edge));
+        }
+    }
+
+    validateEdgeActions();
+
+    for (size_t k = 0; k < m_edge_valid.size(); ++k) {
+        if (!m_edge_valid[k]) {
+            continue;
+        }
+        int& edge_cost = costs[m_edge_indices[k]];
+        if (edge_cost < 0 || m_edge_costs[k] < edge_cost) {
+            edge_cost = m_edge_costs[k];
+        }
+    }
+}
+
+/// Enable parallel edge validation, with one worker thread per collision
+/// checker. Each checker is used exclusively by its worker and must be
+/// independent of the others and of the lattice's own collision checker, e.g.
+/// a clone of it. An empty list disables parallel validation.
+bool ManipLattice::setEdgeValidationCheckers(
+    const std::vector<CollisionChecker*>& checkers)
+{
+    for (auto* checker : checkers) {
+        if (!checker) {
+            SMPL_ERROR_NAMED(G_LOG, "Edge validation collision checker is null");
+            return false;
+        }
+    }
+
+    m_edge_pool.reset();
+    m_edge_checkers = checkers;
+    m_edge_checker_clones.clear();
+    if (!m_edge_checkers.empty()) {
+        m_edge_pool.reset(new ThreadPool((int)m_edge_checkers.size()));
+    }
+    return true;
+}
+
+/// Enable parallel edge validation with \p num_threads workers, each with its
+/// own clone of the lattice's collision checker, which must support
+/// CollisionCheckerCloneExtension. The clones are remade whenever the start
+/// state is set, so that they pick up changes made to the collision checker
+/// between planning requests. Fewer than two threads disables parallel
+/// validation.
+bool ManipLattice::setEdgeValidationThreadCount(int num_threads)
+{
+    if (num_threads < 2) {
+        return setEdgeValidationCheckers({ });
+    }
+
+    if (!collisionChecker()->getExtension<CollisionCheckerCloneExtension>()) {
+        SMPL_ERROR_NAMED(G_LOG, "Parallel edge validation requires a collision checker that can be cloned");
+        return false;
+    }
+
+    return cloneEdgeValidationCheckers(num_threads);
+}
+
+int ManipLattice::edgeValidationThreadCount() const
+{
+    return m_edge_pool ? m_edge_pool->size() : 0;
+}
+
 const RobotState& ManipLattice::extractState(int state_id)
 {
-    return m_states[state_id]->state;
+    return m_states.get(state_id)->state;
 }
 
 bool ManipLattice::projectToPose(int state_id, Affine3& pose)
@@ -450,7 +614,15 @@ bool ManipLattice::projectToPose(int state_id, Affine3& pose)
         return true;
     }
 
-    pose = computePlanningFrameFK(m_states[state_id]->state);
+    // successors of the latest expansion are projected together
+    auto it = std::find(m_succ_ids.begin(), m_succ_ids.end(), state_id);
+    if (it != m_succ_ids.end()) {
+        computeSuccessorPoses();
+        pose = m_succ_poses[it - m_succ_ids.begin()];
+        return true;
+    }
+
+    pose = computePlanningFrameFK(m_states.get(state_id)->state);
     return true;
 }
 
@@ -512,24 +684,18 @@ void ManipLattice::stateToCoord(
 
 ManipLatticeState* ManipLattice::getHashEntry(int state_id) const
 {
-    if (state_id < 0 || state_id >= (int)m_states.size()) {
+    if (state_id < 0 || state_id >= m_states.size()) {
         return nullptr;
     }
 
-    return m_states[state_id];
+    return m_states.get(state_id);
 }
 
 /// Return the state id of the state with the given coordinate or -1 if the
 /// state has not yet been allocated.
 int ManipLattice::getHashEntry(const RobotCoord& coord)
 {
-    ManipLatticeState state;
-    state.coord = coord;
-    auto sit = m_state_to_id.find(&state);
-    if (sit == m_state_to_id.end()) {
-        return -1;
-    }
-    return sit->second;
+    return m_states.find(coord.data());
 }
 
 int ManipLattice::createHashEntry(
@@ -539,11 +705,11 @@ int ManipLattice::createHashEntry(
     int state_id = reserveHashEntry();
     ManipLatticeState* entry = getHashEntry(state_id);
 
-    entry->coord = coord;
+    std::copy(coord.begin(), coord.end(), entry->coord);
     entry->state = state;
 
     // map state -> state id
-    m_state_to_id[entry] = state_id;
+    m_states.insert(state_id);
 
     return state_id;
 }
@@ -561,20 +727,20 @@ int ManipLattice::getOrCreateState(
 
 int ManipLattice::reserveHashEntry()
 {
-    ManipLatticeState* entry = new ManipLatticeState;
-    int state_id = (int)m_states.size();
-
     // map state id -> state
-    m_states.push_back(entry);
+    int state_id = m_states.reserve();
 
     // map planner state -> graph state
-    int* pinds = new int[NUMOFINDICES_STATEID2IND];
-    std::fill(pinds, pinds + NUMOFINDICES_STATEID2IND, -1);
-    StateID2IndexMapping.push_back(pinds);
+    StateID2IndexMapping.push_back(m_states.indices(state_id));
 
     return state_id;
 }
 
+auto ManipLattice::getCoord(const ManipLatticeState* entry) const -> RobotCoord
+{
+    return RobotCoord(entry->coord, entry->coord + m_states.coordSize());
+}
+
 /// NOTE: const although RobotModel::computeFK used underneath may
 /// not be
 auto ManipLattice::computePlanningFrameFK(const RobotState& state) const
@@ -586,6 +752,88 @@ auto ManipLattice::computePlanningFrameFK(const RobotState& state) const
     return m_fk_iface->computeFK(state);
 }
 
+/// Reset the successor list of the latest expansion.
+void ManipLattice::beginSuccessors()
+{
+    m_succ_ids.clear();
+    m_succ_poses_valid = false;
+}
+
+// Compute the poses of count states, where state_at(i) returns the i'th
+// state, with a single batched forward kinematics query.
+template <class StateAt>
+static void ComputeFKBatch(
+    ForwardKinematicsInterface* fk_iface,
+    size_t var_count,
+    size_t count,
+    StateAt state_at,
+    std::vector<double>& positions,
+    std::vector<Affine3, Eigen::aligned_allocator<Affine3>>& poses)
+{
+    positions.resize(var_count * count);
+    for (size_t i = 0; i < count; ++i) {
+        const RobotState& state = state_at(i);
+        for (size_t v = 0; v < var_count; ++v) {
+            positions[v * count + i] = state[v];
+        }
+    }
+
+    poses.resize(count);
+    fk_iface->computeFKBatch(
+            positions.data(), (int)count, (int)count, poses.data());
+}
+
+/// Compute the planning frame poses of the stored states of the successors of
+/// the latest expansion with a single batched forward kinematics query, if
+/// they are not already available.
+void ManipLattice::computeSuccessorPoses()
+{
+    if (m_succ_poses_valid) {
+        return;
+    }
+
+    assert(m_fk_iface);
+
+    ComputeFKBatch(
+            m_fk_iface,
+            robot()->jointVariableCount(),
+            m_succ_ids.size(),
+            [&](size_t i) -> const RobotState& {
+                return m_states.get(m_succ_ids[i])->state;
+            },
+            m_succ_positions,
+            m_succ_poses);
+    m_succ_poses_valid = true;
+}
+
+/// Compute the planning frame poses of the final waypoints of the actions of
+/// the latest expansion with a single batched forward kinematics query. The
+/// final waypoint may differ from the stored state of the successor it maps
+/// to, and is the state that the goal test and path extraction see. If
+/// \p valid is given, only the valid actions are included, in order.
+void ManipLattice::computeActionPoses(
+    const ActionBuffer& actions,
+    const std::vector<char>* valid)
+{
+    assert(m_fk_iface);
+
+    auto& endpoints = m_action_endpoints;
+    endpoints.clear();
+    for (size_t i = 0; i < actions.size(); ++i) {
+        if (!valid || (*valid)[i]) {
+            endpoints.push_back(&actions[i].back());
+        }
+    }
+
+    ComputeFKBatch(
+            m_fk_iface,
+            robot()->jointVariableCount(),
+            endpoints.size(),
+            [&](size_t i) -> const RobotState& { return *endpoints[i]; },
+            m_succ_positions,
+            m_action_poses);
+}
+
 int ManipLattice::cost(
     ManipLatticeState* HashEntry1,
     ManipLatticeState* HashEntry2,
@@ -595,20 +843,22 @@ int ManipLattice::cost(
     return DefaultCostMultiplier;
 }
 
-bool ManipLattice::checkAction(const RobotState& state, const Action& action)
+bool ManipLattice::checkAction(const RobotState& state, const ActionView& action)
 {
-    std::uint32_t violation_mask = 0x00000000;
+    return checkActionJointLimits(action) &&
+            checkActionCollisions(collisionChecker(), state, action);
+}
 
-    // check intermediate states for collisions
+bool ManipLattice::checkActionJointLimits(const ActionView& action)
+{
+    // check intermediate states for joint limits
     for (size_t iidx = 0; iidx < action.size(); ++iidx) {
         const RobotState& istate = action[iidx];
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        " << iidx << ": " << istate);
 
-        // check joint limits
         if (!robot()->checkJointLimits(istate)) {
             SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> violates joint limits");
-            violation_mask |= 0x00000001;
-            break;
+            return false;
         }
 
         // TODO/NOTE: this can result in an unnecessary number of collision
@@ -622,22 +872,113 @@ bool ManipLattice::checkAction(const RobotState& state, const Action& action)
 //        if (!collisionChecker()->isStateValid(istate))
 //        {
 //            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> in collision);
-//            violation_mask |= 0x00000002;
-//            break;
+//            return false;
 //        }
     }
 
-    if (violation_mask) {
+    return true;
+}
+
+/// Check a set of actions from a state for validity, in parallel on the edge
+/// validation workers if they are enabled.
+void ManipLattice::checkActions(
+    const RobotState& state,
+    const ActionBuffer& actions,
+    std::vector<char>& valid)
+{
+    valid.assign(actions.size(), 0);
+
+    if (!m_edge_pool) {
+        for (size_t i = 0; i < actions.size(); ++i) {
+            valid[i] = checkAction(state, actions[i]);
+        }
+        return;
+    }
+
+    // joint limits are checked here, since the robot model is not assumed to
+    // be thread-safe
+    auto& candidates = m_edge_indices;
+    candidates.clear();
+    for (size_t i = 0; i < actions.size(); ++i) {
+        if (checkActionJointLimits(actions[i])) {
+            candidates.push_back((int)i);
+        }
+    }
+
+    m_edge_pool->parallelFor(
+            (int)candidates.size(),
+            [&](int thread, int k)
+            {
+                const int i = candidates[k];
+                valid[i] = checkActionCollisions(
+                        m_edge_checkers[thread], state, actions[i]);
+            });
+}
+
+// Replace the edge validation checkers with fresh clones of the lattice's
+// collision checker
+bool ManipLattice::cloneEdgeValidationCheckers(int num_threads)
+{
+    auto* clone_iface = collisionChecker()->getExtension<CollisionCheckerCloneExtension>();
+    assert(clone_iface);
+
+    std::vector<std::unique_ptr<CollisionChecker>> clones;
+    std::vector<CollisionChecker*> checkers;
+    for (int i = 0; i < num_threads; ++i) {
+        auto clone = clone_iface->cloneCollisionChecker();
+        if (!clone) {
+            SMPL_ERROR_NAMED(G_LOG, "Failed to clone the collision checker for edge validation");
+            return false;
+        }
+        checkers.push_back(clone.get());
+        clones.push_back(std::move(clone));
+    }
+
+    if (!setEdgeValidationCheckers(checkers)) {
         return false;
     }
+    m_edge_checker_clones = std::move(clones);
+    return true;
+}
 
-    // check for collisions along path from parent to first waypoint
-    if (!collisionChecker()->isStateToStateValid(state, action[0])) {
-        SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> path to first waypoint in collision");
-        violation_mask |= 0x00000004;
+/// Check the gathered candidate edges for collisions, in parallel on the edge
+/// validation workers if they are enabled.
+void ManipLattice::validateEdgeActions()
+{
+    m_edge_valid.assign(m_edge_actions.size(), 0);
+
+    if (!m_edge_pool) {
+        for (size_t k = 0; k < m_edge_actions.size(); ++k) {
+            m_edge_valid[k] = checkActionCollisions(
+                    collisionChecker(), *m_edge_sources[k], m_edge_actions[k]);
+        }
+        return;
     }
 
-    if (violation_mask) {
+    m_edge_pool->parallelFor(
+            (int)m_edge_actions.size(),
+            [&](int thread, int k)
+            {
+                m_edge_valid[k] = checkActionCollisions(
+                        m_edge_checkers[thread],
+                        *m_edge_sources[k],
+                        m_edge_actions[k]);
+            });
+}
+
+/// Check the motion from a state through the waypoints of an action for
+/// collisions. Touches no lattice state other than through \p checker, so it
+/// may run on an edge validation worker thread.
+bool ManipLattice::checkActionCollisions(
+    CollisionChecker* checker,
+    const RobotState& state,
+    const ActionView& action) const
+{
+    PhaseTimer timer(PlanningPhase::CollisionCheck);
+
+    // check for collisions along path from parent to first waypoint
+    if (!checker->isStateToStateValid(state, action[0])) {
+        SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> path to first waypoint in collision");
         return false;
     }
 
@@ -645,18 +986,12 @@ bool ManipLattice::checkAction(const RobotState& state, const Action& action)
     for (size_t j = 1; j < action.size(); ++j) {
         auto& prev_istate = action[j - 1];
         auto& curr_istate = action[j];
-        if (!collisionChecker()->isStateToStateValid(prev_istate, curr_istate))
-        {
+        if (!checker->isStateToStateValid(prev_istate, curr_istate)) {
             SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> path between waypoints %zu and %zu in collision", j - 1, j);
-            violation_mask |= 0x00000008;
-            break;
+            return false;
         }
     }
 
-    if (violation_mask) {
-        return false;
-    }
-
     return true;
 }
 
@@ -706,7 +1041,8 @@ auto WithinTolerance(
     return std::make_pair(false, false);
 }
 
-bool ManipLattice::isGoal(const RobotState& state)
+/// \param pose The pose of the planning frame in \p state, if known
+bool ManipLattice::isGoal(const RobotState& state, const Affine3* pose)
 {
     switch (goal().type) {
     case GoalType::JOINT_STATE_GOAL:
@@ -721,10 +1057,10 @@ bool ManipLattice::isGoal(const RobotState& state)
     case GoalType::XYZ_RPY_GOAL:
     {
         // get pose of planning link
-        auto pose = computePlanningFrameFK(state);
+        auto planning_pose = pose ? *pose : computePlanningFrameFK(state);
 
         auto near = WithinTolerance(
-                pose,
+                planning_pose,
                 goal().pose,
                 goal().xyz_tolerance,
                 goal().rpy_tolerance);
@@ -732,10 +1068,10 @@ bool ManipLattice::isGoal(const RobotState& state)
     }
     case GoalType::MULTIPLE_POSE_GOAL:
     {
-        auto pose = computePlanningFrameFK(state);
+        auto planning_pose = pose ? *pose : computePlanningFrameFK(state);
         for (auto& goal_pose : goal().poses) {
             auto near = WithinTolerance(
-                    pose, goal_pose,
+                    planning_pose, goal_pose,
                     goal().xyz_tolerance, goal().rpy_tolerance);
             if (near.first & near.second) {
                 return true;
@@ -745,8 +1081,8 @@ bool ManipLattice::isGoal(const RobotState& state)
     }
     case GoalType::XYZ_GOAL:
     {
-        auto pose = computePlanningFrameFK(state);
-        return WithinPositionTolerance(pose, goal().pose, goal().xyz_tolerance);
+        auto planning_pose = pose ? *pose : computePlanningFrameFK(state);
+        return WithinPositionTolerance(planning_pose, goal().pose, goal().xyz_tolerance);
     }
     case GoalType::USER_GOAL_CONSTRAINT_FN:
     {
@@ -799,6 +1135,19 @@ bool ManipLattice::setStart(const RobotState& state)
         return false;
     }
 
+    if (!m_edge_checker_clones.empty() &&
+        !cloneEdgeValidationCheckers((int)m_edge_checker_clones.size()))
+    {
+        return false;
+    }
+
+    // the first check with a collision checker may update state shared with
+    // other checkers, e.g. the voxels of links outside the planning group in
+    // the occupancy grid, so make it here rather than on the workers
+    for (auto* checker : m_edge_checkers) {
+        checker->isStateValid(state);
+    }
+
     auto* vis_name = "start_config";
     SV_SHOW_INFO_NAMED(vis_name, getStateVisualization(state, vis_name));
 
@@ -865,12 +1214,9 @@ auto ManipLattice::getDiscreteCenter(const RobotState& state) const -> RobotStat
 
 void ManipLattice::clearStates()
 {
-    for (auto& state : m_states) {
-        delete state;
-    }
     m_states.clear();
-    m_state_to_id.clear();
-    m_states.shrink_to_fit();
+    StateID2IndexMapping.clear();
+    beginSuccessors();
 
     m_goal_state_id = reserveHashEntry();
 }
@@ -940,10 +1286,11 @@ bool ManipLattice::extractPath(
         if (curr_id == getGoalStateID()) {
             SMPL_DEBUG_NAMED(G_LOG, "Search for transition to goal state");
 
-            ManipLatticeState* prev_entry = m_states[prev_id];
+            ManipLatticeState* prev_entry = m_states.get(prev_id);
             auto& prev_state = prev_entry->state;
 
-            std::vector<Action> actions;
+            auto& actions = m_action_buffer;
+            actions.clear();
             if (!m_actions->apply(prev_state, actions)) {
                 SMPL_ERROR_NAMED(G_LOG, "Failed to get actions while extracting the path");
                 return false;
@@ -951,10 +1298,10 @@ bool ManipLattice::extractPath(
 
             // find the goal state corresponding to the cheapest valid action
             ManipLatticeState* best_goal_state = nullptr;
-            RobotCoord succ_coord(robot()->jointVariableCount());
+            auto& succ_coord = m_succ_coord;
             int best_cost = std::numeric_limits<int>::max();
             for (size_t aidx = 0; aidx < actions.size(); ++aidx) {
-                auto& action = actions[aidx];
+                auto action = actions[aidx];
 
                 // skip non-goal states
                 if (!isGoal(action.back())) {
@@ -41,6 +41,7 @@
 #include <smpl/console/console.h>
 #include <smpl/graph/manip_lattice.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/planning_stats.h>
 
 namespace smpl {
 
@@ -330,6 +331,22 @@ auto ManipLatticeActionSpace::getStartGoalDistances(const RobotState& state)
 bool ManipLatticeActionSpace::apply(
     const RobotState& parent,
     std::vector<Action>& actions)
+{
+    ActionBuffer buffer;
+    if (!apply(parent, buffer)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        auto action = buffer[i];
+        actions.emplace_back(action.begin(), action.end());
+    }
+    return true;
+}
+
+bool ManipLatticeActionSpace::apply(
+    const RobotState& parent,
+    ActionBuffer& actions)
 {
     double goal_dist, start_dist;
     std::tie(start_dist, goal_dist) = getStartGoalDistances(parent);
@@ -350,7 +367,7 @@ bool ManipLatticeActionSpace::getAction(
     double goal_dist,
     double start_dist,
     const MotionPrimitive& mp,
-    std::vector<Action>& actions)
+    ActionBuffer& actions)
 {
     if (!mprimActive(start_dist, goal_dist, mp.type)) {
         return false;
@@ -363,12 +380,7 @@ bool ManipLatticeActionSpace::getAction(
     case MotionPrimitive::LONG_DISTANCE:  // fall-through
     case MotionPrimitive::SHORT_DISTANCE:
     {
-        Action action;
-        if (!applyMotionPrimitive(parent, mp, action)) {
-            return false;
-        }
-        actions.push_back(std::move(action));
-        return true;
+        return applyMotionPrimitive(parent, mp, actions);
     }
     case MotionPrimitive::SNAP_TO_RPY:
     {
@@ -401,8 +413,8 @@ bool ManipLatticeActionSpace::getAction(
 
         // goal is 7dof; instead of computing IK, use the goal itself as the IK
         // solution
-        Action action = { planningSpace()->goal().angles };
-        actions.push_back(std::move(action));
+        actions.appendWaypoint() = planningSpace()->goal().angles;
+        actions.commitAction();
 
         return true;
     }
@@ -415,18 +427,22 @@ bool ManipLatticeActionSpace::getAction(
 bool ManipLatticeActionSpace::applyMotionPrimitive(
     const RobotState& state,
     const MotionPrimitive& mp,
-    Action& action)
+    ActionBuffer& actions)
 {
-    action = mp.action;
-    for (size_t i = 0; i < action.size(); ++i) {
-        if (action[i].size() != state.size()) {
+    for (size_t i = 0; i < mp.action.size(); ++i) {
+        auto& delta = mp.action[i];
+        if (delta.size() != state.size()) {
+            actions.discardAction();
             return false;
         }
 
-        for (size_t j = 0; j < action[i].size(); ++j) {
-            action[i][j] = action[i][j] + state[j];
+        auto& waypoint = actions.appendWaypoint();
+        waypoint.resize(state.size());
+        for (size_t j = 0; j < delta.size(); ++j) {
+            waypoint[j] = delta[j] + state[j];
         }
     }
+    actions.commitAction();
     return true;
 }
 
@@ -435,31 +451,33 @@ bool ManipLatticeActionSpace::computeIkAction(
     const Affine3& goal,
     double dist_to_goal,
     ik_option::IkOption option,
-    std::vector<Action>& actions)
+    ActionBuffer& actions)
 {
     if (!m_ik_iface) {
         return false;
     }
 
+    PhaseTimer timer(PlanningPhase::InverseKinematics);
+
     if (m_use_multiple_ik_solutions) {
         //get actions for multiple ik solutions
-        std::vector<RobotState> solutions;
-        if (!m_ik_iface->computeIK(goal, state, solutions, option)) {
+        m_ik_solutions.clear();
+        if (!m_ik_iface->computeIK(goal, state, m_ik_solutions, option)) {
             return false;
         }
-        for (auto& solution : solutions) {
-            Action action = { std::move(solution) };
-            actions.push_back(std::move(action));
+        for (auto& solution : m_ik_solutions) {
+            actions.appendWaypoint() = solution;
+            actions.commitAction();
         }
     } else {
         //get single action for single ik solution
-        RobotState ik_sol;
+        auto& ik_sol = actions.appendWaypoint();
+        ik_sol.clear();
         if (!m_ik_iface->computeIK(goal, state, ik_sol)) {
+            actions.discardAction();
             return false;
         }
-
-        Action action = { std::move(ik_sol) };
-        actions.push_back(std::move(action));
+        actions.commitAction();
     }
 
     return true;
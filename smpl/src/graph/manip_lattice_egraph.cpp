@@ -118,7 +118,7 @@ bool ManipLatticeEgraph::extractPath(
         ManipLatticeState* prev_entry = getHashEntry(prev_id);
         const RobotState& prev_state = prev_entry->state;
 
-        std::vector<Action> actions;
+        ActionBuffer actions;
         if (!actionSpace()->apply(prev_state, actions)) {
             SMPL_ERROR_NAMED(G_LOG, "Failed to get actions while extracting the path");
             return false;
@@ -128,7 +128,9 @@ bool ManipLatticeEgraph::extractPath(
         ManipLatticeState* best_state = nullptr;
         RobotCoord succ_coord(robot()->jointVariableCount());
         int best_cost = std::numeric_limits<int>::max();
-        for (const Action& action : actions) {
+        for (size_t aidx = 0; aidx < actions.size(); ++aidx) {
+            auto action = actions[aidx];
+
             // check the validity of this transition
             if (!checkAction(prev_state, action)) {
                 continue;
@@ -260,7 +262,7 @@ bool ManipLatticeEgraph::loadExperienceGraph(const std::string& path)
 
         int entry_id = reserveHashEntry();
         auto* entry = getHashEntry(entry_id);
-        entry->coord = pdp;
+        std::copy(pdp.begin(), pdp.end(), entry->coord);
         entry->state = pp;
 
         // map state id <-> experience graph state
@@ -281,7 +283,7 @@ bool ManipLatticeEgraph::loadExperienceGraph(const std::string& path)
 
                 int entry_id = reserveHashEntry();
                 auto* entry = getHashEntry(entry_id);
-                entry->coord = dp;
+                std::copy(dp.begin(), dp.end(), entry->coord);
                 entry->state = p;
 
                 m_egraph_state_ids.resize(id + 1, -1);
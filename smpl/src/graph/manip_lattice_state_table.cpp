@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <smpl/graph/manip_lattice_state_table.h>
+
+// standard includes
+#include <algorithm>
+#include <assert.h>
+
+// system includes
+#include <boost/functional/hash.hpp>
+
+namespace smpl {
+
+/// Initialize the table for states with \p coord_size discrete coordinates
+/// (and continuous variables) and \p index_size planner indices per state. Any
+/// existing entries are released.
+void ManipLatticeStateTable::init(int coord_size, int index_size)
+{
+    m_coord_size = coord_size;
+    m_index_size = index_size;
+    m_size = 0;
+    m_state_chunks.clear();
+    m_coord_chunks.clear();
+    m_index_chunks.clear();
+    m_slots.clear();
+    m_generation = 1;
+    m_indexed = 0;
+}
+
+/// Remove all entries from the table. Storage is retained for reuse.
+void ManipLatticeStateTable::clear()
+{
+    m_size = 0;
+    m_indexed = 0;
+    if (++m_generation == 0) {
+        // generation counter wrapped around; stale slots could now appear
+        // occupied, so invalidate them explicitly
+        for (auto& slot : m_slots) {
+            slot.generation = 0;
+        }
+        m_generation = 1;
+    }
+}
+
+/// Append a new entry to the table and return its id. The coordinate of the
+/// new entry is zeroed, its continuous state is sized to the coordinate size,
+/// and its planner indices are set to -1. The entry is not indexed by its
+/// coordinate until insert() is called.
+int ManipLatticeStateTable::reserve()
+{
+    if ((m_size >> ChunkShift) == (int)m_state_chunks.size()) {
+        addChunk();
+    }
+
+    auto id = m_size++;
+
+    auto* entry = get(id);
+    std::fill(entry->coord, entry->coord + m_coord_size, 0);
+    if ((int)entry->state.size() != m_coord_size) {
+        entry->state.resize(m_coord_size);
+    }
+
+    auto* inds = indices(id);
+    std::fill(inds, inds + m_index_size, -1);
+
+    return id;
+}
+
+auto ManipLatticeStateTable::get(int id) const -> ManipLatticeState*
+{
+    assert(id >= 0 && id < m_size);
+    return &m_state_chunks[id >> ChunkShift][id & ChunkMask];
+}
+
+/// Return the array of planner indices, of length index_size, for an entry.
+auto ManipLatticeStateTable::indices(int id) -> int*
+{
+    assert(id >= 0 && id < m_size);
+    return m_index_chunks[id >> ChunkShift].get() + (id & ChunkMask) * m_index_size;
+}
+
+/// Return the id of the indexed entry with the given coordinate, or -1 if no
+/// such entry exists.
+int ManipLatticeStateTable::find(const int* coord) const
+{
+    if (m_slots.empty()) {
+        return -1;
+    }
+
+    auto h = hash(coord);
+    auto mask = m_slots.size() - 1;
+    for (auto i = (size_t)h & mask; ; i = (i + 1) & mask) {
+        auto& slot = m_slots[i];
+        if (slot.generation != m_generation) {
+            return -1;
+        }
+        if (slot.hash == h && equal(get(slot.id)->coord, coord)) {
+            return slot.id;
+        }
+    }
+}
+
+/// Index an entry by its current coordinate. The coordinate must not already
+/// be indexed.
+void ManipLatticeStateTable::insert(int id)
+{
+    assert(find(get(id)->coord) == -1);
+
+    // keep the load factor at or below 1/2
+    if (2 * (m_indexed + 1) > (int)m_slots.size()) {
+        growIndex();
+    }
+
+    auto h = hash(get(id)->coord);
+    auto mask = m_slots.size() - 1;
+    auto i = (size_t)h & mask;
+    while (m_slots[i].generation == m_generation) {
+        i = (i + 1) & mask;
+    }
+    m_slots[i].id = id;
+    m_slots[i].hash = h;
+    m_slots[i].generation = m_generation;
+    ++m_indexed;
+}
+
+auto ManipLatticeStateTable::hash(const int* coord) const -> std::uint32_t
+{
+    auto seed = boost::hash_range(coord, coord + m_coord_size);
+    return (std::uint32_t)(seed ^ (seed >> 32));
+}
+
+bool ManipLatticeStateTable::equal(const int* a, const int* b) const
+{
+    return std::equal(a, a + m_coord_size, b);
+}
+
+void ManipLatticeStateTable::addChunk()
+{
+    std::unique_ptr<ManipLatticeState[]> states(new ManipLatticeState[ChunkSize]);
+    std::unique_ptr<int[]> coords(new int[ChunkSize * m_coord_size]);
+    std::unique_ptr<int[]> inds(new int[ChunkSize * m_index_size]);
+    for (int i = 0; i < ChunkSize; ++i) {
+        states[i].coord = coords.get() + i * m_coord_size;
+    }
+    m_state_chunks.push_back(std::move(states));
+    m_coord_chunks.push_back(std::move(coords));
+    m_index_chunks.push_back(std::move(inds));
+}
+
+void ManipLatticeStateTable::growIndex()
+{
+    auto new_size = m_slots.empty() ? (size_t)ChunkSize : 2 * m_slots.size();
+
+    std::vector<Slot> slots(new_size, Slot{ -1, 0, 0 });
+    auto mask = new_size - 1;
+    for (auto& slot : m_slots) {
+        if (slot.generation != m_generation) {
+            continue;
+        }
+        auto i = (size_t)slot.hash & mask;
+        while (slots[i].generation == m_generation) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
+
+    m_slots = std::move(slots);
+}
+
+} // namespace smpl
@@ -139,4 +139,15 @@ int RobotPlanningSpace::GetTrueCost(int parent_id, int child_id)
     return costs[std::distance(succs.begin(), sit)];
 }
 
+void RobotPlanningSpace::GetTrueCosts(
+    const int* parent_ids,
+    const int* child_ids,
+    int count,
+    int* costs)
+{
+    for (int i = 0; i < count; ++i) {
+        costs[i] = GetTrueCost(parent_ids[i], child_ids[i]);
+    }
+}
+
 } // namespace smpl
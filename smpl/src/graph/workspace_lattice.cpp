@@ -32,6 +32,10 @@
 
 #include <smpl/graph/workspace_lattice.h>
 
+// standard includes
+#include <algorithm>
+#include <cmath>
+
 // system includes
 #include <boost/functional/hash.hpp>
 
@@ -42,6 +46,7 @@
 #include <smpl/debug/visualize.h>
 #include <smpl/debug/marker_utils.h>
 #include <smpl/heuristic/robot_heuristic.h>
+#include <smpl/planning_stats.h>
 #include <smpl/graph/workspace_lattice_action_space.h>
 
 auto std::hash<smpl::WorkspaceLatticeState>::operator()(
@@ -168,6 +173,8 @@ bool WorkspaceLattice::setStart(const RobotState& state)
 
     SMPL_DEBUG_STREAM_NAMED(G_LOG, "  coord: " << start_coord);
 
+    validateIKCache(state);
+
     m_start_state_id = getOrCreateState(start_coord, state);
     m_start_entry = getState(m_start_state_id);
 
@@ -333,6 +340,8 @@ void WorkspaceLattice::GetSuccs(
 {
     assert(state_id >= 0 && state_id < m_states.size());
 
+    PhaseTimer timer(PlanningPhase::SuccessorGeneration);
+
     // clear the successor arrays
     succs->clear();
     costs->clear();
@@ -756,6 +765,56 @@ auto WorkspaceLattice::getStateVisualization(
     return markers;
 }
 
+// Find the ik solution for a waypoint of an action. The solver is seeded from
+// the previous waypoint and its branches are tried nearest first. The first
+// branch within the joint limits that moves no variable more than the branch
+// step away from the previous waypoint is taken, so that interpolating between
+// consecutive waypoints stays on the workspace primitive.
+bool WorkspaceLattice::waypointToRobot(
+    const RobotState& prev,
+    const WorkspaceState& waypoint,
+    RobotState& ostate)
+{
+    RobotState seed = prev;
+    // copy over seed angles from the intermediate state
+    for (size_t i = 0; i < freeAngleCount(); ++i) {
+        seed[m_fangle_indices[i]] = waypoint[6 + i];
+    }
+
+    m_ik_solutions.clear();
+    if (!stateWorkspaceToRobotSolutions(waypoint, seed, m_ik_solutions)) {
+        SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "         -> failed to find ik solution");
+        return false;
+    }
+
+    auto same_branch = [&](const RobotState& s) {
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (std::find(begin(m_fangle_indices), end(m_fangle_indices), i) !=
+                end(m_fangle_indices))
+            {
+                continue; // moved by the action itself
+            }
+            auto step = robot()->isContinuous(i) ?
+                    std::fabs(angles::shortest_angle_dist(s[i], prev[i])) :
+                    std::fabs(s[i] - prev[i]);
+            if (step > m_ik_branch_step) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (auto& solution : m_ik_solutions) {
+        if (robot()->checkJointLimits(solution) && same_branch(solution)) {
+            ostate = std::move(solution);
+            return true;
+        }
+    }
+
+    SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "        -> no ik solution within joint limits on the branch of the previous waypoint");
+    return false;
+}
+
 bool WorkspaceLattice::checkAction(
     const RobotState& state,
     const WorkspaceAction& action,
@@ -770,29 +829,20 @@ bool WorkspaceLattice::checkAction(
 
         SMPL_DEBUG_STREAM_NAMED(G_SUCCESSORS_LOG, "        " << widx << ": " << waypoint);
 
-        RobotState seed = state;
-        // copy over seed angles from the intermediate state
-        for (int i = 0; i < this->freeAngleCount(); ++i) {
-            seed[this->m_fangle_indices[i]] = waypoint[6 + i];
-        }
-
-        RobotState irstate;
-        if (!stateWorkspaceToRobot(waypoint, seed, irstate)) {
-            SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "         -> failed to find ik solution");
-            return false;
-        }
-
-        if (!robot()->checkJointLimits(irstate)) {
-            SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "        -> violates joint limits");
+        RobotState wpstate;
+        auto& prev = widx == 0 ? state : wptraj.back();
+        if (!waypointToRobot(prev, waypoint, wpstate)) {
             return false;
         }
 
-        wptraj.push_back(std::move(irstate));
+        wptraj.push_back(std::move(wpstate));
     }
 
     // check for collisions between the waypoints
     assert(wptraj.size() == action.size());
 
+    PhaseTimer timer(PlanningPhase::CollisionCheck);
+
     if (!collisionChecker()->isStateToStateValid(state, wptraj[0])) {
         SMPL_DEBUG_NAMED(G_SUCCESSORS_LOG, "        -> path to first waypoint in collision");
         return false;
@@ -829,27 +879,22 @@ bool WorkspaceLattice::checkLazyAction(
     std::vector<RobotState> wptraj;
     wptraj.reserve(action.size());
 
-    // check waypoints for ik solutions and joint limits
+    // check waypoints for ik solutions and joint limits, choosing the same
+    // solutions as checkAction()
     for (size_t widx = 0; widx < action.size(); ++widx) {
         auto& istate = action[widx];
 
         SMPL_DEBUG_STREAM_NAMED(G_EXPANSIONS_LOG, "        " << widx << ": " << istate);
 
         RobotState irstate;
-        if (!stateWorkspaceToRobot(istate, state, irstate)) {
-            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "         -> failed to find ik solution");
+        auto& prev = widx == 0 ? state : wptraj.back();
+        if (!waypointToRobot(prev, istate, irstate)) {
             return false;
         }
 
-        wptraj.push_back(irstate);
-
-        if (!robot()->checkJointLimits(irstate)) {
-            SMPL_DEBUG_NAMED(G_EXPANSIONS_LOG, "        -> violates joint limits");
-            return false;
-        }
+        wptraj.push_back(std::move(irstate));
     }
 
-    // check for collisions between the waypoints
     assert(wptraj.size() == action.size());
 
     if (final_rstate) {
@@ -31,13 +31,28 @@
 
 #include <smpl/graph/workspace_lattice_base.h>
 
+// standard includes
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
 // project includes
 #include <smpl/angles.h>
 #include <smpl/console/console.h>
+#include <smpl/planning_stats.h>
 #include <smpl/spatial.h>
 
 namespace smpl {
 
+double WorkspaceLatticeBase::IKCacheStats::hitRate() const
+{
+    auto lookups = hits + failure_hits + misses;
+    if (lookups == 0) {
+        return 0.0;
+    }
+    return (double)(hits + failure_hits) / (double)lookups;
+}
+
 bool WorkspaceLatticeBase::init(
     RobotModel* _robot,
     CollisionChecker* checker,
@@ -139,6 +154,14 @@ bool WorkspaceLatticeBase::init(
         SMPL_DEBUG_NAMED(G_LOG, "  J%d: { res: %f, count: %d }", i, m_res[6 + i], m_val_count[6 + i]);
     }
 
+    m_ik_cache_size = (std::size_t)std::max(0, _params.ik_cache_size);
+    m_ik_cache_seed_res = _params.ik_cache_seed_res;
+    clearIKCache();
+    SMPL_DEBUG_NAMED(G_LOG, "ik cache: { size: %zu, seed res: %f }", m_ik_cache_size, m_ik_cache_seed_res);
+
+    m_ik_branch_step = _params.ik_branch_step;
+    SMPL_DEBUG_NAMED(G_LOG, "ik branch step: %f", m_ik_branch_step);
+
     return true;
 }
 
@@ -174,6 +197,15 @@ void WorkspaceLatticeBase::stateRobotToCoord(
     stateWorkspaceToCoord(ws_state, coord);
 }
 
+static
+auto MakeWorkspacePose(const WorkspaceState& state) -> Affine3
+{
+    return Translation3(state[0], state[1], state[2]) *
+            AngleAxis(state[5], Vector3::UnitZ()) *
+            AngleAxis(state[4], Vector3::UnitY()) *
+            AngleAxis(state[3], Vector3::UnitX());
+}
+
 bool WorkspaceLatticeBase::stateWorkspaceToRobot(
     const WorkspaceState& state,
     RobotState& ostate) const
@@ -183,13 +215,7 @@ bool WorkspaceLatticeBase::stateWorkspaceToRobot(
         seed[m_fangle_indices[fai]] = state[6 + fai];
     }
 
-    Affine3 pose =
-            Translation3(state[0], state[1], state[2]) *
-            AngleAxis(state[5], Vector3::UnitZ()) *
-            AngleAxis(state[4], Vector3::UnitY()) *
-            AngleAxis(state[3], Vector3::UnitX());
-
-    return m_rm_iface->computeFastIK(pose, seed, ostate);
+    return stateWorkspaceToRobot(state, seed, ostate);
 }
 
 void WorkspaceLatticeBase::stateWorkspaceToCoord(
@@ -224,14 +250,184 @@ bool WorkspaceLatticeBase::stateWorkspaceToRobot(
     const RobotState& seed,
     RobotState& ostate) const
 {
-    Affine3 pose =
-            Translation3(state[0], state[1], state[2]) *
-            AngleAxis(state[5], Vector3::UnitZ()) *
-            AngleAxis(state[4], Vector3::UnitY()) *
-            AngleAxis(state[3], Vector3::UnitX());
+    PhaseTimer timer(PlanningPhase::InverseKinematics);
+
+    const IKCacheEntry* entry;
+    if (lookupIK(state, seed, false, &entry)) {
+        if (entry->solutions.empty()) {
+            return false;
+        }
+        ostate = entry->solutions.front();
+        return true;
+    }
+
+    Affine3 pose = MakeWorkspacePose(state);
 
     // TODO: unrestricted variant?
-    return m_rm_iface->computeFastIK(pose, seed, ostate);
+    auto found = m_rm_iface->computeFastIK(pose, seed, ostate);
+    insertIK(&ostate, found ? 1 : 0, false);
+    return found;
+}
+
+bool WorkspaceLatticeBase::stateWorkspaceToRobotSolutions(
+    const WorkspaceState& state,
+    const RobotState& seed,
+    std::vector<RobotState>& osolutions) const
+{
+    PhaseTimer timer(PlanningPhase::InverseKinematics);
+
+    const IKCacheEntry* entry;
+    if (lookupIK(state, seed, true, &entry)) {
+        osolutions.insert(end(osolutions), begin(entry->solutions), end(entry->solutions));
+        return !entry->solutions.empty();
+    }
+
+    Affine3 pose = MakeWorkspacePose(state);
+
+    auto first = osolutions.size();
+    auto found = m_rm_iface->computeFastIKBatch(pose, &seed, 1, osolutions);
+    insertIK(osolutions.data() + first, (int)(osolutions.size() - first), true);
+    return found;
+}
+
+void WorkspaceLatticeBase::clearIKCache()
+{
+    if (!m_ik_cache.empty()) {
+        SMPL_DEBUG_NAMED(G_LOG, "Clear %zu ik cache entries", m_ik_cache.size());
+    }
+    m_ik_cache.clear();
+    m_ik_cache_index.clear();
+    m_ik_cache_ref_state.clear();
+}
+
+void WorkspaceLatticeBase::validateIKCache(const RobotState& state)
+{
+    if (m_ik_cache_size == 0) {
+        return;
+    }
+
+    SMPL_DEBUG_NAMED(G_LOG, "ik cache: { entries: %zu, hits: %zu, failure hits: %zu, misses: %zu, bypasses: %zu, evictions: %zu, hit rate: %f }",
+            m_ik_cache.size(),
+            m_ik_cache_stats.hits,
+            m_ik_cache_stats.failure_hits,
+            m_ik_cache_stats.misses,
+            m_ik_cache_stats.bypasses,
+            m_ik_cache_stats.evictions,
+            m_ik_cache_stats.hitRate());
+
+    // the cached solutions are only valid while the pose of the kinematic
+    // chain in the planning frame is unchanged
+    if (!m_ik_cache_ref_state.empty() &&
+        m_fk_iface->computeFK(m_ik_cache_ref_state).isApprox(m_ik_cache_ref_pose, 1e-9))
+    {
+        return;
+    }
+
+    clearIKCache();
+    m_ik_cache_ref_state = state;
+    m_ik_cache_ref_pose = m_fk_iface->computeFK(state);
+}
+
+bool WorkspaceLatticeBase::lookupIK(
+    const WorkspaceState& state,
+    const RobotState& seed,
+    bool all_branches,
+    const IKCacheEntry** entry) const
+{
+    m_ik_cache_key.clear();
+    if (m_ik_cache_size == 0) {
+        return false;
+    }
+
+    // only states at the center of their cell share the pose of the cell
+    stateWorkspaceToCoord(state, m_ik_cache_coord);
+    stateCoordToWorkspace(m_ik_cache_coord, m_ik_cache_center);
+    auto eps = 1e-6;
+    for (int i = 0; i < m_dof_count; ++i) {
+        auto angular = (i >= 3 && i < 6) || (i >= 6 && m_fangle_continuous[i - 6]);
+        auto dist = angular ?
+                angles::shortest_angle_dist(state[i], m_ik_cache_center[i]) :
+                std::fabs(state[i] - m_ik_cache_center[i]);
+        if (dist > eps) {
+            ++m_ik_cache_stats.bypasses;
+            return false;
+        }
+    }
+
+    // the solver holds the redundant variables at the seed, so the solutions
+    // only belong to the cell if the seed agrees with the state
+    for (size_t i = 0; i < freeAngleCount(); ++i) {
+        auto fa = seed[m_fangle_indices[i]];
+        auto dist = m_fangle_continuous[i] ?
+                angles::shortest_angle_dist(fa, state[6 + i]) :
+                std::fabs(fa - state[6 + i]);
+        if (dist > eps) {
+            ++m_ik_cache_stats.bypasses;
+            return false;
+        }
+    }
+
+    m_ik_cache_key.assign(begin(m_ik_cache_coord), end(m_ik_cache_coord));
+    if (m_ik_cache_seed_res > 0.0) {
+        for (size_t i = 0; i < seed.size(); ++i) {
+            if (std::find(begin(m_fangle_indices), end(m_fangle_indices), i) !=
+                end(m_fangle_indices))
+            {
+                continue; // equal to the state and part of the coordinate
+            }
+            auto pos = robot()->isContinuous(i) ?
+                    angles::normalize_angle(seed[i]) : seed[i];
+            m_ik_cache_key.push_back((int)std::floor(pos / m_ik_cache_seed_res));
+        }
+    }
+
+    auto it = m_ik_cache_index.find(m_ik_cache_key);
+    if (it == end(m_ik_cache_index) ||
+        (all_branches && !it->second->all_branches))
+    {
+        ++m_ik_cache_stats.misses;
+        return false;
+    }
+
+    m_ik_cache.splice(begin(m_ik_cache), m_ik_cache, it->second);
+    if (it->second->solutions.empty()) {
+        ++m_ik_cache_stats.failure_hits;
+    } else {
+        ++m_ik_cache_stats.hits;
+    }
+    *entry = &*it->second;
+    return true;
+}
+
+void WorkspaceLatticeBase::insertIK(
+    const RobotState* solutions,
+    int count,
+    bool all_branches) const
+{
+    if (m_ik_cache_key.empty()) {
+        return;
+    }
+
+    auto it = m_ik_cache_index.find(m_ik_cache_key);
+    if (it != end(m_ik_cache_index)) {
+        // upgrade an entry that holds only the nearest solution
+        m_ik_cache.splice(begin(m_ik_cache), m_ik_cache, it->second);
+    } else {
+        if (m_ik_cache.size() >= m_ik_cache_size) {
+            // recycle the least recently used entry
+            m_ik_cache_index.erase(m_ik_cache.back().key);
+            m_ik_cache.splice(begin(m_ik_cache), m_ik_cache, std::prev(end(m_ik_cache)));
+            ++m_ik_cache_stats.evictions;
+        } else {
+            m_ik_cache.emplace_front();
+        }
+        m_ik_cache.front().key = m_ik_cache_key;
+        m_ik_cache_index.emplace(m_ik_cache_key, begin(m_ik_cache));
+    }
+
+    auto& entry = m_ik_cache.front();
+    entry.solutions.assign(solutions, solutions + count);
+    entry.all_branches = all_branches;
 }
 
 void WorkspaceLatticeBase::posWorkspaceToCoord(const double* wp, int* gp) const
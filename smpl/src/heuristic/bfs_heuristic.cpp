@@ -36,6 +36,7 @@
 #include <smpl/console/console.h>
 #include <smpl/debug/marker_utils.h>
 #include <smpl/debug/colors.h>
+#include <smpl/heuristic/bfs_util.h>
 #include <smpl/grid/grid.h>
 #include <smpl/heap/intrusive_heap.h>
 
@@ -45,7 +46,9 @@ static const char* LOG = "heuristic.bfs";
 
 BfsHeuristic::~BfsHeuristic()
 {
-    // empty to allow forward declaration of BFS_3D
+    if (m_grid != NULL) {
+        m_grid->eraseObserver(this);
+    }
 }
 
 bool BfsHeuristic::init(RobotPlanningSpace* space, const OccupancyGrid* grid)
@@ -58,7 +61,11 @@ bool BfsHeuristic::init(RobotPlanningSpace* space, const OccupancyGrid* grid)
         return false;
     }
 
+    if (m_grid != NULL && m_grid != grid) {
+        m_grid->eraseObserver(this);
+    }
     m_grid = grid;
+    m_grid->insertObserver(this);
 
     m_pp = space->getExtension<PointProjectionExtension>();
     if (m_pp != NULL) {
@@ -79,8 +86,37 @@ void BfsHeuristic::setCostPerCell(int cost_per_cell)
     m_cost_per_cell = cost_per_cell;
 }
 
+/// Set the number of threads used to compute the BFS. More than one thread
+/// runs a level-synchronous parallel search.
+void BfsHeuristic::setThreadCount(int num_threads)
+{
+    m_thread_count = num_threads;
+    if (m_bfs) {
+        m_bfs->setThreadCount(num_threads);
+    }
+}
+
+/// Compute heuristic values on demand, with a search from the goal cells
+/// directed toward the start state, rather than running the full BFS when the
+/// goal is updated. This lets the planner begin expanding states immediately
+/// and limits the BFS to the region around the states it actually evaluates.
+void BfsHeuristic::setLazy(bool lazy)
+{
+    m_lazy = lazy;
+    if (m_bfs) {
+        m_bfs->setLazy(lazy);
+    }
+}
+
+void BfsHeuristic::updateStart(const RobotState& state)
+{
+    updateBfsFocus();
+}
+
 void BfsHeuristic::updateGoal(const GoalConstraint& goal)
 {
+    m_goal_cells.clear();
+
     switch (goal.type) {
     case GoalType::XYZ_GOAL:
     case GoalType::XYZ_RPY_GOAL:
@@ -141,6 +177,8 @@ void BfsHeuristic::updateGoal(const GoalConstraint& goal)
         SMPL_ERROR("Unsupported goal type in BFS Heuristic");
         break;
     }
+
+    updateBfsFocus();
 }
 
 double BfsHeuristic::getMetricStartDistance(double x, double y, double z)
@@ -222,6 +260,32 @@ int BfsHeuristic::GetFromToHeuristic(int from_id, int to_id)
     }
 }
 
+/// Repair the walls and distances of the bfs in the neighborhood of the
+/// changed obstacles, rather than rebuilding it from the entire grid.
+void BfsHeuristic::updateOccupancy(
+    const OccupancyGrid& grid,
+    const std::vector<Vector3>& added,
+    const std::vector<Vector3>& removed)
+{
+    if (!m_bfs) {
+        return;
+    }
+
+    std::vector<int> walls;
+    std::vector<int> frees;
+    GetChangedWalls(grid, *m_bfs, m_inflation_radius, added, walls, frees);
+    GetChangedWalls(grid, *m_bfs, m_inflation_radius, removed, walls, frees);
+
+    SMPL_DEBUG_NAMED(LOG, "Update %zu walls and %zu free cells in the bfs heuristic", walls.size() / 3, frees.size() / 3);
+    m_bfs->updateWalls(walls, frees);
+}
+
+void BfsHeuristic::resetOccupancy(const OccupancyGrid& grid)
+{
+    syncGridAndBfs();
+    runBfs();
+}
+
 auto BfsHeuristic::getWallsVisualization() const -> visual::Marker
 {
     std::vector<Vector3> centers;
@@ -390,7 +454,17 @@ void BfsHeuristic::syncGridAndBfs()
     const int yc = grid()->numCellsY();
     const int zc = grid()->numCellsZ();
 //    SMPL_DEBUG_NAMED(LOG, "Initializing BFS of size %d x %d x %d = %d", xc, yc, zc, xc * yc * zc);
-    m_bfs.reset(new BFS_3D(xc, yc, zc));
+    int bx, by, bz;
+    if (m_bfs) {
+        m_bfs->getDimensions(&bx, &by, &bz);
+    }
+    if (m_bfs && bx == xc && by == yc && bz == zc) {
+        m_bfs->clearWalls();
+    } else {
+        m_bfs.reset(new BFS_3D(xc, yc, zc));
+        m_bfs->setThreadCount(m_thread_count);
+        m_bfs->setLazy(m_lazy);
+    }
     const int cell_count = xc * yc * zc;
     int wall_count = 0;
     for (int x = 0; x < xc; ++x) {
@@ -408,6 +482,45 @@ void BfsHeuristic::syncGridAndBfs()
     SMPL_DEBUG_NAMED(LOG, "%d/%d (%0.3f%%) walls in the bfs heuristic", wall_count, cell_count, 100.0 * (double)wall_count / cell_count);
 }
 
+// Rerun the bfs from the current goal cells, if any
+void BfsHeuristic::runBfs()
+{
+    if (m_goal_cells.empty()) {
+        return;
+    }
+
+    std::vector<int> cell_coords;
+    for (auto& cell : m_goal_cells) {
+        cell_coords.push_back(cell.x);
+        cell_coords.push_back(cell.y);
+        cell_coords.push_back(cell.z);
+    }
+    m_bfs->run(begin(cell_coords), end(cell_coords));
+}
+
+// Direct a lazy bfs toward the cell of the start state, near which the
+// planner will query heuristic values first
+void BfsHeuristic::updateBfsFocus()
+{
+    if (!m_lazy || m_pp == NULL) {
+        return;
+    }
+
+    int start_id = planningSpace()->getStartStateID();
+    if (start_id < 0) {
+        return;
+    }
+
+    Vector3 p;
+    if (!m_pp->projectToPoint(start_id, p)) {
+        return;
+    }
+
+    int sx, sy, sz;
+    grid()->worldToGrid(p.x(), p.y(), p.z(), sx, sy, sz);
+    m_bfs->setFocus(sx, sy, sz);
+}
+
 int BfsHeuristic::getBfsCostToGoal(const BFS_3D& bfs, int x, int y, int z) const
 {
     if (!bfs.inBounds(x, y, z)) {
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2016, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+/// \author Andrew Dornbush
+
+#include <smpl/heuristic/bfs_util.h>
+
+// standard includes
+#include <cmath>
+
+// project includes
+#include <smpl/bfs3d/bfs3d.h>
+#include <smpl/occupancy_grid.h>
+
+namespace smpl {
+
+void GetChangedWalls(
+    const OccupancyGrid& grid,
+    const BFS_3D& bfs,
+    double radius,
+    const std::vector<Vector3>& points,
+    std::vector<int>& walls,
+    std::vector<int>& frees)
+{
+    const int r = (int)std::ceil(radius / grid.resolution());
+    for (auto& p : points) {
+        int gx, gy, gz;
+        grid.worldToGrid(p.x(), p.y(), p.z(), gx, gy, gz);
+        for (int x = gx - r; x <= gx + r; ++x) {
+        for (int y = gy - r; y <= gy + r; ++y) {
+        for (int z = gz - r; z <= gz + r; ++z) {
+            if (!bfs.inBounds(x, y, z)) {
+                continue;
+            }
+            const bool wall = grid.getDistance(x, y, z) <= radius;
+            if (wall != bfs.isWall(x, y, z)) {
+                auto& cells = wall ? walls : frees;
+                cells.push_back(x);
+                cells.push_back(y);
+                cells.push_back(z);
+            }
+        }
+        }
+        }
+    }
+}
+
+} // namespace smpl
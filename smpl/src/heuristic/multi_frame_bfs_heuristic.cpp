@@ -36,6 +36,7 @@
 #include <smpl/console/console.h>
 #include <smpl/debug/marker_utils.h>
 #include <smpl/debug/colors.h>
+#include <smpl/heuristic/bfs_util.h>
 
 namespace smpl {
 
@@ -43,7 +44,9 @@ static const char* LOG = "heuristic.mfbfs";
 
 MultiFrameBfsHeuristic::~MultiFrameBfsHeuristic()
 {
-    // empty to allow forward declaration of BFS_3D
+    if (m_grid) {
+        m_grid->eraseObserver(this);
+    }
 }
 
 bool MultiFrameBfsHeuristic::init(
@@ -60,7 +63,11 @@ bool MultiFrameBfsHeuristic::init(
 
     m_pos_offset[0] = m_pos_offset[1] = m_pos_offset[2] = 0.0;
 
+    if (m_grid && m_grid != grid) {
+        m_grid->eraseObserver(this);
+    }
     m_grid = grid;
+    m_grid->insertObserver(this);
 
     m_pp = space->getExtension<PointProjectionExtension>();
     if (m_pp) {
@@ -96,6 +103,19 @@ void MultiFrameBfsHeuristic::setCostPerCell(int cost)
     m_cost_per_cell = cost;
 }
 
+/// Set the number of threads used to compute each BFS. More than one thread
+/// runs a level-synchronous parallel search.
+void MultiFrameBfsHeuristic::setThreadCount(int num_threads)
+{
+    m_thread_count = num_threads;
+    if (m_bfs) {
+        m_bfs->setThreadCount(num_threads);
+    }
+    if (m_ee_bfs) {
+        m_ee_bfs->setThreadCount(num_threads);
+    }
+}
+
 Extension* MultiFrameBfsHeuristic::getExtension(size_t class_code)
 {
     if (class_code == GetClassCode<RobotHeuristic>()) {
@@ -135,10 +155,49 @@ void MultiFrameBfsHeuristic::updateGoal(const GoalConstraint& goal)
         return;
     }
 
+    m_goal_cell[0] = ogx;
+    m_goal_cell[1] = ogy;
+    m_goal_cell[2] = ogz;
+    m_ee_goal_cell[0] = plgx;
+    m_ee_goal_cell[1] = plgy;
+    m_ee_goal_cell[2] = plgz;
+    m_has_goal = true;
+
     m_bfs->run(ogx, ogy, ogz);
     m_ee_bfs->run(plgx, plgy, plgz);
 }
 
+void MultiFrameBfsHeuristic::updateOccupancy(
+    const OccupancyGrid& grid,
+    const std::vector<Vector3>& added,
+    const std::vector<Vector3>& removed)
+{
+    if (!m_bfs || !m_ee_bfs) {
+        return;
+    }
+
+    // the start cells differ between the searches, so the cells that need
+    // updating may too
+    std::vector<int> walls;
+    std::vector<int> frees;
+    for (BFS_3D* bfs : { m_bfs.get(), m_ee_bfs.get() }) {
+        walls.clear();
+        frees.clear();
+        GetChangedWalls(grid, *bfs, m_inflation_radius, added, walls, frees);
+        GetChangedWalls(grid, *bfs, m_inflation_radius, removed, walls, frees);
+        bfs->updateWalls(walls, frees);
+    }
+}
+
+void MultiFrameBfsHeuristic::resetOccupancy(const OccupancyGrid& grid)
+{
+    syncGridAndBfs();
+    if (m_has_goal) {
+        m_bfs->run(m_goal_cell[0], m_goal_cell[1], m_goal_cell[2]);
+        m_ee_bfs->run(m_ee_goal_cell[0], m_ee_goal_cell[1], m_ee_goal_cell[2]);
+    }
+}
+
 double MultiFrameBfsHeuristic::getMetricStartDistance(double x, double y, double z)
 {
     // TODO: shamefully copied from BfsHeuristic
@@ -338,8 +397,19 @@ void MultiFrameBfsHeuristic::syncGridAndBfs()
     const int xc = grid()->numCellsX();
     const int yc = grid()->numCellsY();
     const int zc = grid()->numCellsZ();
-    m_bfs.reset(new BFS_3D(xc, yc, zc));
-    m_ee_bfs.reset(new BFS_3D(xc, yc, zc));
+    int bx, by, bz;
+    if (m_bfs) {
+        m_bfs->getDimensions(&bx, &by, &bz);
+    }
+    if (m_bfs && m_ee_bfs && bx == xc && by == yc && bz == zc) {
+        m_bfs->clearWalls();
+        m_ee_bfs->clearWalls();
+    } else {
+        m_bfs.reset(new BFS_3D(xc, yc, zc));
+        m_ee_bfs.reset(new BFS_3D(xc, yc, zc));
+        m_bfs->setThreadCount(m_thread_count);
+        m_ee_bfs->setThreadCount(m_thread_count);
+    }
     const int cell_count = xc * yc * zc;
     int wall_count = 0;
     for (int z = 0; z < zc; ++z) {
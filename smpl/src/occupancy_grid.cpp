@@ -33,12 +33,14 @@
 #include <smpl/occupancy_grid.h>
 
 // standard includes
+#include <cstring>
 #include <memory>
 
 // project includes
 #include <smpl/debug/marker_utils.h>
 #include <smpl/debug/colors.h>
 #include <smpl/distance_map/euclid_distance_map.h>
+#include <smpl/snapshot.h>
 
 namespace smpl {
 
@@ -67,6 +69,21 @@ namespace smpl {
 /// An arbitrary distance map implementation may be used with this class. If
 /// none is specified, by calling the verbose constructor, an instance of
 /// smpl::EuclidDistanceMap is constructed.
+///
+/// Objects that derive state from the obstacles in the grid, such as the BFS
+/// heuristics, may register as an OccupancyGridObserver to be notified of the
+/// obstacles added and removed by the modifiers of this class, rather than
+/// recomputing that state from scratch. Changes made directly to the
+/// underlying distance map are not reported.
+///
+/// Several grids may share a common, immutable distance map, such as that of
+/// the static environment, by constructing each over its own
+/// smpl::OverlayDistanceMap of the shared map. Copies of such a grid also share
+/// the map, and each grid only allocates storage around the obstacles it adds.
+
+OccupancyGridObserver::~OccupancyGridObserver()
+{
+}
 
 OccupancyGrid::OccupancyGrid()
 {
@@ -109,7 +126,7 @@ OccupancyGrid::OccupancyGrid(
 {
     // distance field guaranteed to be empty -> faster initialization
     if (m_ref_counted) {
-        m_counts.assign(getCellCount(), 0);
+        m_counts = std::make_shared<std::vector<int>>(getCellCount(), 0);
     }
 }
 
@@ -131,8 +148,9 @@ OccupancyGrid::OccupancyGrid(
     initRefCounts();
 }
 
-/// Copy constructor. Constructs the Occupancy Grid with a deep copy of the
-/// contents of \p o.
+/// Copy constructor. Constructs the Occupancy Grid with a clone of the
+/// distance map of \p o. The reference counts are shared with \p o until
+/// either grid is modified.
 OccupancyGrid::OccupancyGrid(const OccupancyGrid& o) :
     m_grid(o.m_grid->clone()),
     reference_frame_(o.reference_frame_),
@@ -152,6 +170,8 @@ OccupancyGrid& OccupancyGrid::operator=(const OccupancyGrid& rhs)
         m_x_stride = rhs.m_x_stride;
         m_y_stride = rhs.m_y_stride;
         m_counts = rhs.m_counts;
+        ++m_version;
+        notifyOccupancyReset();
     }
     return *this;
 }
@@ -162,8 +182,94 @@ void OccupancyGrid::reset()
 {
     m_grid->reset();
     if (m_ref_counted) {
-        m_counts.assign(getCellCount(), 0);
+        m_counts = std::make_shared<std::vector<int>>(getCellCount(), 0);
+    }
+    ++m_version;
+    notifyOccupancyReset();
+}
+
+/// Add the contents of the grid, including its distance map, to a snapshot.
+/// Return false if the distance map does not support snapshots.
+bool OccupancyGrid::saveSnapshot(SnapshotWriter& writer) const
+{
+    if (!m_grid->saveSnapshot(writer)) {
+        return false;
+    }
+
+    writer.addSection(
+            SnapshotTag('F', 'R', 'A', 'M'),
+            reference_frame_.data(),
+            reference_frame_.size());
+
+    if (m_ref_counted) {
+        writer.addSection(
+                SnapshotTag('R', 'C', 'N', 'T'),
+                m_counts->data(),
+                m_counts->size() * sizeof(int));
+    }
+
+    return true;
+}
+
+/// Replace the contents of the grid, including its distance map, with those
+/// from a snapshot. If the grid is reference counted and the snapshot was saved
+/// from a grid that was not, every obstacle cell is given a count of one.
+bool OccupancyGrid::loadSnapshot(const SnapshotReader& reader)
+{
+    size_t counts_size;
+    auto* counts = reader.section(SnapshotTag('R', 'C', 'N', 'T'), &counts_size);
+    if (counts && counts_size != getCellCount() * sizeof(int)) {
+        return false;
+    }
+
+    if (!m_grid->loadSnapshot(reader)) {
+        return false;
+    }
+
+    size_t frame_size;
+    auto* frame = reader.section(SnapshotTag('F', 'R', 'A', 'M'), &frame_size);
+    if (frame) {
+        reference_frame_.assign((const char*)frame, frame_size);
+    }
+
+    if (m_ref_counted && counts) {
+        m_counts = std::make_shared<std::vector<int>>(getCellCount());
+        std::memcpy(m_counts->data(), counts, counts_size);
+    } else {
+        initRefCounts();
+    }
+
+    ++m_version;
+    notifyOccupancyReset();
+    return true;
+}
+
+/// Register an observer to be notified of changes to the obstacles in the
+/// grid. The observer must be erased before it is destroyed.
+bool OccupancyGrid::insertObserver(OccupancyGridObserver* o) const
+{
+    auto it = std::find(m_observers.begin(), m_observers.end(), o);
+    if (it != m_observers.end()) {
+        return false;
     }
+    m_observers.push_back(o);
+    return true;
+}
+
+bool OccupancyGrid::eraseObserver(const OccupancyGridObserver* o) const
+{
+    auto it = std::remove(m_observers.begin(), m_observers.end(), o);
+    if (it == m_observers.end()) {
+        return false;
+    }
+    m_observers.erase(it, m_observers.end());
+    return true;
+}
+
+bool OccupancyGrid::hasObserver(const OccupancyGridObserver* o) const
+{
+    auto it = std::find(m_observers.begin(), m_observers.end(), o);
+    return it != m_observers.end();
 }
 
 /// Count the number of obstacles in the occupancy grid.
@@ -362,6 +468,7 @@ void OccupancyGrid::addPointsToField(
     const std::vector<Vector3>& points)
 {
     if (m_ref_counted) {
+        std::vector<int>& counts = mutableCounts();
         std::vector<Vector3> pts;
         pts.reserve(points.size());
         int gx, gy, gz;
@@ -371,17 +478,19 @@ void OccupancyGrid::addPointsToField(
             if (isInBounds(gx, gy, gz)) {
                 const int idx = coordToIndex(gx, gy, gz);
 
-                if (m_counts[idx] == 0) {
+                if (counts[idx] == 0) {
                     pts.emplace_back(v.x(), v.y(), v.z());
                 }
 
-                ++m_counts[idx];
+                ++counts[idx];
             }
         }
         m_grid->addPointsToMap(pts);
+        notifyOccupancyUpdate(pts, std::vector<Vector3>());
     }
     else {
         m_grid->addPointsToMap(points);
+        notifyOccupancyUpdate(points, std::vector<Vector3>());
     }
 }
 
@@ -390,6 +499,7 @@ void OccupancyGrid::removePointsFromField(
     const std::vector<Vector3>& points)
 {
     if (m_ref_counted) {
+        std::vector<int>& counts = mutableCounts();
         std::vector<Vector3> pts;
         pts.reserve(points.size());
         int gx, gy, gz;
@@ -399,18 +509,20 @@ void OccupancyGrid::removePointsFromField(
             if (isInBounds(gx, gy, gz)) {
                 int idx = coordToIndex(gx, gy, gz);
 
-                if (m_counts[idx] > 0) {
-                    --m_counts[idx];
-                    if (m_counts[idx] == 0) {
+                if (counts[idx] > 0) {
+                    --counts[idx];
+                    if (counts[idx] == 0) {
                         pts.emplace_back(v.x(), v.y(), v.z());
                     }
                 }
             }
         }
         m_grid->removePointsFromMap(pts);
+        notifyOccupancyUpdate(std::vector<Vector3>(), pts);
     }
     else {
         m_grid->removePointsFromMap(points);
+        notifyOccupancyUpdate(std::vector<Vector3>(), points);
     }
 }
 
@@ -423,28 +535,60 @@ void OccupancyGrid::updatePointsInField(
 {
     // TODO: ref counting
     m_grid->updatePointsInMap(old_points, new_points);
+    notifyOccupancyUpdate(new_points, old_points);
+}
+
+void OccupancyGrid::notifyOccupancyUpdate(
+    const std::vector<Vector3>& added,
+    const std::vector<Vector3>& removed)
+{
+    if (added.empty() && removed.empty()) {
+        return;
+    }
+    ++m_version;
+    for (auto* o : m_observers) {
+        o->updateOccupancy(*this, added, removed);
+    }
+}
+
+void OccupancyGrid::notifyOccupancyReset()
+{
+    for (auto* o : m_observers) {
+        o->resetOccupancy(*this);
+    }
 }
 
 void OccupancyGrid::initRefCounts()
 {
     if (!m_ref_counted) {
-        m_counts.clear();
+        m_counts.reset();
         return;
     }
 
     int gidx = 0;
-    m_counts.resize(getCellCount());
+    m_counts = std::make_shared<std::vector<int>>(getCellCount());
+    std::vector<int>& counts = *m_counts;
     iterateCells([&](int x, int y, int z)
     {
         if (m_grid->getCellDistance(x, y, z) <= 0.0) {
-            m_counts[gidx++] = 1;
+            counts[gidx++] = 1;
         }
         else {
-            m_counts[gidx++] = 0;
+            counts[gidx++] = 0;
         }
     });
 }
 
+// Return the reference counts for modification, first copying them if they are
+// shared with copies of the grid
+auto OccupancyGrid::mutableCounts() -> std::vector<int>&
+{
+    if (m_counts.use_count() > 1) {
+        m_counts = std::make_shared<std::vector<int>>(*m_counts);
+    }
+    return *m_counts;
+}
+
 template <typename CellFunction>
 void OccupancyGrid::iterateCells(CellFunction f) const
 {
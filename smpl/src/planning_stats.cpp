@@ -0,0 +1,196 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <smpl/planning_stats.h>
+
+// standard includes
+#include <algorithm>
+#include <limits>
+
+namespace smpl {
+
+// each thread records into its own active statistics so that concurrent
+// planning requests do not share samples
+static thread_local PlanningStats* g_active_stats = nullptr;
+
+auto to_string(PlanningPhase phase) -> std::string
+{
+    switch (phase) {
+    case PlanningPhase::SetGoal:
+        return "set goal";
+    case PlanningPhase::SetStart:
+        return "set start";
+    case PlanningPhase::HeuristicUpdate:
+        return "heuristic update";
+    case PlanningPhase::Search:
+        return "search";
+    case PlanningPhase::Expansion:
+        return "expansion";
+    case PlanningPhase::SuccessorGeneration:
+        return "successor generation";
+    case PlanningPhase::CollisionCheck:
+        return "collision check";
+    case PlanningPhase::InverseKinematics:
+        return "inverse kinematics";
+    case PlanningPhase::PostProcessing:
+        return "post processing";
+    case PlanningPhase::Shortcut:
+        return "shortcut";
+    default:
+        return "unrecognized phase";
+    }
+}
+
+PhaseStats::PhaseStats()
+{
+    reset();
+}
+
+void PhaseStats::add(clock::duration d)
+{
+    auto ns = (std::int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    ns = std::max(ns, std::int64_t(0));
+
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total_ns.fetch_add(ns, std::memory_order_relaxed);
+
+    auto lo = m_min_ns.load(std::memory_order_relaxed);
+    while (ns < lo && !m_min_ns.compare_exchange_weak(lo, ns, std::memory_order_relaxed));
+    auto hi = m_max_ns.load(std::memory_order_relaxed);
+    while (ns > hi && !m_max_ns.compare_exchange_weak(hi, ns, std::memory_order_relaxed));
+
+    int bucket = ns > 1 ? 63 - __builtin_clzll((unsigned long long)ns) : 0;
+    bucket = std::min(bucket, BucketCount - 1);
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PhaseStats::reset()
+{
+    m_count = 0;
+    m_total_ns = 0;
+    m_min_ns = std::numeric_limits<std::int64_t>::max();
+    m_max_ns = 0;
+    for (auto& bucket : m_buckets) {
+        bucket = 0;
+    }
+}
+
+auto PhaseStats::count() const -> std::int64_t
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+double PhaseStats::totalTime() const
+{
+    return 1e-9 * (double)m_total_ns.load(std::memory_order_relaxed);
+}
+
+double PhaseStats::meanTime() const
+{
+    auto n = count();
+    return n > 0 ? totalTime() / (double)n : 0.0;
+}
+
+double PhaseStats::minTime() const
+{
+    return count() > 0 ? 1e-9 * (double)m_min_ns.load(std::memory_order_relaxed) : 0.0;
+}
+
+double PhaseStats::maxTime() const
+{
+    return 1e-9 * (double)m_max_ns.load(std::memory_order_relaxed);
+}
+
+double PhaseStats::percentile(double p) const
+{
+    std::int64_t counts[BucketCount];
+    std::int64_t n = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        n += counts[i];
+    }
+    if (n == 0) {
+        return 0.0;
+    }
+
+    p = std::min(std::max(p, 0.0), 1.0);
+    const double rank = p * (double)n;
+
+    double seen = 0.0;
+    for (int i = 0; i < BucketCount; ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        if (seen + (double)counts[i] >= rank) {
+            const double lo = i == 0 ? 0.0 : (double)(std::int64_t(1) << i);
+            const double hi = (double)(std::int64_t(1) << (i + 1));
+            const double alpha = (rank - seen) / (double)counts[i];
+            const double ns = lo + alpha * (hi - lo);
+            return std::min(std::max(1e-9 * ns, minTime()), maxTime());
+        }
+        seen += (double)counts[i];
+    }
+    return maxTime();
+}
+
+void PlanningStats::reset()
+{
+    for (auto& phase : m_phases) {
+        phase.reset();
+    }
+}
+
+void PlanningStats::getStats(std::map<std::string, double>& stats) const
+{
+    for (int i = 0; i < (int)PlanningPhase::Count; ++i) {
+        auto& phase = m_phases[i];
+        if (phase.count() == 0) {
+            continue;
+        }
+        auto name = to_string((PlanningPhase)i);
+        stats[name + " count"] = (double)phase.count();
+        stats[name + " total time"] = phase.totalTime();
+        stats[name + " mean time"] = phase.meanTime();
+        stats[name + " p50 time"] = phase.percentile(0.5);
+        stats[name + " p99 time"] = phase.percentile(0.99);
+        stats[name + " max time"] = phase.maxTime();
+    }
+}
+
+void SetActivePlanningStats(PlanningStats* stats)
+{
+    g_active_stats = stats;
+}
+
+auto GetActivePlanningStats() -> PlanningStats*
+{
+    return g_active_stats;
+}
+
+} // namespace smpl
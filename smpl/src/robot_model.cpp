@@ -80,8 +80,45 @@ ForwardKinematicsInterface::~ForwardKinematicsInterface()
 {
 }
 
+void ForwardKinematicsInterface::computeFKBatch(
+    const double* positions,
+    int count,
+    int stride,
+    Affine3* poses)
+{
+    auto state = RobotState(jointVariableCount());
+    for (int i = 0; i < count; ++i) {
+        for (size_t v = 0; v < state.size(); ++v) {
+            state[v] = positions[v * stride + i];
+        }
+        poses[i] = computeFK(state);
+    }
+}
+
 InverseKinematicsInterface::~InverseKinematicsInterface()
 {
 }
 
+bool RedundantManipulatorInterface::computeFastIKBatch(
+    const Affine3& pose,
+    const RobotState* seeds,
+    int count,
+    std::vector<RobotState>& solutions,
+    std::vector<int>* seed_indices)
+{
+    auto found = false;
+    for (int i = 0; i < count; ++i) {
+        solutions.emplace_back();
+        if (computeFastIK(pose, seeds[i], solutions.back())) {
+            if (seed_indices != nullptr) {
+                seed_indices->push_back(i);
+            }
+            found = true;
+        } else {
+            solutions.pop_back();
+        }
+    }
+    return found;
+}
+
 } // namespace smpl
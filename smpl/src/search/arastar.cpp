@@ -39,6 +39,7 @@
 // project includes
 #include <smpl/time.h>
 #include <smpl/console/console.h>
+#include <smpl/planning_stats.h>
 
 namespace smpl {
 
@@ -64,7 +65,6 @@ ARAStar::ARAStar(
     m_incons(),
     m_curr_eps(1.0),
     m_iteration(1),
-    m_call_number(0),
     m_last_start_state_id(-1),
     m_last_goal_state_id(-1),
     m_last_eps(1.0),
@@ -87,11 +87,6 @@ ARAStar::ARAStar(
 
 ARAStar::~ARAStar()
 {
-    for (SearchState* s : m_states) {
-        if (s != NULL) {
-            delete s;
-        }
-    }
 }
 
 enum ReplanResultCode
@@ -125,11 +120,12 @@ int ARAStar::replan(
     SearchState* start_state = getSearchState(m_start_state_id);
     SearchState* goal_state = getSearchState(m_goal_state_id);
 
-    if (m_start_state_id != m_last_start_state_id) {
+    bool reinitialized = m_start_state_id != m_last_start_state_id;
+    if (reinitialized) {
         SMPL_DEBUG_NAMED(SLOG, "Reinitialize search");
         m_open.clear();
         m_incons.clear();
-        ++m_call_number; // trigger state reinitializations
+        m_states.nextGeneration(); // trigger state reinitializations
 
         reinitSearchState(start_state);
         reinitSearchState(goal_state);
@@ -155,8 +151,12 @@ int ARAStar::replan(
 
     if (m_goal_state_id != m_last_goal_state_id) {
         SMPL_DEBUG_NAMED(SLOG, "Refresh heuristics, keys, and reorder open list");
-        recomputeHeuristics();
-        reorderOpen();
+        // a fresh search has only computed heuristics for the start and goal
+        // states, when they were reinitialized
+        if (!reinitialized) {
+            recomputeHeuristics();
+            reorderOpen();
+        }
 
         m_last_goal_state_id = m_goal_state_id;
     }
@@ -289,13 +289,7 @@ int ARAStar::force_planning_from_scratch_and_free_memory()
 {
     force_planning_from_scratch();
     m_open.clear();
-    for (SearchState* s : m_states) {
-        if (s != NULL) {
-            delete s;
-        }
-    }
     m_states.clear();
-    m_states.shrink_to_fit();
     return 0;
 }
 
@@ -394,14 +388,15 @@ void ARAStar::costs_changed(const StateChangeQuery& changes)
     force_planning_from_scratch();
 }
 
-// Recompute heuristics for all states.
+// Recompute heuristics for all states in the current search. Stale states
+// recompute their heuristic when they are reinitialized.
 void ARAStar::recomputeHeuristics()
 {
-    for (SearchState* s : m_states) {
-        if (s != NULL) {
-            s->h = m_heur->GetGoalHeuristic(s->state_id);
+    m_states.forEach([&](SearchState& s) {
+        if (m_states.current(&s)) {
+            s.h = m_heur->GetGoalHeuristic(s.state_id);
         }
-    }
+    });
 }
 
 // Convert TimeParameters to ReplanParams. Uses the current epsilon values
@@ -525,6 +520,8 @@ int ARAStar::improvePath(
 // and INCONS list appropriately.
 void ARAStar::expand(SearchState* s)
 {
+    PhaseTimer timer(PlanningPhase::Expansion);
+
     m_succs.clear();
     m_costs.clear();
     m_space->GetSuccs(s->state_id, &m_succs, &m_costs);
@@ -575,41 +572,20 @@ int ARAStar::computeKey(SearchState* s) const
 // one has not been created yet.
 ARAStar::SearchState* ARAStar::getSearchState(int state_id)
 {
-    if (m_states.size() <= state_id) {
-        m_states.resize(state_id + 1, nullptr);
-    }
-
-    auto& state = m_states[state_id];
-    if (state == NULL) {
-        state = createState(state_id);
-    }
-
-    return state;
-}
-
-// Create a new search state for a graph state.
-ARAStar::SearchState* ARAStar::createState(int state_id)
-{
-    assert(state_id < m_states.size());
-
-    SearchState* ss = new SearchState;
-    ss->state_id = state_id;
-    ss->call_number = 0;
-
-    return ss;
+    return m_states.get(state_id);
 }
 
 // Lazily (re)initialize a search state.
 void ARAStar::reinitSearchState(SearchState* state)
 {
-    if (state->call_number != m_call_number) {
+    if (!m_states.current(state)) {
         SMPL_DEBUG_NAMED(SELOG, "Reinitialize state %d", state->state_id);
         state->g = INFINITECOST;
         state->h = m_heur->GetGoalHeuristic(state->state_id);
         state->f = INFINITECOST;
         state->eg = INFINITECOST;
         state->iteration_closed = 0;
-        state->call_number = m_call_number;
+        state->generation = m_states.generation();
         state->bp = nullptr;
         state->incons = false;
     }
@@ -57,9 +57,6 @@ AWAStar::AWAStar(DiscreteSpaceInformation* space, Heuristic* heur)
 
 AWAStar::~AWAStar()
 {
-    for (SearchState* s : m_states) {
-        delete s;
-    }
 }
 
 enum ReplanResultCode
@@ -98,7 +95,7 @@ int AWAStar::replan(
         SMPL_DEBUG_NAMED(SLOG, "Begin new search");
         m_open.clear();
         m_window_size = 0;
-        m_call_number++;
+        m_states.nextGeneration();
 
         reinitSearchState(start_state);
         reinitSearchState(goal_state);
@@ -290,6 +287,12 @@ int AWAStar::replan(std::vector<int>* solution, ReplanParams params, int* cost)
 /// and free all memory allocated by the planner during previous searches.
 int AWAStar::force_planning_from_scratch_and_free_memory()
 {
+    // begin a new search on the next call to replan()
+    m_last_start_id = -1;
+    m_last_goal_id = -1;
+    m_open.clear();
+    m_suspended.clear();
+    m_states.clear();
     return 0;
 }
 
@@ -376,32 +379,20 @@ int AWAStar::computeKey(SearchState* s) const
 // one has not been created yet.
 AWAStar::SearchState* AWAStar::getSearchState(int state_id)
 {
-    if (state_id >= m_states.size()) {
-        auto prev_cap = m_states.capacity();
-        m_states.resize(state_id + 1, nullptr);
-        auto cap = m_states.capacity();
-    }
-
-    if (m_states[state_id] == nullptr) {
-        m_states[state_id] = new SearchState;
-        m_states[state_id]->call_number = 0;
-        m_states[state_id]->state_id = state_id;
-    }
-
-    return m_states[state_id];
+    return m_states.get(state_id);
 }
 
 // Lazily (re)initialize a search state.
 void AWAStar::reinitSearchState(SearchState* state)
 {
-    if (state->call_number != m_call_number) {
+    if (!m_states.current(state)) {
 //        SMPL_DEBUG_NAMED(SELOG, "Reinitialize state %d", state->state_id);
         state->g = INFINITECOST;
         state->h = m_heur->GetGoalHeuristic(state->state_id);
         state->f = INFINITECOST;
         state->flags = 0;
         state->level = -1;
-        state->call_number = m_call_number;
+        state->generation = m_states.generation();
         state->bp = nullptr;
     }
 }
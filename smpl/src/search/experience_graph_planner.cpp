@@ -26,9 +26,7 @@ ExperienceGraphPlanner::ExperienceGraphPlanner(
     m_states(),
     m_start_state(nullptr),
     m_goal_state(nullptr),
-    m_graph_to_search_map(),
     m_open(),
-    m_call_number(0),
     m_eps(5.0),
     m_expand_count(0)
 {
@@ -47,9 +45,6 @@ ExperienceGraphPlanner::ExperienceGraphPlanner(
 
 ExperienceGraphPlanner::~ExperienceGraphPlanner()
 {
-    for (SearchState* s : m_states) {
-        delete s;
-    }
 }
 
 int ExperienceGraphPlanner::replan(
@@ -65,7 +60,7 @@ int ExperienceGraphPlanner::replan(
     std::vector<int>* solution,
     int* cost)
 {
-    ++m_call_number;
+    m_states.nextGeneration();
     m_expand_count = 0;
 
     SMPL_INFO_NAMED(LOG, "Find path to goal");
@@ -241,6 +236,15 @@ int ExperienceGraphPlanner::replan(
 
 int ExperienceGraphPlanner::force_planning_from_scratch_and_free_memory()
 {
+    auto start_id = m_start_state != nullptr ? m_start_state->state_id : -1;
+    auto goal_id = m_goal_state != nullptr ? m_goal_state->state_id : -1;
+
+    m_open.clear();
+    m_states.clear();
+
+    // look up the start and goal states again in the new storage
+    m_start_state = start_id >= 0 ? getSearchState(start_id) : nullptr;
+    m_goal_state = goal_id >= 0 ? getSearchState(goal_id) : nullptr;
     return 0;
 }
 
@@ -318,40 +322,18 @@ void ExperienceGraphPlanner::costs_changed(const StateChangeQuery& state_change)
 
 auto ExperienceGraphPlanner::getSearchState(int state_id) -> SearchState*
 {
-    if (m_graph_to_search_map.size() <= state_id) {
-        m_graph_to_search_map.resize(state_id + 1, -1);
-    }
-
-    if (m_graph_to_search_map[state_id] == -1) {
-        return createState(state_id);
-    } else {
-        return m_states[m_graph_to_search_map[state_id]];
-    }
-}
-
-auto ExperienceGraphPlanner::createState(int state_id) -> SearchState*
-{
-    assert(state_id < m_graph_to_search_map.size());
-
-    m_graph_to_search_map[state_id] = (int)m_states.size();
-
-    SearchState* ss = new SearchState;
-    ss->state_id = state_id;
-    ss->call_number = 0;
-    m_states.push_back(ss);
-
-    return ss;
+    return m_states.get(state_id);
 }
 
 void ExperienceGraphPlanner::reinitSearchState(SearchState* state)
 {
-    if (state->call_number != m_call_number) {
+    if (!m_states.current(state)) {
         SMPL_DEBUG_NAMED(LOG, "Reinitialize state %d", state->state_id);
         state->g = std::numeric_limits<int32_t>::max();
         state->h = m_heur->GetGoalHeuristic(state->state_id);
         state->f = std::numeric_limits<int64_t>::max();
         state->iteration_closed = 0;
-        state->call_number = m_call_number;
+        state->generation = m_states.generation();
         state->bp = nullptr;
     }
 }
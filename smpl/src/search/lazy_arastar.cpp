@@ -1,6 +1,7 @@
 #include <smpl/search/lazy_arastar.h>
 
 #include <smpl/console/console.h>
+#include <smpl/planning_stats.h>
 
 namespace smpl {
 
@@ -68,9 +69,12 @@ static bool IsPredDominated(const CandidatePred& cand, State* state) {
 }
 
 static void ExpandState(LazyARAStar& search, State* state) {
+    PhaseTimer timer(PlanningPhase::Expansion);
+
     SMPL_DEBUG_NAMED(LOG, "Expand state %d", state->graph_state);
 
     state->closed = true;
+    ++search.expand_count_;
 
     state->ebp = state->bp;
     state->eg = state->g;
@@ -132,12 +136,12 @@ static void ExpandState(LazyARAStar& search, State* state) {
     }
 }
 
-static void EvaluateState(LazyARAStar& search, State* s) {
-    assert(!s->true_cost);
-    assert(!s->closed);
-    assert(!s->cands.empty());
-    assert(!search.open_.contains(s));
+static int ComputeFVal(const LazyARAStar& search, const State& s);
 
+// Update a state's candidate predecessors with the true cost of the edge from
+// its best candidate predecessor
+static void UpdateEvaluatedState(LazyARAStar& search, State* s, int32_t cost)
+{
     // get the best candidate
     auto& cands = s->cands;
     auto better_cand = [&](const CandidatePred& a, const CandidatePred& b) {
@@ -147,11 +151,6 @@ static void EvaluateState(LazyARAStar& search, State* s) {
 
     assert(!best_it->true_cost);
 
-    SMPL_DEBUG_NAMED(LOG, "Evaluate transitions %d -> %d", s->bp->graph_state, s->graph_state);
-
-    int32_t cost = search.succ_fun_->GetSuccTrueCost(
-            s->bp->graph_state, s->graph_state);
-
     // remove invalid or now-dominated candidate preds
     if (cost < 0) {
         cands.erase(best_it);
@@ -163,20 +162,69 @@ static void EvaluateState(LazyARAStar& search, State* s) {
         }
     }
 
-    best_it = std::min_element(begin(cands), end(cands), better_cand);
-    s->bp = best_it->pred;
-    s->g = best_it->g;
-    s->true_cost = best_it->true_cost;
-
     // OPTIMIZATION if this element is the best, remove all elements except this
     // one from the lazy list. Also, we can probably also remove this element
     // and maintain the s's (bp,g,true) as the current best candidate
 
+    best_it = std::min_element(begin(cands), end(cands), better_cand);
     if (best_it != end(cands)) {
+        s->bp = best_it->pred;
+        s->g = best_it->g;
+        s->true_cost = best_it->true_cost;
         search.open_.push(s);
     }
 }
 
+// Evaluate the edge from the best candidate predecessor of a state, along with
+// those of up to eval_batch_size_ - 1 further unevaluated states at the top of
+// OPEN, in a single call to GetSuccTrueCosts
+static void EvaluateStates(LazyARAStar& search, State* s) {
+    assert(!s->true_cost);
+    assert(!s->closed);
+    assert(!s->cands.empty());
+    assert(!search.open_.contains(s));
+
+    auto& states = search.eval_states_;
+    states.clear();
+    states.push_back(s);
+    while ((int)states.size() < search.eval_batch_size_ &&
+        !search.open_.empty())
+    {
+        State* next = search.open_.min();
+        if (next->closed || next->true_cost) {
+            break;
+        }
+        // stop short of states that would not be evaluated before the search
+        // terminates
+        if (search.goal_state_->true_cost &&
+            ComputeFVal(search, *search.goal_state_) <= ComputeFVal(search, *next))
+        {
+            break;
+        }
+        search.open_.pop();
+        states.push_back(next);
+    }
+
+    search.eval_preds_.clear();
+    search.eval_succs_.clear();
+    for (State* state : states) {
+        SMPL_DEBUG_NAMED(LOG, "Evaluate transitions %d -> %d", state->bp->graph_state, state->graph_state);
+        search.eval_preds_.push_back(state->bp->graph_state);
+        search.eval_succs_.push_back(state->graph_state);
+    }
+
+    search.eval_costs_.resize(states.size());
+    search.succ_fun_->GetSuccTrueCosts(
+            search.eval_preds_.data(),
+            search.eval_succs_.data(),
+            (int)states.size(),
+            search.eval_costs_.data());
+
+    for (size_t i = 0; i < states.size(); ++i) {
+        UpdateEvaluatedState(search, states[i], search.eval_costs_[i]);
+    }
+}
+
 static void ReconstructPath(
     const LazyARAStar& search,
     std::vector<int>& path,
@@ -236,6 +284,7 @@ int Replan(
     // TODO: lazily initialize search for new/old start state ids
     Clear(search);
     search.call_number_++;
+    search.expand_count_ = 0;
 
     search.start_state_ = GetState(search, start_id);
     search.goal_state_ = GetState(search, goal_id);
@@ -269,13 +318,20 @@ int Replan(
         if (min_state->true_cost) {
             ExpandState(search, min_state);
         } else {
-            EvaluateState(search, min_state);
+            EvaluateStates(search, min_state);
         }
     }
 
     return 1;
 }
 
+/// Set the maximum number of lazy edges, at the top of OPEN, that are
+/// evaluated together in a single call to ILazySuccFun::GetSuccTrueCosts.
+void SetEvalBatchSize(LazyARAStar& search, int batch_size)
+{
+    search.eval_batch_size_ = std::max(batch_size, 1);
+}
+
 bool LazyARAStar::StateCompare::operator()(
     const State& s1,
     const State& s2) const
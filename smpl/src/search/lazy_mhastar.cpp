@@ -1,6 +1,7 @@
 #include <smpl/search/lazy_mhastar.h>
 
 #include <smpl/console/console.h>
+#include <smpl/planning_stats.h>
 
 namespace smpl {
 
@@ -132,6 +133,8 @@ static void InsertOrUpdateInOpenList(
 
 static void ExpandState(LazySMHAStar& search, State* state, size_t hidx)
 {
+    PhaseTimer timer(PlanningPhase::Expansion);
+
     SMPL_DEBUG_NAMED(LOG, "Expand state %d", state->graph_state);
 
     assert(!state->closed_in_add || !state->closed_in_anc);
@@ -45,6 +45,7 @@
 #include <smpl/time.h>
 #include <smpl/console/console.h>
 #include <smpl/console/nonstd.h>
+#include <smpl/planning_stats.h>
 
 namespace smpl {
 
@@ -570,6 +571,8 @@ void MetaMHAstarDTS::update_meta_method(int hidx)
 
 void MetaMHAstarDTS::expand(MHASearchState* state, int hidx)
 {
+    PhaseTimer timer(PlanningPhase::Expansion);
+
     SMPL_INFO("Expanding state %d in search %d", state->state_id, hidx);
 
     assert(!closed_in_add_search(state) || !closed_in_anc_search(state));
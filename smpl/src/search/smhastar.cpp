@@ -41,6 +41,7 @@
 
 #include <smpl/console/console.h>
 #include <smpl/time.h>
+#include <smpl/planning_stats.h>
 
 namespace smpl {
 
@@ -506,6 +507,8 @@ int SMHAStar::compute_key(SMHAState* state, int hidx)
 
 void SMHAStar::expand(SMHAState* state, int hidx)
 {
+    PhaseTimer timer(PlanningPhase::Expansion);
+
     SMPL_DEBUG_NAMED(LOG, "Expanding state %d in search %d", state->state_id, hidx);
 
     assert(!closed_in_add_search(state) || !closed_in_anc_search(state));
@@ -0,0 +1,403 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <smpl/snapshot.h>
+
+// standard includes
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// system includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// project includes
+#include <smpl/console/console.h>
+#include <smpl/distance_map/distance_map_interface.h>
+#include <smpl/occupancy_grid.h>
+
+namespace smpl {
+
+static const char* LOG = "snapshot";
+
+static const char SNAPSHOT_MAGIC[8] = { 'S', 'M', 'P', 'L', 'S', 'N', 'A', 'P' };
+
+// written in the byte order of the host to detect snapshots from hosts with a
+// different byte order
+static const std::uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+static const std::size_t SNAPSHOT_ALIGNMENT = 64;
+
+static const std::uint32_t INFO_TAG = SnapshotTag('I', 'N', 'F', 'O');
+
+struct FileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t section_count;
+};
+
+struct SectionEntry
+{
+    std::uint32_t tag;
+    std::uint32_t reserved;
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+struct DistanceMapInfo
+{
+    std::uint32_t type;
+    std::int32_t num_cells[3];
+    double origin[3];
+    double resolution;
+    double max_dist;
+};
+
+static auto AlignOffset(std::uint64_t offset) -> std::uint64_t
+{
+    return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(std::uint64_t)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+void SnapshotWriter::addSection(
+    std::uint32_t tag,
+    const void* data,
+    std::size_t size)
+{
+    m_sections.push_back(Section{ tag, data, size });
+}
+
+auto SnapshotWriter::allocateSection(std::uint32_t tag, std::size_t size)
+    -> void*
+{
+    m_buffers.emplace_back(new char[size]());
+    addSection(tag, m_buffers.back().get(), size);
+    return m_buffers.back().get();
+}
+
+bool SnapshotWriter::hasSection(std::uint32_t tag) const
+{
+    for (auto& s : m_sections) {
+        if (s.tag == tag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Write the snapshot to a file. The snapshot is written to a temporary file
+/// that then replaces any existing file at \p path, so that processes that
+/// have the existing file mapped continue to see its old contents.
+bool SnapshotWriter::write(const std::string& path) const
+{
+    FileHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.section_count = m_sections.size();
+
+    std::vector<SectionEntry> entries(m_sections.size());
+    std::uint64_t offset = sizeof(header) + entries.size() * sizeof(SectionEntry);
+    for (size_t i = 0; i < m_sections.size(); ++i) {
+        offset = AlignOffset(offset);
+        entries[i].tag = m_sections[i].tag;
+        entries[i].reserved = 0;
+        entries[i].offset = offset;
+        entries[i].size = m_sections[i].size;
+        offset += m_sections[i].size;
+    }
+
+    const std::string tmp_path = path + ".tmp";
+    std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open()) {
+        SMPL_ERROR_NAMED(LOG, "Failed to open '%s' for writing", tmp_path.c_str());
+        return false;
+    }
+
+    ofs.write((const char*)&header, sizeof(header));
+    ofs.write((const char*)entries.data(), entries.size() * sizeof(SectionEntry));
+
+    const char padding[SNAPSHOT_ALIGNMENT] = { };
+    std::uint64_t pos = sizeof(header) + entries.size() * sizeof(SectionEntry);
+    for (size_t i = 0; i < m_sections.size(); ++i) {
+        ofs.write(padding, entries[i].offset - pos);
+        ofs.write((const char*)m_sections[i].data, m_sections[i].size);
+        pos = entries[i].offset + entries[i].size;
+    }
+
+    ofs.close();
+    if (!ofs) {
+        SMPL_ERROR_NAMED(LOG, "Failed to write snapshot to '%s'", tmp_path.c_str());
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to move snapshot to '%s'", path.c_str());
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+SnapshotReader::SnapshotReader() :
+    m_map(nullptr),
+    m_map_size(0),
+    m_sections()
+{
+}
+
+SnapshotReader::~SnapshotReader()
+{
+    close();
+}
+
+/// Map a snapshot file into memory and read its table of sections. Return
+/// false if the file can not be mapped or is not a snapshot of the current
+/// version written on a host with the same byte order.
+bool SnapshotReader::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        SMPL_ERROR_NAMED(LOG, "Failed to open snapshot '%s'", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (std::size_t)st.st_size < sizeof(FileHeader)) {
+        SMPL_ERROR_NAMED(LOG, "Snapshot '%s' is truncated", path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference to the file
+    if (map == MAP_FAILED) {
+        SMPL_ERROR_NAMED(LOG, "Failed to map snapshot '%s'", path.c_str());
+        return false;
+    }
+
+    m_map = map;
+    m_map_size = st.st_size;
+
+    FileHeader header;
+    std::memcpy(&header, m_map, sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        SMPL_ERROR_NAMED(LOG, "'%s' is not a snapshot", path.c_str());
+        close();
+        return false;
+    }
+    if (header.byte_order != SNAPSHOT_BYTE_ORDER) {
+        SMPL_ERROR_NAMED(LOG, "Snapshot '%s' was written with a different byte order", path.c_str());
+        close();
+        return false;
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        SMPL_ERROR_NAMED(LOG, "Snapshot '%s' has version %u (expected %u)", path.c_str(), header.version, SNAPSHOT_VERSION);
+        close();
+        return false;
+    }
+
+    const std::uint64_t table_end =
+            sizeof(header) + header.section_count * sizeof(SectionEntry);
+    if (header.section_count > m_map_size / sizeof(SectionEntry) ||
+        table_end > m_map_size)
+    {
+        SMPL_ERROR_NAMED(LOG, "Snapshot '%s' is truncated", path.c_str());
+        close();
+        return false;
+    }
+
+    const char* base = (const char*)m_map;
+    for (std::uint64_t i = 0; i < header.section_count; ++i) {
+        SectionEntry entry;
+        std::memcpy(
+                &entry,
+                base + sizeof(header) + i * sizeof(SectionEntry),
+                sizeof(entry));
+        if (entry.offset < table_end ||
+            entry.offset > m_map_size ||
+            entry.size > m_map_size - entry.offset)
+        {
+            SMPL_ERROR_NAMED(LOG, "Snapshot '%s' is truncated", path.c_str());
+            close();
+            return false;
+        }
+        m_sections.push_back(Section{ entry.tag, base + entry.offset, entry.size });
+    }
+
+    return true;
+}
+
+void SnapshotReader::close()
+{
+    if (m_map) {
+        munmap(m_map, m_map_size);
+        m_map = nullptr;
+        m_map_size = 0;
+    }
+    m_sections.clear();
+}
+
+bool SnapshotReader::isOpen() const
+{
+    return m_map != nullptr;
+}
+
+auto SnapshotReader::section(std::uint32_t tag, std::size_t* size) const
+    -> const void*
+{
+    for (auto& s : m_sections) {
+        if (s.tag == tag) {
+            if (size) {
+                *size = s.size;
+            }
+            return s.data;
+        }
+    }
+    if (size) {
+        *size = 0;
+    }
+    return nullptr;
+}
+
+void SaveDistanceMapInfo(
+    SnapshotWriter& writer,
+    const DistanceMapInterface& dmap,
+    std::uint32_t type,
+    double max_dist)
+{
+    auto* info = (DistanceMapInfo*)writer.allocateSection(
+            INFO_TAG, sizeof(DistanceMapInfo));
+    info->type = type;
+    info->num_cells[0] = dmap.numCellsX();
+    info->num_cells[1] = dmap.numCellsY();
+    info->num_cells[2] = dmap.numCellsZ();
+    info->origin[0] = dmap.originX();
+    info->origin[1] = dmap.originY();
+    info->origin[2] = dmap.originZ();
+    info->resolution = dmap.resolution();
+    info->max_dist = max_dist;
+}
+
+/// Test whether a snapshot was saved from a distance map with the same type,
+/// layout, and maximum distance as \p dmap.
+bool LoadDistanceMapInfo(
+    const SnapshotReader& reader,
+    const DistanceMapInterface& dmap,
+    std::uint32_t type,
+    double max_dist)
+{
+    std::size_t size;
+    auto* data = reader.section(INFO_TAG, &size);
+    if (!data || size != sizeof(DistanceMapInfo)) {
+        SMPL_ERROR_NAMED(LOG, "Snapshot does not contain a distance map");
+        return false;
+    }
+
+    DistanceMapInfo info;
+    std::memcpy(&info, data, sizeof(info));
+
+    if (info.type != type) {
+        SMPL_ERROR_NAMED(LOG, "Snapshot contains a different type of distance map");
+        return false;
+    }
+
+    const double eps = 1e-9;
+    if (info.num_cells[0] != dmap.numCellsX() ||
+        info.num_cells[1] != dmap.numCellsY() ||
+        info.num_cells[2] != dmap.numCellsZ() ||
+        std::fabs(info.origin[0] - dmap.originX()) > eps ||
+        std::fabs(info.origin[1] - dmap.originY()) > eps ||
+        std::fabs(info.origin[2] - dmap.originZ()) > eps ||
+        std::fabs(info.resolution - dmap.resolution()) > eps ||
+        std::fabs(info.max_dist - max_dist) > eps)
+    {
+        SMPL_ERROR_NAMED(LOG, "Snapshot contains a distance map with a different layout");
+        return false;
+    }
+
+    return true;
+}
+
+/// Save the contents of a distance map to a snapshot file.
+bool SaveSnapshot(const DistanceMapInterface& dmap, const std::string& path)
+{
+    SnapshotWriter writer;
+    if (!dmap.saveSnapshot(writer)) {
+        SMPL_ERROR_NAMED(LOG, "Distance map does not support snapshots");
+        return false;
+    }
+    return writer.write(path);
+}
+
+/// Replace the contents of a distance map with those from a snapshot file. The
+/// distance map must have the same type, layout, and maximum distance as the
+/// map from which the snapshot was saved. The map is left unmodified if the
+/// snapshot can not be loaded.
+bool LoadSnapshot(DistanceMapInterface& dmap, const std::string& path)
+{
+    SnapshotReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    return dmap.loadSnapshot(reader);
+}
+
+/// Save the contents of an occupancy grid, and its distance map, to a snapshot
+/// file.
+bool SaveSnapshot(const OccupancyGrid& grid, const std::string& path)
+{
+    SnapshotWriter writer;
+    if (!grid.saveSnapshot(writer)) {
+        return false;
+    }
+    return writer.write(path);
+}
+
+/// Replace the contents of an occupancy grid, and its distance map, with those
+/// from a snapshot file.
+bool LoadSnapshot(OccupancyGrid& grid, const std::string& path)
+{
+    SnapshotReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    return grid.loadSnapshot(reader);
+}
+
+} // namespace smpl
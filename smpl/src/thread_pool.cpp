@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <smpl/thread_pool.h>
+
+// project includes
+#include <smpl/planning_stats.h>
+
+namespace smpl {
+
+ThreadPool::ThreadPool(int num_threads) : m_next(0)
+{
+    for (int i = 0; i < num_threads; ++i) {
+        m_threads.emplace_back([this, i]() { work(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_work_cv.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+/// Call body(thread, index) for every index in [0, count) and wait for all
+/// calls to return. With no worker threads, the loop runs on the calling
+/// thread as worker 0.
+void ThreadPool::parallelFor(int count, const LoopBody& body)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    if (m_threads.empty()) {
+        for (int i = 0; i < count; ++i) {
+            body(0, i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_body = &body;
+        m_stats = GetActivePlanningStats();
+        m_count = count;
+        m_next = 0;
+        m_active = size();
+        ++m_epoch;
+    }
+    m_work_cv.notify_all();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cv.wait(lock, [&]() { return m_active == 0; });
+    m_body = nullptr;
+    m_stats = nullptr;
+}
+
+void ThreadPool::work(int thread)
+{
+    unsigned epoch = 0;
+    for (;;) {
+        const LoopBody* body;
+        PlanningStats* stats;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_cv.wait(lock, [&]() { return m_stop || m_epoch != epoch; });
+            if (m_stop) {
+                return;
+            }
+            epoch = m_epoch;
+            body = m_body;
+            stats = m_stats;
+            count = m_count;
+        }
+
+        {
+            ScopedActivePlanningStats active_stats(stats);
+            for (int i = m_next++; i < count; i = m_next++) {
+                (*body)(thread, i);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_active == 0) {
+                m_done_cv.notify_one();
+            }
+        }
+    }
+}
+
+} // namespace smpl
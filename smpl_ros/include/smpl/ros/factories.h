@@ -125,6 +125,12 @@ auto MakeLARAStar(
     const PlanningParams& params)
     -> std::unique_ptr<SBPLPlanner>;
 
+auto MakeLazyARAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>;
+
 auto MakeEGWAStar(
     RobotPlanningSpace* space,
     RobotHeuristic* heuristic,
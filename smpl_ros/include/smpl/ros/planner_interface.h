@@ -34,6 +34,7 @@
 #define SMPL_PLANNER_INTERFACE_H
 
 // standard includes
+#include <list>
 #include <map>
 #include <memory>
 #include <string>
@@ -55,6 +56,7 @@
 #include <smpl/forward.h>
 #include <smpl/occupancy_grid.h>
 #include <smpl/planning_params.h>
+#include <smpl/planning_stats.h>
 #include <smpl/robot_model.h>
 #include <smpl/debug/marker.h>
 #include <smpl/graph/robot_planning_space.h>
@@ -127,6 +129,13 @@ public:
     ///     "expansions"
     ///     "solution cost"
     ///
+    /// Additionally, for each phase of planning that ran during the last call
+    /// to solve (see smpl::PlanningPhase), the entries "<phase> count",
+    /// "<phase> total time", "<phase> mean time", "<phase> p50 time",
+    /// "<phase> p99 time", and "<phase> max time", e.g. "collision check p99
+    /// time". Nested phases, such as collision checks within successor
+    /// generation, are included in the times of their enclosing phases.
+    ///
     /// @return The statistics
     auto getPlannerStats() -> std::map<std::string, double>;
 
@@ -157,6 +166,11 @@ protected:
     std::map<std::string, HeuristicFactory> m_heuristic_factories;
     std::map<std::string, PlannerFactory> m_planner_factories;
 
+    // per-phase latencies recorded during the last call to solve. Declared
+    // before the planner components, whose background work may record into it
+    // until they are destroyed.
+    PlanningStats m_stats;
+
     // planner components
 
     std::unique_ptr<RobotPlanningSpace> m_pspace;
@@ -167,6 +181,29 @@ protected:
 
     std::string m_planner_id;
 
+    // Planner components constructed for previous planner ids, kept so that
+    // switching back to them does not rebuild them. Components are valid as
+    // long as the occupancy grid has not changed since they were built, or if
+    // all of their heuristics track changes to the grid themselves.
+    struct PlannerCacheEntry
+    {
+        std::string planner_id;
+        std::unique_ptr<RobotPlanningSpace> pspace;
+        std::map<std::string, std::unique_ptr<RobotHeuristic>> heuristics;
+        std::unique_ptr<SBPLPlanner> planner;
+        int grid_version;
+        bool tracks_grid;
+    };
+
+    // most recently used first; holds at most m_planner_cache_size - 1 entries
+    // in addition to the active planner
+    std::list<PlannerCacheEntry> m_planner_cache;
+    int m_planner_cache_size;
+
+    // state of the active planner components
+    int m_planner_grid_version;
+    bool m_planner_tracks_grid;
+
     // Set start configuration
     bool setGoal(const GoalConstraints& v_goal_constraints);
     bool setStart(const moveit_msgs::RobotState& state);
@@ -181,6 +218,9 @@ protected:
         std::string& search_name) const;
 
     bool reinitPlanner(const std::string& planner_id);
+    void cacheActivePlanner();
+    bool restoreCachedPlanner(const std::string& planner_id);
+    bool isPlannerValid(int grid_version, bool tracks_grid) const;
 
     void postProcessPath(std::vector<RobotState>& path) const;
 };
@@ -95,6 +95,9 @@ public:
         double world_x, double world_y, double world_z,
         int& x, int& y, int& z) const override;
 
+    bool saveSnapshot(SnapshotWriter& writer) const override;
+    bool loadSnapshot(const SnapshotReader& reader) override;
+
 private:
 
     distance_field::PropagationDistanceField m_df;
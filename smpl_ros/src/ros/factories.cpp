@@ -23,7 +23,9 @@
 #include <smpl/search/arastar.h>
 #include <smpl/search/awastar.h>
 #include <smpl/search/experience_graph_planner.h>
+#include <smpl/search/lazy_arastar.h>
 #include <smpl/stl/memory.h>
+#include <smpl/time.h>
 
 namespace smpl {
 
@@ -181,6 +183,14 @@ auto MakeManipLattice(
         space->setVisualizationFrameId(grid->getReferenceFrame());
     }
 
+    int edge_validation_threads;
+    if (params.getParam("edge_validation_threads", edge_validation_threads) &&
+        !space->setEdgeValidationThreadCount(edge_validation_threads))
+    {
+        SMPL_ERROR_NAMED(PI_LOGGER, "Failed to set up parallel edge validation");
+        return nullptr;
+    }
+
     auto& actions = space->actions;
     actions.useMultipleIkSolutions(action_params.use_multiple_ik_solutions);
     actions.useAmp(MotionPrimitive::SNAP_TO_XYZ, action_params.use_xyz_snap_mprim);
@@ -359,6 +369,11 @@ bool GetWorkspaceLatticeParams(
         }
     }
 
+    // optional ik cache settings
+    params.getParam("ik_cache_size", wsp->ik_cache_size);
+    params.getParam("ik_cache_seed_res", wsp->ik_cache_seed_res);
+    params.getParam("ik_branch_step", wsp->ik_branch_step);
+
     return true;
 }
 
@@ -493,6 +508,9 @@ auto MakeMultiFrameBFSHeuristic(
     double inflation_radius;
     params.param("bfs_inflation_radius", inflation_radius, 0.0);
     h->setInflationRadius(inflation_radius);
+    int thread_count;
+    params.param("bfs_thread_count", thread_count, 1);
+    h->setThreadCount(thread_count);
     if (!h->init(space, grid)) {
         return nullptr;
     }
@@ -517,6 +535,12 @@ auto MakeBFSHeuristic(
     double inflation_radius;
     params.param("bfs_inflation_radius", inflation_radius, 0.0);
     h->setInflationRadius(inflation_radius);
+    int thread_count;
+    params.param("bfs_thread_count", thread_count, 1);
+    h->setThreadCount(thread_count);
+    bool lazy;
+    params.param("bfs_lazy", lazy, false);
+    h->setLazy(lazy);
     if (!h->init(space, grid)) {
         return nullptr;
     }
@@ -723,6 +747,99 @@ auto MakeLARAStar(
     return std::move(search);
 }
 
+auto MakeLazyARAStar(
+    RobotPlanningSpace* space,
+    RobotHeuristic* heuristic,
+    const PlanningParams& params)
+    -> std::unique_ptr<SBPLPlanner>
+{
+    // adapts LazyARAStar to SBPLPlanner, and the planning space to
+    // ILazySuccFun, forwarding batches of lazy edges to GetTrueCosts()
+    struct LazyARAStarAdapter : public SBPLPlanner, public ILazySuccFun
+    {
+        RobotPlanningSpace* space;
+        LazyARAStar search;
+        int start_id = -1;
+        int goal_id = -1;
+        double planning_time = 0.0;
+
+        void GetLazySuccs(
+            int state_id,
+            std::vector<int>& succs,
+            std::vector<int>& costs,
+            std::vector<bool>& true_costs) override
+        {
+            space->GetLazySuccs(state_id, &succs, &costs, &true_costs);
+        }
+
+        int GetSuccTrueCost(int state_id, int succ_id) override
+        {
+            return space->GetTrueCost(state_id, succ_id);
+        }
+
+        void GetSuccTrueCosts(
+            const int* state_ids,
+            const int* succ_ids,
+            int count,
+            int* costs) override
+        {
+            space->GetTrueCosts(state_ids, succ_ids, count, costs);
+        }
+
+        // LazyARAStar runs until it finds a solution or exhausts OPEN; the
+        // allowed time is not enforced
+        int replan(double allowed_time, std::vector<int>* solution) override
+        {
+            int cost;
+            return replan(allowed_time, solution, &cost);
+        }
+
+        int replan(
+            double allowed_time,
+            std::vector<int>* solution,
+            int* cost) override
+        {
+            auto start = clock::now();
+            solution->clear();
+            auto err = Replan(search, start_id, goal_id, *solution, *cost);
+            planning_time = to_seconds(clock::now() - start);
+            return err == 0;
+        }
+
+        int set_goal(int state_id) override { goal_id = state_id; return 1; }
+        int set_start(int state_id) override { start_id = state_id; return 1; }
+        int force_planning_from_scratch() override { return 1; }
+        int set_search_mode(bool first_solution) override { return 1; }
+        void costs_changed(const StateChangeQuery& changes) override { }
+
+        double get_solution_eps() const override { return search.eps_; }
+        int get_n_expands() const override { return search.expand_count_; }
+        double get_initial_eps() override { return search.eps_; }
+        double get_initial_eps_planning_time() override { return planning_time; }
+        double get_final_eps_planning_time() override { return planning_time; }
+        int get_n_expands_init_solution() override { return search.expand_count_; }
+        double get_final_epsilon() override { return search.eps_; }
+        void set_initialsolution_eps(double eps) override { search.eps_ = eps; }
+    };
+
+    auto search = make_unique<LazyARAStarAdapter>();
+    search->space = space;
+    if (!Init(search->search, search.get(), heuristic)) {
+        return nullptr;
+    }
+
+    double epsilon;
+    params.param("epsilon", epsilon, 1.0);
+    search->set_initialsolution_eps(epsilon);
+
+    int eval_batch_size;
+    if (params.getParam("eval_batch_size", eval_batch_size)) {
+        SetEvalBatchSize(search->search, eval_batch_size);
+    }
+
+    return std::move(search);
+}
+
 auto MakeEGWAStar(
     RobotPlanningSpace* space,
     RobotHeuristic* heuristic,
@@ -192,7 +192,11 @@ PlannerInterface::PlannerInterface(
     m_heuristics(),
     m_planner(),
     m_sol_cost(INFINITECOST),
-    m_planner_id()
+    m_planner_id(),
+    m_planner_cache(),
+    m_planner_cache_size(4),
+    m_planner_grid_version(0),
+    m_planner_tracks_grid(false)
 {
     if (m_robot) {
         m_fk_iface = m_robot->getExtension<ForwardKinematicsInterface>();
@@ -281,6 +285,7 @@ PlannerInterface::PlannerInterface(
     m_planner_factories["awastar"] = MakeAWAStar;
     m_planner_factories["mhastar"] = MakeMHAStar;
     m_planner_factories["larastar"] = MakeLARAStar;
+    m_planner_factories["lazy_arastar"] = MakeLazyARAStar;
     m_planner_factories["egwastar"] = MakeEGWAStar;
     m_planner_factories["padastar"] = MakePADAStar;
 }
@@ -318,6 +323,10 @@ bool PlannerInterface::init(const PlanningParams& params)
 
     m_params = params;
 
+    m_params.param("planner_cache_size", m_planner_cache_size, 4);
+    m_planner_cache_size = std::max(m_planner_cache_size, 1);
+    SMPL_INFO_NAMED(PI_LOGGER, "  Planner Cache Size: %d", m_planner_cache_size);
+
     m_initialized = true;
 
     SMPL_INFO_NAMED(PI_LOGGER, "Initialized planner interface");
@@ -702,6 +711,9 @@ bool PlannerInterface::solve(
         return false;
     }
 
+    m_stats.reset();
+    ScopedActivePlanningStats active_stats(&m_stats);
+
     if (!canServiceRequest(req, res)) {
         return false;
     }
@@ -712,7 +724,6 @@ bool PlannerInterface::solve(
         return true;
     }
 
-    // TODO: lazily reinitialize planner when algorithm changes
     if (!reinitPlanner(req.planner_id)) {
         res.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
         return false;
@@ -1017,6 +1028,8 @@ bool ExtractPosesGoal(
 // the goal within the graph, the heuristic, and the search.
 bool PlannerInterface::setGoal(const GoalConstraints& v_goal_constraints)
 {
+    PhaseTimer timer(PlanningPhase::SetGoal);
+
     GoalConstraint goal;
 
     if (IsPoseGoal(v_goal_constraints)) {
@@ -1064,6 +1077,7 @@ bool PlannerInterface::setGoal(const GoalConstraints& v_goal_constraints)
         return false;
     }
 
+    // heuristics that build in the background record their own update times
     for (auto& h : m_heuristics) {
         h.second->updateGoal(goal);
     }
@@ -1087,6 +1101,8 @@ bool PlannerInterface::setGoal(const GoalConstraints& v_goal_constraints)
 // state in the graph, heuristic, and search.
 bool PlannerInterface::setStart(const moveit_msgs::RobotState& state)
 {
+    PhaseTimer timer(PlanningPhase::SetStart);
+
     SMPL_INFO_NAMED(PI_LOGGER, "set start configuration");
 
     // TODO: Ideally, the RobotModel should specify joints rather than variables
@@ -1144,6 +1160,7 @@ bool PlannerInterface::setStart(const moveit_msgs::RobotState& state)
         return false;
     }
 
+    // heuristics that build in the background record their own update times
     for (auto& h : m_heuristics) {
         h.second->updateStart(initial_positions);
     }
@@ -1172,7 +1189,10 @@ bool PlannerInterface::plan(double allowed_time, std::vector<RobotState>& path)
     m_planner->force_planning_from_scratch();
 
     // plan
-    b_ret = m_planner->replan(allowed_time, &solution_state_ids, &m_sol_cost);
+    {
+        PhaseTimer timer(PlanningPhase::Search);
+        b_ret = m_planner->replan(allowed_time, &solution_state_ids, &m_sol_cost);
+    }
 
     // check if an empty plan was received.
     if (b_ret && solution_state_ids.size() <= 0) {
@@ -1263,6 +1283,7 @@ auto PlannerInterface::getPlannerStats() -> std::map<std::string, double>
     stats["solution epsilon"] = m_planner->get_solution_eps();
     stats["expansions"] = m_planner->get_n_expands();
     stats["solution cost"] = m_sol_cost;
+    m_stats.getStats(stats);
     return stats;
 }
 
@@ -1381,9 +1402,21 @@ bool PlannerInterface::parsePlannerID(
 
 bool PlannerInterface::reinitPlanner(const std::string& planner_id)
 {
-    if (planner_id == m_planner_id) {
+    if (m_planner && planner_id == m_planner_id) {
         // TODO: check for specification of default planning components when
         // they may not have been previously specified
+        if (isPlannerValid(m_planner_grid_version, m_planner_tracks_grid)) {
+            return true;
+        }
+        SMPL_INFO_NAMED(PI_LOGGER, "Occupancy grid changed since planner '%s' was built", planner_id.c_str());
+        m_planner.reset();
+        m_heuristics.clear();
+        m_pspace.reset();
+    }
+
+    cacheActivePlanner();
+
+    if (restoreCachedPlanner(planner_id)) {
         return true;
     }
 
@@ -1446,21 +1479,96 @@ bool PlannerInterface::reinitPlanner(const std::string& planner_id)
         return false;
     }
     m_planner_id = planner_id;
+
+    m_planner_grid_version = m_grid->version();
+    m_planner_tracks_grid = true;
+    for (auto& entry : m_heuristics) {
+        auto* observer = dynamic_cast<OccupancyGridObserver*>(entry.second.get());
+        if (!observer || !m_grid->hasObserver(observer)) {
+            m_planner_tracks_grid = false;
+        }
+    }
+    return true;
+}
+
+// Move the active planner components, if any, to the front of the planner
+// cache, evicting the least recently used entries beyond the cache size.
+void PlannerInterface::cacheActivePlanner()
+{
+    if (m_planner && m_planner_cache_size > 1) {
+        PlannerCacheEntry entry;
+        entry.planner_id = m_planner_id;
+        entry.pspace = std::move(m_pspace);
+        entry.heuristics = std::move(m_heuristics);
+        entry.planner = std::move(m_planner);
+        entry.grid_version = m_planner_grid_version;
+        entry.tracks_grid = m_planner_tracks_grid;
+        m_planner_cache.push_front(std::move(entry));
+    }
+
+    // destroy the search before the heuristics and space it refers to
+    m_planner.reset();
+    m_heuristics.clear();
+    m_pspace.reset();
+    m_planner_id.clear();
+
+    while (m_planner_cache.size() > (size_t)(m_planner_cache_size - 1)) {
+        SMPL_DEBUG_NAMED(PI_LOGGER, "Evict planner '%s' from the planner cache", m_planner_cache.back().planner_id.c_str());
+        m_planner_cache.pop_back();
+    }
+}
+
+// Make the cached planner components for a planner id active, if they exist
+// and are still valid. Stale components are evicted.
+bool PlannerInterface::restoreCachedPlanner(const std::string& planner_id)
+{
+    auto it = std::find_if(
+            begin(m_planner_cache), end(m_planner_cache),
+            [&](const PlannerCacheEntry& entry) {
+                return entry.planner_id == planner_id;
+            });
+    if (it == end(m_planner_cache)) {
+        return false;
+    }
+
+    if (!isPlannerValid(it->grid_version, it->tracks_grid)) {
+        SMPL_INFO_NAMED(PI_LOGGER, "Evict stale planner '%s' from the planner cache", planner_id.c_str());
+        m_planner_cache.erase(it);
+        return false;
+    }
+
+    SMPL_INFO_NAMED(PI_LOGGER, "Reuse cached planner '%s'", planner_id.c_str());
+    m_pspace = std::move(it->pspace);
+    m_heuristics = std::move(it->heuristics);
+    m_planner = std::move(it->planner);
+    m_planner_id = std::move(it->planner_id);
+    m_planner_grid_version = it->grid_version;
+    m_planner_tracks_grid = it->tracks_grid;
+    m_planner_cache.erase(it);
     return true;
 }
 
+bool PlannerInterface::isPlannerValid(int grid_version, bool tracks_grid) const
+{
+    return tracks_grid || grid_version == m_grid->version();
+}
+
 void PlannerInterface::postProcessPath(std::vector<RobotState>& path) const
 {
+    PhaseTimer timer(PlanningPhase::PostProcessing);
+
     // shortcut path
     if (m_params.shortcut_path) {
         if (!InterpolatePath(*m_checker, path)) {
             SMPL_WARN_NAMED(PI_LOGGER, "Failed to interpolate planned path with %zu waypoints before shortcutting.", path.size());
             std::vector<RobotState> ipath = path;
             path.clear();
+            PhaseTimer shortcut_timer(PlanningPhase::Shortcut);
             ShortcutPath(m_robot, m_checker, ipath, path, m_params.shortcut_type);
         } else {
             std::vector<RobotState> ipath = path;
             path.clear();
+            PhaseTimer shortcut_timer(PlanningPhase::Shortcut);
             ShortcutPath(m_robot, m_checker, ipath, path, m_params.shortcut_type);
         }
     }
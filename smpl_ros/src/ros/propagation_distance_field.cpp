@@ -33,9 +33,17 @@
 
 // standard includes
 #include <cmath>
+#include <cstring>
+#include <sstream>
+
+// project includes
+#include <smpl/snapshot.h>
 
 namespace smpl {
 
+static const std::uint32_t SNAPSHOT_TYPE = SnapshotTag('P', 'R', 'O', 'P');
+static const std::uint32_t FIELD_TAG = SnapshotTag('F', 'I', 'E', 'L');
+
 PropagationDistanceField::PropagationDistanceField(
     double origin_x, double origin_y, double origin_z,
     double size_x, double size_y, double size_z,
@@ -195,6 +203,41 @@ void PropagationDistanceField::worldToGrid(
     (void)m_df.worldToGrid(world_x, world_y, world_z, x, y, z);
 }
 
+/// Add the field to a snapshot, in the stream format of the underlying
+/// distance field, which records the obstacle cells.
+bool PropagationDistanceField::saveSnapshot(SnapshotWriter& writer) const
+{
+    std::ostringstream ss;
+    if (!m_df.writeToStream(ss)) {
+        return false;
+    }
+
+    SaveDistanceMapInfo(writer, *this, SNAPSHOT_TYPE, m_max_distance);
+
+    const std::string field = ss.str();
+    void* data = writer.allocateSection(FIELD_TAG, field.size());
+    std::memcpy(data, field.data(), field.size());
+    return true;
+}
+
+/// Replace the field with the one from a snapshot. The distances are
+/// propagated from the obstacle cells recorded in the snapshot.
+bool PropagationDistanceField::loadSnapshot(const SnapshotReader& reader)
+{
+    if (!LoadDistanceMapInfo(reader, *this, SNAPSHOT_TYPE, m_max_distance)) {
+        return false;
+    }
+
+    size_t size;
+    auto* field = (const char*)reader.section(FIELD_TAG, &size);
+    if (!field) {
+        return false;
+    }
+
+    std::istringstream ss(std::string(field, size));
+    return m_df.readFromStream(ss);
+}
+
 EigenSTL::vector_Vector3d PropagationDistanceField::toAlignedVector(
     const std::vector<Eigen::Vector3d>& vin) const
 {
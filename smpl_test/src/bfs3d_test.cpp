@@ -0,0 +1,264 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE BFS3DTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/bfs3d/bfs3d.h>
+
+static const int N = 12;
+
+static int Index(int x, int y, int z)
+{
+    return (z * N + y) * N + x;
+}
+
+// A cube of cells with random walls and start cells that are never walls
+struct Scene
+{
+    std::vector<bool> walls;
+    std::vector<int> starts; // (x, y, z) triples
+
+    Scene(std::default_random_engine& rng, double wall_prob)
+    {
+        std::uniform_int_distribution<int> coord(0, N - 1);
+        for (int i = 0; i < 3; ++i) {
+            starts.push_back(coord(rng));
+            starts.push_back(coord(rng));
+            starts.push_back(coord(rng));
+        }
+
+        std::bernoulli_distribution wall(wall_prob);
+        walls.resize(N * N * N);
+        for (int z = 0; z < N; ++z) {
+        for (int y = 0; y < N; ++y) {
+        for (int x = 0; x < N; ++x) {
+            walls[Index(x, y, z)] = !isStart(x, y, z) && wall(rng);
+        }
+        }
+        }
+    }
+
+    bool isStart(int x, int y, int z) const
+    {
+        for (size_t i = 0; i < starts.size(); i += 3) {
+            if (starts[i] == x && starts[i + 1] == y && starts[i + 2] == z) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Toggle a random set of distinct cells and return them as (x, y, z)
+    // triples of new walls and of freed cells
+    void change(
+        std::default_random_engine& rng,
+        int count,
+        std::vector<int>& new_walls,
+        std::vector<int>& frees)
+    {
+        new_walls.clear();
+        frees.clear();
+        std::vector<bool> toggled(N * N * N, false);
+        std::uniform_int_distribution<int> coord(0, N - 1);
+        for (int i = 0; i < count; ++i) {
+            int x = coord(rng), y = coord(rng), z = coord(rng);
+            if (isStart(x, y, z) || toggled[Index(x, y, z)]) {
+                continue;
+            }
+            toggled[Index(x, y, z)] = true;
+            auto& out = walls[Index(x, y, z)] ? frees : new_walls;
+            walls[Index(x, y, z)] = !walls[Index(x, y, z)];
+            out.push_back(x);
+            out.push_back(y);
+            out.push_back(z);
+        }
+    }
+
+    // 26-connected breadth-first search from the start cells
+    auto distances() const -> std::vector<int>
+    {
+        std::vector<int> dist(N * N * N, smpl::BFS_3D::UNDISCOVERED);
+        std::vector<int> queue;
+        for (size_t i = 0; i < starts.size(); i += 3) {
+            int n = Index(starts[i], starts[i + 1], starts[i + 2]);
+            if (dist[n] != 0) {
+                dist[n] = 0;
+                queue.push_back(n);
+            }
+        }
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int n = queue[head];
+            int x = n % N, y = n / N % N, z = n / (N * N);
+            for (int dz = -1; dz <= 1; ++dz) {
+            for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                int nx = x + dx, ny = y + dy, nz = z + dz;
+                if (nx < 0 || nx >= N || ny < 0 || ny >= N || nz < 0 || nz >= N) {
+                    continue;
+                }
+                int m = Index(nx, ny, nz);
+                if (walls[m] || dist[m] != smpl::BFS_3D::UNDISCOVERED) {
+                    continue;
+                }
+                dist[m] = dist[n] + 1;
+                queue.push_back(m);
+            }
+            }
+            }
+        }
+        for (int n = 0; n < N * N * N; ++n) {
+            if (walls[n]) {
+                dist[n] = smpl::BFS_3D::WALL;
+            }
+        }
+        return dist;
+    }
+};
+
+enum class Mode { Sequential, Parallel, Lazy, LazyFocus };
+
+static void Configure(smpl::BFS_3D& bfs, Mode mode)
+{
+    bfs.setThreadCount(mode == Mode::Parallel ? 4 : 1);
+    bfs.setLazy(mode == Mode::Lazy || mode == Mode::LazyFocus);
+}
+
+static void Run(smpl::BFS_3D& bfs, const Scene& scene)
+{
+    for (int z = 0; z < N; ++z) {
+    for (int y = 0; y < N; ++y) {
+    for (int x = 0; x < N; ++x) {
+        if (scene.walls[Index(x, y, z)]) {
+            bfs.setWall(x, y, z);
+        } else {
+            bfs.unsetWall(x, y, z);
+        }
+    }
+    }
+    }
+    bfs.run(scene.starts.begin(), scene.starts.end());
+}
+
+// Query every cell in a random order, moving the focus of a lazy search
+// around as it goes, and count the cells that differ from the reference
+static int CountMismatches(
+    smpl::BFS_3D& bfs,
+    const Scene& scene,
+    Mode mode,
+    std::default_random_engine& rng)
+{
+    std::vector<int> order(N * N * N);
+    for (int n = 0; n < N * N * N; ++n) {
+        order[n] = n;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+
+    auto expected = scene.distances();
+    int mismatches = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        int n = order[i];
+        int x = n % N, y = n / N % N, z = n / (N * N);
+        if (mode == Mode::LazyFocus && i % 64 == 0) {
+            bfs.setFocus(x, y, z);
+        }
+        if (bfs.getDistance(x, y, z) != expected[n]) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+static void CheckMode(Mode mode)
+{
+    std::default_random_engine rng(1);
+    for (int trial = 0; trial < 10; ++trial) {
+        Scene scene(rng, 0.3);
+        smpl::BFS_3D bfs(N, N, N);
+        Configure(bfs, mode);
+        Run(bfs, scene);
+        BOOST_CHECK_EQUAL(CountMismatches(bfs, scene, mode, rng), 0);
+
+        // repair the distances of the search after each change of walls
+        std::vector<int> walls, frees;
+        for (int update = 0; update < 10; ++update) {
+            scene.change(rng, update % 2 ? 200 : 10, walls, frees);
+            bfs.updateWalls(walls, frees);
+            BOOST_CHECK_EQUAL(CountMismatches(bfs, scene, mode, rng), 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(SequentialTest)
+{
+    CheckMode(Mode::Sequential);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelTest)
+{
+    CheckMode(Mode::Parallel);
+}
+
+BOOST_AUTO_TEST_CASE(LazyTest)
+{
+    CheckMode(Mode::Lazy);
+}
+
+BOOST_AUTO_TEST_CASE(LazyFocusTest)
+{
+    CheckMode(Mode::LazyFocus);
+}
+
+// Queries issued while a background search is running must block until the
+// cell has been reached
+BOOST_AUTO_TEST_CASE(QueryWhileRunningTest)
+{
+    std::default_random_engine rng(2);
+    for (auto mode : { Mode::Sequential, Mode::Parallel }) {
+        Scene scene(rng, 0.2);
+        smpl::BFS_3D bfs(N, N, N);
+        Configure(bfs, mode);
+        Run(bfs, scene);
+        auto expected = scene.distances();
+        int mismatches = 0;
+        for (int n = N * N * N - 1; n >= 0; --n) {
+            int x = n % N, y = n / N % N, z = n / (N * N);
+            if (bfs.getDistance(x, y, z) != expected[n]) {
+                ++mismatches;
+            }
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0);
+    }
+}
@@ -1,10 +1,25 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <ostream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
 #include <utility>
 
+#include <stdlib.h>
+#include <unistd.h>
+
 #include <smpl/distance_map/euclid_distance_map.h>
+#include <smpl/distance_map/overlay_distance_map.h>
 #include <smpl/distance_map/sparse_distance_map.h>
+#include <smpl/snapshot.h>
 
 /*
 template <class T>
@@ -153,9 +168,514 @@ void TestSpecialMemberFunctions()
     }
 }
 
+// Compare the incremental and bulk insertion paths of EuclidDistanceMap on a
+// large random point cloud, and check that they produce the same distances
+bool BenchmarkBulkBuild()
+{
+    const double size_x = 2.0;
+    const double size_y = 2.0;
+    const double size_z = 1.5;
+    const double res = 0.01;
+    const double max_dist = 0.2;
+    const int num_points = 3000000;
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    for (int i = 0; i < num_points; ++i) {
+        points.emplace_back(
+                size_x * dist(rng), size_y * dist(rng), size_z * dist(rng));
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    smpl::EuclidDistanceMap incremental(
+            0.0, 0.0, 0.0, size_x, size_y, size_z, res, max_dist);
+    incremental.setBulkBuildThreshold(num_points + 1);
+    // insert one point first so that the next insertion is not treated as a
+    // build from a freshly reset map
+    incremental.addPointsToMap({ points.front() });
+    auto start = clock::now();
+    incremental.addPointsToMap(points);
+    printf("incremental: %0.3f s\n", elapsed(start));
+
+    bool ok = true;
+    const int max_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        smpl::EuclidDistanceMap bulk(
+                0.0, 0.0, 0.0, size_x, size_y, size_z, res, max_dist);
+        bulk.setThreadCount(threads);
+        start = clock::now();
+        bulk.addPointsToMap(points);
+        printf("bulk (%d threads): %0.3f s\n", threads, elapsed(start));
+
+        if (bulk != incremental) {
+            printf("Bulk and incremental distance maps are not equal\n");
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Time the insertion of increasingly large point sets into a map that already
+// holds obstacles, incrementally and with a bulk build, and report the
+// smallest set for which the bulk build wins next to the default threshold
+void BenchmarkBulkBuildCrossover()
+{
+    const double size = 2.0;
+    const double res = 0.02;
+
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, size);
+    auto random_points = [&](int count) {
+        std::vector<Eigen::Vector3d> points;
+        for (int i = 0; i < count; ++i) {
+            points.emplace_back(dist(rng), dist(rng), dist(rng));
+        }
+        return points;
+    };
+
+    for (int num_base_points : { 5000, 20000 }) {
+    for (double max_dist : { 0.06, 0.2, 0.4 }) {
+        smpl::EuclidDistanceMap base(
+                0.0, 0.0, 0.0, size, size, size, res, max_dist);
+        base.addPointsToMap(random_points(num_base_points));
+
+        int crossover = -1;
+        for (int count = 125; count <= 32000 && crossover < 0; count *= 2) {
+            auto points = random_points(count);
+
+            smpl::EuclidDistanceMap incremental(base);
+            incremental.setBulkBuildThreshold(std::numeric_limits<int>::max());
+            auto start = clock::now();
+            incremental.addPointsToMap(points);
+            auto incremental_time = elapsed(start);
+
+            smpl::EuclidDistanceMap bulk(base);
+            bulk.setBulkBuildThreshold(1);
+            start = clock::now();
+            bulk.addPointsToMap(points);
+            auto bulk_time = elapsed(start);
+
+            printf("%d obstacles, max distance %0.2f, %5d points: incremental %0.3f s, bulk %0.3f s\n",
+                    num_base_points, max_dist, count, incremental_time, bulk_time);
+            if (bulk_time < incremental_time) {
+                crossover = count;
+            }
+        }
+        printf("%d obstacles, max distance %0.2f: bulk build wins at %d points, default threshold %d\n",
+                num_base_points, max_dist, crossover, base.bulkBuildThreshold());
+    }
+    }
+}
+
+// Check every cell of a map against the distance to the nearest of a set of
+// obstacle cells, or to the border, computed by brute force
+bool MatchesBruteForce(
+    const smpl::DistanceMapInterface& d,
+    const std::set<std::tuple<int, int, int>>& obstacles)
+{
+    const int nx = d.numCellsX();
+    const int ny = d.numCellsY();
+    const int nz = d.numCellsZ();
+    const int dmax = (int)std::ceil(d.getUninitializedDistance() / d.resolution());
+
+    for (int x = 0; x < nx; ++x) {
+    for (int y = 0; y < ny; ++y) {
+    for (int z = 0; z < nz; ++z) {
+        auto border = std::min({ x + 1, nx - x, y + 1, ny - y, z + 1, nz - z });
+        auto dsqrd = border * border;
+        for (auto& o : obstacles) {
+            auto dx = x - std::get<0>(o);
+            auto dy = y - std::get<1>(o);
+            auto dz = z - std::get<2>(o);
+            dsqrd = std::min(dsqrd, dx * dx + dy * dy + dz * dz);
+        }
+        dsqrd = std::min(dsqrd, dmax * dmax);
+        auto expected = d.resolution() * std::sqrt((double)dsqrd);
+        if (std::fabs(d.getCellDistance(x, y, z) - expected) > 1e-5) {
+            return false;
+        }
+    }
+    }
+    }
+
+    return true;
+}
+
+// Generate random obstacle cells and the points at their centers
+void RandomObstacles(
+    const smpl::DistanceMapInterface& d,
+    std::default_random_engine& rng,
+    int count,
+    std::set<std::tuple<int, int, int>>& cells,
+    std::vector<Eigen::Vector3d>& points)
+{
+    std::uniform_int_distribution<int> dx(0, d.numCellsX() - 1);
+    std::uniform_int_distribution<int> dy(0, d.numCellsY() - 1);
+    std::uniform_int_distribution<int> dz(0, d.numCellsZ() - 1);
+    for (int i = 0; i < count; ++i) {
+        int x = dx(rng), y = dy(rng), z = dz(rng);
+        Eigen::Vector3d p;
+        d.gridToWorld(x, y, z, p.x(), p.y(), p.z());
+        cells.insert(std::make_tuple(x, y, z));
+        points.push_back(p);
+    }
+}
+
+// Check bulk builds from a handful of obstacles, both into a fresh map and as
+// a forced rebuild of a map that already holds obstacles
+bool TestBulkBuildSparse()
+{
+    const double size = 1.5;
+    const double res = 0.0625;
+    const double max_dist = 0.375;
+
+    std::default_random_engine rng;
+    std::set<std::tuple<int, int, int>> cells;
+    std::vector<Eigen::Vector3d> points;
+
+    smpl::EuclidDistanceMap d(0.0, 0.0, 0.0, size, size, size, res, max_dist);
+    RandomObstacles(d, rng, 5, cells, points);
+    d.addPointsToMap(points);
+    if (!MatchesBruteForce(d, cells)) {
+        printf("Bulk build from sparse obstacles is incorrect\n");
+        return false;
+    }
+
+    points.clear();
+    RandomObstacles(d, rng, 3, cells, points);
+    d.setBulkBuildThreshold(1);
+    d.addPointsToMap(points);
+    if (!MatchesBruteForce(d, cells)) {
+        printf("Bulk rebuild with sparse obstacles is incorrect\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Check that incremental additions, removals, and updates after a bulk build
+// continue from the propagation bookkeeping it produced
+bool TestBulkThenIncremental()
+{
+    const double size = 1.5;
+    const double res = 0.0625;
+    const double max_dist = 0.375;
+
+    std::default_random_engine rng;
+    std::set<std::tuple<int, int, int>> cells;
+    std::vector<Eigen::Vector3d> points;
+
+    smpl::EuclidDistanceMap d(0.0, 0.0, 0.0, size, size, size, res, max_dist);
+    RandomObstacles(d, rng, 200, cells, points);
+    d.addPointsToMap(points);
+    if (!MatchesBruteForce(d, cells)) {
+        printf("Bulk build is incorrect\n");
+        return false;
+    }
+
+    d.setBulkBuildThreshold(std::numeric_limits<int>::max());
+
+    std::vector<Eigen::Vector3d> added;
+    RandomObstacles(d, rng, 10, cells, added);
+    d.addPointsToMap(added);
+    if (!MatchesBruteForce(d, cells)) {
+        printf("Incremental insertion after a bulk build is incorrect\n");
+        return false;
+    }
+
+    // remove some of the bulk-built obstacles and some of the added ones
+    std::vector<Eigen::Vector3d> removed(points.begin(), points.begin() + 20);
+    removed.insert(removed.end(), added.begin(), added.begin() + 5);
+    for (auto& p : removed) {
+        int x, y, z;
+        d.worldToGrid(p.x(), p.y(), p.z(), x, y, z);
+        cells.erase(std::make_tuple(x, y, z));
+    }
+    d.removePointsFromMap(removed);
+    if (!MatchesBruteForce(d, cells)) {
+        printf("Incremental removal after a bulk build is incorrect\n");
+        return false;
+    }
+
+    // move the remaining added obstacles
+    std::vector<Eigen::Vector3d> old_points(added.begin() + 5, added.end());
+    for (auto& p : old_points) {
+        int x, y, z;
+        d.worldToGrid(p.x(), p.y(), p.z(), x, y, z);
+        cells.erase(std::make_tuple(x, y, z));
+    }
+    std::vector<Eigen::Vector3d> new_points;
+    RandomObstacles(d, rng, 5, cells, new_points);
+    d.updatePointsInMap(old_points, new_points);
+    if (!MatchesBruteForce(d, cells)) {
+        printf("Incremental update after a bulk build is incorrect\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Check that updates to a map whose propagation bookkeeping is released, once
+// or after every update, rebuild the bookkeeping and stay correct
+bool TestReleasePropagationData()
+{
+    const double size = 1.5;
+    const double res = 0.0625;
+    const double max_dist = 0.375;
+
+    std::default_random_engine rng;
+    std::set<std::tuple<int, int, int>> cells;
+    std::vector<Eigen::Vector3d> points;
+
+    smpl::EuclidDistanceMap d(0.0, 0.0, 0.0, size, size, size, res, max_dist);
+    RandomObstacles(d, rng, 200, cells, points);
+    d.addPointsToMap(points);
+
+    d.releasePropagationData();
+    if (d.hasPropagationData() || !MatchesBruteForce(d, cells)) {
+        printf("Releasing the propagation data changed the distances\n");
+        return false;
+    }
+
+    // an incremental insertion restores the bookkeeping first
+    d.setBulkBuildThreshold(std::numeric_limits<int>::max());
+    std::vector<Eigen::Vector3d> added;
+    RandomObstacles(d, rng, 10, cells, added);
+    d.addPointsToMap(added);
+    if (!d.hasPropagationData() || !MatchesBruteForce(d, cells)) {
+        printf("Incremental insertion after a release is incorrect\n");
+        return false;
+    }
+
+    // released after each update from here on
+    d.setRetainPropagationData(false);
+    if (d.hasPropagationData()) {
+        printf("The propagation data is retained after opting out\n");
+        return false;
+    }
+
+    std::vector<Eigen::Vector3d> removed(points.begin(), points.begin() + 20);
+    for (auto& p : removed) {
+        int x, y, z;
+        d.worldToGrid(p.x(), p.y(), p.z(), x, y, z);
+        cells.erase(std::make_tuple(x, y, z));
+    }
+    d.removePointsFromMap(removed);
+    if (d.hasPropagationData() || !MatchesBruteForce(d, cells)) {
+        printf("Incremental removal after a release is incorrect\n");
+        return false;
+    }
+
+    std::vector<Eigen::Vector3d> old_points(added.begin(), added.end());
+    for (auto& p : old_points) {
+        int x, y, z;
+        d.worldToGrid(p.x(), p.y(), p.z(), x, y, z);
+        cells.erase(std::make_tuple(x, y, z));
+    }
+    std::vector<Eigen::Vector3d> new_points;
+    RandomObstacles(d, rng, 10, cells, new_points);
+    d.updatePointsInMap(old_points, new_points);
+    if (d.hasPropagationData() || !MatchesBruteForce(d, cells)) {
+        printf("Incremental update after a release is incorrect\n");
+        return false;
+    }
+
+    // bulk builds from the recorded obstacles
+    d.setBulkBuildThreshold(1);
+    std::vector<Eigen::Vector3d> bulk;
+    RandomObstacles(d, rng, 50, cells, bulk);
+    d.addPointsToMap(bulk);
+    if (d.hasPropagationData() || !MatchesBruteForce(d, cells)) {
+        printf("Bulk build after a release is incorrect\n");
+        return false;
+    }
+
+    smpl::EuclidDistanceMap copy(d);
+    d.setRetainPropagationData(true);
+    d.addPointsToMap(added);
+    copy.addPointsToMap(added);
+    if (!d.hasPropagationData() || copy.hasPropagationData() || copy != d) {
+        printf("A copy does not keep the retention setting\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Check that grids too large for the 16-bit cell coordinates are rejected
+bool TestOversizedGrid()
+{
+    const double res = 0.01;
+    try {
+        smpl::EuclidDistanceMap d(0.0, 0.0, 0.0, 400.0, 1.0, 1.0, res, 0.1);
+        printf("Constructed a distance map with %d cells along x\n", d.numCellsX());
+        return false;
+    } catch (const std::length_error&) {
+        return true;
+    }
+}
+
+// Save a distance map to a snapshot and check that loading it, and applying
+// the same update to both maps afterwards, reproduces the original distances
+template <class DistanceMap>
+bool TestSnapshot()
+{
+    const double size = 2.0;
+    const double res = 0.02;
+    const double max_dist = 0.2;
+
+    char path[] = "/tmp/distance_map_test.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        printf("Failed to create a snapshot file\n");
+        return false;
+    }
+    close(fd);
+
+    std::vector<Eigen::Vector3d> points;
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, size);
+    for (int i = 0; i < 20000; ++i) {
+        points.emplace_back(dist(rng), dist(rng), dist(rng));
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    DistanceMap d1(0.0, 0.0, 0.0, size, size, size, res, max_dist);
+    auto start = clock::now();
+    d1.addPointsToMap(points);
+    printf("build: %0.3f s\n", elapsed(start));
+
+    if (!smpl::SaveSnapshot(d1, path)) {
+        printf("Failed to save snapshot\n");
+        std::remove(path);
+        return false;
+    }
+
+    DistanceMap d2(0.0, 0.0, 0.0, size, size, size, res, max_dist);
+    start = clock::now();
+    bool loaded = smpl::LoadSnapshot(d2, path);
+    std::remove(path);
+    if (!loaded) {
+        printf("Failed to load snapshot\n");
+        return false;
+    }
+    printf("load: %0.3f s\n", elapsed(start));
+
+    if (d1 != d2) {
+        printf("Loaded distance map is not equal to the saved map\n");
+        return false;
+    }
+
+    points.resize(points.size() >> 1);
+    d1.removePointsFromMap(points);
+    d2.removePointsFromMap(points);
+    if (d1 != d2) {
+        printf("Distance maps are not equal after updating the loaded map\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool ApproxEqual(
+    const smpl::DistanceMapInterface& d1,
+    const smpl::DistanceMapInterface& d2,
+    double tol)
+{
+    for (int x = 0; x < d1.numCellsX(); ++x) {
+    for (int y = 0; y < d1.numCellsY(); ++y) {
+    for (int z = 0; z < d1.numCellsZ(); ++z) {
+        double dist1 = d1.getCellDistance(x, y, z);
+        double dist2 = d2.getCellDistance(x, y, z);
+        if (std::fabs(dist1 - dist2) > tol) {
+            return false;
+        }
+    }
+    }
+    }
+
+    return true;
+}
+
+// Check that an overlay over a shared base map matches a single map with the
+// obstacles of both, before and after it replaces the base with a private copy.
+// The overlay's own distances are not rounded to single precision.
+bool TestOverlay()
+{
+    const double size = 2.0;
+    const double res = 0.02;
+    const double max_dist = 0.2;
+
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(0.0, size);
+    auto random_points = [&](int count) {
+        std::vector<Eigen::Vector3d> points;
+        for (int i = 0; i < count; ++i) {
+            points.emplace_back(dist(rng), dist(rng), dist(rng));
+        }
+        return points;
+    };
+
+    auto base_points = random_points(5000);
+    auto base = std::make_shared<smpl::EuclidDistanceMap>(
+            0.0, 0.0, 0.0, size, size, size, res, max_dist);
+    base->addPointsToMap(base_points);
+
+    smpl::OverlayDistanceMap overlay(base);
+    smpl::EuclidDistanceMap full(*base);
+
+    auto points = random_points(500);
+    overlay.addPointsToMap(points);
+    full.addPointsToMap(points);
+    if (!ApproxEqual(overlay, full, 1e-6)) {
+        printf("Overlay is not equal to the combined map after insertion\n");
+        return false;
+    }
+
+    smpl::OverlayDistanceMap copy(overlay);
+
+    base_points.resize(base_points.size() >> 1);
+    overlay.removePointsFromMap(base_points);
+    full.removePointsFromMap(base_points);
+    if (!ApproxEqual(overlay, full, 1e-6)) {
+        printf("Overlay is not equal to the combined map after removal\n");
+        return false;
+    }
+    if (overlay.isShared() || !copy.isShared()) {
+        printf("Only the modified overlay should own its base map\n");
+        return false;
+    }
+
+    return true;
+}
+
 int main(int argc, char* argv[])
 {
     TestSpecialMemberFunctions<smpl::SparseDistanceMap>();
 //    TestSpecialMemberFunctions<smpl::EuclidDistanceMap>();
-    return 0;
+    bool ok = true;
+    ok &= TestBulkBuildSparse();
+    ok &= TestBulkThenIncremental();
+    ok &= TestReleasePropagationData();
+    ok &= TestOversizedGrid();
+    ok &= BenchmarkBulkBuild();
+    BenchmarkBulkBuildCrossover();
+    ok &= TestSnapshot<smpl::EuclidDistanceMap>();
+    ok &= TestSnapshot<smpl::SparseDistanceMap>();
+    ok &= TestOverlay();
+    return ok ? 0 : 1;
 }
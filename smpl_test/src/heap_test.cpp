@@ -30,7 +30,10 @@
 /// \author Andrew Dornbush
 
 #include <stdio.h>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <type_traits>
 #include <utility>
@@ -41,6 +44,8 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/container/stable_vector.hpp>
 
+#include <smpl/heap/bucket_heap.h>
+#include <smpl/heap/intrusive_dary_heap.h>
 #include <smpl/heap/intrusive_heap.h>
 
 #define LOGDEBUG 0
@@ -66,7 +71,17 @@ struct open_element_compare
     }
 };
 
+struct open_element_key
+{
+    int operator()(const open_element& e) const
+    {
+        return e.priority;
+    }
+};
+
 typedef smpl::intrusive_heap<open_element, open_element_compare> heap_type;
+typedef smpl::bucket_heap<open_element, open_element_key> bucket_heap_type;
+typedef smpl::intrusive_dary_heap<open_element, open_element_key, 4> dary_heap_type;
 
 template <typename Iterator>
 class pointer_iterator :
@@ -91,6 +106,12 @@ public:
     pointer_iterator& operator++() { ++m_it; return *this; }
     ///@}
 
+    /// \name Bidirectional Iterator Requirements
+    ///@{}
+    pointer_iterator operator--(int) { pointer_iterator it(m_it); --m_it; return it; }
+    pointer_iterator& operator--() { --m_it; return *this; }
+    ///@}
+
     /// \name Random Access Iterator Requirements
     ///@{}
     pointer_iterator& operator+=(typename Base::difference_type n)
@@ -723,3 +744,399 @@ BOOST_AUTO_TEST_CASE(PushEraseTest)
         }
     }
 }
+
+BOOST_AUTO_TEST_CASE(BucketHeapPopTest)
+{
+    std::vector<open_element> elements = { 8, 10, 4, 2, 12, -3, 1000 };
+
+    bucket_heap_type h(pointer_it(elements.begin()), pointer_it(elements.end()));
+    BOOST_CHECK(h.size() == elements.size());
+
+    std::vector<int> popped;
+    while (!h.empty()) {
+        BOOST_CHECK(h.contains(h.min()));
+        open_element* e = h.min();
+        popped.push_back(e->priority);
+        h.pop();
+        BOOST_CHECK(!h.contains(e));
+    }
+    BOOST_CHECK((popped == std::vector<int>{ -3, 2, 4, 8, 10, 12, 1000 }));
+}
+
+BOOST_AUTO_TEST_CASE(BucketHeapMutabilityTest)
+{
+    // Test random pushes, erasures, and updates against the intrusive heap
+
+    std::vector<open_element> elements(100);
+    std::vector<open_element> bucket_elements(100);
+    std::vector<bool> inheap(elements.size(), false);
+
+    heap_type h;
+    bucket_heap_type bh;
+
+    std::default_random_engine rng;
+    std::uniform_int_distribution<int> dist(0, elements.size() - 1);
+    std::uniform_int_distribution<int> priority_dist(-500, 500);
+    std::uniform_int_distribution<int> op_dist(0, 3);
+
+    // unique priorities, so that both queues pop the same element
+    auto priority = [&](int r) { return (int)elements.size() * priority_dist(rng) + r; };
+
+    int num_trials = 10000;
+    for (int i = 0; i < num_trials; ++i) {
+        int r = dist(rng);
+        int op = op_dist(rng);
+        if (!inheap[r]) {
+            elements[r].priority = bucket_elements[r].priority = priority(r);
+            h.push(&elements[r]);
+            bh.push(&bucket_elements[r]);
+            inheap[r] = true;
+        } else if (op == 0) {
+            h.erase(&elements[r]);
+            bh.erase(&bucket_elements[r]);
+            inheap[r] = false;
+        } else if (op == 1 && !h.empty()) {
+            h.pop();
+            bh.pop();
+        } else {
+            elements[r].priority = bucket_elements[r].priority = priority(r);
+            h.update(&elements[r]);
+            bh.update(&bucket_elements[r]);
+        }
+
+        for (size_t ei = 0; ei < elements.size(); ++ei) {
+            inheap[ei] = h.contains(&elements[ei]);
+            BOOST_CHECK(inheap[ei] == bh.contains(&bucket_elements[ei]));
+        }
+
+        BOOST_CHECK(h.size() == bh.size());
+        if (!h.empty()) {
+            BOOST_CHECK(h.min()->priority == bh.min()->priority);
+        }
+    }
+}
+
+// Weighted A* over a 26-connected grid with uniform edge costs and an inflated
+// Chebyshev distance heuristic, similar to the f-values produced by searches
+// over ManipLattice with the BFS heuristic.
+template <template <class, class> class OpenList>
+struct GridSearch
+{
+    struct State : smpl::heap_element
+    {
+        int g;
+        int f;
+        bool closed;
+    };
+
+    struct StateCompare
+    {
+        bool operator()(const State& a, const State& b) const
+        {
+            return a.f < b.f;
+        }
+    };
+
+    struct StateKey
+    {
+        int operator()(const State& s) const
+        {
+            return s.f;
+        }
+    };
+
+    using Key = typename std::conditional<
+            std::is_same<OpenList<State, StateKey>, smpl::bucket_heap<State, StateKey>>::value,
+            StateKey,
+            StateCompare>::type;
+
+    int n;
+    std::vector<bool> walls;
+    std::vector<State> states;
+
+    GridSearch(int n, const std::vector<bool>& walls) : n(n), walls(walls) { }
+
+    int search(int start, int goal, int cost, int cost_per_cell, int eps, int& expansions)
+    {
+        auto coord = [&](int i, int& x, int& y, int& z) {
+            x = i % n;
+            y = i / n % n;
+            z = i / (n * n);
+        };
+        int gx, gy, gz;
+        coord(goal, gx, gy, gz);
+        auto heuristic = [&](int i) {
+            int x, y, z;
+            coord(i, x, y, z);
+            return cost_per_cell * std::max(std::abs(x - gx),
+                    std::max(std::abs(y - gy), std::abs(z - gz)));
+        };
+
+        states.assign(walls.size(), State());
+        for (auto& s : states) {
+            s.g = std::numeric_limits<int>::max();
+            s.closed = false;
+        }
+
+        OpenList<State, Key> open;
+        states[start].g = 0;
+        states[start].f = eps * heuristic(start);
+        open.push(&states[start]);
+        expansions = 0;
+        while (!open.empty()) {
+            State* s = open.min();
+            open.pop();
+            s->closed = true;
+            ++expansions;
+            int i = (int)(s - &states[0]);
+            if (i == goal) {
+                return s->g;
+            }
+            int x, y, z;
+            coord(i, x, y, z);
+            for (int dx = -1; dx <= 1; ++dx) {
+            for (int dy = -1; dy <= 1; ++dy) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                int sx = x + dx, sy = y + dy, sz = z + dz;
+                if (!(dx | dy | dz) ||
+                    sx < 0 || sy < 0 || sz < 0 || sx >= n || sy >= n || sz >= n)
+                {
+                    continue;
+                }
+                int j = (sz * n + sy) * n + sx;
+                State* succ = &states[j];
+                if (walls[j] || succ->closed || s->g + cost >= succ->g) {
+                    continue;
+                }
+                succ->g = s->g + cost;
+                succ->f = succ->g + eps * heuristic(j);
+                if (open.contains(succ)) {
+                    open.decrease(succ);
+                } else {
+                    open.push(succ);
+                }
+            }
+            }
+            }
+        }
+        return -1;
+    }
+};
+
+template <class T, class Key>
+using intrusive_heap_t = smpl::intrusive_heap<T, Key>;
+
+template <class T, class Key>
+using bucket_heap_t = smpl::bucket_heap<T, Key>;
+
+BOOST_AUTO_TEST_CASE(BucketHeapSearchBenchmark)
+{
+    const int n = 100;
+    std::vector<bool> walls(n * n * n, false);
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    for (size_t i = 0; i < walls.size(); ++i) {
+        walls[i] = u(rng) < 0.3;
+    }
+    const int start = 0;
+    const int goal = (int)walls.size() - 1;
+    walls[start] = walls[goal] = false;
+
+    GridSearch<intrusive_heap_t> heap_search(n, walls);
+    GridSearch<bucket_heap_t> bucket_search(n, walls);
+
+    using clock = std::chrono::steady_clock;
+    for (int eps : { 1, 10, 100 }) {
+        const int cost = 1000;
+        const int cost_per_cell = 100;
+
+        int heap_expansions, bucket_expansions;
+        auto t0 = clock::now();
+        int heap_cost = heap_search.search(start, goal, cost, cost_per_cell, eps, heap_expansions);
+        auto t1 = clock::now();
+        int bucket_cost = bucket_search.search(start, goal, cost, cost_per_cell, eps, bucket_expansions);
+        auto t2 = clock::now();
+
+        if (eps == 1) {
+            BOOST_CHECK(heap_cost == bucket_cost);
+        }
+
+        printf("eps %3d: intrusive_heap %.4fs (%d expansions, cost %d), bucket_heap %.4fs (%d expansions, cost %d)\n",
+                eps,
+                std::chrono::duration<double>(t1 - t0).count(), heap_expansions, heap_cost,
+                std::chrono::duration<double>(t2 - t1).count(), bucket_expansions, bucket_cost);
+    }
+}
+
+template <int D>
+void CheckDaryHeap()
+{
+    // Test random pushes, pops, erasures, and updates against a linear search
+    // for the minimum element
+
+    typedef smpl::intrusive_dary_heap<open_element, open_element_key, D> heap;
+
+    std::vector<open_element> elements(200);
+    heap h;
+
+    std::default_random_engine rng;
+    std::uniform_int_distribution<int> dist(0, elements.size() - 1);
+    std::uniform_int_distribution<int> priority_dist(-1000, 1000);
+    std::uniform_int_distribution<int> op_dist(0, 4);
+
+    int num_trials = 20000;
+    for (int i = 0; i < num_trials; ++i) {
+        int r = dist(rng);
+        int op = op_dist(rng);
+        if (!h.contains(&elements[r])) {
+            elements[r].priority = priority_dist(rng);
+            h.push(&elements[r]);
+        } else if (op == 0) {
+            h.erase(&elements[r]);
+        } else if (op == 1) {
+            h.pop();
+        } else if (op == 2) {
+            elements[r].priority -= std::abs(priority_dist(rng));
+            h.decrease(&elements[r]);
+        } else if (op == 3) {
+            elements[r].priority += std::abs(priority_dist(rng));
+            h.increase(&elements[r]);
+        } else {
+            elements[r].priority = priority_dist(rng);
+            h.update(&elements[r]);
+        }
+
+        size_t count = 0;
+        int min_priority = std::numeric_limits<int>::max();
+        for (auto& e : elements) {
+            if (h.contains(&e)) {
+                ++count;
+                min_priority = std::min(min_priority, e.priority);
+            }
+        }
+        BOOST_CHECK(h.size() == count);
+        BOOST_CHECK(std::distance(h.begin(), h.end()) == count);
+        if (!h.empty()) {
+            BOOST_CHECK(h.min()->priority == min_priority);
+        }
+    }
+
+    // reorder after changing all priorities
+    for (auto& e : elements) {
+        e.priority = priority_dist(rng);
+    }
+    h.make();
+    int prev = std::numeric_limits<int>::min();
+    while (!h.empty()) {
+        BOOST_CHECK(h.min()->priority >= prev);
+        prev = h.min()->priority;
+        h.pop();
+    }
+
+    // reorder a heap with a single element
+    h.push(&elements[0]);
+    elements[0].priority = priority_dist(rng);
+    h.make();
+    BOOST_CHECK(h.size() == 1 && h.min() == &elements[0]);
+}
+
+BOOST_AUTO_TEST_CASE(DaryHeapTest)
+{
+    CheckDaryHeap<2>();
+    CheckDaryHeap<4>();
+    CheckDaryHeap<8>();
+
+    std::vector<open_element> elements = { 8, 10, 4, 2, 12 };
+    dary_heap_type h(pointer_it(elements.begin()), pointer_it(elements.end()));
+    BOOST_CHECK(h.size() == 5);
+    BOOST_CHECK(h.min() == &elements[3]);
+
+    dary_heap_type h2(std::move(h));
+    BOOST_CHECK(h.empty());
+    BOOST_CHECK(h2.size() == 5);
+    BOOST_CHECK(h2.min() == &elements[3]);
+
+    h2.clear();
+    BOOST_CHECK(h2.empty());
+    BOOST_CHECK(!h2.contains(&elements[3]));
+}
+
+// Time 1M pushes followed by 1M pops, and a Dijkstra-like workload that
+// repeatedly pops the minimum, pushes successors with larger keys, and
+// decreases the keys of elements already in the heap.
+template <class Heap>
+void BenchmarkHeap(const char* name, std::vector<open_element>& elements)
+{
+    std::default_random_engine rng;
+    std::uniform_int_distribution<int> priority_dist(0, 1000000);
+    std::uniform_int_distribution<int> succ_dist(1, 1000);
+    std::uniform_int_distribution<size_t> index_dist(0, elements.size() - 1);
+
+    using clock = std::chrono::steady_clock;
+
+    std::vector<open_element*> order(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) {
+        order[i] = &elements[i];
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+
+    Heap h;
+    auto t0 = clock::now();
+    for (open_element* e : order) {
+        e->priority = priority_dist(rng);
+        h.push(e);
+    }
+    long long checksum = 0;
+    while (!h.empty()) {
+        checksum += h.min()->priority;
+        h.pop();
+    }
+    auto t1 = clock::now();
+
+    // keep half of the elements in the heap while popping and pushing
+    for (size_t i = 0; i < elements.size() / 2; ++i) {
+        open_element* e = &elements[index_dist(rng)];
+        if (!h.contains(e)) {
+            e->priority = priority_dist(rng);
+            h.push(e);
+        }
+    }
+    for (size_t i = 0; i < elements.size(); ++i) {
+        open_element* min = h.min();
+        const int f = min->priority;
+        checksum += f;
+        h.pop();
+        for (int s = 0; s < 2; ++s) {
+            open_element* e = &elements[index_dist(rng)];
+            const int fs = f + succ_dist(rng);
+            if (!h.contains(e)) {
+                e->priority = fs;
+                h.push(e);
+            } else if (fs < e->priority) {
+                e->priority = fs;
+                h.decrease(e);
+            }
+        }
+    }
+    auto t2 = clock::now();
+
+    printf("%s: push/pop %.3fs, search %.3fs (checksum %lld)\n",
+            name,
+            std::chrono::duration<double>(t1 - t0).count(),
+            std::chrono::duration<double>(t2 - t1).count(),
+            checksum);
+}
+
+BOOST_AUTO_TEST_CASE(DaryHeapBenchmark)
+{
+    const size_t count = 1000000;
+
+    // elements are pushed in a random order and accessed at random indices
+    // of an array much larger than the cache
+    std::vector<open_element> elements(count);
+
+    BenchmarkHeap<heap_type>("intrusive_heap", elements);
+    BenchmarkHeap<smpl::intrusive_dary_heap<open_element, open_element_key, 2>>("intrusive_dary_heap<2>", elements);
+    BenchmarkHeap<smpl::intrusive_dary_heap<open_element, open_element_key, 4>>("intrusive_dary_heap<4>", elements);
+    BenchmarkHeap<smpl::intrusive_dary_heap<open_element, open_element_key, 8>>("intrusive_dary_heap<8>", elements);
+}
@@ -0,0 +1,206 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2017, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#define BOOST_TEST_MODULE LazyARAStarTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/search/lazy_arastar.h>
+
+// 4-connected grid whose edges are all estimated at unit cost; evaluating an
+// edge reveals a true cost of 1, 3, or invalid
+struct LazyGrid : public smpl::ILazySuccFun
+{
+    int width;
+    int height;
+    std::vector<int> cell_costs;
+
+    // sizes of the batches passed to GetSuccTrueCosts
+    std::vector<int> batch_sizes;
+
+    LazyGrid(int w, int h, unsigned int seed) : width(w), height(h)
+    {
+        std::default_random_engine rng(seed);
+        std::uniform_int_distribution<int> dist(0, 9);
+        for (int i = 0; i < w * h; ++i) {
+            int r = dist(rng);
+            cell_costs.push_back(r < 2 ? -1 : (r < 4 ? 3 : 1));
+        }
+        cell_costs.front() = 1;
+        cell_costs.back() = 1;
+    }
+
+    int goal() const { return width * height - 1; }
+
+    template <class Visitor>
+    void visitNeighbors(int state_id, Visitor visit) const
+    {
+        int x = state_id % width;
+        int y = state_id / width;
+        if (x > 0) visit(state_id - 1);
+        if (x < width - 1) visit(state_id + 1);
+        if (y > 0) visit(state_id - width);
+        if (y < height - 1) visit(state_id + width);
+    }
+
+    void GetLazySuccs(
+        int state_id,
+        std::vector<int>& succs,
+        std::vector<int>& costs,
+        std::vector<bool>& true_costs) override
+    {
+        visitNeighbors(state_id, [&](int succ_id) {
+            succs.push_back(succ_id);
+            costs.push_back(1);
+            true_costs.push_back(false);
+        });
+    }
+
+    int GetSuccTrueCost(int state_id, int succ_id) override
+    {
+        return cell_costs[succ_id];
+    }
+
+    void GetSuccTrueCosts(
+        const int* state_ids,
+        const int* succ_ids,
+        int count,
+        int* costs) override
+    {
+        batch_sizes.push_back(count);
+        ILazySuccFun::GetSuccTrueCosts(state_ids, succ_ids, count, costs);
+    }
+
+    // cost of the cheapest path from the first to the last cell, or -1
+    int shortestPathCost() const
+    {
+        std::vector<int> g(width * height, -1);
+        using entry = std::pair<int, int>;
+        std::priority_queue<entry, std::vector<entry>, std::greater<entry>> open;
+        open.push(entry(0, 0));
+        while (!open.empty()) {
+            auto e = open.top();
+            open.pop();
+            if (g[e.second] >= 0) continue;
+            g[e.second] = e.first;
+            visitNeighbors(e.second, [&](int succ_id) {
+                if (g[succ_id] < 0 && cell_costs[succ_id] >= 0) {
+                    open.push(entry(e.first + cell_costs[succ_id], succ_id));
+                }
+            });
+        }
+        return g[goal()];
+    }
+};
+
+struct ManhattanHeuristic : public smpl::RobotHeuristic
+{
+    const LazyGrid* grid;
+
+    double getMetricStartDistance(double x, double y, double z) override { return 0.0; }
+    double getMetricGoalDistance(double x, double y, double z) override { return 0.0; }
+
+    int GetGoalHeuristic(int state_id) override
+    {
+        return GetFromToHeuristic(state_id, grid->goal());
+    }
+
+    int GetStartHeuristic(int state_id) override
+    {
+        return GetFromToHeuristic(0, state_id);
+    }
+
+    int GetFromToHeuristic(int from_id, int to_id) override
+    {
+        return std::abs(from_id % grid->width - to_id % grid->width) +
+                std::abs(from_id / grid->width - to_id / grid->width);
+    }
+
+    Extension* getExtension(size_t class_code) override { return nullptr; }
+};
+
+// Plan across the grid, returning the cost of the solution or -1 if none was
+// found
+static int PlanWithBatchSize(LazyGrid& grid, int batch_size)
+{
+    ManhattanHeuristic h;
+    h.grid = &grid;
+
+    smpl::LazyARAStar search;
+    BOOST_REQUIRE(smpl::Init(search, &grid, &h));
+    smpl::SetEvalBatchSize(search, batch_size);
+
+    std::vector<int> solution;
+    int cost;
+    if (smpl::Replan(search, 0, grid.goal(), solution, cost) != 0) {
+        return -1;
+    }
+
+    BOOST_CHECK_EQUAL(solution.front(), 0);
+    BOOST_CHECK_EQUAL(solution.back(), grid.goal());
+    BOOST_CHECK_GT(search.expand_count_, 0);
+    return cost;
+}
+
+BOOST_AUTO_TEST_CASE(BatchedEvaluationTest)
+{
+    int solved = 0;
+    for (unsigned int seed = 0; seed < 20; ++seed) {
+        LazyGrid grid(20, 20, seed);
+        int expected = grid.shortestPathCost();
+
+        BOOST_CHECK_EQUAL(PlanWithBatchSize(grid, 1), expected);
+        BOOST_CHECK(std::all_of(
+                begin(grid.batch_sizes), end(grid.batch_sizes),
+                [](int n) { return n == 1; }));
+
+        grid.batch_sizes.clear();
+        BOOST_CHECK_EQUAL(PlanWithBatchSize(grid, 4), expected);
+        BOOST_CHECK(std::all_of(
+                begin(grid.batch_sizes), end(grid.batch_sizes),
+                [](int n) { return n >= 1 && n <= 4; }));
+
+        if (expected >= 0) {
+            ++solved;
+            BOOST_CHECK(std::any_of(
+                    begin(grid.batch_sizes), end(grid.batch_sizes),
+                    [](int n) { return n > 1; }));
+        }
+    }
+    BOOST_CHECK_GT(solved, 0);
+}
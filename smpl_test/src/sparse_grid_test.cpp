@@ -1,5 +1,9 @@
+#include <chrono>
 #include <iostream>
+#include <algorithm>
+#include <random>
 #include <unordered_map>
+#include <vector>
 
 #include <Eigen/Dense>
 #define BOOST_TEST_MODULE OcTreeTest
@@ -7,6 +11,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <smpl/grid/sparse_grid.h>
+#include <smpl/octree/pool_allocator.h>
 
 BOOST_AUTO_TEST_CASE(DefaultConstructorTest)
 {
@@ -355,4 +360,405 @@ BOOST_AUTO_TEST_CASE(ResizeTest)
     BOOST_CHECK_EQUAL(g.max_depth(), 3);
 }
 
+BOOST_AUTO_TEST_CASE(PoolAllocatorTest)
+{
+    using PoolGrid = smpl::SparseGrid<int, smpl::PoolAllocator<int>>;
+    PoolGrid g(0);
+    smpl::SparseGrid<int> h(0);
+
+    std::default_random_engine rng;
+    std::uniform_int_distribution<int> coord(0, 255);
+    for (int i = 0; i < 10000; ++i) {
+        int x = coord(rng), y = coord(rng), z = coord(rng);
+        int v = i % 3;
+        g.set(x, y, z, v);
+        h.set(x, y, z, v);
+    }
+
+    BOOST_CHECK_EQUAL(g.tree().num_nodes(), h.tree().num_nodes());
+    for (int i = 0; i < 1000; ++i) {
+        int x = coord(rng), y = coord(rng), z = coord(rng);
+        BOOST_CHECK_EQUAL(g.get(x, y, z), h.get(x, y, z));
+    }
+
+    auto stats = g.tree().get_allocator().stats();
+    BOOST_CHECK_EQUAL(
+            stats.blocks_used, (g.tree().num_nodes() - 1) / 8);
+    BOOST_CHECK_GE(g.mem_usage(), stats.blocks_used * stats.block_size);
+
+    // copies get their own pool
+    PoolGrid cg(g);
+    BOOST_CHECK(cg.tree().get_allocator() != g.tree().get_allocator());
+    BOOST_CHECK_EQUAL(cg.get(0, 0, 0), g.get(0, 0, 0));
+
+    g.reset(0);
+    stats = g.tree().get_allocator().stats();
+    BOOST_CHECK_EQUAL(stats.blocks_used, 0);
+    BOOST_CHECK_EQUAL(stats.slab_count, 0);
+    BOOST_CHECK_EQUAL(g.tree().num_nodes(), 1);
+    BOOST_CHECK_EQUAL(cg.tree().num_nodes(), h.tree().num_nodes());
+
+    // non-trivial types are destroyed node by node and recycled
+    smpl::SparseGrid<std::string, smpl::PoolAllocator<std::string>> sg("a");
+    sg.set(0, 0, 0, "b");
+    sg.set(0, 0, 0, "a");
+    BOOST_CHECK_EQUAL(sg.tree().get_allocator().stats().blocks_used, 0);
+    sg.set(1, 2, 3, "c");
+    sg.reset("d");
+    BOOST_CHECK_EQUAL(sg.get(1, 2, 3), "d");
+}
+
+template <class Grid>
+double TimeNodeChurn(Grid& g, int iterations)
+{
+    std::default_random_engine rng;
+    std::uniform_int_distribution<int> coord(0, 1023);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        // each set expands a path to a leaf and the matching unset prunes it
+        int x = coord(rng), y = coord(rng), z = coord(rng);
+        g.set(x, y, z, 1);
+        if (i & 1) {
+            g.set(x, y, z, 0);
+        }
+        if (i % 100000 == 99999 && i + 1 < iterations) {
+            g.reset(0);
+        }
+    }
+    return std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+BOOST_AUTO_TEST_CASE(PoolAllocatorBenchmark)
+{
+    const int iterations = 1000000;
+
+    smpl::SparseGrid<int> g(1024, 1024, 1024, 0);
+    double t_std = TimeNodeChurn(g, iterations);
+
+    smpl::SparseGrid<int, smpl::PoolAllocator<int>> pg(1024, 1024, 1024, 0);
+    double t_pool = TimeNodeChurn(pg, iterations);
+
+    BOOST_CHECK_EQUAL(g.tree().num_nodes(), pg.tree().num_nodes());
+
+    auto stats = pg.tree().get_allocator().stats();
+    std::cout << "node churn (" << iterations << " sets):" << std::endl;
+    std::cout << "  std::allocator:  " << t_std << " s" << std::endl;
+    std::cout << "  PoolAllocator:   " << t_pool << " s" << std::endl;
+    std::cout << "  pool: " << stats.slab_count << " slabs, " <<
+            stats.blocks_used << " blocks used, " <<
+            stats.blocks_free << " blocks free, " <<
+            stats.bytes_reserved << " B reserved" << std::endl;
+}
+
+// A dense copy of the values of a small cubic SparseGrid<int>
+struct DenseReference
+{
+    int n;
+    std::vector<int> values;
+
+    DenseReference(int n, int value) : n(n), values(n * n * n, value) { }
+
+    int& operator()(int x, int y, int z) { return values[(x * n + y) * n + z]; }
+};
+
+bool MatchesReference(const smpl::SparseGrid<int>& g, DenseReference& d)
+{
+    for (int x = 0; x < d.n; ++x) {
+    for (int y = 0; y < d.n; ++y) {
+    for (int z = 0; z < d.n; ++z) {
+        if (g.get(x, y, z) != d(x, y, z)) {
+            return false;
+        }
+    }
+    }
+    }
+    return true;
+}
+
+// Fill boxes of random size with random values, so that leaves are left at
+// many depths
+void SetRandomBoxes(
+    std::default_random_engine& rng,
+    int count,
+    smpl::SparseGrid<int>& g,
+    DenseReference& d)
+{
+    std::uniform_int_distribution<int> coord_dist(0, d.n - 1);
+    std::uniform_int_distribution<int> extent_dist(1, 8);
+    std::uniform_int_distribution<int> value_dist(0, 3);
+    for (int i = 0; i < count; ++i) {
+        int x0 = coord_dist(rng), y0 = coord_dist(rng), z0 = coord_dist(rng);
+        int x1 = std::min(d.n, x0 + extent_dist(rng));
+        int y1 = std::min(d.n, y0 + extent_dist(rng));
+        int z1 = std::min(d.n, z0 + extent_dist(rng));
+        int v = value_dist(rng);
+        for (int x = x0; x < x1; ++x) {
+        for (int y = y0; y < y1; ++y) {
+        for (int z = z0; z < z1; ++z) {
+            g.set(x, y, z, v);
+            d(x, y, z) = v;
+        }
+        }
+        }
+    }
+}
+
+void CheckBatchGet(
+    const smpl::SparseGrid<int>& g,
+    DenseReference& d,
+    const std::vector<int>& coords)
+{
+    size_t count = coords.size() / 3;
+    std::vector<const int*> values(count);
+    g.get(coords.data(), count, values.data());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (*values[i] != d(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2])) {
+            ++mismatches;
+        }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(BatchGetTest)
+{
+    const int n = 32;
+    std::default_random_engine rng;
+    smpl::SparseGrid<int> g(n, n, n, 0);
+    DenseReference d(n, 0);
+    SetRandomBoxes(rng, 200, g, d);
+
+    // every cell, in row-major order
+    std::vector<int> coords;
+    for (int x = 0; x < n; ++x) {
+    for (int y = 0; y < n; ++y) {
+    for (int z = 0; z < n; ++z) {
+        coords.insert(coords.end(), { x, y, z });
+    }
+    }
+    }
+    CheckBatchGet(g, d, coords);
+
+    // random cells, with repeats and steps to neighboring cells
+    std::uniform_int_distribution<int> coord_dist(0, n - 1);
+    std::uniform_int_distribution<int> step_dist(-1, 1);
+    coords.clear();
+    for (int i = 0; i < 20000; ++i) {
+        switch (i % 3) {
+        case 0:
+            coords.insert(coords.end(), { coord_dist(rng), coord_dist(rng), coord_dist(rng) });
+            break;
+        case 1:
+            coords.insert(coords.end(), { coords[3 * i - 3], coords[3 * i - 2], coords[3 * i - 1] });
+            break;
+        default:
+            for (int a = 0; a < 3; ++a) {
+                auto c = coords[3 * i - 3 + a] + step_dist(rng);
+                coords.push_back(std::max(0, std::min(n - 1, c)));
+            }
+            break;
+        }
+    }
+    CheckBatchGet(g, d, coords);
+
+    // a single cell, and the cells of a fully collapsed grid
+    CheckBatchGet(g, d, { 5, 6, 7 });
+    g.reset(2);
+    d = DenseReference(n, 2);
+    CheckBatchGet(g, d, coords);
+}
+
+// Interleave modifications with lookups near the most recently looked up
+// cell, so that lookups are likely to hit the leaf cached before the
+// modification
+BOOST_AUTO_TEST_CASE(LeafCacheSetTest)
+{
+    const int n = 32;
+    std::default_random_engine rng;
+    smpl::SparseGrid<int> g(n, n, n, 0);
+    DenseReference d(n, 0);
+    SetRandomBoxes(rng, 50, g, d);
+
+    std::uniform_int_distribution<int> coord_dist(0, n - 1);
+    std::uniform_int_distribution<int> step_dist(-2, 2);
+    std::uniform_int_distribution<int> value_dist(0, 3);
+    std::uniform_int_distribution<int> op_dist(0, 3);
+    int x = 0, y = 0, z = 0;
+    int mismatches = 0;
+    for (int i = 0; i < 100000; ++i) {
+        if (i % 64 == 0) {
+            x = coord_dist(rng);
+            y = coord_dist(rng);
+            z = coord_dist(rng);
+        } else {
+            x = std::max(0, std::min(n - 1, x + step_dist(rng)));
+            y = std::max(0, std::min(n - 1, y + step_dist(rng)));
+            z = std::max(0, std::min(n - 1, z + step_dist(rng)));
+        }
+
+        auto v = value_dist(rng);
+        switch (op_dist(rng)) {
+        case 0:
+            g.set(x, y, z, v);
+            d(x, y, z) = v;
+            break;
+        case 1:
+            g(x, y, z) = v;
+            d(x, y, z) = v;
+            break;
+        default:
+            if (g.get(x, y, z) != d(x, y, z)) {
+                ++mismatches;
+            }
+            break;
+        }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+    BOOST_CHECK(MatchesReference(g, d));
+}
+
+BOOST_AUTO_TEST_CASE(LeafCacheResetTest)
+{
+    smpl::SparseGrid<int> g(32, 32, 32, 0);
+    g.set(1, 2, 3, 7);
+    BOOST_CHECK_EQUAL(g.get(1, 2, 3), 7);
+    BOOST_CHECK_EQUAL(g.get(0, 0, 0), 0);
+
+    g.reset(4);
+    BOOST_CHECK_EQUAL(g.get(0, 0, 0), 4);
+    BOOST_CHECK_EQUAL(g.get(1, 2, 3), 4);
+
+    g.resize(16, 16, 16, 9);
+    BOOST_CHECK_EQUAL(g.get(0, 0, 0), 9);
+    BOOST_CHECK_EQUAL(g.get(1, 2, 3), 9);
+}
+
+// Lookups cached for one grid must not be used for its copies, in either
+// direction, or for the target of an assignment
+BOOST_AUTO_TEST_CASE(LeafCacheCopyTest)
+{
+    const int n = 32;
+    std::default_random_engine rng;
+    smpl::SparseGrid<int> g(n, n, n, 0);
+    DenseReference d(n, 0);
+    SetRandomBoxes(rng, 50, g, d);
+
+    // a lookup cached for the original, which is then modified in place
+    g.set(4, 5, 6, 1);
+    d(4, 5, 6) = 1;
+    BOOST_CHECK_EQUAL(g.get(4, 5, 6), 1);
+    smpl::SparseGrid<int> cg(g);
+    g.set(4, 5, 6, 2);
+    BOOST_CHECK_EQUAL(cg.get(4, 5, 6), 1);
+    g.set(4, 5, 6, 1);
+
+    BOOST_CHECK_EQUAL(g.get(4, 5, 6), d(4, 5, 6));
+    cg.set(4, 5, 6, 9);
+    BOOST_CHECK_EQUAL(cg.get(4, 5, 6), 9);
+    BOOST_CHECK_EQUAL(g.get(4, 5, 6), d(4, 5, 6));
+    BOOST_CHECK_EQUAL(cg.get(4, 5, 6), 9);
+
+    smpl::SparseGrid<int> h(n, n, n, 8);
+    BOOST_CHECK_EQUAL(h.get(4, 5, 6), 8);
+    h = g;
+    BOOST_CHECK_EQUAL(h.get(4, 5, 6), d(4, 5, 6));
+    BOOST_CHECK(MatchesReference(h, d));
+
+    smpl::SparseGrid<int> m(n, n, n, 8);
+    BOOST_CHECK_EQUAL(m.get(4, 5, 6), 8);
+    m = std::move(cg);
+    BOOST_CHECK_EQUAL(m.get(4, 5, 6), 9);
+
+    smpl::SparseGrid<int> mc(std::move(h));
+    BOOST_CHECK(MatchesReference(mc, d));
+    BOOST_CHECK(MatchesReference(g, d));
+}
+
+// Pruning frees the leaves it collapses. The freed nodes are reused by another
+// grid before the next lookup, so a stale cached leaf would show its values.
+BOOST_AUTO_TEST_CASE(LeafCachePruneTest)
+{
+    const int n = 32;
+    smpl::SparseGrid<int> g(n, n, n, 0);
+    DenseReference d(n, 0);
+    for (int x = 0; x < 4; ++x) {
+    for (int y = 0; y < 4; ++y) {
+    for (int z = 0; z < 4; ++z) {
+        g.set_lazy(x, y, z, 5);
+        d(x, y, z) = 5;
+    }
+    }
+    }
+    BOOST_CHECK_EQUAL(g.get(1, 1, 1), 5);
+
+    g.prune();
+    BOOST_CHECK_EQUAL(g.tree().num_leaves(), 7 + 7 + 8);
+
+    smpl::SparseGrid<int> h(n, n, n, 0);
+    for (int i = 0; i < 8; ++i) {
+        h.set(i, i, i, -1);
+    }
+
+    BOOST_CHECK_EQUAL(g.get(1, 1, 1), 5);
+    BOOST_CHECK(MatchesReference(g, d));
+
+    // pruning with a predicate
+    g.set_lazy(2, 2, 2, 6);
+    g.set_lazy(2, 2, 2, 5);
+    BOOST_CHECK_EQUAL(g.get(2, 2, 2), 5);
+    g.prune([](int v) { return v == 5; });
+    h.reset(0);
+    for (int i = 0; i < 8; ++i) {
+        h.set(i, i, i, -1);
+    }
+    BOOST_CHECK_EQUAL(g.get(2, 2, 2), 5);
+    BOOST_CHECK(MatchesReference(g, d));
+}
+
+// Compare scalar lookups of the cells of a row-major scan with a single batch
+// lookup of the same cells
+BOOST_AUTO_TEST_CASE(BatchGetBenchmark)
+{
+    const int n = 128;
+    std::default_random_engine rng;
+    smpl::SparseGrid<int> g(n, n, n, 0);
+    DenseReference d(n, 0);
+    SetRandomBoxes(rng, 2000, g, d);
+
+    std::vector<int> coords;
+    for (int x = 0; x < n; ++x) {
+    for (int y = 0; y < n; ++y) {
+    for (int z = 0; z < n; ++z) {
+        coords.insert(coords.end(), { x, y, z });
+    }
+    }
+    }
+    size_t count = coords.size() / 3;
+
+    auto start = std::chrono::steady_clock::now();
+    long long scalar_sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        scalar_sum += g.get(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+    }
+    double t_scalar = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    std::vector<const int*> values(count);
+    start = std::chrono::steady_clock::now();
+    g.get(coords.data(), count, values.data());
+    long long batch_sum = 0;
+    for (size_t i = 0; i < count; ++i) {
+        batch_sum += *values[i];
+    }
+    double t_batch = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    BOOST_CHECK_EQUAL(scalar_sum, batch_sum);
+    std::cout << "lookup of " << count << " cells:" << std::endl;
+    std::cout << "  scalar: " << t_scalar << " s" << std::endl;
+    std::cout << "  batch:  " << t_batch << " s" << std::endl;
+}
+
 // TODO: Test throwing constructor/destructor
@@ -0,0 +1,394 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright (c) 2018, Andrew Dornbush
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     1. Redistributions of source code must retain the above copyright notice
+//        this list of conditions and the following disclaimer.
+//     2. Redistributions in binary form must reproduce the above copyright
+//        notice, this list of conditions and the following disclaimer in the
+//        documentation and/or other materials provided with the distribution.
+//     3. Neither the name of the copyright holder nor the names of its
+//        contributors may be used to endorse or promote products derived from
+//        this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#define BOOST_TEST_MODULE WorkspaceLatticeIKCacheTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <smpl/collision_checker.h>
+#include <smpl/robot_model.h>
+#include <smpl/graph/workspace_lattice_base.h>
+
+// Cartesian robot { x, y, z, elbow, fa } whose elbow picks one of two ik
+// branches and whose free angle fa does not move the end effector. Poses with
+// x > 1 are unreachable. Counts the ik queries that reach the solver.
+struct BranchingRobot :
+    public smpl::ForwardKinematicsInterface,
+    public smpl::InverseKinematicsInterface,
+    public smpl::RedundantManipulatorInterface
+{
+    double base_x = 0.0;
+    int fast_ik_calls = 0;
+    int batch_ik_calls = 0;
+
+    BranchingRobot()
+    {
+        setPlanningJoints({ "x", "y", "z", "elbow", "fa" });
+    }
+
+    double minPosLimit(int jidx) const override { return -M_PI; }
+    double maxPosLimit(int jidx) const override { return M_PI; }
+    bool hasPosLimit(int jidx) const override { return true; }
+    bool isContinuous(int jidx) const override { return false; }
+    double velLimit(int jidx) const override { return 0.0; }
+    double accLimit(int jidx) const override { return 0.0; }
+    bool checkJointLimits(const smpl::RobotState& state, bool verbose) override
+    {
+        return true;
+    }
+
+    auto computeFK(const smpl::RobotState& state) -> smpl::Affine3 override
+    {
+        return smpl::Affine3(smpl::Translation3(
+                base_x + state[0], state[1], state[2]));
+    }
+
+    bool computeIK(
+        const smpl::Affine3& pose,
+        const smpl::RobotState& start,
+        smpl::RobotState& solution,
+        smpl::ik_option::IkOption option) override
+    {
+        return computeFastIK(pose, start, solution);
+    }
+
+    bool computeIK(
+        const smpl::Affine3& pose,
+        const smpl::RobotState& start,
+        std::vector<smpl::RobotState>& solutions,
+        smpl::ik_option::IkOption option) override
+    {
+        return false;
+    }
+
+    const int redundantVariableCount() const override { return 1; }
+    const int redundantVariableIndex(int rvidx) const override { return 4; }
+
+    bool solve(
+        const smpl::Affine3& pose,
+        const smpl::RobotState& seed,
+        double elbow,
+        smpl::RobotState& solution) const
+    {
+        auto p = pose.translation();
+        if (p.x() > 1.0) {
+            return false;
+        }
+        solution = { p.x() - base_x, p.y(), p.z(), elbow, seed[4] };
+        return true;
+    }
+
+    bool computeFastIK(
+        const smpl::Affine3& pose,
+        const smpl::RobotState& seed,
+        smpl::RobotState& solution) override
+    {
+        ++fast_ik_calls;
+        return solve(pose, seed, seed[3] >= 0.0 ? 1.0 : -1.0, solution);
+    }
+
+    bool computeFastIKBatch(
+        const smpl::Affine3& pose,
+        const smpl::RobotState* seeds,
+        int count,
+        std::vector<smpl::RobotState>& solutions,
+        std::vector<int>* seed_indices) override
+    {
+        ++batch_ik_calls;
+        auto found = false;
+        for (int i = 0; i < count; ++i) {
+            auto elbow = seeds[i][3] >= 0.0 ? 1.0 : -1.0;
+            for (auto e : { elbow, -elbow }) {
+                smpl::RobotState solution;
+                if (solve(pose, seeds[i], e, solution)) {
+                    solutions.push_back(solution);
+                    if (seed_indices) seed_indices->push_back(i);
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        if (class_code == smpl::GetClassCode<smpl::RobotModel>() ||
+            class_code == smpl::GetClassCode<smpl::ForwardKinematicsInterface>() ||
+            class_code == smpl::GetClassCode<smpl::InverseKinematicsInterface>() ||
+            class_code == smpl::GetClassCode<smpl::RedundantManipulatorInterface>())
+        {
+            return this;
+        }
+        return nullptr;
+    }
+};
+
+struct EmptyChecker : public smpl::CollisionChecker
+{
+    bool isStateValid(const smpl::RobotState& state, bool verbose) override
+    {
+        return true;
+    }
+
+    bool isStateToStateValid(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish,
+        bool verbose) override
+    {
+        return true;
+    }
+
+    bool interpolatePath(
+        const smpl::RobotState& start,
+        const smpl::RobotState& finish,
+        std::vector<smpl::RobotState>& path) override
+    {
+        path = { start, finish };
+        return true;
+    }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        return class_code == smpl::GetClassCode<smpl::CollisionChecker>() ?
+                this : nullptr;
+    }
+};
+
+// only the workspace conversions and the ik cache are exercised
+struct TestLattice : public smpl::WorkspaceLatticeBase
+{
+    int getStartStateID() const override { return -1; }
+    int getGoalStateID() const override { return -1; }
+
+    bool extractPath(
+        const std::vector<int>& ids,
+        std::vector<smpl::RobotState>& path) override
+    {
+        return false;
+    }
+
+    void GetSuccs(
+        int state_id,
+        std::vector<int>* succs,
+        std::vector<int>* costs) override
+    { }
+
+    void GetPreds(
+        int state_id,
+        std::vector<int>* preds,
+        std::vector<int>* costs) override
+    { }
+
+    void PrintState(int state_id, bool verbose, FILE* f) override { }
+
+    auto getExtension(size_t class_code) -> smpl::Extension* override
+    {
+        return nullptr;
+    }
+};
+
+struct Fixture
+{
+    BranchingRobot robot;
+    EmptyChecker checker;
+    TestLattice lattice;
+
+    explicit Fixture(int cache_size)
+    {
+        smpl::WorkspaceLatticeBase::Params params;
+        params.res_x = params.res_y = params.res_z = 0.1;
+        params.R_count = 36;
+        params.P_count = 19;
+        params.Y_count = 36;
+        params.free_angle_res = { 0.1 };
+        params.ik_cache_size = cache_size;
+        BOOST_REQUIRE(lattice.init(&robot, &checker, params));
+    }
+
+    // the workspace state at the center of the cell { x, 0, 0, 0, 0, 0, fa }
+    auto cell(int x, int fa = 0) -> smpl::WorkspaceState
+    {
+        smpl::WorkspaceCoord coord(lattice.dofCount(), 0);
+        coord[0] = x;
+        coord[6] = fa;
+        smpl::WorkspaceState state;
+        lattice.stateCoordToWorkspace(coord, state);
+        return state;
+    }
+
+    // a seed on the positive elbow branch with the free angle of the state
+    auto seed(const smpl::WorkspaceState& state) -> smpl::RobotState
+    {
+        return { 0.0, 0.0, 0.0, 0.5, state[6] };
+    }
+
+    bool nearest(const smpl::WorkspaceState& state, smpl::RobotState& solution)
+    {
+        return lattice.stateWorkspaceToRobot(state, seed(state), solution);
+    }
+
+    bool all(
+        const smpl::WorkspaceState& state,
+        std::vector<smpl::RobotState>& solutions)
+    {
+        solutions.clear();
+        return lattice.stateWorkspaceToRobotSolutions(
+                state, seed(state), solutions);
+    }
+
+    // the first workspace coordinate of each cache entry, most recent first
+    auto order() const -> std::vector<int>
+    {
+        std::vector<int> xs;
+        for (auto& entry : lattice.m_ik_cache) {
+            xs.push_back(entry.key[0]);
+        }
+        return xs;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(LRUOrderAndEvictionTest)
+{
+    Fixture f(2);
+    smpl::RobotState solution;
+
+    BOOST_CHECK(f.nearest(f.cell(1), solution));
+    BOOST_CHECK(f.nearest(f.cell(2), solution));
+    BOOST_CHECK((f.order() == std::vector<int>{ 2, 1 }));
+
+    // a hit moves the entry to the front
+    BOOST_CHECK(f.nearest(f.cell(1), solution));
+    BOOST_CHECK((f.order() == std::vector<int>{ 1, 2 }));
+    BOOST_CHECK_EQUAL(f.robot.fast_ik_calls, 2);
+
+    // a miss evicts the least recently used entry
+    BOOST_CHECK(f.nearest(f.cell(3), solution));
+    BOOST_CHECK((f.order() == std::vector<int>{ 3, 1 }));
+    BOOST_CHECK(f.nearest(f.cell(2), solution));
+    BOOST_CHECK((f.order() == std::vector<int>{ 2, 3 }));
+    BOOST_CHECK_EQUAL(f.robot.fast_ik_calls, 4);
+
+    auto& stats = f.lattice.ikCacheStats();
+    BOOST_CHECK_EQUAL(stats.hits, 1);
+    BOOST_CHECK_EQUAL(stats.misses, 4);
+    BOOST_CHECK_EQUAL(stats.evictions, 2);
+    BOOST_CHECK_EQUAL(f.lattice.m_ik_cache_index.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(FailureTest)
+{
+    Fixture f(4);
+    smpl::RobotState solution;
+
+    BOOST_CHECK(!f.nearest(f.cell(20), solution));
+    BOOST_CHECK(!f.nearest(f.cell(20), solution));
+    BOOST_CHECK_EQUAL(f.robot.fast_ik_calls, 1);
+    BOOST_CHECK_EQUAL(f.lattice.ikCacheStats().failure_hits, 1);
+}
+
+BOOST_AUTO_TEST_CASE(AllBranchesUpgradeTest)
+{
+    Fixture f(4);
+    auto state = f.cell(1);
+
+    smpl::RobotState solution;
+    BOOST_CHECK(f.nearest(state, solution));
+    BOOST_CHECK_EQUAL(solution[3], 1.0);
+    BOOST_CHECK(!f.lattice.m_ik_cache.front().all_branches);
+
+    // the nearest solution alone can't answer a query for every branch
+    std::vector<smpl::RobotState> solutions;
+    BOOST_CHECK(f.all(state, solutions));
+    BOOST_CHECK_EQUAL(solutions.size(), 2);
+    BOOST_CHECK_EQUAL(f.robot.batch_ik_calls, 1);
+    BOOST_CHECK_EQUAL(f.lattice.m_ik_cache.size(), 1);
+    BOOST_CHECK(f.lattice.m_ik_cache.front().all_branches);
+
+    // the upgraded entry answers both kinds of query
+    BOOST_CHECK(f.all(state, solutions));
+    BOOST_CHECK_EQUAL(solutions.size(), 2);
+    BOOST_CHECK(f.nearest(state, solution));
+    BOOST_CHECK_EQUAL(solution[3], 1.0);
+    BOOST_CHECK_EQUAL(f.robot.batch_ik_calls, 1);
+    BOOST_CHECK_EQUAL(f.robot.fast_ik_calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(SeedFreeAngleTest)
+{
+    Fixture f(4);
+    auto state = f.cell(1, 3);
+
+    // a seed with another free angle gives a solution for another cell
+    auto seed = f.seed(f.cell(1, 5));
+    smpl::RobotState solution;
+    BOOST_CHECK(f.lattice.stateWorkspaceToRobot(state, seed, solution));
+    BOOST_CHECK_EQUAL(solution[4], seed[4]);
+    BOOST_CHECK(f.lattice.m_ik_cache.empty());
+    BOOST_CHECK_EQUAL(f.lattice.ikCacheStats().bypasses, 1);
+
+    BOOST_CHECK(f.nearest(state, solution));
+    BOOST_CHECK_EQUAL(solution[4], state[6]);
+    BOOST_CHECK(f.lattice.stateWorkspaceToRobot(state, seed, solution));
+    BOOST_CHECK_EQUAL(solution[4], seed[4]);
+    BOOST_CHECK_EQUAL(f.robot.fast_ik_calls, 3);
+}
+
+BOOST_AUTO_TEST_CASE(ValidateClearsMovedFrameTest)
+{
+    Fixture f(4);
+    smpl::RobotState start = { 0.0, 0.0, 0.0, 0.5, 0.0 };
+    smpl::RobotState solution;
+
+    f.lattice.validateIKCache(start);
+    BOOST_CHECK(f.nearest(f.cell(1), solution));
+    BOOST_CHECK(f.nearest(f.cell(2), solution));
+
+    // the same frame keeps the cached solutions across requests
+    f.lattice.validateIKCache(start);
+    BOOST_CHECK_EQUAL(f.lattice.m_ik_cache.size(), 2);
+    BOOST_CHECK(f.nearest(f.cell(1), solution));
+    BOOST_CHECK_EQUAL(f.robot.fast_ik_calls, 2);
+
+    // moving the base invalidates them
+    f.robot.base_x = 0.25;
+    f.lattice.validateIKCache(start);
+    BOOST_CHECK(f.lattice.m_ik_cache.empty());
+    BOOST_CHECK(f.lattice.m_ik_cache_index.empty());
+    BOOST_CHECK(f.nearest(f.cell(1), solution));
+    BOOST_CHECK_EQUAL(f.robot.fast_ik_calls, 3);
+    BOOST_CHECK_CLOSE(
+            f.robot.computeFK(solution).translation().x(),
+            f.cell(1)[0],
+            1e-6);
+}
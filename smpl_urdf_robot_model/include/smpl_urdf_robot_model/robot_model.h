@@ -108,6 +108,11 @@ auto GetParentLink(const Joint* joint) -> const Link*;
 auto GetCommonRoot(const RobotModel* model, const Joint* a, const Joint* b) -> const Joint*;
 bool IsAncestor(const RobotModel* model, const Joint* a, const Joint* b);
 
+// The joint and all of its descendants, in depth-first pre-order, so that
+// every joint appears after its parent.
+auto SubtreeJoints(const RobotModel* model, const Joint* joint)
+    -> range<const Joint* const*>;
+
 /////////////////////////
 // Variable Properties //
 /////////////////////////
@@ -250,6 +255,13 @@ struct RobotModel
 
     std::vector<const Joint*> ancestor_map;
 
+    // joints in depth-first pre-order, the position of each joint in that
+    // order (by joint index), and the end of the subtree rooted at each
+    // position
+    std::vector<const Joint*> joint_preorder;
+    std::vector<int> joint_preorder_index;
+    std::vector<int> joint_subtree_end;
+
     // self-references => non-copyable
     RobotModel() = default;
     RobotModel(const RobotModel&) = delete;
@@ -166,6 +166,10 @@ struct RobotState
     const Joint*            dirty_collisions_joint = NULL;
     const Joint*            dirty_visuals_joint = NULL;
 
+    // the child links of this joint and of all of its ancestors are up to
+    // date, even if they lie within the dirty subtree
+    const Joint*            clean_chain_joint = NULL;
+
     // self-references => non-copyable
     RobotState() = default;
     RobotState(const RobotState&) = delete;
@@ -1,6 +1,9 @@
 #ifndef SMPL_URDF_ROBOT_MODEL_URDF_ROBOT_MODEL_H
 #define SMPL_URDF_ROBOT_MODEL_URDF_ROBOT_MODEL_H
 
+// standard includes
+#include <vector>
+
 // system includes
 #include <smpl/robot_model.h>
 
@@ -35,9 +38,37 @@ struct URDFRobotModel :
     std::vector<int> planning_to_state_variable;
     const Link* planning_link = NULL;
 
+    // A joint on the path to the planning link, for batched forward
+    // kinematics. The origin is premultiplied by the origins of any fixed
+    // joints between this joint and the previous one and is stored as a
+    // column-major 3x4 matrix.
+    struct FKChainJoint
+    {
+        const Joint* joint;
+        double origin[12];
+        double axis[3];
+        int variable;           // state variable index
+        int planning_variable;  // planning variable index or -1
+    };
+
+    // The movable joints between fk_chain_base and the planning link, built
+    // on demand by computeFKBatch() when the planning link changes.
+    // fk_chain_tip holds the origins of any trailing fixed joints.
+    std::vector<FKChainJoint> fk_chain;
+    double fk_chain_tip[12];
+    const Link* fk_chain_base = NULL;
+    const Link* fk_chain_link = NULL;
+    bool fk_chain_batchable = false;
+
     auto computeFK(const smpl::RobotState& state)
         -> Eigen::Affine3d override;
 
+    void computeFKBatch(
+        const double* positions,
+        int count,
+        int stride,
+        Eigen::Affine3d* poses) override;
+
     double minPosLimit(int jidx) const override;
     double maxPosLimit(int jidx) const override;
     bool hasPosLimit(int jidx) const override;
@@ -75,6 +75,18 @@ void AddFloatingJointVariables(
     variables->push_back(v);
 }
 
+static
+void AppendSubtree(RobotModel* model, const Joint* joint)
+{
+    auto pos = (int)model->joint_preorder.size();
+    model->joint_preorder_index[GetJointIndex(model, joint)] = pos;
+    model->joint_preorder.push_back(joint);
+    for (auto* child = joint->child->children; child != NULL; child = child->sibling) {
+        AppendSubtree(model, child);
+    }
+    model->joint_subtree_end[pos] = (int)model->joint_preorder.size();
+}
+
 bool InitRobotModel(
     RobotModel* out,
     const ::urdf::ModelInterface* urdf,
@@ -523,6 +535,12 @@ bool InitRobotModel(
         }
     }
 
+    // ...flatten the tree so that subtrees are contiguous ranges of joints
+    robot_model.joint_preorder.reserve(robot_model.joints.size());
+    robot_model.joint_preorder_index.resize(robot_model.joints.size());
+    robot_model.joint_subtree_end.resize(robot_model.joints.size());
+    AppendSubtree(&robot_model, robot_model.root_joint);
+
     *out = std::move(robot_model);
     return true;
 }
@@ -813,6 +831,16 @@ bool IsAncestor(const RobotModel* model, const Joint* a, const Joint* b)
     return GetCommonRoot(model, a, b) == a;
 }
 
+auto SubtreeJoints(const RobotModel* model, const Joint* joint)
+    -> range<const Joint* const*>
+{
+    auto first = model->joint_preorder_index[GetJointIndex(model, joint)];
+    auto last = model->joint_subtree_end[first];
+    return make_range(
+            model->joint_preorder.data() + first,
+            model->joint_preorder.data() + last);
+}
+
 auto GetJointOfVariable(const JointVariable* variable) -> const Joint*
 {
     return variable->joint;
@@ -188,6 +188,13 @@ void SetVariablePosition(
         auto* v = GetVariable(state->model, index);
         auto* vj = GetJointOfVariable(v);
 
+        // the clean chain remains up to date above the modified joint
+        if (state->clean_chain_joint != NULL &&
+            IsAncestor(state->model, vj, state->clean_chain_joint))
+        {
+            state->clean_chain_joint = vj->parent != NULL ? vj->parent->parent : NULL;
+        }
+
         if (state->dirty_links_joint == NULL) {
             state->dirty_links_joint = vj;
         } else {
@@ -414,58 +421,62 @@ auto GetJointAccelerations(const RobotState* state, int index) -> const double*
 
 /////////////////////////// DANGER ZONE ///////////////////////////
 
+// Recompute the transforms of a joint and its child link, given an up-to-date
+// parent link transform.
 static
-void UpdateLinkTransforms(RobotState* state, std::vector<const Joint*>* q)
+void UpdateJointAndLinkTransform(RobotState* state, const Joint* joint)
+{
+    auto* child_link = joint->child;
+
+    // update the joint transform
+    auto& joint_transform =
+            state->joint_transforms[GetJointIndex(state->model, joint)];
+    joint_transform =
+            ComputeJointTransform(joint, GetJointPositions(state, joint));
+
+    // update the child link transform
+    auto& link_transform =
+            state->link_transforms[GetLinkIndex(state->model, child_link)];
+    if (joint->parent != NULL) {
+        // parent_link * origin * joint transform
+        auto& parent_transform =
+                state->link_transforms[
+                        GetLinkIndex(state->model, joint->parent)];
+        link_transform = parent_transform * joint->origin * joint_transform;
+    } else {
+        link_transform = joint->origin * joint_transform;
+    }
+}
+
+static
+void UpdateDirtyLinkTransforms(RobotState* state)
 {
     assert(state->dirty_links_joint != NULL);
 
-    q->push_back(state->dirty_links_joint);
-
-    while (!q->empty()) {
-        auto* joint = q->back();
-        q->pop_back();
-
-        auto* child_link = joint->child;
-
-        // update the joint transform
-        auto& joint_transform =
-                state->joint_transforms[GetJointIndex(state->model, joint)];
-        joint_transform =
-                ComputeJointTransform(joint, GetJointPositions(state, joint));
-
-        // update the child link transform
-        auto& link_transform =
-                state->link_transforms[GetLinkIndex(state->model, child_link)];
-        if (joint->parent != NULL) {
-            // parent_link * origin * joint transform
-            auto& parent_transform =
-                    state->link_transforms[
-                            GetLinkIndex(state->model, joint->parent)];
-            link_transform = parent_transform * joint->origin * joint_transform;
-        } else {
-            link_transform = joint->origin * joint_transform;
-        }
-
-        // recurse on children
-        for (auto* child = child_link->children; child != NULL; child = child->sibling) {
-            q->push_back(child);
-        }
+    for (auto* joint : SubtreeJoints(state->model, state->dirty_links_joint)) {
+        UpdateJointAndLinkTransform(state, joint);
     }
 
     state->dirty_links_joint = NULL;
+    state->clean_chain_joint = NULL;
 }
 
+// Update the links between the dirty subtree root and the child link of
+// joint, skipping any prefix of that path which is already up to date.
 static
-void UpdateOnlyCollisionBodyTransforms(
-    RobotState* state,
-    std::vector<const Joint*>* q)
+void UpdateLinkChain(RobotState* state, const Joint* joint)
 {
-    assert(state->dirty_collisions_joint != NULL);
-    q->push_back(state->dirty_collisions_joint);
-    while (!q->empty()) {
-        auto* joint = q->back();
-        q->pop_back();
+    if (joint->parent != NULL && IsLinkTransformDirty(state, joint->parent)) {
+        UpdateLinkChain(state, joint->parent->parent);
+    }
+    UpdateJointAndLinkTransform(state, joint);
+}
 
+static
+void UpdateOnlyCollisionBodyTransforms(RobotState* state)
+{
+    assert(state->dirty_collisions_joint != NULL);
+    for (auto* joint : SubtreeJoints(state->model, state->dirty_collisions_joint)) {
         auto* child_link = joint->child;
 
         auto& link_transform =
@@ -476,24 +487,15 @@ void UpdateOnlyCollisionBodyTransforms(
                             GetCollisionBodyIndex(state->model, &collision)];
             collision_transform = link_transform * collision.origin;
         }
-        for (auto* child = child_link->children; child != NULL; child = child->sibling) {
-            q->push_back(child);
-        }
     }
     state->dirty_collisions_joint = NULL;
 }
 
 static
-void UpdateOnlyVisualBodyTransforms(
-    RobotState* state,
-    std::vector<const Joint*>* q)
+void UpdateOnlyVisualBodyTransforms(RobotState* state)
 {
     assert(state->dirty_visuals_joint != NULL);
-    q->push_back(state->dirty_visuals_joint);
-    while (!q->empty()) {
-        auto* joint = q->back();
-        q->pop_back();
-
+    for (auto* joint : SubtreeJoints(state->model, state->dirty_visuals_joint)) {
         auto* child_link = joint->child;
 
         auto& link_transform =
@@ -504,40 +506,48 @@ void UpdateOnlyVisualBodyTransforms(
                             GetVisualBodyIndex(state->model, &visual)];
             visual_transform = link_transform * visual.origin;
         }
-        for (auto* child = child_link->children; child != NULL; child = child->sibling) {
-            q->push_back(child);
-        }
     }
     state->dirty_visuals_joint = NULL;
 }
 
+// Whether link transforms that body transforms rooted at joint depend on are
+// outdated: the dirty links lie in the supertree or subtree of joint.
+static
+bool AreBodyLinksDirty(const RobotState* state, const Joint* joint)
+{
+    return state->dirty_links_joint != NULL &&
+            (IsAncestor(state->model, joint, state->dirty_links_joint) |
+            IsAncestor(state->model, state->dirty_links_joint, joint));
+}
+
 void UpdateTransforms(RobotState* state)
 {
-    std::vector<const Joint*> q;
     if (state->dirty_links_joint != NULL) {
-        UpdateLinkTransforms(state, &q);
+        UpdateDirtyLinkTransforms(state);
     }
     if (state->dirty_collisions_joint != NULL) {
-        UpdateOnlyCollisionBodyTransforms(state, &q);
+        UpdateOnlyCollisionBodyTransforms(state);
     }
     if (state->dirty_visuals_joint != NULL) {
-        UpdateOnlyVisualBodyTransforms(state, &q);
+        UpdateOnlyVisualBodyTransforms(state);
     }
 }
 
 void UpdateLinkTransforms(RobotState* state)
 {
     if (state->dirty_links_joint != NULL) {
-        std::vector<const Joint*> q;
-        UpdateLinkTransforms(state, &q);
+        UpdateDirtyLinkTransforms(state);
     }
 }
 
+// Only the links on the path to the requested link are recomputed. The rest of
+// the dirty subtree stays dirty, and the path is remembered so that only the
+// part below a modified joint is recomputed by the next update.
 void UpdateLinkTransform(RobotState* state, const Link* link)
 {
     if (IsLinkTransformDirty(state, link)) {
-        std::vector<const Joint*> q;
-        UpdateLinkTransforms(state, &q);
+        UpdateLinkChain(state, link->parent);
+        state->clean_chain_joint = link->parent;
     }
 }
 
@@ -549,17 +559,11 @@ void UpdateLinkTransform(RobotState* state, int index)
 void UpdateCollisionBodyTransforms(RobotState* state)
 {
     if (state->dirty_collisions_joint != NULL) {
-        std::vector<const Joint*> q;
-        if (state->dirty_links_joint != NULL) {
-            // supertree or subtree => update
-            if (IsAncestor(state->model, state->dirty_collisions_joint, state->dirty_links_joint) |
-                IsAncestor(state->model, state->dirty_links_joint, state->dirty_collisions_joint))
-            {
-                UpdateLinkTransforms(state, &q);
-            }
-            // ...otherwise, sibling tree
+        // ...links in a sibling tree do not affect these bodies
+        if (AreBodyLinksDirty(state, state->dirty_collisions_joint)) {
+            UpdateDirtyLinkTransforms(state);
         }
-        UpdateOnlyCollisionBodyTransforms(state, &q);
+        UpdateOnlyCollisionBodyTransforms(state);
     }
 }
 
@@ -568,11 +572,11 @@ void UpdateCollisionBodyTransform(
     const LinkCollision* collision)
 {
     if (IsCollisionBodyTransformDirty(state, collision)) {
-        std::vector<const Joint*> q;
-        if (IsLinkTransformDirty(state, collision->link)) {
-            UpdateLinkTransforms(state, &q);
+        // every body in the dirty subtree is updated, not just this one
+        if (AreBodyLinksDirty(state, state->dirty_collisions_joint)) {
+            UpdateDirtyLinkTransforms(state);
         }
-        UpdateOnlyCollisionBodyTransforms(state, &q);
+        UpdateOnlyCollisionBodyTransforms(state);
     }
 }
 
@@ -584,28 +588,20 @@ void UpdateCollisionBodyTransform(RobotState* state, int index)
 void UpdateVisualBodyTransforms(RobotState* state)
 {
     if (state->dirty_visuals_joint != NULL) {
-        std::vector<const Joint*> q;
-        if (state->dirty_links_joint != NULL) {
-            // supertree or subtree => update
-            if (IsAncestor(state->model, state->dirty_visuals_joint, state->dirty_links_joint) |
-                IsAncestor(state->model, state->dirty_links_joint, state->dirty_visuals_joint))
-            {
-                UpdateLinkTransforms(state, &q);
-            }
-            // ...otherwise, sibling tree
+        if (AreBodyLinksDirty(state, state->dirty_visuals_joint)) {
+            UpdateDirtyLinkTransforms(state);
         }
-        UpdateOnlyVisualBodyTransforms(state, &q);
+        UpdateOnlyVisualBodyTransforms(state);
     }
 }
 
 void UpdateVisualBodyTransform(RobotState* state, const LinkVisual* visual)
 {
     if (IsVisualBodyTransformDirty(state, visual)) {
-        std::vector<const Joint*> q;
-        if (IsLinkTransformDirty(state, visual->link)) {
-            UpdateLinkTransforms(state, &q);
+        if (AreBodyLinksDirty(state, state->dirty_visuals_joint)) {
+            UpdateDirtyLinkTransforms(state);
         }
-        UpdateOnlyVisualBodyTransforms(state, &q);
+        UpdateOnlyVisualBodyTransforms(state);
     }
 }
 
@@ -708,7 +704,9 @@ bool IsJointTransformDirty(const RobotState* state, const Joint* joint)
 bool IsLinkTransformDirty(const RobotState* state, const Link* link)
 {
     return state->dirty_links_joint != NULL &&
-            IsAncestor(state->model, state->dirty_links_joint, link->parent);
+            IsAncestor(state->model, state->dirty_links_joint, link->parent) &&
+            (state->clean_chain_joint == NULL ||
+            !IsAncestor(state->model, link->parent, state->clean_chain_joint));
 }
 
 bool IsCollisionBodyTransformDirty(const RobotState* state, const LinkCollision* collision)
@@ -1,5 +1,9 @@
 #include <smpl_urdf_robot_model/urdf_robot_model.h>
 
+// standard includes
+#include <algorithm>
+#include <cmath>
+
 // project includes
 #include <smpl_urdf_robot_model/robot_state_bounds.h>
 #include <smpl_urdf_robot_model/robot_model.h>
@@ -100,6 +104,250 @@ auto URDFRobotModel::computeFK(const smpl::RobotState& state)
     return *GetLinkTransform(&this->robot_state, this->planning_link);
 }
 
+// Number of states evaluated together by computeFKBatch(). The transforms of
+// a batch are stored lane-wise, T[element][lane], so that the per-lane loops
+// below can be vectorized.
+static const int FK_BATCH_WIDTH = 4;
+
+static
+void StoreTransform(const Affine3* T, double* M)
+{
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 3; ++r) {
+            M[3 * c + r] = (*T)(r, c);
+        }
+    }
+}
+
+static
+void BuildFKChain(URDFRobotModel* model)
+{
+    model->fk_chain.clear();
+    model->fk_chain_base = NULL;
+    model->fk_chain_link = model->planning_link;
+    model->fk_chain_batchable = false;
+
+    if (model->planning_link == NULL) return;
+
+    auto state_to_planning_variable =
+            std::vector<int>(GetVariableCount(model->robot_model), -1);
+    for (auto i = 0; i < model->jointVariableCount(); ++i) {
+        state_to_planning_variable[model->planning_to_state_variable[i]] = i;
+    }
+
+    // joints from the root to the planning link
+    std::vector<const Joint*> path;
+    for (auto* joint = model->planning_link->parent; joint != NULL; ) {
+        path.push_back(joint);
+        joint = joint->parent != NULL ? joint->parent->parent : NULL;
+    }
+    std::reverse(begin(path), end(path));
+
+    auto is_planning_joint = [&](const Joint* joint) {
+        for (auto& variable : Variables(joint)) {
+            auto index = GetVariableIndex(model->robot_model, &variable);
+            if (state_to_planning_variable[index] >= 0) return true;
+        }
+        return false;
+    };
+
+    // the transform of the link preceding the first planning joint does not
+    // vary within a batch and is taken from the reference state
+    auto first = std::find_if(begin(path), end(path), is_planning_joint);
+    if (first == end(path)) {
+        model->fk_chain_base = model->planning_link;
+    } else {
+        model->fk_chain_base = (*first)->parent;
+    }
+
+    auto pending = Affine3(Affine3::Identity());
+    for (auto it = first; it != end(path); ++it) {
+        auto* joint = *it;
+        switch (joint->type) {
+        case JointType::Fixed:
+            pending = pending * joint->origin;
+            break;
+        case JointType::Revolute:
+        case JointType::Prismatic:
+        {
+            URDFRobotModel::FKChainJoint chain_joint;
+            chain_joint.joint = joint;
+            auto origin = Affine3(pending * joint->origin);
+            StoreTransform(&origin, chain_joint.origin);
+            chain_joint.axis[0] = joint->axis.x();
+            chain_joint.axis[1] = joint->axis.y();
+            chain_joint.axis[2] = joint->axis.z();
+            chain_joint.variable = GetVariableIndex(model->robot_model, joint->vfirst);
+            chain_joint.planning_variable =
+                    state_to_planning_variable[chain_joint.variable];
+            model->fk_chain.push_back(chain_joint);
+            pending = Affine3::Identity();
+            break;
+        }
+        default:
+            // planar and floating joints are evaluated one state at a time
+            model->fk_chain.clear();
+            return;
+        }
+    }
+
+    StoreTransform(&pending, model->fk_chain_tip);
+    model->fk_chain_batchable = true;
+}
+
+// T = T * A, for a transform A shared by all lanes
+static
+void ComposeTransform(double T[12][FK_BATCH_WIDTH], const double* A)
+{
+    double R[12][FK_BATCH_WIDTH];
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 3; ++r) {
+            for (int l = 0; l < FK_BATCH_WIDTH; ++l) {
+                R[3 * c + r][l] =
+                        T[r][l] * A[3 * c] +
+                        T[3 + r][l] * A[3 * c + 1] +
+                        T[6 + r][l] * A[3 * c + 2];
+            }
+        }
+    }
+    for (int r = 0; r < 3; ++r) {
+        for (int l = 0; l < FK_BATCH_WIDTH; ++l) {
+            R[9 + r][l] += T[9 + r][l];
+        }
+    }
+    std::copy(&R[0][0], &R[0][0] + 12 * FK_BATCH_WIDTH, &T[0][0]);
+}
+
+// T = T * AngleAxis(q, axis), with a rotation angle per lane
+static
+void ComposeRevolute(
+    double T[12][FK_BATCH_WIDTH],
+    const double* axis,
+    const double* q)
+{
+    auto x = axis[0];
+    auto y = axis[1];
+    auto z = axis[2];
+
+    double c[FK_BATCH_WIDTH];
+    double s[FK_BATCH_WIDTH];
+    for (int l = 0; l < FK_BATCH_WIDTH; ++l) {
+        c[l] = std::cos(q[l]);
+        s[l] = std::sin(q[l]);
+    }
+
+    // Rodrigues' formula, column-major
+    double R[9][FK_BATCH_WIDTH];
+    for (int l = 0; l < FK_BATCH_WIDTH; ++l) {
+        auto t = 1.0 - c[l];
+        R[0][l] = c[l] + x * x * t;
+        R[1][l] = x * y * t + z * s[l];
+        R[2][l] = x * z * t - y * s[l];
+        R[3][l] = x * y * t - z * s[l];
+        R[4][l] = c[l] + y * y * t;
+        R[5][l] = y * z * t + x * s[l];
+        R[6][l] = x * z * t + y * s[l];
+        R[7][l] = y * z * t - x * s[l];
+        R[8][l] = c[l] + z * z * t;
+    }
+
+    double M[9][FK_BATCH_WIDTH];
+    for (int j = 0; j < 3; ++j) {
+        for (int r = 0; r < 3; ++r) {
+            for (int l = 0; l < FK_BATCH_WIDTH; ++l) {
+                M[3 * j + r][l] =
+                        T[r][l] * R[3 * j][l] +
+                        T[3 + r][l] * R[3 * j + 1][l] +
+                        T[6 + r][l] * R[3 * j + 2][l];
+            }
+        }
+    }
+    std::copy(&M[0][0], &M[0][0] + 9 * FK_BATCH_WIDTH, &T[0][0]);
+}
+
+// T = T * Translation(q * axis), with a displacement per lane
+static
+void ComposePrismatic(
+    double T[12][FK_BATCH_WIDTH],
+    const double* axis,
+    const double* q)
+{
+    for (int r = 0; r < 3; ++r) {
+        for (int l = 0; l < FK_BATCH_WIDTH; ++l) {
+            T[9 + r][l] += q[l] * (
+                    T[r][l] * axis[0] +
+                    T[3 + r][l] * axis[1] +
+                    T[6 + r][l] * axis[2]);
+        }
+    }
+}
+
+void URDFRobotModel::computeFKBatch(
+    const double* positions,
+    int count,
+    int stride,
+    Eigen::Affine3d* poses)
+{
+    if (this->fk_chain_link != this->planning_link) {
+        BuildFKChain(this);
+    }
+
+    if (!this->fk_chain_batchable) {
+        ForwardKinematicsInterface::computeFKBatch(positions, count, stride, poses);
+        return;
+    }
+
+    // the chain starts at the root joint when fk_chain_base is null
+    auto base_transform = Affine3(Affine3::Identity());
+    if (this->fk_chain_base != NULL) {
+        base_transform = *GetUpdatedLinkTransform(
+                &this->robot_state, this->fk_chain_base);
+    }
+    double base[12];
+    StoreTransform(&base_transform, base);
+
+    for (auto i = 0; i < count; i += FK_BATCH_WIDTH) {
+        auto n = std::min(FK_BATCH_WIDTH, count - i);
+
+        double T[12][FK_BATCH_WIDTH];
+        for (int e = 0; e < 12; ++e) {
+            std::fill(T[e], T[e] + FK_BATCH_WIDTH, base[e]);
+        }
+
+        for (auto& chain_joint : this->fk_chain) {
+            // unused lanes of the last batch repeat the first state
+            double q[FK_BATCH_WIDTH];
+            if (chain_joint.planning_variable >= 0) {
+                auto* p = positions + chain_joint.planning_variable * stride + i;
+                for (int l = 0; l < FK_BATCH_WIDTH; ++l) {
+                    q[l] = p[l < n ? l : 0];
+                }
+            } else {
+                std::fill(q, q + FK_BATCH_WIDTH, GetVariablePosition(
+                        &this->robot_state, chain_joint.variable));
+            }
+
+            ComposeTransform(T, chain_joint.origin);
+            if (chain_joint.joint->type == JointType::Revolute) {
+                ComposeRevolute(T, chain_joint.axis, q);
+            } else {
+                ComposePrismatic(T, chain_joint.axis, q);
+            }
+        }
+        ComposeTransform(T, this->fk_chain_tip);
+
+        for (auto l = 0; l < n; ++l) {
+            auto& M = poses[i + l].matrix();
+            for (int c = 0; c < 4; ++c) {
+                for (int r = 0; r < 3; ++r) {
+                    M(r, c) = T[3 * c + r][l];
+                }
+            }
+            M.row(3) << 0.0, 0.0, 0.0, 1.0;
+        }
+    }
+}
+
 double URDFRobotModel::minPosLimit(int jidx) const
 {
     return this->vprops[jidx].min_position;
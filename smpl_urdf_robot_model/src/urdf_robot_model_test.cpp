@@ -0,0 +1,361 @@
+// standard includes
+#include <math.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// system includes
+#define BOOST_TEST_MODULE URDFRobotModelTest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <urdf_parser/urdf_parser.h>
+
+// project includes
+#include <smpl_urdf_robot_model/robot_model.h>
+#include <smpl_urdf_robot_model/robot_state.h>
+#include <smpl_urdf_robot_model/urdf_robot_model.h>
+
+using namespace smpl::urdf;
+using smpl::Affine3;
+using smpl::AngleAxis;
+using smpl::Quaternion;
+using smpl::Translation3;
+using smpl::Vector3;
+
+// An arm with fixed, revolute, continuous, and prismatic joints, off-axis
+// joint origins, a wrist joint that is not part of the planning group, and a
+// second branch from the shoulder link.
+static const char* ARM_URDF = R"(
+<robot name="arm">
+  <link name="base_link"/>
+  <link name="shoulder_link"/>
+  <link name="offset_link"/>
+  <link name="slide_link"/>
+  <link name="elbow_link"/>
+  <link name="wrist_link"/>
+  <link name="tool_link"/>
+  <link name="tip_link"/>
+  <link name="side_link"/>
+  <link name="side_tip_link"/>
+  <joint name="a_shoulder" type="revolute">
+    <parent link="base_link"/>
+    <child link="shoulder_link"/>
+    <origin xyz="0.1 0 0.3" rpy="0 0 0.2"/>
+    <axis xyz="0 0 1"/>
+    <limit lower="-3" upper="3" effort="1" velocity="1"/>
+  </joint>
+  <joint name="b_offset" type="fixed">
+    <parent link="shoulder_link"/>
+    <child link="offset_link"/>
+    <origin xyz="0 0.1 0.2" rpy="0.3 0 0"/>
+  </joint>
+  <joint name="c_slide" type="prismatic">
+    <parent link="offset_link"/>
+    <child link="slide_link"/>
+    <origin xyz="0.05 0 0" rpy="0 0.4 0"/>
+    <axis xyz="0.6 0 0.8"/>
+    <limit lower="-0.5" upper="0.5" effort="1" velocity="1"/>
+  </joint>
+  <joint name="d_elbow" type="continuous">
+    <parent link="slide_link"/>
+    <child link="elbow_link"/>
+    <origin xyz="0 0 0.4"/>
+    <axis xyz="0 1 0"/>
+  </joint>
+  <joint name="e_wrist" type="revolute">
+    <parent link="elbow_link"/>
+    <child link="wrist_link"/>
+    <origin xyz="0.3 0 0" rpy="0 0 -0.5"/>
+    <axis xyz="1 0 0"/>
+    <limit lower="-3" upper="3" effort="1" velocity="1"/>
+  </joint>
+  <joint name="f_roll" type="revolute">
+    <parent link="wrist_link"/>
+    <child link="tool_link"/>
+    <origin xyz="0.1 0 0"/>
+    <axis xyz="0.2 0.4 0.9"/>
+    <limit lower="-3" upper="3" effort="1" velocity="1"/>
+  </joint>
+  <joint name="g_tip" type="fixed">
+    <parent link="tool_link"/>
+    <child link="tip_link"/>
+    <origin xyz="0 0 0.15" rpy="0.1 0.2 0.3"/>
+  </joint>
+  <joint name="h_side" type="revolute">
+    <parent link="shoulder_link"/>
+    <child link="side_link"/>
+    <origin xyz="0 -0.2 0.1"/>
+    <axis xyz="1 0 0"/>
+    <limit lower="-3" upper="3" effort="1" velocity="1"/>
+  </joint>
+  <joint name="i_side_tip" type="prismatic">
+    <parent link="side_link"/>
+    <child link="side_tip_link"/>
+    <origin xyz="0 0 0.2"/>
+    <axis xyz="0 0 1"/>
+    <limit lower="-0.5" upper="0.5" effort="1" velocity="1"/>
+  </joint>
+</robot>
+)";
+
+static
+auto MakeWorldJoint(JointType type) -> JointSpec
+{
+    JointSpec world_joint;
+    world_joint.name = "world_joint";
+    world_joint.origin = Translation3(0.5, -0.25, 0.1) *
+            AngleAxis(0.3, Vector3(1.0, 2.0, 3.0).normalized());
+    world_joint.axis = Vector3::Zero();
+    world_joint.type = type;
+    return world_joint;
+}
+
+static
+void LoadArm(RobotModel* model, JointType world_joint_type)
+{
+    auto urdf = ::urdf::parseURDF(ARM_URDF);
+    BOOST_REQUIRE(urdf);
+    auto world_joint = MakeWorldJoint(world_joint_type);
+    BOOST_REQUIRE(InitRobotModel(model, urdf.get(), &world_joint));
+}
+
+// The motion of a joint relative to its origin, computed from the joint type
+// and its variables.
+static
+auto ReferenceJointMotion(const Joint* joint, const double* q) -> Affine3
+{
+    switch (joint->type) {
+    case JointType::Fixed:
+        return Affine3::Identity();
+    case JointType::Revolute:
+        return Affine3(AngleAxis(q[0], joint->axis));
+    case JointType::Prismatic:
+        return Affine3(Translation3(q[0] * joint->axis));
+    case JointType::Planar:
+        return Translation3(q[0], q[1], 0.0) * AngleAxis(q[2], Vector3::UnitZ());
+    case JointType::Floating:
+    default:
+        return Translation3(q[0], q[1], q[2]) *
+                Quaternion(q[6], q[3], q[4], q[5]);
+    }
+}
+
+// The transform of a link, composed from the root along its chain of joints
+// without any caching.
+static
+auto ReferenceLinkTransform(
+    const RobotModel* model,
+    const std::vector<double>& positions,
+    const Link* link)
+    -> Affine3
+{
+    auto transform = Affine3(Affine3::Identity());
+    for (auto* joint = link->parent; joint != NULL; ) {
+        const double* q = NULL;
+        if (joint->vfirst != joint->vlast) {
+            q = &positions[GetVariableIndex(model, joint->vfirst)];
+        }
+        transform = joint->origin * ReferenceJointMotion(joint, q) * transform;
+        joint = joint->parent != NULL ? joint->parent->parent : NULL;
+    }
+    return transform;
+}
+
+static
+double TransformError(const Affine3& a, const Affine3& b)
+{
+    return (a.matrix() - b.matrix()).cwiseAbs().maxCoeff();
+}
+
+static
+auto RandomPositions(const RobotModel* model, std::default_random_engine& rng)
+    -> std::vector<double>
+{
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> positions(GetVariableCount(model));
+    for (auto& p : positions) {
+        p = dist(rng);
+    }
+
+    // floating joint variables hold a normalized quaternion
+    for (auto& joint : Joints(model)) {
+        if (joint.type != JointType::Floating) continue;
+        auto* q = &positions[GetVariableIndex(model, joint.vfirst)];
+        Quaternion rot(q[6], q[3], q[4], q[5]);
+        rot.normalize();
+        q[3] = rot.x();
+        q[4] = rot.y();
+        q[5] = rot.z();
+        q[6] = rot.w();
+    }
+    return positions;
+}
+
+static const double TOLERANCE = 1e-9;
+
+// Compare computeFKBatch() against computeFK() and the reference transform,
+// for batch sizes around the batch width and reference states that move the
+// world joint and the joints outside the planning group between batches.
+static
+void CheckFKBatch(
+    JointType world_joint_type,
+    const std::vector<std::string>& planning_joints)
+{
+    RobotModel model;
+    LoadArm(&model, world_joint_type);
+
+    URDFRobotModel urdf_model;
+    BOOST_REQUIRE(Init(&urdf_model, &model, &planning_joints));
+    BOOST_REQUIRE(SetPlanningLink(&urdf_model, "tip_link"));
+    auto* tip = GetLink(&model, "tip_link");
+
+    std::default_random_engine rng;
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    auto var_count = (int)urdf_model.jointVariableCount();
+    for (int count : { 1, 2, 3, 4, 5, 7, 8, 9, 13 }) {
+        auto reference = RandomPositions(&model, rng);
+        SetReferenceState(&urdf_model, reference.data());
+
+        auto stride = count + 3;
+        std::vector<double> positions(var_count * stride);
+        std::vector<smpl::RobotState> states(count);
+        for (int i = 0; i < count; ++i) {
+            auto full = RandomPositions(&model, rng);
+            states[i].resize(var_count);
+            for (int v = 0; v < var_count; ++v) {
+                auto index = urdf_model.planning_to_state_variable[v];
+                states[i][v] = full[index];
+                positions[v * stride + i] = full[index];
+            }
+        }
+
+        std::vector<Eigen::Affine3d> poses(count + 1, Eigen::Affine3d::Identity());
+        poses[count](0, 3) = 42.0;
+        urdf_model.computeFKBatch(positions.data(), count, stride, poses.data());
+
+        // no pose is written past count
+        BOOST_CHECK_EQUAL(poses[count](0, 3), 42.0);
+
+        for (int i = 0; i < count; ++i) {
+            auto full = reference;
+            for (int v = 0; v < var_count; ++v) {
+                full[urdf_model.planning_to_state_variable[v]] = states[i][v];
+            }
+            auto expected = ReferenceLinkTransform(&model, full, tip);
+            BOOST_CHECK_SMALL(TransformError(poses[i], expected), TOLERANCE);
+
+            // computeFK() moves the planning variables of the reference state
+            auto fk = urdf_model.computeFK(states[i]);
+            BOOST_CHECK_SMALL(TransformError(fk, expected), TOLERANCE);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FKBatchPlanarWorldJoint)
+{
+    CheckFKBatch(JointType::Planar, { "a_shoulder", "c_slide", "d_elbow", "f_roll" });
+}
+
+BOOST_AUTO_TEST_CASE(FKBatchFloatingWorldJoint)
+{
+    CheckFKBatch(JointType::Floating, { "a_shoulder", "c_slide", "d_elbow", "f_roll" });
+}
+
+// The chain begins below the first planning joint, so the moving shoulder is
+// taken from the reference state
+BOOST_AUTO_TEST_CASE(FKBatchPartialChain)
+{
+    CheckFKBatch(JointType::Fixed, { "d_elbow", "f_roll" });
+}
+
+// A planar joint in the planning group is evaluated one state at a time
+BOOST_AUTO_TEST_CASE(FKBatchPlanarPlanningJoint)
+{
+    CheckFKBatch(JointType::Planar, { "world_joint", "a_shoulder", "c_slide", "f_roll" });
+}
+
+// Only the chain to a queried link is updated. Moving a joint off that chain
+// must keep it clean and moving an ancestor must recompute it from the
+// ancestor down.
+BOOST_AUTO_TEST_CASE(LinkChainAfterVariableChanges)
+{
+    RobotModel model;
+    LoadArm(&model, JointType::Floating);
+
+    RobotState state;
+    BOOST_REQUIRE(InitRobotState(&state, &model));
+
+    std::default_random_engine rng;
+    auto positions = RandomPositions(&model, rng);
+    SetVariablePositions(&state, positions.data());
+
+    auto* tip = GetLink(&model, "tip_link");
+    auto* side_tip = GetLink(&model, "side_tip_link");
+    auto* wrist = GetLink(&model, "wrist_link");
+
+    auto set_variable = [&](const char* name, double position) {
+        auto index = GetVariableIndex(&model, GetVariable(&model, name));
+        positions[index] = position;
+        SetVariablePosition(&state, index, position);
+    };
+
+    auto check_link = [&](const Link* link) {
+        auto expected = ReferenceLinkTransform(&model, positions, link);
+        auto* actual = GetUpdatedLinkTransform(&state, link);
+        BOOST_CHECK_SMALL(TransformError(*actual, expected), TOLERANCE);
+        BOOST_CHECK(!IsLinkTransformDirty(&state, link));
+    };
+
+    check_link(tip);
+    BOOST_CHECK(IsLinkTransformDirty(&state, side_tip));
+
+    // sibling branch
+    set_variable("h_side", 0.7);
+    BOOST_CHECK(!IsLinkTransformDirty(&state, tip));
+    check_link(side_tip);
+    check_link(tip);
+
+    // descendant of the clean chain
+    set_variable("f_roll", -1.1);
+    BOOST_CHECK(!IsLinkTransformDirty(&state, wrist));
+    BOOST_CHECK(IsLinkTransformDirty(&state, tip));
+    check_link(tip);
+
+    // ancestor of the clean chain
+    set_variable("a_shoulder", 0.4);
+    BOOST_CHECK(IsLinkTransformDirty(&state, wrist));
+    BOOST_CHECK(IsLinkTransformDirty(&state, tip));
+    check_link(wrist);
+    check_link(tip);
+
+    // world joint
+    set_variable("world_joint/trans_x", 2.0);
+    check_link(side_tip);
+    check_link(tip);
+
+    // random changes and queries
+    std::uniform_int_distribution<int> var_dist(0, (int)GetVariableCount(&model) - 1);
+    std::uniform_int_distribution<int> link_dist(0, (int)GetLinkCount(&model) - 1);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    for (int i = 0; i < 500; ++i) {
+        auto index = var_dist(rng);
+        auto* joint = GetJointOfVariable(GetVariable(&model, index));
+        if (joint->type == JointType::Floating &&
+            index >= (int)GetVariableIndex(&model, joint->vfirst) + 3)
+        {
+            continue; // keep the quaternion normalized
+        }
+        positions[index] = dist(rng);
+        SetVariablePosition(&state, index, positions[index]);
+        check_link(GetLink(&model, link_dist(rng)));
+    }
+
+    UpdateLinkTransforms(&state);
+    for (auto& link : Links(&model)) {
+        auto expected = ReferenceLinkTransform(&model, positions, &link);
+        BOOST_CHECK_SMALL(
+                TransformError(*GetLinkTransform(&state, &link), expected),
+                TOLERANCE);
+    }
+}